@@ -0,0 +1,244 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "protocol_examples_common.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include "esp_websocket_client.h"
+#include "esp_system.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include <sys/resource.h>
+
+static const char *TAG = "websocket";
+
+static volatile bool s_measuring;
+static volatile int s_bench_rx_bytes;
+
+static void log_error_if_nonzero(const char *message, int error_code)
+{
+    if (error_code != 0) {
+        ESP_LOGE(TAG, "Last error %s: 0x%x", message, error_code);
+    }
+}
+
+static void websocket_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
+    switch (event_id) {
+    case WEBSOCKET_EVENT_CONNECTED:
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_CONNECTED");
+        break;
+    case WEBSOCKET_EVENT_DISCONNECTED:
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_DISCONNECTED");
+        log_error_if_nonzero("HTTP status code",  data->error_handle.esp_ws_handshake_status_code);
+        if (data->error_handle.error_type == WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT) {
+            log_error_if_nonzero("reported from esp-tls", data->error_handle.esp_tls_last_esp_err);
+            log_error_if_nonzero("reported from tls stack", data->error_handle.esp_tls_stack_err);
+            log_error_if_nonzero("captured as transport's socket errno",  data->error_handle.esp_transport_sock_errno);
+        }
+        break;
+    case WEBSOCKET_EVENT_DATA:
+        if (s_measuring) {
+            // Count the echo instead of logging every chunk, logging would dominate the timing
+            if (data->op_code == WS_TRANSPORT_OPCODES_BINARY || data->op_code == WS_TRANSPORT_OPCODES_CONT) {
+                s_bench_rx_bytes += data->data_len;
+            }
+            break;
+        }
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_DATA");
+        ESP_LOGI(TAG, "Received opcode=%d", data->op_code);
+        if (data->op_code == 0x08 && data->data_len == 2) {
+            ESP_LOGW(TAG, "Received closed message with code=%d", 256 * data->data_ptr[0] + data->data_ptr[1]);
+        } else {
+            ESP_LOGW(TAG, "Received=%.*s", data->data_len, (char *)data->data_ptr);
+        }
+
+        // If received data contains json structure it succeed to parse
+        ESP_LOGW(TAG, "Total payload length=%d, data_len=%d, current payload offset=%d\r\n", data->payload_len, data->data_len, data->payload_offset);
+
+        break;
+    case WEBSOCKET_EVENT_ERROR:
+        ESP_LOGI(TAG, "WEBSOCKET_EVENT_ERROR");
+        log_error_if_nonzero("HTTP status code",  data->error_handle.esp_ws_handshake_status_code);
+        if (data->error_handle.error_type == WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT) {
+            log_error_if_nonzero("reported from esp-tls", data->error_handle.esp_tls_last_esp_err);
+            log_error_if_nonzero("reported from tls stack", data->error_handle.esp_tls_stack_err);
+            log_error_if_nonzero("captured as transport's socket errno",  data->error_handle.esp_transport_sock_errno);
+        }
+        break;
+    }
+}
+
+
+#if CONFIG_WEBSOCKET_BENCH_MESSAGES
+static void websocket_bench_run(esp_websocket_client_handle_t client, const char *name, bool gather, uint8_t *payload)
+{
+    const int len = CONFIG_WEBSOCKET_BENCH_PAYLOAD;
+    const int total = CONFIG_WEBSOCKET_BENCH_MESSAGES * len;
+    // A small per-message header followed by the bulk payload, as an application would frame it
+    uint8_t header[8] = { 0 };
+    esp_websocket_iov_t iov[2] = {
+        { .data = header, .len = sizeof(header) },
+        { .data = payload + sizeof(header), .len = len - sizeof(header) },
+    };
+
+    s_bench_rx_bytes = 0;
+    s_measuring = true;
+    uint32_t heap_before = esp_get_free_heap_size();
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CONFIG_WEBSOCKET_BENCH_MESSAGES; i++) {
+        memcpy(header, &i, sizeof(i));
+        int ret = gather ? esp_websocket_client_send_iov(client, WS_TRANSPORT_OPCODES_BINARY, iov, 2, portMAX_DELAY)
+                  : esp_websocket_client_send_bin(client, (const char *)payload, len, portMAX_DELAY);
+        if (ret != len) {
+            ESP_LOGE(TAG, "[%s] send %d failed (%d)", name, i, ret);
+            break;
+        }
+    }
+    int64_t sent = esp_timer_get_time();
+    uint32_t heap_sending = esp_get_free_heap_size();
+    while (s_bench_rx_bytes < total && esp_timer_get_time() - sent < 5 * 1000 * 1000) {
+        vTaskDelay(1);
+    }
+    int64_t echoed = esp_timer_get_time();
+    s_measuring = false;
+
+    ESP_LOGI(TAG, "[%s] %d x %d B: send %lld us (%.1f KB/s, %.1f us/msg), echo complete after %lld us, %d/%d B back",
+             name, CONFIG_WEBSOCKET_BENCH_MESSAGES, len, (long long)(sent - start),
+             total * 1000000.0 / 1024 / (double)(sent - start + 1), (double)(sent - start) / CONFIG_WEBSOCKET_BENCH_MESSAGES,
+             (long long)(echoed - start), s_bench_rx_bytes, total);
+    ESP_LOGI(TAG, "[%s] free heap %" PRIu32 " before, %" PRIu32 " after sending", name, heap_before, heap_sending);
+}
+
+static void websocket_bench(esp_websocket_client_handle_t client)
+{
+    uint8_t *payload = malloc(CONFIG_WEBSOCKET_BENCH_PAYLOAD);
+    if (payload == NULL) {
+        ESP_LOGE(TAG, "No memory for the benchmark payload");
+        return;
+    }
+    for (int i = 0; i < CONFIG_WEBSOCKET_BENCH_PAYLOAD; i++) {
+        payload[i] = (uint8_t)i;
+    }
+    websocket_bench_run(client, "copy", false, payload);
+    websocket_bench_run(client, "iov", true, payload);
+    free(payload);
+}
+#endif
+
+#if CONFIG_WEBSOCKET_IDLE_PROBE_SEC
+static long voluntary_switches(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+}
+
+static void websocket_idle_probe(esp_websocket_client_handle_t client)
+{
+    // Only the client task is active during the idle window, so it dominates the switch count
+    s_measuring = true;
+    long before = voluntary_switches();
+    vTaskDelay(CONFIG_WEBSOCKET_IDLE_PROBE_SEC * 1000 / portTICK_PERIOD_MS);
+    long idle = voluntary_switches() - before;
+    ESP_LOGI(TAG, "[idle] %ld voluntary context switches in %d s (%.2f/s)", idle, CONFIG_WEBSOCKET_IDLE_PROBE_SEC,
+             (double)idle / CONFIG_WEBSOCKET_IDLE_PROBE_SEC);
+
+    int64_t worst = 0;
+    int64_t sum = 0;
+    int sent = 0;
+    for (int i = 0; i < CONFIG_WEBSOCKET_IDLE_PROBE_SEC; i++) {
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        int64_t start = esp_timer_get_time();
+        if (esp_websocket_client_send_text(client, "probe", 5, portMAX_DELAY) != 5) {
+            continue;
+        }
+        int64_t took = esp_timer_get_time() - start;
+        worst = took > worst ? took : worst;
+        sum += took;
+        sent++;
+    }
+    s_measuring = false;
+    ESP_LOGI(TAG, "[idle] send call: %d sent, avg %lld us, max %lld us", sent,
+             sent ? (long long)(sum / sent) : 0LL, (long long)worst);
+}
+#endif
+
+static void websocket_app_start(void)
+{
+    esp_websocket_client_config_t websocket_cfg = {};
+
+    websocket_cfg.uri = CONFIG_WEBSOCKET_URI;
+
+    ESP_LOGI(TAG, "Connecting to %s...", websocket_cfg.uri);
+
+    uint32_t heap_before_init = esp_get_free_heap_size();
+    esp_websocket_client_handle_t client = esp_websocket_client_init(&websocket_cfg);
+    ESP_LOGI(TAG, "Client init took %" PRIu32 " bytes of heap", heap_before_init - esp_get_free_heap_size());
+    esp_websocket_register_events(client, WEBSOCKET_EVENT_ANY, websocket_event_handler, (void *)client);
+
+    esp_websocket_client_start(client);
+    char data[32];
+    int i = 0;
+    while (i < 1) {
+        if (esp_websocket_client_is_connected(client)) {
+            int len = sprintf(data, "hello %04d", i++);
+            ESP_LOGI(TAG, "Sending %s", data);
+            esp_websocket_client_send_text(client, data, len, portMAX_DELAY);
+        }
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
+
+#if CONFIG_WEBSOCKET_BENCH_MESSAGES || CONFIG_WEBSOCKET_IDLE_PROBE_SEC
+    // Debug logging of every frame would dominate the measurements
+    esp_log_level_set("websocket_client", ESP_LOG_INFO);
+    esp_log_level_set("transport_ws", ESP_LOG_INFO);
+    esp_log_level_set("trans_tcp", ESP_LOG_INFO);
+#endif
+#if CONFIG_WEBSOCKET_BENCH_MESSAGES
+    websocket_bench(client);
+#endif
+#if CONFIG_WEBSOCKET_IDLE_PROBE_SEC
+    websocket_idle_probe(client);
+#endif
+
+    esp_websocket_client_destroy(client);
+}
+
+int main(void)
+{
+
+    ESP_LOGI(TAG, "[APP] Startup..");
+    ESP_LOGI(TAG, "[APP] Free memory: %" PRIu32 " bytes", esp_get_free_heap_size());
+    ESP_LOGI(TAG, "[APP] IDF version: %s", esp_get_idf_version());
+    esp_log_level_set("*", ESP_LOG_INFO);
+    esp_log_level_set("websocket_client", ESP_LOG_DEBUG);
+    esp_log_level_set("transport_ws", ESP_LOG_DEBUG);
+    esp_log_level_set("trans_tcp", ESP_LOG_DEBUG);
+
+    ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+
+    /* This helper function configures Wi-Fi or Ethernet, as selected in menuconfig.
+     * Read "Establishing Wi-Fi or Ethernet Connection" section in
+     * examples/protocols/README.md for more information about this function.
+     */
+    ESP_ERROR_CHECK(example_connect());
+
+    websocket_app_start();
+    return 0;
+}
@@ -9,6 +9,59 @@
 
 #define RESET_DELAY_MS 2000
 
+// Trigger edges closer than this to the previous accepted edge are bounce
+#ifndef TRIGGER_GLITCH_US
+#define TRIGGER_GLITCH_US 5000
+#endif
+
+// Laser bit period. Defaults to the protocol rate; the RMT transmitter can go
+// well below 1 ms once the receivers are built with the same value.
+#ifndef LASER_BIT_DURATION_US
+#define LASER_BIT_DURATION_US (BIT_DURATION_MS * 1000U)
+#endif
+
+// Idle time the receivers need between two frames. It is appended to every
+// frame, so back-to-back frames are spaced by exactly this gap.
+#ifndef LASER_FRAME_GAP_US
+#define LASER_FRAME_GAP_US (TRANSMISSION_PAUSE_MS * 1000U)
+#endif
+
+// Window over which game-state changes are merged into one WebSocket push
+#ifndef WS_PUBLISH_COALESCE_MS
+#define WS_PUBLISH_COALESCE_MS 20
+#endif
+
+// Full status is only sent when no delta went out for this long
+#ifndef WS_HEARTBEAT_IDLE_MS
+#define WS_HEARTBEAT_IDLE_MS 1000
+#endif
+
+// Fire-mode defaults until game config pushes its own (see fire_mode.h)
+#ifndef FIRE_MODE_DEFAULT
+#define FIRE_MODE_DEFAULT FIRE_MODE_SEMI
+#endif
+#ifndef FIRE_BURST_COUNT
+#define FIRE_BURST_COUNT 3
+#endif
+#ifndef FIRE_RATE_RPM
+#define FIRE_RATE_RPM 600
+#endif
+
+// Page shown after boot; "display hud|debug" switches at runtime
+#ifndef DM_DEFAULT_PAGE
+#define DM_DEFAULT_PAGE DM_PAGE_HUD
+#endif
+
+// Respawn delay as applied by game_state. game_sched checks for completion
+// once this long after the respawn starts.
+#ifndef GAME_RESPAWN_MS
+#define GAME_RESPAWN_MS 5000
+#endif
+// HUD countdown
+#ifndef DM_RESPAWN_COUNTDOWN_MS
+#define DM_RESPAWN_COUNTDOWN_MS GAME_RESPAWN_MS
+#endif
+
 // I2C pins for OLED display
 #define I2C_SDA_PIN 8
 #define I2C_SCL_PIN 9
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define DM_ROW_LEN 32
+#define DM_ROWS 3
+#define DM_HUD_BAR_CELLS 10
+
+    typedef enum
+    {
+        DM_PAGE_HUD = 0,
+        DM_PAGE_DEBUG,
+        DM_PAGE_COUNT
+    } dm_page_t;
+
+    // Typed game-state deltas pushed to the display instead of polled
+    typedef enum
+    {
+        DM_HUD_AMMO = 0,
+        DM_HUD_MAX_AMMO, // -1 for unlimited
+        DM_HUD_HEARTS,
+        DM_HUD_KILLS,
+        DM_HUD_DEATHS,
+        DM_HUD_HITS,
+        DM_HUD_RESPAWN, // 1 when respawning starts, 0 when done
+    } dm_hud_field_t;
+
+    typedef struct
+    {
+        int32_t ammo;
+        int32_t max_ammo;
+        uint32_t hearts;
+        uint32_t kills;
+        uint32_t deaths;
+        uint32_t hits;
+        uint32_t last_hit_ms;
+        bool respawning;
+        uint32_t respawn_until_ms;
+    } hud_model_t;
+
+    // Pure model and renderer, no LVGL or RTOS access
+    void hud_model_init(hud_model_t* m);
+
+    // Returns true when the delta changed the model.
+    bool hud_model_apply(hud_model_t* m, dm_hud_field_t field, int32_t value, uint32_t now_ms);
+
+    void hud_render(const hud_model_t* m, uint32_t now_ms, char rows[DM_ROWS][DM_ROW_LEN]);
+
+    // Milliseconds until the rendered text changes with time alone
+    // (respawn countdown), or UINT32_MAX if it only changes on a delta.
+    uint32_t hud_next_change_ms(const hud_model_t* m, uint32_t now_ms);
+
+    // Display manager side (display_manager.cpp)
+    bool display_manager_push(dm_hud_field_t field, int32_t value);
+    bool display_manager_set_page(dm_page_t page);
+
+    // Compare game state against what the display last received and push a
+    // delta for every field that changed. Cheap when nothing changed, so it
+    // may be called from every place that mutates game state.
+    void display_hud_sync(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,2 +1,7 @@
 #pragma once
+// Types and the base API are the shared component's; the weapon builds its
+// own implementation, src/display_manager.cpp, which adds the HUD page and
+// render stats below. The shared source is left out of both builds.
 #include "../../shared/include/display_manager.h"
+#include "display_hud.h"
+#include "display_stats.h"
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Display manager cost counters, rolled over once per second
+    typedef struct
+    {
+        uint32_t label_updates;
+        uint32_t label_skips;
+        uint32_t flush_bytes_per_s; // written to the panel by oled_flush, after its diff
+        uint32_t render_us_per_s; // time spent in the display task
+        uint32_t wakeups_per_s;
+    } dm_stats_t;
+
+    // Any task; fields are read one by one, so they may be an update apart
+    void display_manager_get_stats(dm_stats_t* out);
+
+#define DM_STATS_MAGIC 0xA9
+#define DM_STATS_VERSION 1
+#define DM_STATS_LEN 28
+
+    // Current stats as a binary message, all fields little-endian:
+    //   u8 magic, u8 version, u16 reserved, u32 uptime_ms, u32 label_updates,
+    //   u32 label_skips, u32 flush_bytes_per_s, u32 render_us_per_s,
+    //   u32 wakeups_per_s
+    // Returns the length, 0 if cap is below DM_STATS_LEN. This is the reply
+    // to the "display stats" WebSocket command.
+    size_t display_manager_encode_stats(uint8_t* buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "espnow_comm.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ESPNOW_DISPATCH_MAX_HANDLERS 8
+
+    typedef void (*espnow_handler_fn)(const EspnowMessageEnvelope* env, void* ctx);
+
+    // Register the handler for one message type. A later registration for the
+    // same type replaces the earlier one.
+    bool espnow_dispatch_register(uint8_t type, espnow_handler_fn fn, void* ctx);
+
+    // Route an envelope to its handler. Returns false if nobody handles the type.
+    bool espnow_dispatch(const EspnowMessageEnvelope* env);
+
+    uint32_t espnow_dispatch_unhandled(void);
+
+#ifdef __cplusplus
+}
+#endif
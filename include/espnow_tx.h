@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include "game_protocol.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Records per frame, capped at what fits ESP_NOW_MAX_DATA_LEN. Above 1 a
+// busy ring goes out as ESPNOW_SHOT_BATCH frames. No device firmware parses
+// those yet (only the simulator does), so the default sends every record on
+// its own; raise it only once every receiver unpacks batches.
+#ifndef ESPNOW_TX_MAX_BATCH
+#define ESPNOW_TX_MAX_BATCH 1
+#endif
+#ifndef ESPNOW_TX_RING_DEPTH
+#define ESPNOW_TX_RING_DEPTH 16
+#endif
+// While shots arrive faster than this apart, hold the first one for up to
+// ESPNOW_TX_COALESCE_US so followers share its frame.
+#ifndef ESPNOW_TX_BUSY_GAP_US
+#define ESPNOW_TX_BUSY_GAP_US 150000
+#endif
+#ifndef ESPNOW_TX_COALESCE_US
+#define ESPNOW_TX_COALESCE_US 20000
+#endif
+
+#define ESPNOW_SHOT_BATCH_MAGIC 0xB7
+
+    typedef struct __attribute__((packed))
+    {
+        uint8_t magic;
+        uint8_t count;
+        PlayerMessage msgs[];
+    } EspnowShotBatch;
+
+    typedef struct
+    {
+        uint32_t coalesce_us;
+        uint32_t busy_gap_us;
+        uint8_t max_batch;
+    } espnow_tx_policy_t;
+
+    // How long to hold a batch of `depth` queued records before sending.
+    // Pure: 0 when idle or the batch is full, coalesce_us under load.
+    uint32_t espnow_tx_hold_us(const espnow_tx_policy_t* policy, size_t depth, int64_t now_us,
+                               int64_t last_send_us);
+
+    // Sends count records as one frame. The default sends single records via
+    // espnow_comm_broadcast() and batches as ESPNOW_SHOT_BATCH frames.
+    typedef bool (*espnow_tx_transport_fn)(const PlayerMessage* msgs, uint8_t count, void* ctx);
+
+    typedef struct
+    {
+        uint32_t depth;
+        uint32_t depth_high_water;
+        uint32_t frames_sent;
+        uint32_t records_sent;
+        uint32_t max_batch_seen;
+        uint32_t send_failures;
+        uint32_t overflows;
+    } espnow_tx_stats_t;
+
+    bool espnow_tx_init(void);
+    void espnow_tx_set_transport(espnow_tx_transport_fn fn, void* ctx);
+
+    // Queue a record without blocking. Fails (and counts) when the ring is full.
+    // Records posted before the link is up wait in the ring.
+    bool espnow_tx_post(const PlayerMessage* msg);
+
+    // Called once ESP-NOW is initialised; until then espnow_tx_service() only
+    // waits, so nothing is handed to a transport that cannot send yet.
+    void espnow_tx_set_link_up(void);
+
+    // Wait up to timeout for the link and queued records, apply the batching
+    // policy and send one frame. Run by the ESP-NOW TX task.
+    bool espnow_tx_service(TickType_t timeout);
+
+    void espnow_tx_get_stats(espnow_tx_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Deferred binary event log. Hot paths push fixed-size records into a
+    // ring without taking a mutex (slots are claimed by compare-exchange, a
+    // short critical section on the C3, which has no atomic instructions);
+    // evlog_task formats and prints them at low priority.
+
+    typedef enum
+    {
+        EVLOG_TAG_SHOT = 0,
+        EVLOG_TAG_LASER,
+        EVLOG_TAG_ESPNOW,
+        EVLOG_TAG_WS,
+        EVLOG_TAG_COUNT
+    } evlog_tag_t;
+
+    typedef enum
+    {
+        EVLOG_LEVEL_ERROR = 1,
+        EVLOG_LEVEL_WARN,
+        EVLOG_LEVEL_INFO,
+        EVLOG_LEVEL_DEBUG
+    } evlog_level_t;
+
+    typedef enum
+    {
+        EVLOG_SHOT_FIRED = 0,     // a = laser word, b = shots fired
+        EVLOG_SHOT_QUEUE_FULL,    // a = laser word
+        EVLOG_SHOT_ESPNOW_FAILED, // a = laser word (TX ring full)
+    } evlog_code_t;
+
+    typedef struct
+    {
+        uint32_t t_ms;
+        uint8_t tag;
+        uint8_t level;
+        uint16_t code;
+        uint32_t a;
+        uint32_t b;
+    } evlog_record_t;
+
+// Compile-time filters: records above EVLOG_MAX_LEVEL or for a tag whose bit
+// is clear in EVLOG_TAG_MASK compile to nothing.
+#ifndef EVLOG_MAX_LEVEL
+#define EVLOG_MAX_LEVEL EVLOG_LEVEL_INFO
+#endif
+#ifndef EVLOG_TAG_MASK
+#define EVLOG_TAG_MASK 0xFFFFFFFFu
+#endif
+
+#define EVLOG_ENABLED(tag, level) ((((EVLOG_TAG_MASK) >> (tag)) & 1u) && (level) <= (EVLOG_MAX_LEVEL))
+
+#define EVLOG(tag, level, code, a, b)                                                                        \
+    do                                                                                                       \
+    {                                                                                                        \
+        if (EVLOG_ENABLED(tag, level))                                                                       \
+            evlog_push((tag), (level), (code), (uint32_t)(a), (uint32_t)(b));                                \
+    } while (0)
+
+    // Never blocks or allocates. Returns false and counts a drop when full.
+    bool evlog_push(uint8_t tag, uint8_t level, uint16_t code, uint32_t a, uint32_t b);
+    uint32_t evlog_dropped(void);
+
+    // Oldest record, false when empty. Single consumer: evlog_task owns this
+    // on the device, host tests drain the ring directly.
+    bool evlog_pop(evlog_record_t* out);
+
+    void evlog_task(void* pvParameters);
+
+#ifdef __cplusplus
+}
+#endif
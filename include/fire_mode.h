@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        FIRE_MODE_SEMI = 0,
+        FIRE_MODE_BURST,
+        FIRE_MODE_AUTO
+    } fire_mode_t;
+
+    typedef struct
+    {
+        fire_mode_t mode;
+        uint8_t burst_count;
+        uint16_t rounds_per_minute;
+    } fire_mode_config_t;
+
+    // Fire-mode engine: turns trigger presses/releases into shot times. Pure,
+    // all times in microseconds from the same clock as the trigger events.
+    typedef struct
+    {
+        fire_mode_config_t cfg;
+        uint32_t interval_us;
+        uint32_t min_interval_us;
+        bool held;
+        uint8_t shots_left;
+        int64_t next_shot_us;
+    } fire_engine_t;
+
+    // min_interval_us is the protocol floor (frame time + inter-frame gap);
+    // the configured rate is clamped to it.
+    void fire_engine_init(fire_engine_t* e, const fire_mode_config_t* cfg, uint32_t min_interval_us);
+    void fire_engine_press(fire_engine_t* e, int64_t t_us);
+    void fire_engine_release(fire_engine_t* e, int64_t t_us);
+    void fire_engine_cancel(fire_engine_t* e);
+
+    // True when a shot is due at now_us. *wake_us receives the time the engine
+    // next needs attention, or -1 when it is idle until the next press.
+    bool fire_engine_due(const fire_engine_t* e, int64_t now_us, int64_t* wake_us);
+
+    // Record that the due shot was fired at t_us.
+    void fire_engine_fired(fire_engine_t* e, int64_t t_us);
+
+    // Active fire-mode configuration. The shared GameConfig has no fire-mode
+    // fields, so it is set at runtime with the "fire" WebSocket command; the
+    // control task picks up a new generation before its next shot.
+    void fire_mode_set_config(const fire_mode_config_t* cfg);
+    uint32_t fire_mode_get_config(fire_mode_config_t* out);
+    uint32_t fire_mode_generation(void);
+
+    // "fire <semi|burst|auto> [burst_count] [rpm]" onto base; omitted values
+    // keep base's. False on an unknown mode or a zero count or rate.
+    bool fire_mode_parse(const char* args, const fire_mode_config_t* base, fire_mode_config_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Game timers on esp_timer. Timer callbacks only record which event fired;
+    // subscribers are called from the bound task (game_task), once per firing.
+    typedef enum
+    {
+        GAME_EVT_RESPAWN_STARTED = 0,
+        GAME_EVT_RESPAWN_DONE,
+        GAME_EVT_INVULN_END,
+        GAME_EVT_MODE_END,
+        GAME_EVT_TICK,
+        GAME_EVT_COUNT
+    } game_evt_t;
+
+#define GAME_SCHED_MAX_SUBSCRIBERS 6
+
+    // Respawn completion is checked once at GAME_RESPAWN_MS (config.h). If
+    // game_state is not done yet, it is checked again after a backoff that
+    // doubles from the first to the last value.
+#ifndef GAME_SCHED_RESPAWN_RETRY_US
+#define GAME_SCHED_RESPAWN_RETRY_US 1000
+#endif
+#ifndef GAME_SCHED_RESPAWN_RETRY_MAX_US
+#define GAME_SCHED_RESPAWN_RETRY_MAX_US 100000
+#endif
+
+    typedef void (*game_sched_cb)(game_evt_t evt, void* ctx);
+
+    bool game_sched_init(void);
+
+    // Make the calling task the one that runs subscriber callbacks.
+    void game_sched_bind(void);
+
+    bool game_sched_subscribe(game_sched_cb cb, void* ctx);
+
+    // One-shot timer for the timed events (invulnerability, mode end).
+    // Re-arming an event restarts it.
+    bool game_sched_after(game_evt_t evt, uint32_t delay_ms);
+    bool game_sched_every(game_evt_t evt, uint32_t period_ms);
+    void game_sched_cancel(game_evt_t evt);
+
+    // Start watching for respawn completion if game_state is respawning. The
+    // deadline is GAME_RESPAWN_MS after began_us (esp_timer time of the death),
+    // however late the watch is armed. Posts GAME_EVT_RESPAWN_STARTED once per
+    // respawn; safe to call repeatedly from any task. The hit handler arms it
+    // with the time it took the hit; game_snapshot_publish() arms it with the
+    // time it first sees a respawn that began inside game_state.
+    void game_sched_respawn_watch(int64_t began_us);
+
+    // Duration of the last completed respawn, from began_us to completion
+    uint32_t game_sched_last_respawn_us(void);
+
+    // Block up to timeout for events, then deliver them to subscribers.
+    void game_sched_service(TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
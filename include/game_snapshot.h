@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "game_state.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Consistent copy of game state and config. Readers never block and never
+    // see a half-written snapshot; publishing is short and serialized, so any
+    // task may publish after mutating game state.
+    typedef struct
+    {
+        GameStateData state;
+        DeviceConfig config;
+        GameConfig game;
+        bool respawning;
+        uint32_t generation;        // bumps on every publish
+        uint32_t config_generation; // bumps only when config or game config changed
+    } game_snapshot_t;
+
+    // Copy the current game_state into the snapshot. Call after mutating game
+    // state; group related mutations before one publish so readers never see
+    // half of them. Returns true if any published field differs from the
+    // previous snapshot.
+    bool game_snapshot_publish(void);
+
+    // Torn-free copy of the latest snapshot. Copies with plain loads and never
+    // waits on the writer, only retries while a publish is in flight; the
+    // read counters are the one critical section on the C3.
+    void game_snapshot_read(game_snapshot_t* out);
+
+    uint32_t game_snapshot_generation(void);
+    uint32_t game_snapshot_config_generation(void);
+
+    // Reader and retry counters for profiling
+    typedef struct
+    {
+        uint32_t publishes;
+        uint32_t reads;
+        uint32_t read_retries;
+    } game_snapshot_stats_t;
+
+    void game_snapshot_get_stats(game_snapshot_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
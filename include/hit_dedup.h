@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Number of recent hit events remembered. Must be a power of two <= 128.
+#ifndef HIT_DEDUP_WINDOW
+#define HIT_DEDUP_WINDOW 64
+#endif
+// A repeat older than this counts as a new event
+#ifndef HIT_DEDUP_TTL_MS
+#define HIT_DEDUP_TTL_MS 2000
+#endif
+
+#define HIT_DEDUP_SLOTS (HIT_DEDUP_WINDOW * 2)
+
+    typedef struct
+    {
+        uint8_t mac[6];
+        uint32_t timestamp_ms;
+        uint32_t data;
+    } hit_key_t;
+
+    // Sliding-window duplicate filter keyed by (source MAC, timestamp, data).
+    // The last HIT_DEDUP_WINDOW keys live in a ring; a linear-probing index
+    // over the ring gives O(1) lookup with fixed memory. Pure, no locking.
+    typedef struct
+    {
+        hit_key_t keys[HIT_DEDUP_WINDOW];
+        uint32_t seen_ms[HIT_DEDUP_WINDOW];
+        uint8_t home[HIT_DEDUP_WINDOW];
+        uint8_t index[HIT_DEDUP_SLOTS]; // ring position + 1, 0 = empty
+        uint8_t next;
+        uint8_t used;
+        uint32_t accepted;
+        uint32_t duplicates;
+    } hit_dedup_t;
+
+    void hit_dedup_init(hit_dedup_t* d);
+
+    // Returns true for a new event (and remembers it), false for a duplicate.
+    bool hit_dedup_check(hit_dedup_t* d, const uint8_t mac[6], uint32_t timestamp_ms, uint32_t data, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // One run of constant laser level. Consecutive equal bits are merged, so a
+    // frame never needs more than one symbol per bit plus the trailing gap.
+    typedef struct
+    {
+        uint32_t duration_us;
+        uint8_t level;
+    } laser_symbol_t;
+
+#define LASER_FRAME_MAX_SYMBOLS (MESSAGE_TOTAL_BITS + 1)
+
+    typedef struct
+    {
+        laser_symbol_t symbols[LASER_FRAME_MAX_SYMBOLS];
+        uint8_t count;
+        uint32_t message;
+        uint32_t total_us;
+    } laser_frame_t;
+
+    // Encode a laser word MSB first, bit_us per bit, followed by gap_us of
+    // idle. Pure, no hardware access.
+    void laser_frame_encode(laser_frame_t* frame, uint32_t message, uint32_t bit_us, uint32_t gap_us);
+
+    // Cut the frame's runs into pieces of at most max_us, in order, for a
+    // transmitter with a narrow duration field. An odd count is made even by
+    // halving the last piece, so pieces pair up into RMT words. Returns the
+    // count, 0 if cap is too small or the last piece cannot be halved.
+    size_t laser_frame_split(const laser_frame_t* frame, uint32_t max_us, laser_symbol_t* out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include "laser_frame.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Frames the transmitter holds at once; laser_tx_send blocks while all are
+// queued. The host backend models the same limit.
+#define LASER_TX_QUEUE_DEPTH 3
+
+    // Laser transmitter engine. Frames are played out by the RMT peripheral on
+    // the device (or recorded by the host backend), so no task runs per bit.
+    // gap_us of idle is appended to every frame, so queued frames play out
+    // back to back at exactly the protocol spacing.
+    bool laser_tx_init(int gpio_num, uint32_t bit_us, uint32_t gap_us);
+
+    // Queue a frame for transmission. The frame is copied, so the caller may
+    // reuse it immediately. Blocks up to timeout while every hardware slot is
+    // queued.
+    bool laser_tx_send(const laser_frame_t* frame, TickType_t timeout);
+
+    // Wait until every queued frame has left the pin.
+    bool laser_tx_wait_idle(TickType_t timeout);
+
+    uint32_t laser_tx_bit_us(void);
+    uint32_t laser_tx_gap_us(void);
+
+    // Shortest possible start-to-start spacing of two frames
+    uint32_t laser_tx_frame_interval_us(void);
+
+    // esp_timer time at which the most recently sent frame puts its first
+    // edge on the pin: right away on an idle channel, else when the frames
+    // queued ahead of it finish.
+    int64_t laser_tx_last_start_us(void);
+
+#ifndef ESP_PLATFORM
+    // Host backend: every level change is recorded with its timestamp.
+    typedef struct
+    {
+        int64_t t_us;
+        uint8_t level;
+    } laser_edge_t;
+
+    // Time source for the recorder; defaults to a monotonic host clock.
+    void laser_tx_host_set_clock(int64_t (*now_us)(void));
+    const laser_edge_t* laser_tx_host_edges(size_t* count);
+    void laser_tx_host_clear(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Trigger-to-photon instrumentation. With LATENCY_BENCH=0 the control and
+// laser tasks take no stamps and nothing here is called.
+#ifndef LATENCY_BENCH
+#define LATENCY_BENCH 0
+#endif
+// Most recent shots kept per stage
+#ifndef LATENCY_BENCH_SAMPLES
+#define LATENCY_BENCH_SAMPLES 256
+#endif
+// Trigger pulls made by the bench driver on the device
+#ifndef LATENCY_BENCH_SHOTS
+#define LATENCY_BENCH_SHOTS 200
+#endif
+
+    // Stages of one shot, each ending where the next begins:
+    // trigger edge (ISR) -> control_task decides to fire -> word is in
+    // laserMessageQueue -> laser_task has it -> frame handed to laser_tx ->
+    // first laser edge. Burst and auto follow-ups start at their due time.
+    typedef enum
+    {
+        LB_STAGE_WAKE = 0, // edge to control_task
+        LB_STAGE_CONTROL,  // shot cache and checks
+        LB_STAGE_QUEUE,    // through laserMessageQueue to laser_task
+        LB_STAGE_ENCODE,   // frame lookup and laser_tx_send()
+        LB_STAGE_TX,       // handoff to the first edge on the pin
+        LB_STAGE_TOTAL,    // edge to first laser edge
+        LB_STAGE_COUNT
+    } lb_stage_t;
+
+    typedef struct
+    {
+        uint32_t p50_us;
+        uint32_t p99_us;
+        uint32_t max_us;
+    } lb_stat_t;
+
+    typedef struct
+    {
+        lb_stat_t stage[LB_STAGE_COUNT];
+        uint32_t shots;     // samples behind the percentiles
+        uint32_t unmatched; // stamps that could not be paired up
+    } lb_report_t;
+
+    // Hot-path stamps, all esp_timer_get_time() microseconds. control_task
+    // calls queued() right before it puts the word into laserMessageQueue and
+    // cancel() if that fails; laser_task calls sent() for the word it took.
+    // The queue is FIFO so they pair up in order. photon_us < 0 marks a frame
+    // laser_tx refused. Single producer and single consumer without a mutex;
+    // its atomic counter updates are short critical sections on the C3.
+    void latency_bench_queued(uint32_t word, int64_t edge_us, int64_t decide_us, int64_t queued_us);
+    void latency_bench_cancel(void);
+    void latency_bench_sent(uint32_t word, int64_t dequeued_us, int64_t handoff_us, int64_t photon_us);
+
+    // Drop all samples. Call while no shot is in flight.
+    void latency_bench_reset(void);
+
+    // Percentiles over the kept samples. Call while no shot is in flight.
+    void latency_bench_report(lb_report_t* out);
+
+    const char* latency_bench_stage_name(lb_stage_t stage);
+
+    // Baseline text, also what latency_bench_format() writes:
+    //   <stage> <p50_us> <p99_us> <max_us>
+    // one line per stage, '#' starts a comment. An optional
+    //   tolerance <pct> <slack_us> <max_pct>
+    // line sets the allowed growth: p50 and p99 may exceed the baseline by
+    // pct percent plus slack_us, max by max_pct percent plus slack_us.
+    typedef struct
+    {
+        lb_stat_t stage[LB_STAGE_COUNT];
+        bool present[LB_STAGE_COUNT];
+        uint32_t tolerance_pct;
+        uint32_t slack_us;
+        uint32_t max_tolerance_pct;
+    } lb_baseline_t;
+
+    size_t latency_bench_format(const lb_report_t* report, char* buf, size_t cap);
+    bool latency_bench_parse_baseline(const char* text, lb_baseline_t* out);
+
+    // Logs every metric above its limit and returns how many there were.
+    int latency_bench_compare(const lb_report_t* report, const lb_baseline_t* baseline);
+
+    // Bench driver: pulls the trigger `shots` times through the trigger pin in
+    // open-drain mode, so the edges take the real ISR path, then prints the
+    // report and checks it against the baseline when one is set.
+    typedef struct
+    {
+        uint32_t shots;    // 0 leaves the driver off
+        uint32_t press_ms; // trigger held
+        uint32_t gap_ms;   // released between pulls, 0 picks frame time + 50 ms
+        const char* baseline;
+        void (*done)(const lb_report_t* report, int regressions);
+    } latency_bench_cfg_t;
+
+    // Before latency_bench_start(); the device default runs LATENCY_BENCH_SHOTS
+    // pulls against the baseline embedded at build time, if any.
+    void latency_bench_configure(const latency_bench_cfg_t* cfg);
+    bool latency_bench_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <lvgl.h>
+#include "ssd1306_diff.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Take over the display's flush path: LVGL areas are merged into a full
+    // page-layout framebuffer and only the bytes that changed since the last
+    // flush are written to the SSD1306. Expects the display to render in
+    // SSD1306 page layout (set_px_cb plus 8-row rounder), as init_display sets up.
+    bool oled_flush_attach(lv_disp_t* disp);
+
+    // Transfer counters since attach
+    void oled_flush_get_stats(uint32_t* bytes_sent, uint32_t* transactions);
+
+#ifdef __cplusplus
+}
+#endif
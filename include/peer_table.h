@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef PEER_TABLE_CAPACITY
+#define PEER_TABLE_CAPACITY 256
+#endif
+// Open-addressing slots, kept at most half full. Power of two.
+#define PEER_TABLE_SLOTS (PEER_TABLE_CAPACITY * 2)
+// Ids of a peer known only by MAC, until it is heard from
+#define PEER_ID_UNKNOWN 0xFF
+
+    typedef struct
+    {
+        uint8_t mac[6];
+        uint8_t player_id;
+        uint8_t device_id;
+        uint8_t team_id;
+    } peer_info_t;
+
+    typedef struct
+    {
+        peer_info_t entries[PEER_TABLE_SLOTS];
+        uint8_t used[PEER_TABLE_SLOTS];
+        uint16_t count;
+    } peer_map_t;
+
+    // Fixed-capacity MAC -> peer map (linear probing, backward-shift delete).
+    // Pure, no locking; the peer_table_* functions below wrap one instance.
+    void peer_map_clear(peer_map_t* m);
+    bool peer_map_put(peer_map_t* m, const peer_info_t* peer);
+    bool peer_map_remove(peer_map_t* m, const uint8_t mac[6]);
+    const peer_info_t* peer_map_find(const peer_map_t* m, const uint8_t mac[6]);
+
+    // Versioned binary blob: header followed by packed peer_info_t records.
+    size_t peer_map_serialize(const peer_map_t* m, uint8_t* out, size_t cap);
+    bool peer_map_deserialize(peer_map_t* m, const uint8_t* blob, size_t len);
+
+    bool peer_table_parse_mac(const char* text, uint8_t mac[6]);
+
+    // The device peer table, persisted as a blob in NVS. Safe to use from
+    // any task. Loads the blob, then applies the legacy CSV peer list: it
+    // still registers the radio peers on every boot, and MACs missing from
+    // the table are added with PEER_ID_UNKNOWN ids. Removing a MAC from the
+    // CSV does not remove it from the table; use peer_del.
+    void peer_table_load(void);
+    bool peer_table_put(const peer_info_t* peer);
+    bool peer_table_remove(const uint8_t mac[6]);
+    bool peer_table_find(const uint8_t mac[6], peer_info_t* out);
+    size_t peer_table_count(void);
+    bool peer_table_save(void);
+
+    // Fills in the ids of a peer added with PEER_ID_UNKNOWN from a frame it
+    // sent about itself, and saves the table. Peers with ids are left alone.
+    // Returns true if the entry changed.
+    bool peer_table_learn(const uint8_t mac[6], uint8_t player_id, uint8_t device_id, uint8_t team_id);
+
+    // Registers the peer_add / peer_del WebSocket commands
+    void peer_table_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Fixed-memory registry of counters, gauges and latency histograms.
+    // Recording is a handful of relaxed atomic updates, safe from any task but
+    // not lock-free on the C3: it has no atomic instructions, so every
+    // fetch_add or compare-exchange is a few-cycle critical section with
+    // interrupts masked. The snapshot reads each value on its own, so fields
+    // may be one update apart.
+
+    typedef enum
+    {
+        PERF_CTR_SHOTS = 0,      // words put into laserMessageQueue
+        PERF_CTR_LASER_STALLS,   // laserMessageQueue full, shot retried
+        PERF_CTR_LASER_DROPPED,  // frames laser_tx refused
+        PERF_CTR_ESPNOW_FRAMES,  // shot frames handed to the radio
+        PERF_CTR_ESPNOW_FAILED,
+        PERF_CTR_WS_FRAMES,      // frames fully written to a client socket
+        PERF_CTR_WS_EVICTIONS,
+        PERF_CTR_DISPLAY_RENDERS,
+        PERF_CTR_COUNT
+    } perf_counter_t;
+
+    typedef enum
+    {
+        PERF_GAUGE_LASER_QUEUE = 0, // words left behind the one just taken
+        PERF_GAUGE_ESPNOW_QUEUE,    // records left in the TX ring after a send
+        PERF_GAUGE_WS_CLIENTS,
+        PERF_GAUGE_FREE_HEAP,       // sampled when a snapshot is taken
+        PERF_GAUGE_MIN_FREE_HEAP,
+        PERF_GAUGE_COUNT
+    } perf_gauge_t;
+
+    typedef enum
+    {
+        PERF_HIST_SHOT_ENCODE = 0, // laser_task: frame lookup or encode
+        PERF_HIST_LASER_QUEUE,     // control_task send to laser_task receive
+        PERF_HIST_ESPNOW_SEND,     // one transport call
+        PERF_HIST_WS_SEND,         // one non-blocking socket send
+        PERF_HIST_DISPLAY_RENDER,  // one display_manager pass incl. LVGL
+        PERF_HIST_COUNT
+    } perf_hist_t;
+
+// Bucket 0 holds 0 us, bucket k (1..N-2) holds [2^(k-1), 2^k) us and the last
+// bucket everything from 2^(N-2) us up: 262 ms with the default 20.
+#ifndef PERF_HIST_BUCKETS
+#define PERF_HIST_BUCKETS 20
+#endif
+
+#define PERF_SNAPSHOT_MAGIC 0xA7
+#define PERF_SNAPSHOT_VERSION 1
+#define PERF_SNAPSHOT_HEADER_LEN 12
+#define PERF_SNAPSHOT_LEN                                                                                    \
+    (PERF_SNAPSHOT_HEADER_LEN + 4 * (PERF_CTR_COUNT + PERF_GAUGE_COUNT) +                                   \
+     PERF_HIST_COUNT * 4 * (3 + PERF_HIST_BUCKETS))
+
+    void perf_count(perf_counter_t ctr, uint32_t n);
+    void perf_gauge_set(perf_gauge_t gauge, int32_t value);
+    void perf_hist_record(perf_hist_t hist, uint32_t us);
+
+    // Snapshot, all fields little-endian:
+    //   u8 magic, u8 version, u8 counters, u8 gauges, u8 histograms,
+    //   u8 buckets, u16 reserved, u32 uptime_ms,
+    //   u32 counter[counters], i32 gauge[gauges],
+    //   histograms x { u32 count, u32 sum_us, u32 max_us, u32 bucket[buckets] }
+    // in the order of the enums above. Everything counts from boot and wraps
+    // at 2^32; readers chart the difference between two snapshots.
+    // Returns the length, 0 if cap is below PERF_SNAPSHOT_LEN.
+    size_t perf_metrics_snapshot(uint8_t* buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "game_protocol.h"
+#include "laser_frame.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Everything a trigger pull needs, built once per identity instead of per
+    // shot. The hot path only patches shot.timestamp_ms and dispatches.
+    typedef struct
+    {
+        uint32_t laser_word;
+        PlayerMessage shot;
+        laser_frame_t frame;
+        uint8_t player_id;
+        uint8_t device_id;
+        uint8_t team_id;
+        uint32_t color_rgb;
+    } armed_shot_t;
+
+    // Return the armed shot for the current DeviceConfig, rebuilding it only
+    // when the snapshot's config generation moved. Call from the control task
+    // only.
+    const armed_shot_t* shot_cache_arm(void);
+
+    // Copy the prebuilt laser frame if it matches laser_word. Any task.
+    bool shot_cache_copy_frame(uint32_t laser_word, laser_frame_t* out);
+
+    void shot_cache_invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
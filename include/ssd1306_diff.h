@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SSD1306_PAGES (OLED_HEIGHT / 8)
+#define SSD1306_FB_SIZE (OLED_WIDTH * SSD1306_PAGES)
+
+// Bytes a separate transfer costs beyond its pixel data (address window
+// command plus data control byte and I2C address bytes). Changed spans closer
+// than this are merged.
+#define SSD1306_SPAN_OVERHEAD 10
+
+    // One I2C write to the panel; data starts with the SSD1306 control byte
+    typedef struct
+    {
+        bool (*write)(void* ctx, const uint8_t* data, size_t len);
+        void* ctx;
+    } ssd1306_bus_t;
+
+    // Shadow-framebuffer flusher. Framebuffers use the panel's page layout:
+    // byte [page * OLED_WIDTH + x], bit n is row page * 8 + n.
+    typedef struct
+    {
+        uint8_t shadow[SSD1306_FB_SIZE];
+        bool valid;
+        ssd1306_bus_t bus;
+        uint32_t bytes_sent;
+        uint32_t transactions;
+    } ssd1306_diff_t;
+
+    // Switches the panel to horizontal addressing so one window write can
+    // cover several pages.
+    bool ssd1306_diff_init(ssd1306_diff_t* d, const ssd1306_bus_t* bus);
+
+    // Transmit only the spans of fb that differ from what the panel shows.
+    // Returns the payload bytes written. The shadow follows only writes the
+    // bus accepted; after a failed data write the panel contents are unknown
+    // and the next flush resends the whole frame.
+    size_t ssd1306_diff_flush(ssd1306_diff_t* d, const uint8_t* fb);
+
+    // Force the next flush to resend the whole frame
+    void ssd1306_diff_invalidate(ssd1306_diff_t* d);
+
+#ifndef ESP_PLATFORM
+    // Host mock bus: counts transactions and bytes, including the I2C address
+    // byte, and keeps the panel's GDDRAM as the writes leave it
+    typedef struct
+    {
+        uint32_t transactions;
+        uint32_t bytes;
+        uint8_t panel[SSD1306_FB_SIZE];
+        uint8_t c0, c1, p0, p1; // address window
+        uint8_t col, page;      // write pointer
+        // Transaction number to fail (0 = none). A failed data write still
+        // lands its first half, as an aborted I2C transfer would.
+        uint32_t fail_at;
+    } ssd1306_mock_bus_t;
+
+    ssd1306_bus_t ssd1306_mock_bus(ssd1306_mock_bus_t* mock);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Game-state change notifications. Producers mark what changed; a single
+    // consumer (the WebSocket task) collects the marks in coalesced batches so
+    // a burst of changes produces one push instead of one per change.
+    typedef enum
+    {
+        STATE_DIRTY_SHOT = 1 << 0,
+        STATE_DIRTY_HIT = 1 << 1,
+        STATE_DIRTY_RESPAWN = 1 << 2,
+        STATE_DIRTY_CONFIG = 1 << 3,
+        STATE_DIRTY_CLIENT = 1 << 4, // a client connected and needs a full state
+        STATE_DIRTY_OTHER = 1 << 5,  // changed inside game_state itself
+        STATE_DIRTY_REPLY = 1 << 6,  // a client waits for a one-off reply
+    } state_dirty_t;
+
+#define STATE_DIRTY_GAME (STATE_DIRTY_SHOT | STATE_DIRTY_HIT | STATE_DIRTY_RESPAWN | STATE_DIRTY_CONFIG | STATE_DIRTY_OTHER)
+
+    // Make the calling task the consumer.
+    void state_publisher_bind(void);
+
+    // Never blocks. Safe to call before a consumer is bound.
+    void state_publisher_mark(uint32_t bits);
+
+    // Block up to timeout for the first mark, then keep collecting for the
+    // coalesce window. Returns the accumulated bits (0 on timeout).
+    uint32_t state_publisher_wait(TickType_t timeout, TickType_t coalesce);
+
+    // esp_timer time of the first mark in the batch last returned by wait(),
+    // for change-to-wire latency
+    int64_t state_publisher_batch_start_us(void);
+
+#ifdef __cplusplus
+}
+#endif
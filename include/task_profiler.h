@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Per-task CPU share and stack headroom, sampled from the kernel's run-time
+// stats every TASK_PROFILER_PERIOD_MS on the esp_timer task. CPU needs
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS; without it only stacks are known.
+#ifndef TASK_PROFILER_PERIOD_MS
+#define TASK_PROFILER_PERIOD_MS 5000
+#endif
+// Tasks listed per report. Every task is sampled; beyond this many the rest
+// are only counted and the report is marked truncated.
+#ifndef TASK_PROFILER_MAX_TASKS
+#define TASK_PROFILER_MAX_TASKS 24
+#endif
+#define TASK_PROFILER_NAME_LEN 16
+#define TASK_PROFILER_CPU_UNKNOWN 0xFFFF
+
+    typedef struct
+    {
+        char name[TASK_PROFILER_NAME_LEN];
+        uint16_t cpu_bp;     // share of the last period in 1/100 %
+        uint8_t priority;    // current, so inheritance shows
+        uint8_t state;       // eTaskState
+        uint32_t stack_free; // fewest bytes ever left on the stack
+    } task_prof_entry_t;
+
+    typedef struct
+    {
+        uint32_t uptime_ms; // when the sample was taken
+        uint32_t period;    // run-time counter ticks in the period, us on ESP-IDF
+        uint8_t count;      // tasks listed
+        uint8_t total;      // tasks in the system, saturating at 255
+        bool truncated;     // total > count, the first count are listed
+        task_prof_entry_t tasks[TASK_PROFILER_MAX_TASKS];
+    } task_prof_report_t;
+
+    bool task_profiler_start(void);
+
+    // Latest sample; count is 0 until the first period has passed.
+    void task_profiler_get(task_prof_report_t* out);
+
+#define TASK_PROF_MAGIC 0xA8
+#define TASK_PROF_VERSION 2
+#define TASK_PROF_HEADER_LEN 14
+#define TASK_PROF_FLAG_TRUNCATED 0x01
+#define TASK_PROF_ENTRY_LEN (TASK_PROFILER_NAME_LEN + 8)
+#define TASK_PROF_MAX_LEN (TASK_PROF_HEADER_LEN + TASK_PROFILER_MAX_TASKS * TASK_PROF_ENTRY_LEN)
+
+    // Latest sample as a binary message, all fields little-endian:
+    //   u8 magic, u8 version, u8 count, u8 name_len, u32 uptime_ms,
+    //   u32 period, u8 total, u8 flags (TASK_PROF_FLAG_*),
+    //   then count x { char name[name_len] (NUL padded),
+    //   u16 cpu_bp, u8 priority, u8 state, u32 stack_free }
+    // Returns the length, 0 if cap is too small.
+    size_t task_profiler_encode(uint8_t* buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
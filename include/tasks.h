@@ -1,15 +1,25 @@
 #pragma once
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    // laserMessageQueue item
+    typedef struct
+    {
+        uint32_t word;
+        uint32_t queued_us; // low bits of esp_timer_get_time(), for the queue wait
+    } laser_msg_t;
+
     void control_task(void* pvParameters);
     void laser_task(void* pvParameters);
     void ws_task(void* pvParameters);
     void game_task(void* pvParameters);
     void espnow_task(void* pvParameters);
+    void espnow_tx_task(void* pvParameters);
     void wifi_task(void* pvParameters);
 
 #ifdef __cplusplus
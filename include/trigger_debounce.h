@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        TRIGGER_EVT_NONE = 0,
+        TRIGGER_EVT_PRESS,
+        TRIGGER_EVT_RELEASE
+    } trigger_evt_type_t;
+
+    typedef struct
+    {
+        trigger_evt_type_t type;
+        int64_t t_us;
+    } trigger_event_t;
+
+    // Leading-edge debouncer: the first edge that changes state is reported
+    // immediately, further edges inside glitch_us are treated as bounce. If the
+    // contact settles on the other level during that window, settle() reports
+    // the late transition once the window has passed. Pure, no hardware access.
+    typedef struct
+    {
+        uint32_t glitch_us;
+        bool pressed;
+        bool raw;
+        int64_t last_edge_us;
+        int64_t press_us;
+        int64_t release_us;
+    } trigger_debounce_t;
+
+    void trigger_debounce_init(trigger_debounce_t* d, uint32_t glitch_us, bool pressed, int64_t now_us);
+
+    // Feed a raw level change. Safe to call from an ISR.
+    trigger_evt_type_t trigger_debounce_edge(trigger_debounce_t* d, bool pressed, int64_t t_us);
+
+    // Resolve a level that changed inside the glitch window without a further edge.
+    trigger_evt_type_t trigger_debounce_settle(trigger_debounce_t* d, int64_t now_us);
+
+    // Time at which settle() must run, or -1 when raw and debounced level agree.
+    int64_t trigger_debounce_deadline(const trigger_debounce_t* d);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include "trigger_debounce.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Arm the trigger GPIO interrupt. Events are delivered to the calling
+    // task through its task notification.
+    bool trigger_input_init(uint32_t glitch_us);
+
+    // Block until the next debounced trigger event or timeout. Only the task
+    // that called trigger_input_init() may wait.
+    bool trigger_input_wait(trigger_event_t* evt, TickType_t timeout);
+
+    bool trigger_input_is_pressed(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "game_snapshot.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Wire encodings for the messages this device pushes itself. Both write
+    // into the caller's buffer and never allocate; MessagePack maps use the
+    // same keys as the JSON objects.
+    typedef enum
+    {
+        WS_FMT_JSON = 0,
+        WS_FMT_MSGPACK,
+        WS_FMT_COUNT
+    } ws_fmt_t;
+
+#define WS_CODEC_MAX_LEN 192
+
+    typedef enum
+    {
+        WS_EVT_SHOT = 0,
+        WS_EVT_HIT,
+    } ws_event_type_t;
+
+    // Hot-path events, one message each (never coalesced)
+    typedef struct
+    {
+        uint8_t type; // ws_event_type_t
+        uint8_t player_id;
+        uint8_t device_id;
+        uint8_t team_id;
+        int16_t victim; // player hit, -1 if unknown or a shot
+        uint32_t data;
+        uint32_t ts_ms;
+    } ws_event_t;
+
+    // Fields of cur that differ from prev; with no prev (a client's first
+    // frame) every field is sent
+    typedef struct
+    {
+        const game_snapshot_t* prev;
+        const game_snapshot_t* cur;
+    } ws_delta_t;
+
+    // Bit per delta field that differs; 0 means there is nothing to send
+    uint32_t ws_codec_delta_fields(const ws_delta_t* delta);
+
+    // All return the encoded length, 0 if nothing to send or it did not fit.
+    size_t ws_codec_event(ws_fmt_t fmt, const ws_event_t* evt, uint8_t* buf, size_t cap);
+    size_t ws_codec_delta(ws_fmt_t fmt, const ws_delta_t* delta, uint8_t* buf, size_t cap);
+
+    // Exactly "json" or "msgpack"; returns false for anything else
+    bool ws_codec_parse_fmt(const char* name, ws_fmt_t* out);
+
+#ifdef __cplusplus
+}
+#endif
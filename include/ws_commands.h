@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WS_COMMANDS_MAX 12
+
+    // Text control commands of the form "<name> <args...>". Frames the shared
+    // ws_server does not consume itself reach ws_commands_handle() through
+    // its on_text hook, on the server task. Commands run there and should
+    // return quickly.
+    typedef bool (*ws_command_fn)(int client_fd, const char* args, void* ctx);
+
+    // Any task, also while clients are sending commands. name must outlive
+    // the registration.
+    bool ws_commands_register(const char* name, ws_command_fn fn, void* ctx);
+
+    // Returns false when no registered command matches.
+    bool ws_commands_handle(int client_fd, const char* text, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ws_codec.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef WS_OUT_MAX_CLIENTS
+#define WS_OUT_MAX_CLIENTS 4
+#endif
+
+// Per-client backlog of guaranteed frames (shots, hits). A client that
+// overflows it, or makes no progress for WS_OUT_EVICT_MS, is disconnected.
+#ifndef WS_OUT_EVENT_SLOTS
+#define WS_OUT_EVENT_SLOTS 8
+#endif
+#define WS_OUT_EVENT_MAX_LEN 128
+#ifndef WS_OUT_EVICT_MS
+#define WS_OUT_EVICT_MS 2000
+#endif
+// Retry period while a socket is refusing data
+#define WS_OUT_RETRY_MS 10
+// Largest one-off reply; replies share one buffer and go out one at a time
+#ifndef WS_OUT_REPLY_MAX_LEN
+#define WS_OUT_REPLY_MAX_LEN 640
+#endif
+// Distinct replies a client may have waiting
+#ifndef WS_OUT_REPLY_SLOTS
+#define WS_OUT_REPLY_SLOTS 4
+#endif
+// Client ops (connect, disconnect, format, reply, control) waiting for
+// ws_task: room for every client to connect, negotiate, ask once and
+// disconnect between two services. Ops beyond that are dropped and counted.
+#ifndef WS_OUT_OPS_DEPTH
+#define WS_OUT_OPS_DEPTH (WS_OUT_MAX_CLIENTS * 4)
+#endif
+
+    // Server-to-client WebSocket frames written straight to the client
+    // sockets with non-blocking sends. Every client has its own bounded
+    // queue, serviced by ws_task only, so frames never interleave on a socket
+    // and a slow client never blocks the producer or other clients.
+    typedef enum
+    {
+        WS_OP_TEXT = 0x1,
+        WS_OP_BINARY = 0x2,
+        WS_OP_CLOSE = 0x8,
+        WS_OP_PING = 0x9,
+        WS_OP_PONG = 0xA,
+    } ws_opcode_t;
+
+#define WS_OUT_CONTROL_MAX_LEN 125
+
+    typedef struct
+    {
+        uint32_t frames_sent;
+        uint32_t bytes_sent;
+        uint32_t would_block;   // sends that had to be resumed later
+        uint32_t events_queued;
+        uint32_t event_high_water; // deepest per-client backlog seen
+        uint32_t states_superseded; // state changes folded into a later delta
+        uint32_t evictions;
+        uint32_t replies_sent;
+        uint32_t ops_dropped; // client ops lost to a full op queue
+    } ws_out_stats_t;
+
+    // Call before the server can report clients
+    bool ws_out_init(void);
+
+    // Client registry, fed from the ws_server connect callback and commands.
+    // Any task; applied by ws_task on its next service. Clients start on JSON
+    // until they negotiate another format.
+    void ws_out_client_add(int fd);
+    void ws_out_client_remove(int fd);
+    void ws_out_set_format(int fd, ws_fmt_t fmt);
+
+    // Unmasked frame header for payload_len bytes; returns header length (2..10)
+    size_t ws_out_frame_header(uint8_t* hdr, ws_opcode_t op, size_t payload_len);
+
+    // Latest-state source: encode what the client in slot has not seen yet,
+    // 0 if nothing. fresh is set on the first call for a new client and
+    // after a format change; the source then sends the whole state.
+    typedef size_t (*ws_out_state_fn)(int slot, bool fresh, ws_fmt_t fmt, uint8_t* buf, size_t cap);
+    void ws_out_set_state_source(ws_out_state_fn fn);
+
+    // Ends a session ws_out gives up on (stalled, send failed, CLOSE
+    // answered). The socket belongs to the server, which must do the
+    // closing; without a hook ws_out shuts the socket down itself.
+    typedef void (*ws_out_close_fn)(int fd);
+    void ws_out_set_close_fn(ws_out_close_fn fn);
+
+    // One-off binary reply to a single client, e.g. answering a command. Any
+    // task; ws_task calls fn once the client's backlog has drained and sends
+    // what it wrote. Replies go out in request order; asking again for one
+    // not yet encoded is a no-op, and one beyond WS_OUT_REPLY_SLOTS is dropped.
+    typedef size_t (*ws_out_reply_fn)(uint8_t* buf, size_t cap);
+    void ws_out_reply(int fd, ws_out_reply_fn fn);
+
+    // Control frame answering the client (PONG to a PING, CLOSE echoing the
+    // status code). Any task; goes out ahead of the backlog once the current
+    // frame is complete. After a CLOSE nothing else is sent and the session is
+    // ended. A pending CLOSE is never replaced by a PONG.
+    void ws_out_control(int fd, ws_opcode_t op, const uint8_t* payload, size_t len);
+
+    // ws_task only. Encode once per format in use and append to every
+    // client's guaranteed backlog.
+    typedef size_t (*ws_out_encode_fn)(ws_fmt_t fmt, const void* msg, uint8_t* buf, size_t cap);
+    int ws_out_enqueue(ws_out_encode_fn encode, const void* msg);
+
+    // ws_task only. Every client gets a state frame when its backlog drains;
+    // changes made before then are folded into that one frame.
+    void ws_out_mark_state(void);
+
+    // ws_task only. Write as much as the sockets accept. Returns true while
+    // any client still has data pending.
+    bool ws_out_service(void);
+
+    // ws_task only. True when no client has a frame partly written, so
+    // another writer on ws_task (the shared ws_server's status and respawn
+    // messages) can put a whole frame on the sockets without splitting one.
+    bool ws_out_between_frames(void);
+
+    int ws_out_client_count(void);
+    void ws_out_get_stats(ws_out_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
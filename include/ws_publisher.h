@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "game_snapshot.h"
+#include "ws_codec.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Shot and hit events waiting for ws_task, which drains them one coalesce
+// window after the first arrives. An event that finds the queue full is
+// dropped, counted in events_dropped and logged from ws_task.
+#ifndef WS_EVENT_QUEUE_LEN
+#define WS_EVENT_QUEUE_LEN 16
+#endif
+
+    // Game-state deltas and shot/hit events for WebSocket clients, encoded per
+    // client in the format it negotiated with "proto json|msgpack" after
+    // connecting (JSON until then, see README). Each client has its own
+    // baseline: a delta carries every field that changed since that client's
+    // last one, so a new client first gets all fields and a slow one gets the
+    // changes folded together.
+    typedef struct
+    {
+        uint32_t deltas_sent;
+        uint32_t events_sent;
+        uint32_t events_dropped;
+        uint32_t heartbeats;
+        uint32_t last_latency_us; // first state change to frame handed to the socket
+        uint32_t max_latency_us;
+        uint32_t avg_latency_us;  // exponential, 1/8 weight
+    } ws_publisher_stats_t;
+
+    bool ws_publisher_init(void);
+
+    // Queue a shot or hit for ws_task. Any task, never blocks.
+    bool ws_publisher_post_event(const ws_event_t* evt);
+
+    // ws_task: move queued events to the client backlogs, in order. Returns
+    // how many were taken.
+    int ws_publisher_drain_events(void);
+
+    // ws_task: game state changed; every client gets a delta.
+    void ws_publisher_push(void);
+
+    // ws_task: write pending frames. Returns true while a client has a backlog.
+    bool ws_publisher_service(void);
+
+    void ws_publisher_count_heartbeat(void);
+    void ws_publisher_get_stats(ws_publisher_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+#include "display_hud.h"
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+
+#define HUD_COUNTDOWN_STEP_MS 100
+
+void hud_model_init(hud_model_t* m)
+{
+    memset(m, 0, sizeof(*m));
+    m->max_ammo = -1;
+}
+
+static bool set_u32(uint32_t* dst, int32_t value)
+{
+    const uint32_t v = value < 0 ? 0 : (uint32_t)value;
+    if (*dst == v)
+        return false;
+    *dst = v;
+    return true;
+}
+
+bool hud_model_apply(hud_model_t* m, dm_hud_field_t field, int32_t value, uint32_t now_ms)
+{
+    switch (field)
+    {
+        case DM_HUD_AMMO:
+            if (m->ammo == value)
+                return false;
+            m->ammo = value;
+            return true;
+        case DM_HUD_MAX_AMMO:
+            if (m->max_ammo == value)
+                return false;
+            m->max_ammo = value;
+            return true;
+        case DM_HUD_HEARTS:
+            return set_u32(&m->hearts, value);
+        case DM_HUD_KILLS:
+            return set_u32(&m->kills, value);
+        case DM_HUD_DEATHS:
+            return set_u32(&m->deaths, value);
+        case DM_HUD_HITS:
+            if (!set_u32(&m->hits, value))
+                return false;
+            m->last_hit_ms = now_ms;
+            return true;
+        case DM_HUD_RESPAWN:
+            if (m->respawning == (value != 0))
+                return false;
+            m->respawning = value != 0;
+            m->respawn_until_ms = m->respawning ? now_ms + DM_RESPAWN_COUNTDOWN_MS : 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void render_ammo(const hud_model_t* m, char* row)
+{
+    if (m->max_ammo < 0)
+    {
+        snprintf(row, DM_ROW_LEN, "AMMO %ld inf", (long)m->ammo);
+        return;
+    }
+
+    char bar[DM_HUD_BAR_CELLS + 1];
+    const int32_t ammo = m->ammo < 0 ? 0 : (m->ammo > m->max_ammo ? m->max_ammo : m->ammo);
+    const int filled = m->max_ammo > 0 ? (int)((ammo * DM_HUD_BAR_CELLS + m->max_ammo - 1) / m->max_ammo) : 0;
+    for (int i = 0; i < DM_HUD_BAR_CELLS; i++)
+        bar[i] = i < filled ? '#' : '-';
+    bar[DM_HUD_BAR_CELLS] = '\0';
+    snprintf(row, DM_ROW_LEN, "%ld/%ld [%s]", (long)ammo, (long)m->max_ammo, bar);
+}
+
+void hud_render(const hud_model_t* m, uint32_t now_ms, char rows[DM_ROWS][DM_ROW_LEN])
+{
+    render_ammo(m, rows[0]);
+    snprintf(rows[1], DM_ROW_LEN, "HP %lu  K%lu/D%lu", (unsigned long)m->hearts, (unsigned long)m->kills,
+             (unsigned long)m->deaths);
+
+    if (m->respawning)
+    {
+        const uint32_t left =
+            (int32_t)(m->respawn_until_ms - now_ms) > 0 ? m->respawn_until_ms - now_ms : 0;
+        snprintf(rows[2], DM_ROW_LEN, "RESPAWN %lu.%lus", (unsigned long)(left / 1000),
+                 (unsigned long)(left % 1000 / 100));
+    }
+    else
+    {
+        snprintf(rows[2], DM_ROW_LEN, "Hits %lu", (unsigned long)m->hits);
+    }
+}
+
+uint32_t hud_next_change_ms(const hud_model_t* m, uint32_t now_ms)
+{
+    if (!m->respawning || (int32_t)(m->respawn_until_ms - now_ms) <= 0)
+        return UINT32_MAX;
+    // The countdown shows tenths, truncated; it changes once left drops below
+    // the next multiple of the step. In the last step it already reads 0.0.
+    const uint32_t left = m->respawn_until_ms - now_ms;
+    if (left < HUD_COUNTDOWN_STEP_MS)
+        return UINT32_MAX;
+    return left % HUD_COUNTDOWN_STEP_MS + 1;
+}
@@ -2,19 +2,54 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <freertos/task.h>
+#include <esp_timer.h>
 #include <lvgl.h>
 #include <stdio.h>
 #include <string.h>
+#include "config.h"
+#include "display_hud.h"
+#include "display_stats.h"
+#include "game_snapshot.h"
+#include "oled_flush.h"
+#include "perf_metrics.h"
+#include "runtime_metrics.h"
+#include "ws_commands.h"
+#include "ws_out.h"
 
 typedef enum
 {
     DM_ST_BOOT = 0,
-    DM_ST_DEBUG,
+    DM_ST_PAGE,
     DM_ST_OVERLAY_HIT,
     DM_ST_OVERLAY_MSG,
     DM_ST_ERROR
 } dm_state_t;
 
+// Queue entries: a shared dm_event_t, or one of this module's HUD messages
+typedef enum
+{
+    DM_MSG_EVENT = 0,
+    DM_MSG_HUD,
+    DM_MSG_PAGE,
+} dm_msg_kind_t;
+
+typedef struct
+{
+    dm_msg_kind_t kind;
+    union
+    {
+        dm_event_t evt;
+        struct
+        {
+            dm_hud_field_t field;
+            int32_t value;
+        } hud;
+        dm_page_t page;
+    };
+} dm_msg_t;
+
+#define DM_QUEUE_LEN 16
+
 static QueueHandle_t s_q;
 static dm_sources_t s_src;
 static dm_state_t s_state;
@@ -27,28 +62,179 @@ static lv_obj_t* s_row1;
 static lv_obj_t* s_row2;
 static lv_obj_t* s_row3;
 static lv_obj_t* s_overlay;
+static lv_disp_t* s_disp;
+// Something was handed to LVGL since the last refresh
+static bool s_lv_dirty;
+static dm_page_t s_page = DM_DEFAULT_PAGE;
+static hud_model_t s_hud;
+static bool s_page_dirty = true;
+
+// Last text handed to LVGL per label; unchanged rows are not touched, so
+// LVGL never invalidates them and nothing is flushed over I2C.
+static char s_row_text[3][DM_ROW_LEN];
+static char s_overlay_text[DM_ROW_LEN];
+
+// Source values, refreshed per field class instead of on every render
+#define DM_REFRESH_FAST_MS 100
+#define DM_REFRESH_SLOW_MS 1000
+typedef struct
+{
+    bool wifi;
+    bool ws;
+    int rssi;
+    int pid;
+    int did;
+    char ssid[DM_ROW_LEN];
+    char status[DM_ROW_LEN];
+    char ip[DM_ROW_LEN];
+    char dname[DM_ROW_LEN];
+    uint32_t fast_at_ms;
+    uint32_t slow_at_ms;
+    bool valid;
+} dm_source_cache_t;
+static dm_source_cache_t s_cache;
+
+static dm_stats_t s_stats;
+static uint32_t s_window_start_ms;
+static uint32_t s_window_start_bytes;
+static uint32_t s_window_render_us;
+static uint32_t s_window_wakeups;
 
 static uint32_t now_ms(void)
 {
     return s_src.uptime_ms ? s_src.uptime_ms() : (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
 }
 
+static void set_label(lv_obj_t* label, char* cache, const char* txt)
+{
+    if (strncmp(cache, txt, DM_ROW_LEN) == 0)
+    {
+        s_stats.label_skips++;
+        return;
+    }
+    strncpy(cache, txt, DM_ROW_LEN - 1);
+    cache[DM_ROW_LEN - 1] = '\0';
+    lv_label_set_text(label, txt);
+    s_lv_dirty = true;
+    s_stats.label_updates++;
+}
+
 static void set_rows(const char* r1, const char* r2, const char* r3)
 {
-    lv_label_set_text(s_row1, r1);
-    lv_label_set_text(s_row2, r2);
-    lv_label_set_text(s_row3, r3);
+    set_label(s_row1, s_row_text[0], r1);
+    set_label(s_row2, s_row_text[1], r2);
+    set_label(s_row3, s_row_text[2], r3);
 }
 
 static void overlay_show(const char* txt)
 {
-    lv_label_set_text(s_overlay, txt);
+    set_label(s_overlay, s_overlay_text, txt);
     lv_obj_clear_flag(s_overlay, LV_OBJ_FLAG_HIDDEN);
+    s_lv_dirty = true;
 }
 
 static void overlay_hide(void)
 {
     lv_obj_add_flag(s_overlay, LV_OBJ_FLAG_HIDDEN);
+    s_lv_dirty = true;
+}
+
+static void copy_str(char* dst, const char* src)
+{
+    snprintf(dst, DM_ROW_LEN, "%s", src ? src : "");
+}
+
+static void refresh_sources(uint32_t t)
+{
+    if (!s_cache.valid || t - s_cache.fast_at_ms >= DM_REFRESH_FAST_MS)
+    {
+        s_cache.wifi = s_src.wifi_connected ? s_src.wifi_connected() : false;
+        s_cache.ws = s_src.ws_connected ? s_src.ws_connected() : false;
+        s_cache.fast_at_ms = t;
+    }
+
+    if (!s_cache.valid || t - s_cache.slow_at_ms >= DM_REFRESH_SLOW_MS)
+    {
+        copy_str(s_cache.ssid, s_src.wifi_ssid ? s_src.wifi_ssid() : "?");
+        copy_str(s_cache.status, s_src.wifi_status ? s_src.wifi_status() : "?");
+        copy_str(s_cache.ip, (s_src.wifi_ip && s_cache.wifi) ? s_src.wifi_ip() : "--");
+        copy_str(s_cache.dname, s_src.device_name ? s_src.device_name() : "Device");
+        s_cache.pid = s_src.player_id ? s_src.player_id() : -1;
+        s_cache.did = s_src.device_id ? s_src.device_id() : -1;
+        s_cache.rssi = s_src.wifi_rssi ? s_src.wifi_rssi() : 0;
+        s_cache.slow_at_ms = t;
+    }
+    s_cache.valid = true;
+}
+
+// Bytes oled_flush has put on the I2C bus, after its diff; LVGL's own area
+// sizes would count unchanged pixels too
+static uint32_t flushed_bytes(void)
+{
+    uint32_t bytes = 0;
+    oled_flush_get_stats(&bytes, NULL);
+    return bytes;
+}
+
+static void stats_tick(uint32_t t)
+{
+    const uint32_t elapsed = t - s_window_start_ms;
+    if (elapsed < 1000)
+        return;
+    const uint32_t bytes = flushed_bytes();
+    s_stats.flush_bytes_per_s = (uint32_t)((uint64_t)(bytes - s_window_start_bytes) * 1000 / elapsed);
+    s_stats.render_us_per_s = (uint32_t)((uint64_t)s_window_render_us * 1000 / elapsed);
+    s_stats.wakeups_per_s = (uint32_t)((uint64_t)s_window_wakeups * 1000 / elapsed);
+    s_window_start_bytes = bytes;
+    s_window_render_us = 0;
+    s_window_wakeups = 0;
+    s_window_start_ms = t;
+}
+
+void display_manager_get_stats(dm_stats_t* out)
+{
+    *out = s_stats;
+
+    // The task only rolls the window when it wakes; while it sleeps, report
+    // the idle window in progress instead of the last busy one.
+    const uint32_t elapsed = now_ms() - s_window_start_ms;
+    if (elapsed >= 2000)
+    {
+        out->flush_bytes_per_s = (uint32_t)((uint64_t)(flushed_bytes() - s_window_start_bytes) * 1000 / elapsed);
+        out->render_us_per_s = (uint32_t)((uint64_t)s_window_render_us * 1000 / elapsed);
+        out->wakeups_per_s = (uint32_t)((uint64_t)s_window_wakeups * 1000 / elapsed);
+    }
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+size_t display_manager_encode_stats(uint8_t* buf, size_t cap)
+{
+    if (cap < DM_STATS_LEN)
+        return 0;
+
+    dm_stats_t st;
+    display_manager_get_stats(&st);
+
+    uint8_t* p = buf;
+    *p++ = DM_STATS_MAGIC;
+    *p++ = DM_STATS_VERSION;
+    *p++ = 0;
+    *p++ = 0;
+    p = put_u32(p, now_ms());
+    p = put_u32(p, st.label_updates);
+    p = put_u32(p, st.label_skips);
+    p = put_u32(p, st.flush_bytes_per_s);
+    p = put_u32(p, st.render_us_per_s);
+    p = put_u32(p, st.wakeups_per_s);
+    return (size_t)(p - buf);
 }
 
 static void ui_init(lv_disp_t* disp)
@@ -68,28 +254,40 @@ static void ui_init(lv_disp_t* disp)
     lv_obj_set_style_text_color(s_row2, lv_color_white(), 0);
     lv_obj_set_style_text_color(s_row3, lv_color_white(), 0);
 
+    // Start every label empty so it matches the row cache
+    lv_label_set_text(s_row1, "");
+    lv_label_set_text(s_row2, "");
+    lv_label_set_text(s_row3, "");
+
     s_overlay = lv_label_create(scr);
     lv_obj_set_style_text_color(s_overlay, lv_color_white(), 0);
     lv_obj_align(s_overlay, LV_ALIGN_CENTER, 0, 0);
+    lv_label_set_text(s_overlay, "");
     lv_obj_add_flag(s_overlay, LV_OBJ_FLAG_HIDDEN);
+
+    // LVGL's refresh timer fires every LV_DISP_DEF_REFR_PERIOD and would wake
+    // this task about 33 times a second on a static screen. It stays paused;
+    // the task refreshes with lv_refr_now() after it changed something.
+    s_disp = disp;
+    lv_timer_pause(disp->refr_timer);
+    s_lv_dirty = true;
 }
 
-static void render_debug(uint8_t page, bool slow)
+static void render_debug(void)
 {
-    (void)page;
-    (void)slow;
-    char r1[32], r2[32], r3[32];
+    char r1[DM_ROW_LEN], r2[DM_ROW_LEN], r3[DM_ROW_LEN];
 
-    const bool wifi = s_src.wifi_connected ? s_src.wifi_connected() : false;
-    const bool ws = s_src.ws_connected ? s_src.ws_connected() : false;
+    refresh_sources(now_ms());
+    const bool wifi = s_cache.wifi;
+    const bool ws = s_cache.ws;
 
     // Data Sources
-    const char* ssid = s_src.wifi_ssid ? s_src.wifi_ssid() : "?";
-    const char* status = s_src.wifi_status ? s_src.wifi_status() : "?";
-    const char* ip = (s_src.wifi_ip && wifi) ? s_src.wifi_ip() : "--";
-    const char* dname = s_src.device_name ? s_src.device_name() : "Device";
-    const int pid = s_src.player_id ? s_src.player_id() : -1;
-    const int did = s_src.device_id ? s_src.device_id() : -1;
+    const char* ssid = s_cache.ssid;
+    const char* status = s_cache.status;
+    const char* ip = s_cache.ip;
+    const char* dname = s_cache.dname;
+    const int pid = s_cache.pid;
+    const int did = s_cache.did;
 
     // Prioritized Display Logic
     if (ws)
@@ -103,7 +301,7 @@ static void render_debug(uint8_t page, bool slow)
     {
         // WiFi Connected: Show IP and SSID
         snprintf(r1, sizeof(r1), "%s - OK", ssid);
-        snprintf(r2, sizeof(r2), "RSSI:%d", s_src.wifi_rssi ? s_src.wifi_rssi() : 0);
+        snprintf(r2, sizeof(r2), "RSSI:%d", s_cache.rssi);
         snprintf(r3, sizeof(r3), "%s", ip);
     }
     else
@@ -111,15 +309,22 @@ static void render_debug(uint8_t page, bool slow)
         // Not Connected: Show Status and SSID (AP or Connecting)
         snprintf(r1, sizeof(r1), "%s", status);
         snprintf(r2, sizeof(r2), "%s", ssid);
-        snprintf(r3, sizeof(r3), "RSSI:%d", s_src.wifi_rssi ? s_src.wifi_rssi() : 0);
+        snprintf(r3, sizeof(r3), "RSSI:%d", s_cache.rssi);
     }
 
     set_rows(r1, r2, r3);
 }
 
+static void render_hud(void)
+{
+    char rows[DM_ROWS][DM_ROW_LEN];
+    hud_render(&s_hud, now_ms(), rows);
+    set_rows(rows[0], rows[1], rows[2]);
+}
+
 static void render_error(void)
 {
-    char r1[32], r2[32], r3[32];
+    char r1[DM_ROW_LEN], r2[DM_ROW_LEN], r3[DM_ROW_LEN];
     snprintf(r1, sizeof(r1), "ERROR");
     snprintf(r2, sizeof(r2), "C:%lu", (unsigned long)s_error_code);
     snprintf(r3, sizeof(r3), "Fix & reboot");
@@ -132,16 +337,35 @@ static void enter_state(dm_state_t st, uint32_t dur_ms)
     s_state_until_ms = dur_ms ? now_ms() + dur_ms : 0;
 }
 
+// "display hud" / "display debug" switch pages; "display stats" replies
+// with display_manager_encode_stats()
+static bool cmd_display(int client_fd, const char* args, void* ctx)
+{
+    (void)ctx;
+    if (strcmp(args, "hud") == 0)
+        return display_manager_set_page(DM_PAGE_HUD);
+    if (strcmp(args, "debug") == 0)
+        return display_manager_set_page(DM_PAGE_DEBUG);
+    if (strcmp(args, "stats") == 0)
+    {
+        ws_out_reply(client_fd, display_manager_encode_stats);
+        return true;
+    }
+    return false;
+}
+
 bool display_manager_init(lv_disp_t* disp, const dm_sources_t* src)
 {
     if (!disp || !src)
         return false;
     s_src = *src;
-    s_q = xQueueCreate(8, sizeof(dm_event_t));
+    s_q = xQueueCreate(DM_QUEUE_LEN, sizeof(dm_msg_t));
     if (!s_q)
         return false;
 
     ui_init(disp);
+    hud_model_init(&s_hud);
+    ws_commands_register("display", cmd_display, NULL);
 
     set_rows("RayZ", "BOOT", "");
     s_state = DM_ST_BOOT;
@@ -153,7 +377,38 @@ bool display_manager_post(const dm_event_t* evt)
 {
     if (!s_q || !evt)
         return false;
-    return xQueueSend(s_q, evt, 0) == pdTRUE;
+    dm_msg_t m = {};
+    m.kind = DM_MSG_EVENT;
+    m.evt = *evt;
+    return xQueueSend(s_q, &m, 0) == pdTRUE;
+}
+
+bool display_manager_push(dm_hud_field_t field, int32_t value)
+{
+    if (!s_q)
+        return false;
+    dm_msg_t m = {};
+    m.kind = DM_MSG_HUD;
+    m.hud.field = field;
+    m.hud.value = value;
+    return xQueueSend(s_q, &m, 0) == pdTRUE;
+}
+
+bool display_manager_set_page(dm_page_t page)
+{
+    if (!s_q || page >= DM_PAGE_COUNT)
+        return false;
+    dm_msg_t m = {};
+    m.kind = DM_MSG_PAGE;
+    m.page = page;
+    return xQueueSend(s_q, &m, 0) == pdTRUE;
+}
+
+static void start_hit_overlay(void)
+{
+    s_return_state = s_state;
+    enter_state(DM_ST_OVERLAY_HIT, 600);
+    overlay_show("HIT!");
 }
 
 static void handle_event(const dm_event_t* e)
@@ -167,12 +422,10 @@ static void handle_event(const dm_event_t* e)
             break;
         case DM_EVT_ERROR_CLEAR:
             s_error_code = 0;
-            enter_state(DM_ST_DEBUG, 0);
+            enter_state(DM_ST_PAGE, 0);
             break;
         case DM_EVT_HIT:
-            s_return_state = s_state;
-            enter_state(DM_ST_OVERLAY_HIT, 600);
-            overlay_show("HIT!");
+            start_hit_overlay();
             break;
         case DM_EVT_MSG:
             s_return_state = s_state;
@@ -184,29 +437,92 @@ static void handle_event(const dm_event_t* e)
     }
 }
 
+static void handle_msg(const dm_msg_t* m)
+{
+    switch (m->kind)
+    {
+        case DM_MSG_EVENT:
+            handle_event(&m->evt);
+            break;
+        case DM_MSG_HUD:
+            if (!hud_model_apply(&s_hud, m->hud.field, m->hud.value, now_ms()))
+                break;
+            s_page_dirty |= s_page == DM_PAGE_HUD;
+            if (m->hud.field == DM_HUD_HITS && s_state == DM_ST_PAGE)
+                start_hit_overlay();
+            break;
+        case DM_MSG_PAGE:
+            s_page_dirty |= s_page != m->page;
+            s_page = m->page;
+            break;
+        default:
+            break;
+    }
+}
+
+static uint32_t ms_until(uint32_t deadline, uint32_t t)
+{
+    return (int32_t)(deadline - t) > 0 ? deadline - t : 0;
+}
+
+// Time until the display next has work: an LVGL timer, an overlay or boot
+// screen expiring, or the render cadence of the current state.
+static TickType_t next_wait(uint32_t lv_next_ms)
+{
+    const uint32_t t = now_ms();
+    uint32_t wait = lv_next_ms == LV_NO_TIMER_READY ? UINT32_MAX : lv_next_ms;
+
+    if (s_state_until_ms)
+    {
+        const uint32_t w = ms_until(s_state_until_ms, t);
+        wait = w < wait ? w : wait;
+    }
+
+    uint32_t cadence = UINT32_MAX;
+    if (s_state == DM_ST_ERROR)
+        cadence = ms_until(s_last_slow_ms + 1000, t);
+    else if (s_state == DM_ST_OVERLAY_HIT || (s_state == DM_ST_PAGE && s_page == DM_PAGE_DEBUG))
+        cadence = ms_until(s_last_fast_ms + 100, t);
+    else if (s_state == DM_ST_PAGE && s_page == DM_PAGE_HUD)
+        cadence = hud_next_change_ms(&s_hud, t);
+    wait = cadence < wait ? cadence : wait;
+
+    return wait == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait);
+}
+
 void display_manager_task(void* pv)
 {
     (void)pv;
+    TickType_t wait = 0;
     for (;;)
     {
-        dm_event_t e;
-        while (xQueueReceive(s_q, &e, 0) == pdTRUE)
+        // Sleep until an event is posted or the next deadline, so overlays
+        // react immediately and a static screen costs no wakeups.
+        dm_msg_t m;
+        if (xQueueReceive(s_q, &m, wait) == pdTRUE)
         {
-            handle_event(&e);
+            handle_msg(&m);
+            while (xQueueReceive(s_q, &m, 0) == pdTRUE)
+            {
+                handle_msg(&m);
+            }
         }
+        s_window_wakeups++;
 
         const uint32_t t = now_ms();
+        const int64_t render_start_us = esp_timer_get_time();
 
         if (s_state_until_ms && t >= s_state_until_ms)
         {
             if (s_state == DM_ST_OVERLAY_HIT || s_state == DM_ST_OVERLAY_MSG)
             {
                 overlay_hide();
-                enter_state(s_return_state == DM_ST_ERROR ? DM_ST_ERROR : DM_ST_DEBUG, 0);
+                enter_state(s_return_state == DM_ST_ERROR ? DM_ST_ERROR : DM_ST_PAGE, 0);
             }
             else if (s_state == DM_ST_BOOT)
             {
-                enter_state(DM_ST_DEBUG, 0);
+                enter_state(DM_ST_PAGE, 0);
+                s_page_dirty = true;
             }
             s_state_until_ms = 0;
         }
@@ -222,12 +538,23 @@ void display_manager_task(void* pv)
                 s_last_slow_ms = t;
             }
         }
-        else if (s_state == DM_ST_DEBUG)
+        else if (s_state == DM_ST_PAGE && s_page == DM_PAGE_HUD)
         {
-            if (fast)
+            // Pushed deltas mark the page dirty; only the respawn countdown
+            // re-renders on time alone
+            if (s_page_dirty || hud_next_change_ms(&s_hud, t) != UINT32_MAX)
+            {
+                render_hud();
+                s_page_dirty = false;
+            }
+        }
+        else if (s_state == DM_ST_PAGE)
+        {
+            if (fast || s_page_dirty)
             {
-                render_debug(0, slow);
+                render_debug();
                 s_last_fast_ms = t;
+                s_page_dirty = false;
             }
             if (slow)
                 s_last_slow_ms = t;
@@ -243,7 +570,63 @@ void display_manager_task(void* pv)
             }
         }
 
-        lv_timer_handler();
-        vTaskDelay(pdMS_TO_TICKS(20));
+        // Invalidating an object resumes the refresh timer. Draw what changed
+        // now and pause it again before it can schedule another wakeup.
+        if (s_lv_dirty || !s_disp->refr_timer->paused)
+        {
+            lv_refr_now(s_disp);
+            lv_timer_pause(s_disp->refr_timer);
+            s_lv_dirty = false;
+        }
+        const uint32_t lv_next = lv_timer_handler();
+        const uint32_t render_us = (uint32_t)(esp_timer_get_time() - render_start_us);
+        s_window_render_us += render_us;
+        perf_hist_record(PERF_HIST_DISPLAY_RENDER, render_us);
+        perf_count(PERF_CTR_DISPLAY_RENDERS, 1);
+        stats_tick(t);
+        wait = next_wait(lv_next);
+    }
+}
+
+void display_hud_sync(void)
+{
+    static portMUX_TYPE s_sync_lock = portMUX_INITIALIZER_UNLOCKED;
+    static int32_t s_sent[DM_HUD_RESPAWN + 1];
+    static uint32_t s_sent_valid; // bit per field the display has a value for
+
+    if (!s_q)
+        return;
+
+    game_snapshot_t snap;
+    game_snapshot_read(&snap);
+    int32_t cur[DM_HUD_RESPAWN + 1];
+    cur[DM_HUD_AMMO] = metric_ammo();
+    cur[DM_HUD_MAX_AMMO] = snap.game.unlimited_ammo ? -1 : (int32_t)snap.game.max_ammo;
+    cur[DM_HUD_HEARTS] = snap.state.hearts_remaining;
+    cur[DM_HUD_KILLS] = (int32_t)snap.state.kills;
+    cur[DM_HUD_DEATHS] = (int32_t)snap.state.deaths;
+    cur[DM_HUD_HITS] = (int32_t)snap.state.hits_landed;
+    cur[DM_HUD_RESPAWN] = snap.respawning ? 1 : 0;
+
+    // Compare under the lock, post outside it. A field only counts as sent
+    // once the queue took it, so a delta refused by a full queue goes out
+    // again on the next sync.
+    uint32_t changed = 0;
+    portENTER_CRITICAL(&s_sync_lock);
+    for (int f = 0; f <= DM_HUD_RESPAWN; f++)
+    {
+        if (!(s_sent_valid & (1u << f)) || s_sent[f] != cur[f])
+            changed |= 1u << f;
+    }
+    portEXIT_CRITICAL(&s_sync_lock);
+
+    for (int f = 0; f <= DM_HUD_RESPAWN; f++)
+    {
+        if (!(changed & (1u << f)) || !display_manager_push((dm_hud_field_t)f, cur[f]))
+            continue;
+        portENTER_CRITICAL(&s_sync_lock);
+        s_sent[f] = cur[f];
+        s_sent_valid |= 1u << f;
+        portEXIT_CRITICAL(&s_sync_lock);
     }
 }
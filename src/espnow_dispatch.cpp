@@ -0,0 +1,51 @@
+#include "espnow_dispatch.h"
+
+typedef struct
+{
+    uint8_t type;
+    espnow_handler_fn fn;
+    void* ctx;
+} dispatch_entry_t;
+
+static dispatch_entry_t s_table[ESPNOW_DISPATCH_MAX_HANDLERS];
+static uint8_t s_count = 0;
+static uint32_t s_unhandled = 0;
+
+bool espnow_dispatch_register(uint8_t type, espnow_handler_fn fn, void* ctx)
+{
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        if (s_table[i].type == type)
+        {
+            s_table[i].fn = fn;
+            s_table[i].ctx = ctx;
+            return true;
+        }
+    }
+    if (s_count >= ESPNOW_DISPATCH_MAX_HANDLERS)
+        return false;
+    s_table[s_count].type = type;
+    s_table[s_count].fn = fn;
+    s_table[s_count].ctx = ctx;
+    s_count++;
+    return true;
+}
+
+bool espnow_dispatch(const EspnowMessageEnvelope* env)
+{
+    for (uint8_t i = 0; i < s_count; i++)
+    {
+        if (s_table[i].type == env->msg.type)
+        {
+            s_table[i].fn(env, s_table[i].ctx);
+            return true;
+        }
+    }
+    s_unhandled++;
+    return false;
+}
+
+uint32_t espnow_dispatch_unhandled(void)
+{
+    return s_unhandled;
+}
@@ -0,0 +1,156 @@
+#include "espnow_tx.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <string.h>
+#if defined(ESP_PLATFORM) || defined(WEAPON_SIM)
+#include <esp_now.h>
+#endif
+#include "espnow_comm.h"
+#include "perf_metrics.h"
+
+static const char* TAG = "EspNowTx";
+
+#if defined(ESP_PLATFORM) || defined(WEAPON_SIM)
+#define ESPNOW_TX_FRAME_MAX ESP_NOW_MAX_DATA_LEN
+#else
+#define ESPNOW_TX_FRAME_MAX 250
+#endif
+#define ESPNOW_TX_FIT ((ESPNOW_TX_FRAME_MAX - sizeof(EspnowShotBatch)) / sizeof(PlayerMessage))
+#define ESPNOW_TX_BATCH_LIMIT (ESPNOW_TX_MAX_BATCH < ESPNOW_TX_FIT ? ESPNOW_TX_MAX_BATCH : ESPNOW_TX_FIT)
+
+static QueueHandle_t s_ring;
+static espnow_tx_transport_fn s_transport;
+static void* s_transport_ctx;
+static int64_t s_last_send_us = INT64_MIN / 2;
+static volatile bool s_link_up;
+static TaskHandle_t s_waiter;
+// Posters on any task and the TX task both count; s_stats_lock covers them
+static espnow_tx_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static const espnow_tx_policy_t s_policy = {
+    .coalesce_us = ESPNOW_TX_COALESCE_US,
+    .busy_gap_us = ESPNOW_TX_BUSY_GAP_US,
+    .max_batch = (uint8_t)ESPNOW_TX_BATCH_LIMIT,
+};
+
+static bool default_transport(const PlayerMessage* msgs, uint8_t count, void* ctx)
+{
+    (void)ctx;
+    if (count == 1)
+        return espnow_comm_broadcast(&msgs[0]);
+
+#if defined(ESP_PLATFORM) || defined(WEAPON_SIM)
+    static const uint8_t broadcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    uint8_t frame[ESPNOW_TX_FRAME_MAX];
+    EspnowShotBatch* batch = (EspnowShotBatch*)frame;
+    batch->magic = ESPNOW_SHOT_BATCH_MAGIC;
+    batch->count = count;
+    memcpy(batch->msgs, msgs, count * sizeof(PlayerMessage));
+    return esp_now_send(broadcast_mac, frame, sizeof(EspnowShotBatch) + count * sizeof(PlayerMessage)) == ESP_OK;
+#else
+    return false;
+#endif
+}
+
+bool espnow_tx_init(void)
+{
+    if (s_ring)
+        return true;
+    s_ring = xQueueCreate(ESPNOW_TX_RING_DEPTH, sizeof(PlayerMessage));
+    if (!s_ring)
+        return false;
+    if (!s_transport)
+        s_transport = default_transport;
+    return true;
+}
+
+void espnow_tx_set_transport(espnow_tx_transport_fn fn, void* ctx)
+{
+    s_transport = fn ? fn : default_transport;
+    s_transport_ctx = ctx;
+}
+
+bool espnow_tx_post(const PlayerMessage* msg)
+{
+    if (!s_ring || xQueueSend(s_ring, msg, 0) != pdTRUE)
+    {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.overflows++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return false;
+    }
+    const uint32_t depth = uxQueueMessagesWaiting(s_ring);
+    portENTER_CRITICAL(&s_stats_lock);
+    if (depth > s_stats.depth_high_water)
+        s_stats.depth_high_water = depth;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return true;
+}
+
+void espnow_tx_set_link_up(void)
+{
+    s_link_up = true;
+    if (s_waiter)
+        xTaskNotifyGive(s_waiter);
+}
+
+bool espnow_tx_service(TickType_t timeout)
+{
+    if (!s_link_up)
+    {
+        s_waiter = xTaskGetCurrentTaskHandle();
+        if (!s_link_up && !ulTaskNotifyTake(pdTRUE, timeout))
+            return false;
+        // The link came up while we waited; the timeout restarts for the ring
+    }
+
+    PlayerMessage batch[ESPNOW_TX_BATCH_LIMIT];
+    if (!s_ring || xQueueReceive(s_ring, &batch[0], timeout) != pdTRUE)
+        return false;
+
+    uint8_t n = 1;
+    const int64_t first_us = esp_timer_get_time();
+    const uint32_t hold_us =
+        espnow_tx_hold_us(&s_policy, 1 + uxQueueMessagesWaiting(s_ring), first_us, s_last_send_us);
+
+    while (n < s_policy.max_batch)
+    {
+        const int64_t left_us = first_us + hold_us - esp_timer_get_time();
+        const TickType_t wait = left_us > 0 ? pdMS_TO_TICKS((left_us + 999) / 1000) : 0;
+        if (xQueueReceive(s_ring, &batch[n], wait) != pdTRUE)
+            break;
+        n++;
+    }
+
+    const int64_t send_us = esp_timer_get_time();
+    const bool ok = s_transport(batch, n, s_transport_ctx);
+    s_last_send_us = esp_timer_get_time();
+    perf_hist_record(PERF_HIST_ESPNOW_SEND, (uint32_t)(s_last_send_us - send_us));
+    perf_count(ok ? PERF_CTR_ESPNOW_FRAMES : PERF_CTR_ESPNOW_FAILED, 1);
+    perf_gauge_set(PERF_GAUGE_ESPNOW_QUEUE, (int32_t)uxQueueMessagesWaiting(s_ring));
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.frames_sent++;
+    s_stats.records_sent += n;
+    if (n > s_stats.max_batch_seen)
+        s_stats.max_batch_seen = n;
+    if (!ok)
+        s_stats.send_failures++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    if (!ok)
+    {
+        ESP_LOGW(TAG, "Shot frame send failed (%u records)", n);
+    }
+    return ok;
+}
+
+void espnow_tx_get_stats(espnow_tx_stats_t* out)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+    out->depth = s_ring ? uxQueueMessagesWaiting(s_ring) : 0;
+}
@@ -0,0 +1,12 @@
+// Batching policy of the ESP-NOW TX ring, kept apart from the ring itself so
+// host tools can link it without FreeRTOS
+#include "espnow_tx.h"
+
+uint32_t espnow_tx_hold_us(const espnow_tx_policy_t* policy, size_t depth, int64_t now_us, int64_t last_send_us)
+{
+    if (depth >= policy->max_batch)
+        return 0;
+    if (now_us - last_send_us >= (int64_t)policy->busy_gap_us)
+        return 0;
+    return policy->coalesce_us;
+}
@@ -0,0 +1,139 @@
+#include "event_log.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <atomic>
+#include "protocol_config.h"
+
+static const char* TAG = "EvLog";
+
+#define EVLOG_RING_SIZE 64 // power of two
+
+// Bounded MPSC ring: each slot carries a sequence number so producers can
+// claim slots with a single CAS and the consumer never takes a lock. The
+// sequence is kept relative to the lap base so zero-init is a valid state.
+struct evlog_slot_t
+{
+    std::atomic<uint32_t> seq;
+    evlog_record_t rec;
+};
+
+static evlog_slot_t s_ring[EVLOG_RING_SIZE];
+static std::atomic<uint32_t> s_head{0};
+static uint32_t s_tail = 0;
+static std::atomic<uint32_t> s_dropped{0};
+static TaskHandle_t s_task = NULL;
+
+static inline uint32_t lap_base(uint32_t pos)
+{
+    return pos & ~(uint32_t)(EVLOG_RING_SIZE - 1);
+}
+
+bool evlog_push(uint8_t tag, uint8_t level, uint16_t code, uint32_t a, uint32_t b)
+{
+    uint32_t pos = s_head.load(std::memory_order_relaxed);
+    evlog_slot_t* slot;
+    for (;;)
+    {
+        slot = &s_ring[pos & (EVLOG_RING_SIZE - 1)];
+        const int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - lap_base(pos));
+        if (diff == 0)
+        {
+            if (s_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = s_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->rec.t_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    slot->rec.tag = tag;
+    slot->rec.level = level;
+    slot->rec.code = code;
+    slot->rec.a = a;
+    slot->rec.b = b;
+    slot->seq.store(lap_base(pos) + 1, std::memory_order_release);
+
+    if (s_task)
+        xTaskNotifyGive(s_task);
+    return true;
+}
+
+uint32_t evlog_dropped(void)
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+bool evlog_pop(evlog_record_t* out)
+{
+    evlog_slot_t* slot = &s_ring[s_tail & (EVLOG_RING_SIZE - 1)];
+    if (slot->seq.load(std::memory_order_acquire) != lap_base(s_tail) + 1)
+        return false;
+    *out = slot->rec;
+    slot->seq.store(lap_base(s_tail) + EVLOG_RING_SIZE, std::memory_order_release);
+    s_tail++;
+    return true;
+}
+
+static void format_bits(uint32_t value, char* out)
+{
+    for (int i = 0; i < MESSAGE_TOTAL_BITS; i++)
+    {
+        out[i] = (value >> (MESSAGE_TOTAL_BITS - 1 - i)) & 1 ? '1' : '0';
+    }
+    out[MESSAGE_TOTAL_BITS] = '\0';
+}
+
+static void print_record(const evlog_record_t* r)
+{
+    char bits[MESSAGE_TOTAL_BITS + 1];
+    switch (r->code)
+    {
+        case EVLOG_SHOT_FIRED:
+            format_bits(r->a, bits);
+            ESP_LOGI(TAG, "[Laser] %lu ms | %s | Shots: %lu", (unsigned long)r->t_ms, bits, (unsigned long)r->b);
+            break;
+        case EVLOG_SHOT_QUEUE_FULL:
+            ESP_LOGW(TAG, "[Laser] %lu ms | laser queue full (0x%08lx)", (unsigned long)r->t_ms,
+                     (unsigned long)r->a);
+            break;
+        case EVLOG_SHOT_ESPNOW_FAILED:
+            ESP_LOGW(TAG, "[Laser] %lu ms | ESP-NOW shot ring full", (unsigned long)r->t_ms);
+            break;
+        default:
+            ESP_LOGI(TAG, "%lu ms | tag=%u lvl=%u code=%u a=%lu b=%lu", (unsigned long)r->t_ms, r->tag, r->level,
+                     r->code, (unsigned long)r->a, (unsigned long)r->b);
+            break;
+    }
+}
+
+void evlog_task(void* pvParameters)
+{
+    (void)pvParameters;
+    s_task = xTaskGetCurrentTaskHandle();
+
+    uint32_t reported_drops = 0;
+    evlog_record_t rec;
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (evlog_pop(&rec))
+        {
+            print_record(&rec);
+        }
+
+        const uint32_t drops = evlog_dropped();
+        if (drops != reported_drops)
+        {
+            ESP_LOGW(TAG, "%lu records dropped", (unsigned long)(drops - reported_drops));
+            reported_drops = drops;
+        }
+    }
+}
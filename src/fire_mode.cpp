@@ -0,0 +1,138 @@
+#include "fire_mode.h"
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static fire_mode_config_t s_config = {
+    .mode = (fire_mode_t)FIRE_MODE_DEFAULT,
+    .burst_count = FIRE_BURST_COUNT,
+    .rounds_per_minute = FIRE_RATE_RPM,
+};
+static volatile uint32_t s_generation = 1;
+
+static bool wants_fire(const fire_engine_t* e)
+{
+    if (e->cfg.mode == FIRE_MODE_AUTO)
+        return e->held;
+    return e->shots_left > 0;
+}
+
+void fire_engine_init(fire_engine_t* e, const fire_mode_config_t* cfg, uint32_t min_interval_us)
+{
+    e->cfg = *cfg;
+    e->min_interval_us = min_interval_us;
+    e->interval_us = cfg->rounds_per_minute ? 60000000UL / cfg->rounds_per_minute : min_interval_us;
+    if (e->interval_us < min_interval_us)
+        e->interval_us = min_interval_us;
+    e->held = false;
+    e->shots_left = 0;
+    e->next_shot_us = 0;
+}
+
+void fire_engine_press(fire_engine_t* e, int64_t t_us)
+{
+    (void)t_us;
+    e->held = true;
+    switch (e->cfg.mode)
+    {
+        case FIRE_MODE_SEMI:
+            // One press is buffered if it lands inside the cooldown
+            e->shots_left = 1;
+            break;
+        case FIRE_MODE_BURST:
+            if (e->shots_left == 0)
+                e->shots_left = e->cfg.burst_count ? e->cfg.burst_count : 1;
+            break;
+        case FIRE_MODE_AUTO:
+            break;
+    }
+}
+
+void fire_engine_release(fire_engine_t* e, int64_t t_us)
+{
+    (void)t_us;
+    e->held = false;
+}
+
+void fire_engine_cancel(fire_engine_t* e)
+{
+    e->shots_left = 0;
+    e->held = false;
+}
+
+bool fire_engine_due(const fire_engine_t* e, int64_t now_us, int64_t* wake_us)
+{
+    if (!wants_fire(e))
+    {
+        *wake_us = -1;
+        return false;
+    }
+    if (now_us >= e->next_shot_us)
+    {
+        *wake_us = now_us;
+        return true;
+    }
+    *wake_us = e->next_shot_us;
+    return false;
+}
+
+void fire_engine_fired(fire_engine_t* e, int64_t t_us)
+{
+    const uint32_t interval = e->cfg.mode == FIRE_MODE_SEMI ? e->min_interval_us : e->interval_us;
+
+    // Schedule from the planned time, not the wakeup time, so wakeup latency
+    // does not accumulate into a lower rate. After an idle period restart
+    // from the actual shot time.
+    const int64_t base = (t_us - e->next_shot_us) < (int64_t)interval ? e->next_shot_us : t_us;
+    e->next_shot_us = base + interval;
+
+    if (e->shots_left > 0)
+        e->shots_left--;
+}
+
+void fire_mode_set_config(const fire_mode_config_t* cfg)
+{
+    portENTER_CRITICAL(&s_mux);
+    s_config = *cfg;
+    s_generation++;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+uint32_t fire_mode_get_config(fire_mode_config_t* out)
+{
+    portENTER_CRITICAL(&s_mux);
+    *out = s_config;
+    const uint32_t gen = s_generation;
+    portEXIT_CRITICAL(&s_mux);
+    return gen;
+}
+
+uint32_t fire_mode_generation(void)
+{
+    return s_generation;
+}
+
+bool fire_mode_parse(const char* args, const fire_mode_config_t* base, fire_mode_config_t* out)
+{
+    static const char* const names[] = {"semi", "burst", "auto"};
+    char name[8];
+    unsigned count = base->burst_count, rpm = base->rounds_per_minute;
+    if (sscanf(args, "%7s %u %u", name, &count, &rpm) < 1)
+        return false;
+    if (count == 0 || count > UINT8_MAX || rpm == 0 || rpm > UINT16_MAX)
+        return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            out->mode = (fire_mode_t)i;
+            out->burst_count = (uint8_t)count;
+            out->rounds_per_minute = (uint16_t)rpm;
+            return true;
+        }
+    }
+    return false;
+}
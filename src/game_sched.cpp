@@ -0,0 +1,184 @@
+#include "game_sched.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "config.h"
+#include "game_snapshot.h"
+#include "game_state.h"
+
+static const char* TAG = "GameSched";
+
+typedef struct
+{
+    game_sched_cb cb;
+    void* ctx;
+} game_sub_t;
+
+static esp_timer_handle_t s_timers[GAME_EVT_COUNT];
+static esp_timer_handle_t s_respawn_timer;
+static std::atomic<uint32_t> s_pending{0};
+static std::atomic<bool> s_watching{false};
+static int64_t s_respawn_start_us;
+static uint32_t s_respawn_retry_us;
+static std::atomic<uint32_t> s_last_respawn_us{0};
+static TaskHandle_t s_task = NULL;
+
+static portMUX_TYPE s_sub_lock = portMUX_INITIALIZER_UNLOCKED;
+static game_sub_t s_subs[GAME_SCHED_MAX_SUBSCRIBERS];
+static uint8_t s_sub_count = 0;
+
+static void post(game_evt_t evt)
+{
+    s_pending.fetch_or(1u << evt, std::memory_order_release);
+    if (s_task)
+        xTaskNotifyGive(s_task);
+}
+
+static void timer_cb(void* arg)
+{
+    post((game_evt_t)(uintptr_t)arg);
+}
+
+// Fires at the respawn deadline. game_state keeps its own clock, so it may
+// still be a moment short; then check again after a growing backoff.
+static void respawn_cb(void* arg)
+{
+    (void)arg;
+    if (!game_state_check_respawn() && game_state_is_respawning())
+    {
+        s_respawn_retry_us = s_respawn_retry_us ? s_respawn_retry_us * 2 : GAME_SCHED_RESPAWN_RETRY_US;
+        if (s_respawn_retry_us > GAME_SCHED_RESPAWN_RETRY_MAX_US)
+            s_respawn_retry_us = GAME_SCHED_RESPAWN_RETRY_MAX_US;
+        esp_timer_start_once(s_respawn_timer, s_respawn_retry_us);
+        return;
+    }
+
+    s_last_respawn_us.store((uint32_t)(esp_timer_get_time() - s_respawn_start_us), std::memory_order_relaxed);
+    s_watching.store(false, std::memory_order_release);
+    game_snapshot_publish();
+    post(GAME_EVT_RESPAWN_DONE);
+}
+
+bool game_sched_init(void)
+{
+    if (s_respawn_timer)
+        return true;
+
+    esp_timer_create_args_t args = {};
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.callback = timer_cb;
+    args.name = "game_evt";
+    for (int i = 0; i < GAME_EVT_COUNT; i++)
+    {
+        args.arg = (void*)(uintptr_t)i;
+        if (esp_timer_create(&args, &s_timers[i]) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to create timer %d", i);
+            return false;
+        }
+    }
+
+    args.callback = respawn_cb;
+    args.arg = NULL;
+    args.name = "respawn";
+    if (esp_timer_create(&args, &s_respawn_timer) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create respawn timer");
+        return false;
+    }
+    return true;
+}
+
+void game_sched_bind(void)
+{
+    s_task = xTaskGetCurrentTaskHandle();
+}
+
+bool game_sched_subscribe(game_sched_cb cb, void* ctx)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&s_sub_lock);
+    if (s_sub_count < GAME_SCHED_MAX_SUBSCRIBERS)
+    {
+        s_subs[s_sub_count].cb = cb;
+        s_subs[s_sub_count].ctx = ctx;
+        s_sub_count++;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_sub_lock);
+    return ok;
+}
+
+bool game_sched_after(game_evt_t evt, uint32_t delay_ms)
+{
+    if (evt >= GAME_EVT_COUNT || !s_timers[evt])
+        return false;
+    esp_timer_stop(s_timers[evt]);
+    return esp_timer_start_once(s_timers[evt], (uint64_t)delay_ms * 1000) == ESP_OK;
+}
+
+bool game_sched_every(game_evt_t evt, uint32_t period_ms)
+{
+    if (evt >= GAME_EVT_COUNT || !s_timers[evt])
+        return false;
+    esp_timer_stop(s_timers[evt]);
+    return esp_timer_start_periodic(s_timers[evt], (uint64_t)period_ms * 1000) == ESP_OK;
+}
+
+void game_sched_cancel(game_evt_t evt)
+{
+    if (evt < GAME_EVT_COUNT && s_timers[evt])
+        esp_timer_stop(s_timers[evt]);
+}
+
+void game_sched_respawn_watch(int64_t began_us)
+{
+    if (!s_respawn_timer || !game_state_is_respawning())
+        return;
+
+    bool expected = false;
+    if (!s_watching.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        return;
+
+    // Armed late, the time already spent respawning counts; past the deadline
+    // the first check runs at once
+    const int64_t now_us = esp_timer_get_time();
+    if (began_us > now_us)
+        began_us = now_us;
+    const int64_t left_us = began_us + (int64_t)GAME_RESPAWN_MS * 1000 - now_us;
+    s_respawn_start_us = began_us;
+    s_respawn_retry_us = 0;
+    esp_timer_start_once(s_respawn_timer, left_us > 0 ? (uint64_t)left_us : 0);
+    post(GAME_EVT_RESPAWN_STARTED);
+}
+
+uint32_t game_sched_last_respawn_us(void)
+{
+    return s_last_respawn_us.load(std::memory_order_relaxed);
+}
+
+void game_sched_service(TickType_t timeout)
+{
+    if (s_pending.load(std::memory_order_acquire) == 0)
+        ulTaskNotifyTake(pdTRUE, timeout);
+
+    const uint32_t bits = s_pending.exchange(0, std::memory_order_acq_rel);
+    if (bits == 0)
+        return;
+
+    portENTER_CRITICAL(&s_sub_lock);
+    const uint8_t count = s_sub_count;
+    portEXIT_CRITICAL(&s_sub_lock);
+
+    for (int evt = 0; evt < GAME_EVT_COUNT; evt++)
+    {
+        if ((bits & (1u << evt)) == 0)
+            continue;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            s_subs[i].cb((game_evt_t)evt, s_subs[i].ctx);
+        }
+    }
+}
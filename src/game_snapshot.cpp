@@ -0,0 +1,119 @@
+#include "game_snapshot.h"
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <string.h>
+#include "game_sched.h"
+
+// Seqlock: the sequence is odd while a publish is in flight. The payload is
+// kept in atomic words so concurrent reads are well defined; readers copy
+// with relaxed loads and discard the copy if the sequence moved.
+#define SNAP_WORDS ((sizeof(game_snapshot_t) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+union snap_words_t
+{
+    game_snapshot_t snap;
+    uint32_t words[SNAP_WORDS];
+};
+
+static std::atomic<uint32_t> s_seq{0};
+static std::atomic<uint32_t> s_words[SNAP_WORDS];
+static std::atomic<uint32_t> s_generation{0};
+static std::atomic<uint32_t> s_config_generation{0};
+
+// Publishers are serialized; the previous snapshot is only touched under it
+static portMUX_TYPE s_pub_lock = portMUX_INITIALIZER_UNLOCKED;
+static snap_words_t s_last;
+
+static std::atomic<uint32_t> s_publishes{0};
+static std::atomic<uint32_t> s_reads{0};
+static std::atomic<uint32_t> s_read_retries{0};
+
+static bool config_equal(const game_snapshot_t* a, const game_snapshot_t* b)
+{
+    return a->config.player_id == b->config.player_id && a->config.device_id == b->config.device_id &&
+           a->config.team_id == b->config.team_id && a->config.color_rgb == b->config.color_rgb &&
+           a->game.unlimited_ammo == b->game.unlimited_ammo && a->game.max_ammo == b->game.max_ammo;
+}
+
+static bool state_equal(const game_snapshot_t* a, const game_snapshot_t* b)
+{
+    return a->state.kills == b->state.kills && a->state.deaths == b->state.deaths &&
+           a->state.shots_fired == b->state.shots_fired && a->state.hits_landed == b->state.hits_landed &&
+           a->state.hearts_remaining == b->state.hearts_remaining && a->respawning == b->respawning;
+}
+
+bool game_snapshot_publish(void)
+{
+    snap_words_t next;
+    memset(&next, 0, sizeof(next));
+
+    portENTER_CRITICAL(&s_pub_lock);
+    next.snap.state = *game_state_get();
+    next.snap.config = *game_state_get_config();
+    next.snap.game = *game_state_get_game_config();
+    next.snap.respawning = game_state_is_respawning();
+
+    const bool config_changed = !config_equal(&next.snap, &s_last.snap);
+    const bool respawn_began = next.snap.respawning && !s_last.snap.respawning;
+    const bool changed = config_changed || !state_equal(&next.snap, &s_last.snap);
+    next.snap.generation = s_last.snap.generation + 1;
+    next.snap.config_generation = s_last.snap.config_generation + (config_changed ? 1 : 0);
+    s_last = next;
+
+    const uint32_t seq = s_seq.load(std::memory_order_relaxed);
+    s_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < SNAP_WORDS; i++)
+        s_words[i].store(next.words[i], std::memory_order_relaxed);
+    s_seq.store(seq + 2, std::memory_order_release);
+
+    s_generation.store(next.snap.generation, std::memory_order_release);
+    s_config_generation.store(next.snap.config_generation, std::memory_order_release);
+    portEXIT_CRITICAL(&s_pub_lock);
+
+    s_publishes.fetch_add(1, std::memory_order_relaxed);
+
+    // Respawn completion is timed by the scheduler from here on; a respawn
+    // game_state began on its own is timed from when it is first seen
+    if (respawn_began)
+        game_sched_respawn_watch(esp_timer_get_time());
+    return changed;
+}
+
+void game_snapshot_read(game_snapshot_t* out)
+{
+    snap_words_t copy;
+    for (;;)
+    {
+        const uint32_t before = s_seq.load(std::memory_order_acquire);
+        if ((before & 1) == 0)
+        {
+            for (size_t i = 0; i < SNAP_WORDS; i++)
+                copy.words[i] = s_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s_seq.load(std::memory_order_relaxed) == before)
+                break;
+        }
+        s_read_retries.fetch_add(1, std::memory_order_relaxed);
+    }
+    s_reads.fetch_add(1, std::memory_order_relaxed);
+    *out = copy.snap;
+}
+
+uint32_t game_snapshot_generation(void)
+{
+    return s_generation.load(std::memory_order_acquire);
+}
+
+uint32_t game_snapshot_config_generation(void)
+{
+    return s_config_generation.load(std::memory_order_acquire);
+}
+
+void game_snapshot_get_stats(game_snapshot_stats_t* out)
+{
+    out->publishes = s_publishes.load(std::memory_order_relaxed);
+    out->reads = s_reads.load(std::memory_order_relaxed);
+    out->read_retries = s_read_retries.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,107 @@
+#include "hit_dedup.h"
+#include <string.h>
+
+#define SLOT_MASK (HIT_DEDUP_SLOTS - 1)
+
+static uint8_t key_home(const hit_key_t* k)
+{
+    // FNV-1a over the key fields
+    uint32_t h = 2166136261u;
+    const uint8_t* p = k->mac;
+    for (int i = 0; i < 6; i++)
+        h = (h ^ p[i]) * 16777619u;
+    for (int i = 0; i < 4; i++)
+        h = (h ^ ((k->timestamp_ms >> (8 * i)) & 0xFF)) * 16777619u;
+    for (int i = 0; i < 4; i++)
+        h = (h ^ ((k->data >> (8 * i)) & 0xFF)) * 16777619u;
+    return (uint8_t)((h ^ (h >> 16)) & SLOT_MASK);
+}
+
+static bool key_equal(const hit_key_t* a, const hit_key_t* b)
+{
+    return a->timestamp_ms == b->timestamp_ms && a->data == b->data && memcmp(a->mac, b->mac, 6) == 0;
+}
+
+static int find_slot(const hit_dedup_t* d, const hit_key_t* k, uint8_t home)
+{
+    for (uint8_t s = home;; s = (s + 1) & SLOT_MASK)
+    {
+        const uint8_t idx = d->index[s];
+        if (idx == 0)
+            return -1;
+        if (d->home[idx - 1] == home && key_equal(&d->keys[idx - 1], k))
+            return s;
+    }
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void remove_slot(hit_dedup_t* d, uint8_t i)
+{
+    uint8_t j = i;
+    for (;;)
+    {
+        j = (j + 1) & SLOT_MASK;
+        if (d->index[j] == 0)
+            break;
+        const uint8_t k = d->home[d->index[j] - 1];
+        const bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if (stays)
+            continue;
+        d->index[i] = d->index[j];
+        i = j;
+    }
+    d->index[i] = 0;
+}
+
+void hit_dedup_init(hit_dedup_t* d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+bool hit_dedup_check(hit_dedup_t* d, const uint8_t mac[6], uint32_t timestamp_ms, uint32_t data, uint32_t now_ms)
+{
+    hit_key_t key;
+    memcpy(key.mac, mac, 6);
+    key.timestamp_ms = timestamp_ms;
+    key.data = data;
+    const uint8_t home = key_home(&key);
+
+    const int found = find_slot(d, &key, home);
+    if (found >= 0)
+    {
+        const uint8_t pos = d->index[found] - 1;
+        if (now_ms - d->seen_ms[pos] <= HIT_DEDUP_TTL_MS)
+        {
+            d->duplicates++;
+            return false;
+        }
+        d->seen_ms[pos] = now_ms;
+        d->accepted++;
+        return true;
+    }
+
+    // Evict the oldest entry once the window is full
+    const uint8_t pos = d->next;
+    if (d->used == HIT_DEDUP_WINDOW)
+    {
+        const int old = find_slot(d, &d->keys[pos], d->home[pos]);
+        if (old >= 0)
+            remove_slot(d, (uint8_t)old);
+    }
+    else
+    {
+        d->used++;
+    }
+
+    d->keys[pos] = key;
+    d->seen_ms[pos] = now_ms;
+    d->home[pos] = home;
+    uint8_t s = home;
+    while (d->index[s] != 0)
+        s = (s + 1) & SLOT_MASK;
+    d->index[s] = pos + 1;
+    d->next = (pos + 1) % HIT_DEDUP_WINDOW;
+
+    d->accepted++;
+    return true;
+}
@@ -0,0 +1,966 @@
+// Arena simulator: many weapons and vests on one host, sharing one simulated
+// radio channel. The firmware keeps its task state in file statics, so a
+// process holds one firmware instance at most; the arena instead replays the
+// weapon's data path as a discrete-event model built on the same pure
+// modules the tasks use: fire_engine (control_task), the ESP-NOW TX batching
+// policy and hit_dedup (espnow_task), laser frame timing (laser_task) and
+// ws_codec message sizes with delta coalescing (ws_task).
+//
+//   weapon_arena [--weapons N | --sweep N,N,...] [--duration-s S] [--seed N]
+//                [--script FILE] [radio, player and device options]
+//
+// Reported per run: shot-to-hit-confirmation latency (trigger to the
+// weapon's accepted hit event) with its laser / radio / RX breakdown, channel
+// utilisation, collisions, ESP-NOW access delay and WebSocket delivery.
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <random>
+#include <vector>
+#include "config.h"
+#include "espnow_tx.h"
+#include "fire_mode.h"
+#include "game_snapshot.h"
+#include "hit_dedup.h"
+#include "laser_frame.h"
+#include "ws_codec.h"
+#include "ws_out.h"
+
+#define ARENA_MAX_SWEEP 16
+
+typedef struct
+{
+    int weapons;
+    int sweep[ARENA_MAX_SWEEP];
+    int sweep_count;
+    double duration_s;
+    uint64_t seed;
+    const char* script;
+    const char* csv;
+    arena_radio_cfg_t radio;
+    // Players
+    int teams;
+    double press_ms;
+    double hold_ms;
+    double hit_prob;
+    fire_mode_config_t fire;
+    // Devices
+    uint8_t batch;
+    uint32_t rx_depth;
+    uint32_t rx_proc_us;
+    uint32_t vest_proc_us;
+    int hit_repeats;
+    uint32_t repeat_gap_ms;
+    int ws_clients;
+    ws_fmt_t fmt;
+} arena_options_t;
+
+typedef struct
+{
+    int64_t t_us;
+    uint64_t seq;
+    arena_event_kind_t kind;
+    int32_t a;
+    int64_t b;
+} arena_event_t;
+
+struct event_later
+{
+    bool operator()(const arena_event_t& x, const arena_event_t& y) const
+    {
+        return x.t_us != y.t_us ? x.t_us > y.t_us : x.seq > y.seq;
+    }
+};
+
+typedef struct
+{
+    int64_t shot;
+    int64_t arrive_us;
+} rx_item_t;
+
+typedef struct
+{
+    uint8_t mac[6];
+    uint8_t team;
+    fire_engine_t fire;
+    int64_t fire_token;
+    int64_t laser_busy_until;
+    // ESP-NOW TX ring and its coalescing hold
+    std::deque<int64_t> ring;
+    bool collecting;
+    int64_t flush_token;
+    int64_t last_send_us;
+    // espnow_task: RX queue and hit filter
+    std::deque<rx_item_t> rx;
+    hit_dedup_t dedup;
+    // ws_task: published state and per-client backlog
+    game_snapshot_t sent;
+    game_snapshot_t cur;
+    bool delta_due;
+    std::vector<int> ws_backlog;
+} weapon_t;
+
+typedef struct
+{
+    uint8_t mac[6];
+    std::vector<int64_t> lit; // shots currently illuminating the sensor
+} vest_t;
+
+typedef struct
+{
+    int32_t weapon;
+    int32_t vest; // -1 when the shot misses
+    int64_t fire_us;
+    int64_t decode_us;
+    int64_t arrive_us;
+    bool corrupt;
+    bool confirmed;
+} shot_t;
+
+typedef struct
+{
+    int64_t t_us;
+    int32_t player;
+    bool press;
+} script_line_t;
+
+typedef struct
+{
+    int weapons;
+    uint64_t shots;
+    uint64_t aimed;
+    uint64_t corrupt;
+    uint64_t confirmed;
+    uint64_t duplicates;
+    uint64_t rx_drops;
+    uint64_t tx_overflows;
+    uint64_t espnow_frames;
+    uint64_t ws_sent;
+    uint64_t ws_delivered;
+    uint64_t ws_drops;
+    uint64_t ws_bytes;
+    std::vector<int64_t> latency;
+    std::vector<int64_t> laser;
+    std::vector<int64_t> radio;
+    std::vector<int64_t> rx;
+    std::vector<int64_t> ws_latency;
+} arena_result_t;
+
+static arena_options_t s_opts;
+static std::priority_queue<arena_event_t, std::vector<arena_event_t>, event_later> s_events;
+static uint64_t s_seq;
+static int64_t s_now;
+static std::mt19937_64 s_rng;
+static std::vector<script_line_t> s_script;
+
+static std::vector<weapon_t> s_weapons;
+static std::vector<vest_t> s_vests;
+static std::vector<shot_t> s_shots;
+static arena_result_t s_res;
+static uint32_t s_frame_us;
+static uint32_t s_decode_us;
+static uint16_t s_shot_len;
+static uint16_t s_ws_len[WS_EVT_HIT + 1];
+
+void arena_schedule(int64_t t_us, arena_event_kind_t kind, int32_t a, int64_t b)
+{
+    s_events.push({t_us, s_seq++, kind, a, b});
+}
+
+int64_t arena_now(void)
+{
+    return s_now;
+}
+
+double arena_uniform(void)
+{
+    return std::uniform_real_distribution<double>(0.0, 1.0)(s_rng);
+}
+
+uint32_t arena_uniform_int(uint32_t max_inclusive)
+{
+    return std::uniform_int_distribution<uint32_t>(0, max_inclusive)(s_rng);
+}
+
+static int64_t exp_us(double mean_ms)
+{
+    return (int64_t)(std::exponential_distribution<double>(1.0 / mean_ms)(s_rng) * 1000.0);
+}
+
+static int32_t vest_station(int32_t v)
+{
+    return s_res.weapons + v;
+}
+
+static int32_t ap_station(void)
+{
+    return 2 * s_res.weapons;
+}
+
+static int32_t client_station(int c)
+{
+    return 2 * s_res.weapons + 1 + c;
+}
+
+// WebSocket: weapon -> AP -> client, bounded per client like ws_out
+
+static void ws_send(int32_t w, uint16_t len)
+{
+    weapon_t& wp = s_weapons[w];
+    for (int c = 0; c < s_opts.ws_clients; c++)
+    {
+        if (wp.ws_backlog[c] >= WS_OUT_EVENT_SLOTS)
+        {
+            s_res.ws_drops++;
+            continue;
+        }
+        wp.ws_backlog[c]++;
+        const int32_t id = medium_new_frame(FRAME_WS_UP, w, ap_station(), len);
+        arena_frame_t* f = medium_frame(id);
+        f->weapon = w;
+        f->client = c;
+        medium_send(id);
+        s_res.ws_sent++;
+        s_res.ws_bytes += len;
+    }
+}
+
+void arena_on_unicast_done(const arena_frame_t* f, bool ok)
+{
+    if (f->kind == FRAME_WS_UP)
+    {
+        s_weapons[f->weapon].ws_backlog[f->client]--;
+        if (!ok)
+        {
+            s_res.ws_drops++;
+            return;
+        }
+        const int32_t id = medium_new_frame(FRAME_WS_DOWN, ap_station(), client_station(f->client), f->payload);
+        arena_frame_t* down = medium_frame(id);
+        down->origin_us = f->origin_us;
+        down->weapon = f->weapon;
+        down->client = f->client;
+        medium_send(id);
+        return;
+    }
+    if (!ok)
+    {
+        s_res.ws_drops++;
+        return;
+    }
+    s_res.ws_delivered++;
+    s_res.ws_latency.push_back(arena_now() - f->origin_us);
+}
+
+static void ws_state_changed(int32_t w)
+{
+    weapon_t& wp = s_weapons[w];
+    wp.cur.generation++;
+    if (wp.delta_due)
+        return;
+    wp.delta_due = true;
+    arena_schedule(arena_now() + WS_PUBLISH_COALESCE_MS * 1000LL, EV_WS_DELTA, w, 0);
+}
+
+static void on_ws_delta(int32_t w)
+{
+    weapon_t& wp = s_weapons[w];
+    wp.delta_due = false;
+    uint8_t buf[WS_CODEC_MAX_LEN];
+    const ws_delta_t delta = {&wp.sent, &wp.cur};
+    const size_t n = ws_codec_delta(s_opts.fmt, &delta, buf, sizeof(buf));
+    wp.sent = wp.cur;
+    if (n > 0)
+        ws_send(w, (uint16_t)n);
+}
+
+// ESP-NOW shot TX ring, as espnow_tx_service() drains it
+
+static void espnow_flush(int32_t w)
+{
+    weapon_t& wp = s_weapons[w];
+    wp.collecting = false;
+    const size_t n = wp.ring.size() < s_opts.batch ? wp.ring.size() : s_opts.batch;
+    if (n == 0)
+        return;
+    wp.ring.erase(wp.ring.begin(), wp.ring.begin() + n);
+    // One record goes out as a plain PlayerMessage, more as a batch
+    const uint16_t len = n == 1 ? s_shot_len : (uint16_t)(sizeof(EspnowShotBatch) + n * s_shot_len);
+    medium_send(medium_new_frame(FRAME_SHOT, w, -1, len));
+    wp.last_send_us = arena_now();
+    s_res.espnow_frames++;
+}
+
+static void espnow_service(int32_t w)
+{
+    weapon_t& wp = s_weapons[w];
+    while (!wp.ring.empty() && !wp.collecting)
+    {
+        espnow_tx_policy_t policy = {ESPNOW_TX_COALESCE_US, ESPNOW_TX_BUSY_GAP_US, s_opts.batch};
+        const uint32_t hold = espnow_tx_hold_us(&policy, wp.ring.size(), arena_now(), wp.last_send_us);
+        if (hold == 0)
+        {
+            espnow_flush(w);
+            continue;
+        }
+        wp.collecting = true;
+        arena_schedule(arena_now() + hold, EV_ESPNOW_FLUSH, w, ++wp.flush_token);
+    }
+}
+
+static void espnow_post(int32_t w, int64_t shot)
+{
+    weapon_t& wp = s_weapons[w];
+    if (wp.ring.size() >= ESPNOW_TX_RING_DEPTH)
+    {
+        s_res.tx_overflows++;
+        return;
+    }
+    wp.ring.push_back(shot);
+    if (wp.collecting && wp.ring.size() >= s_opts.batch)
+    {
+        wp.flush_token++; // the pending hold is moot, the batch is full
+        espnow_flush(w);
+    }
+    espnow_service(w);
+}
+
+// Weapon: trigger, fire engine, laser
+
+static void arm_fire(int32_t w, int64_t at_us)
+{
+    weapon_t& wp = s_weapons[w];
+    arena_schedule(at_us, EV_FIRE, w, ++wp.fire_token);
+}
+
+static int32_t pick_target(int32_t w)
+{
+    if (arena_uniform() >= s_opts.hit_prob)
+        return -1;
+    const int n = s_res.weapons;
+    // Vests belong to the player of the same index; aim at another team
+    for (int tries = 0; tries < 8; tries++)
+    {
+        const int32_t v = (int32_t)arena_uniform_int((uint32_t)n - 1);
+        if (v != w && (s_opts.teams < 2 || s_weapons[v].team != s_weapons[w].team))
+            return v;
+    }
+    return -1;
+}
+
+static void fire_shot(int32_t w)
+{
+    weapon_t& wp = s_weapons[w];
+    const int64_t now = arena_now();
+    const int64_t id = (int64_t)s_shots.size();
+    const int32_t vest = pick_target(w);
+    s_shots.push_back({w, vest, now, -1, -1, false, false});
+    s_res.shots++;
+
+    // laser_tx queues frames back to back
+    const int64_t start = now > wp.laser_busy_until ? now : wp.laser_busy_until;
+    wp.laser_busy_until = start + s_frame_us;
+    if (vest >= 0)
+    {
+        s_res.aimed++;
+        arena_schedule(start, EV_LASER_START, vest, id);
+        arena_schedule(start + s_decode_us, EV_LASER_END, vest, id);
+    }
+
+    espnow_post(w, id);
+    ws_send(w, s_ws_len[WS_EVT_SHOT]);
+    wp.cur.state.shots_fired++;
+    ws_state_changed(w);
+}
+
+static void on_fire(int32_t w, int64_t token)
+{
+    weapon_t& wp = s_weapons[w];
+    if (token != wp.fire_token)
+        return;
+    int64_t wake = -1;
+    if (fire_engine_due(&wp.fire, arena_now(), &wake))
+    {
+        fire_engine_fired(&wp.fire, arena_now());
+        fire_shot(w);
+        fire_engine_due(&wp.fire, arena_now(), &wake);
+    }
+    if (wake >= 0)
+        arm_fire(w, wake > arena_now() ? wake : arena_now());
+}
+
+static void on_press(int32_t w)
+{
+    fire_engine_press(&s_weapons[w].fire, arena_now());
+    arm_fire(w, arena_now());
+    if (s_script.empty())
+        arena_schedule(arena_now() + 1000 + exp_us(s_opts.hold_ms), EV_RELEASE, w, 0);
+}
+
+static void on_release(int32_t w)
+{
+    fire_engine_release(&s_weapons[w].fire, arena_now());
+    arm_fire(w, arena_now());
+    if (s_script.empty())
+        arena_schedule(arena_now() + exp_us(s_opts.press_ms), EV_PRESS, w, 0);
+}
+
+// Vest: laser decode and hit report
+
+static void on_laser_start(int32_t v, int64_t shot)
+{
+    vest_t& vs = s_vests[v];
+    // Two beams on one sensor garble both words
+    for (int64_t other : vs.lit)
+    {
+        s_shots[other].corrupt = true;
+        s_shots[shot].corrupt = true;
+    }
+    vs.lit.push_back(shot);
+}
+
+static void on_laser_end(int32_t v, int64_t shot)
+{
+    vest_t& vs = s_vests[v];
+    vs.lit.erase(std::find(vs.lit.begin(), vs.lit.end(), shot));
+    shot_t& s = s_shots[shot];
+    if (s.corrupt)
+    {
+        s_res.corrupt++;
+        return;
+    }
+    s.decode_us = arena_now();
+    for (int i = 0; i < s_opts.hit_repeats; i++)
+        arena_schedule(arena_now() + s_opts.vest_proc_us + i * s_opts.repeat_gap_ms * 1000LL, EV_VEST_SEND, v, shot);
+}
+
+static void on_vest_send(int32_t v, int64_t shot)
+{
+    const int32_t id = medium_new_frame(FRAME_HIT, vest_station(v), -1, s_shot_len);
+    medium_frame(id)->shot = shot;
+    medium_send(id);
+}
+
+// Weapon: ESP-NOW receive path
+
+void arena_on_broadcast_rx(const arena_frame_t* f, int32_t listener, int64_t t_us)
+{
+    int64_t shot = -1;
+    if (f->kind == FRAME_HIT && s_shots[f->shot].weapon == listener)
+        shot = f->shot;
+    arena_schedule(t_us, EV_RX, listener, shot);
+}
+
+static void on_rx(int32_t w, int64_t shot)
+{
+    weapon_t& wp = s_weapons[w];
+    if (wp.rx.size() >= s_opts.rx_depth)
+    {
+        s_res.rx_drops++;
+        return;
+    }
+    wp.rx.push_back({shot, arena_now()});
+    if (wp.rx.size() == 1)
+        arena_schedule(arena_now() + s_opts.rx_proc_us, EV_RX_DONE, w, 0);
+}
+
+static void confirm_hit(int32_t w, int64_t id, int64_t arrive_us)
+{
+    weapon_t& wp = s_weapons[w];
+    shot_t& s = s_shots[id];
+    const vest_t& vs = s_vests[s.vest];
+    const int64_t now = arena_now();
+    // Repeats of one report carry the vest's decode time, as on the wire
+    const uint32_t ts_ms = (uint32_t)(s.decode_us / 1000);
+    if (!hit_dedup_check(&wp.dedup, vs.mac, ts_ms, (uint32_t)id, (uint32_t)(now / 1000)))
+    {
+        s_res.duplicates++;
+        return;
+    }
+    s.confirmed = true;
+    s.arrive_us = arrive_us;
+    s_res.confirmed++;
+    s_res.latency.push_back(now - s.fire_us);
+    s_res.laser.push_back(s.decode_us - s.fire_us);
+    s_res.radio.push_back(arrive_us - s.decode_us);
+    s_res.rx.push_back(now - arrive_us);
+
+    ws_send(w, s_ws_len[WS_EVT_HIT]);
+    wp.cur.state.hits_landed++;
+    wp.cur.state.kills++;
+    ws_state_changed(w);
+}
+
+static void on_rx_done(int32_t w)
+{
+    weapon_t& wp = s_weapons[w];
+    const rx_item_t item = wp.rx.front();
+    wp.rx.pop_front();
+    if (item.shot >= 0)
+        confirm_hit(w, item.shot, item.arrive_us);
+    if (!wp.rx.empty())
+        arena_schedule(arena_now() + s_opts.rx_proc_us, EV_RX_DONE, w, 0);
+}
+
+static void dispatch(const arena_event_t& e)
+{
+    switch (e.kind)
+    {
+    case EV_PRESS:
+        on_press(e.a);
+        break;
+    case EV_RELEASE:
+        on_release(e.a);
+        break;
+    case EV_FIRE:
+        on_fire(e.a, e.b);
+        break;
+    case EV_LASER_START:
+        on_laser_start(e.a, e.b);
+        break;
+    case EV_LASER_END:
+        on_laser_end(e.a, e.b);
+        break;
+    case EV_VEST_SEND:
+        on_vest_send(e.a, e.b);
+        break;
+    case EV_ESPNOW_FLUSH:
+        if (e.b == s_weapons[e.a].flush_token)
+        {
+            espnow_flush(e.a);
+            espnow_service(e.a);
+        }
+        break;
+    case EV_WS_DELTA:
+        on_ws_delta(e.a);
+        break;
+    case EV_TX_START:
+        medium_on_tx_start(e.a, e.b);
+        break;
+    case EV_TX_END:
+        medium_on_tx_end(e.a);
+        break;
+    case EV_RX:
+        on_rx(e.a, e.b);
+        break;
+    case EV_RX_DONE:
+        on_rx_done(e.a);
+        break;
+    }
+}
+
+static void ws_sizes(void)
+{
+    uint8_t buf[WS_CODEC_MAX_LEN];
+    ws_event_t evt = {};
+    evt.player_id = 42;
+    evt.device_id = 42;
+    evt.team_id = 1;
+    evt.victim = 17;
+    evt.data = 0xFFFFFFFFu;
+    evt.ts_ms = 1234567;
+    evt.type = WS_EVT_SHOT;
+    s_ws_len[WS_EVT_SHOT] = (uint16_t)ws_codec_event(s_opts.fmt, &evt, buf, sizeof(buf));
+    evt.type = WS_EVT_HIT;
+    s_ws_len[WS_EVT_HIT] = (uint16_t)ws_codec_event(s_opts.fmt, &evt, buf, sizeof(buf));
+}
+
+static void run(int weapons)
+{
+    s_res = arena_result_t();
+    s_res.weapons = weapons;
+    s_events = decltype(s_events)();
+    s_seq = 0;
+    s_now = 0;
+    s_rng.seed(s_opts.seed);
+    s_shots.clear();
+
+    laser_frame_t frame;
+    laser_frame_encode(&frame, 0, LASER_BIT_DURATION_US, LASER_FRAME_GAP_US);
+    s_frame_us = frame.total_us;
+    s_decode_us = MESSAGE_TOTAL_BITS * LASER_BIT_DURATION_US;
+    s_shot_len = (uint16_t)sizeof(PlayerMessage);
+    ws_sizes();
+
+    // Weapons receive broadcasts; vests, the AP and the WebSocket clients only send
+    medium_init(&s_opts.radio, 2 * weapons + 1 + s_opts.ws_clients, weapons);
+
+    s_weapons.assign(weapons, weapon_t());
+    s_vests.assign(weapons, vest_t());
+    for (int i = 0; i < weapons; i++)
+    {
+        weapon_t& wp = s_weapons[i];
+        const uint8_t mac[6] = {0x02, 0xA0, 0, 0, (uint8_t)(i >> 8), (uint8_t)i};
+        memcpy(wp.mac, mac, sizeof(mac));
+        memcpy(s_vests[i].mac, mac, sizeof(mac));
+        s_vests[i].mac[1] = 0xB0;
+        wp.team = (uint8_t)(s_opts.teams > 1 ? i % s_opts.teams : 0);
+        fire_engine_init(&wp.fire, &s_opts.fire, s_frame_us);
+        wp.fire_token = 0;
+        wp.laser_busy_until = 0;
+        wp.collecting = false;
+        wp.flush_token = 0;
+        wp.last_send_us = INT64_MIN / 2;
+        hit_dedup_init(&wp.dedup);
+        memset(&wp.sent, 0, sizeof(wp.sent));
+        wp.cur = wp.sent;
+        wp.delta_due = false;
+        wp.ws_backlog.assign(s_opts.ws_clients, 0);
+    }
+
+    if (s_script.empty())
+    {
+        for (int i = 0; i < weapons; i++)
+            arena_schedule(exp_us(s_opts.press_ms), EV_PRESS, i, 0);
+    }
+    else
+    {
+        for (const script_line_t& l : s_script)
+        {
+            if (l.player < weapons)
+                arena_schedule(l.t_us, l.press ? EV_PRESS : EV_RELEASE, l.player, 0);
+        }
+    }
+
+    const int64_t end_us = (int64_t)(s_opts.duration_s * 1e6);
+    while (!s_events.empty() && s_events.top().t_us <= end_us)
+    {
+        const arena_event_t e = s_events.top();
+        s_events.pop();
+        s_now = e.t_us;
+        dispatch(e);
+    }
+    s_now = end_us;
+}
+
+static int64_t pct(std::vector<int64_t>& v, double p)
+{
+    if (v.empty())
+        return 0;
+    const size_t k = (size_t)(p * (double)(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static double ms(int64_t us)
+{
+    return us / 1000.0;
+}
+
+static void print_dist(const char* name, std::vector<int64_t>& v)
+{
+    printf("  %-22s p50 %8.2f  p90 %8.2f  p99 %8.2f  max %8.2f ms  (n=%zu)\n", name, ms(pct(v, 0.5)),
+           ms(pct(v, 0.9)), ms(pct(v, 0.99)), ms(pct(v, 1.0)), v.size());
+}
+
+static double utilisation(void)
+{
+    return 100.0 * (double)medium_stats()->busy_us / (s_opts.duration_s * 1e6);
+}
+
+static std::vector<int64_t> access_samples(void)
+{
+    size_t n = 0;
+    const int64_t* a = medium_access_samples(&n);
+    return std::vector<int64_t>(a, a + n);
+}
+
+static void report(void)
+{
+    const arena_medium_stats_t* m = medium_stats();
+    const double secs = s_opts.duration_s;
+    static const char* kinds[FRAME_KIND_COUNT] = {"shot", "hit", "ws up", "ws down"};
+    std::vector<int64_t> access = access_samples();
+
+    printf("\n== %d weapons, %d vests, %.0f s ==\n", s_res.weapons, s_res.weapons, secs);
+    printf("shots %llu (%.1f/s), aimed %llu, garbled %llu, confirmed %llu, duplicate reports %llu\n",
+           (unsigned long long)s_res.shots, s_res.shots / secs, (unsigned long long)s_res.aimed,
+           (unsigned long long)s_res.corrupt, (unsigned long long)s_res.confirmed,
+           (unsigned long long)s_res.duplicates);
+    printf("channel busy %.1f%%, lost copies %llu, espnow rx drops %llu, tx ring overflows %llu\n", utilisation(),
+           (unsigned long long)m->lost_rx, (unsigned long long)s_res.rx_drops,
+           (unsigned long long)s_res.tx_overflows);
+    for (int k = 0; k < FRAME_KIND_COUNT; k++)
+    {
+        printf("  %-8s %8llu tx (%7.1f/s), %6llu collided\n", kinds[k], (unsigned long long)m->frames[k],
+               m->frames[k] / secs, (unsigned long long)m->collided[k]);
+    }
+    printf("shot to confirmed hit:\n");
+    print_dist("total", s_res.latency);
+    print_dist("laser", s_res.laser);
+    print_dist("vest to weapon radio", s_res.radio);
+    print_dist("weapon rx queue", s_res.rx);
+    print_dist("espnow access delay", access);
+    printf("websocket: %llu sent (%.1f kB/s), %llu delivered, %llu dropped, %llu retries\n",
+           (unsigned long long)s_res.ws_sent, s_res.ws_bytes / secs / 1000.0,
+           (unsigned long long)s_res.ws_delivered, (unsigned long long)s_res.ws_drops,
+           (unsigned long long)m->retries);
+    print_dist("delivery", s_res.ws_latency);
+}
+
+static void sweep_header(FILE* f, bool csv)
+{
+    if (csv)
+        fprintf(f, "weapons,shots_per_s,busy_pct,collided,confirm_ratio,p50_ms,p99_ms,max_ms,access_p99_ms,"
+                   "rx_drops,ws_p99_ms,ws_drops\n");
+    else
+        fprintf(f, "%7s %8s %6s %8s %8s %8s %8s %8s %9s %8s %8s %8s\n", "weapons", "shots/s", "busy%", "collided",
+                "confirm", "p50ms", "p99ms", "maxms", "access99", "rxdrop", "ws99ms", "wsdrop");
+}
+
+static void sweep_row(FILE* f, bool csv)
+{
+    const arena_medium_stats_t* m = medium_stats();
+    uint64_t collided = 0;
+    for (int k = 0; k < FRAME_KIND_COUNT; k++)
+        collided += m->collided[k];
+    std::vector<int64_t> access = access_samples();
+    const double ratio = s_res.aimed ? (double)s_res.confirmed / (double)s_res.aimed : 0.0;
+    fprintf(f,
+            csv ? "%d,%.1f,%.1f,%llu,%.3f,%.2f,%.2f,%.2f,%.2f,%llu,%.2f,%llu\n"
+                : "%7d %8.1f %6.1f %8llu %8.3f %8.2f %8.2f %8.2f %9.2f %8llu %8.2f %8llu\n",
+            s_res.weapons, s_res.shots / s_opts.duration_s, utilisation(), (unsigned long long)collided, ratio,
+            ms(pct(s_res.latency, 0.5)), ms(pct(s_res.latency, 0.99)), ms(pct(s_res.latency, 1.0)),
+            ms(pct(access, 0.99)), (unsigned long long)s_res.rx_drops, ms(pct(s_res.ws_latency, 0.99)),
+            (unsigned long long)s_res.ws_drops);
+}
+
+static bool load_script(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[128];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+        unsigned long t_ms;
+        int player;
+        char what[16];
+        const int n = sscanf(line, "%lu %d %15s", &t_ms, &player, what);
+        if (n <= 0)
+            continue;
+        if (n != 3 || player < 0 || (strcmp(what, "press") != 0 && strcmp(what, "release") != 0))
+        {
+            fprintf(stderr, "%s:%d: expected \"<t_ms> <player> press|release\"\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        s_script.push_back({(int64_t)t_ms * 1000, player, strcmp(what, "press") == 0});
+    }
+    fclose(f);
+    return true;
+}
+
+static bool parse_sweep(const char* s)
+{
+    s_opts.sweep_count = 0;
+    while (*s && s_opts.sweep_count < ARENA_MAX_SWEEP)
+    {
+        char* end;
+        const long n = strtol(s, &end, 10);
+        if (end == s || n < 2)
+            return false;
+        s_opts.sweep[s_opts.sweep_count++] = (int)n;
+        s = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',')
+            return false;
+    }
+    return s_opts.sweep_count > 0 && *s == '\0';
+}
+
+static bool parse_mode(const char* s, fire_mode_t* out)
+{
+    if (strcmp(s, "semi") == 0)
+        *out = FIRE_MODE_SEMI;
+    else if (strcmp(s, "burst") == 0)
+        *out = FIRE_MODE_BURST;
+    else if (strcmp(s, "auto") == 0)
+        *out = FIRE_MODE_AUTO;
+    else
+        return false;
+    return true;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --weapons N        players, each with a weapon and a vest (default 20)\n"
+            "  --sweep N,N,...    run once per player count and print one row each\n"
+            "  --duration-s S     simulated seconds per run (default 60)\n"
+            "  --seed N           random seed (default 1)\n"
+            "  --csv FILE         also write the sweep rows as CSV\n"
+            "  --script FILE      \"<t_ms> <player> press|release\" lines instead of random players\n"
+            "radio:\n"
+            "  --loss P           per-receiver loss probability (default 0.01)\n"
+            "  --latency-us N     driver and wakeup latency after the last bit (default 300)\n"
+            "  --jitter-us N      uniform extra latency (default 200)\n"
+            "  --espnow-rate M    ESP-NOW PHY rate in Mbit/s (default 1)\n"
+            "  --wifi-rate M      WebSocket data rate in Mbit/s (default 24)\n"
+            "players:\n"
+            "  --teams N          aim only at other teams (default 2)\n"
+            "  --press-ms N       mean idle time between trigger pulls (default 2000)\n"
+            "  --hold-ms N        mean trigger hold time (default 150)\n"
+            "  --hit-prob P       chance that a shot is on target (default 0.3)\n"
+            "  --mode semi|burst|auto, --rpm N, --burst N\n"
+            "devices:\n"
+            "  --batch N          ESP-NOW records per frame (default ESPNOW_TX_MAX_BATCH)\n"
+            "  --rx-depth N       weapon ESP-NOW RX queue depth (default 16)\n"
+            "  --rx-proc-us N     weapon time per received frame (default 60)\n"
+            "  --vest-proc-us N   vest decode-to-send time (default 500)\n"
+            "  --hit-repeats N    copies of every hit report (default 2)\n"
+            "  --repeat-gap-ms N  spacing of the copies (default 30)\n"
+            "  --ws-clients N     WebSocket clients per weapon (default 1)\n"
+            "  --fmt json|msgpack WebSocket encoding (default json)\n",
+            prog);
+}
+
+static bool parse_args(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val)
+            return false;
+        if (strcmp(arg, "--weapons") == 0)
+            s_opts.weapons = atoi(val);
+        else if (strcmp(arg, "--sweep") == 0)
+        {
+            if (!parse_sweep(val))
+                return false;
+        }
+        else if (strcmp(arg, "--duration-s") == 0)
+            s_opts.duration_s = atof(val);
+        else if (strcmp(arg, "--seed") == 0)
+            s_opts.seed = strtoull(val, NULL, 0);
+        else if (strcmp(arg, "--csv") == 0)
+            s_opts.csv = val;
+        else if (strcmp(arg, "--script") == 0)
+            s_opts.script = val;
+        else if (strcmp(arg, "--loss") == 0)
+            s_opts.radio.loss = atof(val);
+        else if (strcmp(arg, "--latency-us") == 0)
+            s_opts.radio.latency_us = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--jitter-us") == 0)
+            s_opts.radio.jitter_us = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--espnow-rate") == 0)
+            s_opts.radio.espnow_rate_mbps = atof(val);
+        else if (strcmp(arg, "--wifi-rate") == 0)
+            s_opts.radio.wifi_rate_mbps = atof(val);
+        else if (strcmp(arg, "--teams") == 0)
+            s_opts.teams = atoi(val);
+        else if (strcmp(arg, "--press-ms") == 0)
+            s_opts.press_ms = atof(val);
+        else if (strcmp(arg, "--hold-ms") == 0)
+            s_opts.hold_ms = atof(val);
+        else if (strcmp(arg, "--hit-prob") == 0)
+            s_opts.hit_prob = atof(val);
+        else if (strcmp(arg, "--mode") == 0)
+        {
+            if (!parse_mode(val, &s_opts.fire.mode))
+                return false;
+        }
+        else if (strcmp(arg, "--rpm") == 0)
+            s_opts.fire.rounds_per_minute = (uint16_t)atoi(val);
+        else if (strcmp(arg, "--burst") == 0)
+            s_opts.fire.burst_count = (uint8_t)atoi(val);
+        else if (strcmp(arg, "--batch") == 0)
+            s_opts.batch = (uint8_t)atoi(val);
+        else if (strcmp(arg, "--rx-depth") == 0)
+            s_opts.rx_depth = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--rx-proc-us") == 0)
+            s_opts.rx_proc_us = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--vest-proc-us") == 0)
+            s_opts.vest_proc_us = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--hit-repeats") == 0)
+            s_opts.hit_repeats = atoi(val);
+        else if (strcmp(arg, "--repeat-gap-ms") == 0)
+            s_opts.repeat_gap_ms = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--ws-clients") == 0)
+            s_opts.ws_clients = atoi(val);
+        else if (strcmp(arg, "--fmt") == 0)
+        {
+            if (!ws_codec_parse_fmt(val, &s_opts.fmt))
+                return false;
+        }
+        else
+            return false;
+        i++;
+    }
+    return s_opts.weapons >= 2 && s_opts.duration_s > 0 && s_opts.batch >= 1 && s_opts.rx_depth >= 1 &&
+           s_opts.ws_clients >= 0 && s_opts.ws_clients <= WS_OUT_MAX_CLIENTS && s_opts.hit_repeats >= 1 &&
+           s_opts.press_ms > 0 && s_opts.hold_ms > 0;
+}
+
+int main(int argc, char** argv)
+{
+    s_opts.weapons = 20;
+    s_opts.duration_s = 60;
+    s_opts.seed = 1;
+    s_opts.radio = {1, 24, 0.01, 300, 200};
+    s_opts.teams = 2;
+    s_opts.press_ms = 2000;
+    s_opts.hold_ms = 150;
+    s_opts.hit_prob = 0.3;
+    s_opts.fire = {FIRE_MODE_DEFAULT, FIRE_BURST_COUNT, FIRE_RATE_RPM};
+    s_opts.batch = ESPNOW_TX_MAX_BATCH;
+    s_opts.rx_depth = 16;
+    s_opts.rx_proc_us = 60;
+    s_opts.vest_proc_us = 500;
+    s_opts.hit_repeats = 2;
+    s_opts.repeat_gap_ms = 30;
+    s_opts.ws_clients = 1;
+    s_opts.fmt = WS_FMT_JSON;
+
+    if (!parse_args(argc, argv))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (s_opts.script && !load_script(s_opts.script))
+        return 1;
+
+    if (s_opts.sweep_count == 0)
+    {
+        run(s_opts.weapons);
+        report();
+        return 0;
+    }
+
+    FILE* csv = NULL;
+    if (s_opts.csv)
+    {
+        csv = fopen(s_opts.csv, "w");
+        if (!csv)
+        {
+            fprintf(stderr, "cannot write %s\n", s_opts.csv);
+            return 1;
+        }
+        sweep_header(csv, true);
+    }
+    sweep_header(stdout, false);
+    for (int i = 0; i < s_opts.sweep_count; i++)
+    {
+        run(s_opts.sweep[i]);
+        sweep_row(stdout, false);
+        if (csv)
+            sweep_row(csv, true);
+        fflush(stdout);
+    }
+    if (csv)
+        fclose(csv);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Arena simulator: N weapons and N vests sharing one Wi-Fi channel, run as a
+// discrete-event model in simulated microseconds. arena_medium.cpp is the
+// radio (airtime, carrier sense, collisions, loss); arena.cpp holds players,
+// devices, metrics and the command line.
+
+typedef enum
+{
+    EV_PRESS,        // a: weapon
+    EV_RELEASE,      // a: weapon
+    EV_FIRE,         // a: weapon, b: fire token
+    EV_LASER_START,  // a: vest, b: shot
+    EV_LASER_END,    // a: vest, b: shot
+    EV_VEST_SEND,    // a: vest, b: shot
+    EV_ESPNOW_FLUSH, // a: weapon; coalescing hold expired
+    EV_WS_DELTA,     // a: weapon; coalesced state delta due
+    EV_TX_START,     // a: station, b: attempt token
+    EV_TX_END,       // a: station
+    EV_RX,           // a: weapon, b: shot confirmed by a hit frame, -1 otherwise
+    EV_RX_DONE,      // a: weapon
+} arena_event_kind_t;
+
+typedef enum
+{
+    FRAME_SHOT, // ESP-NOW shot broadcast, one record or a batch
+    FRAME_HIT,  // ESP-NOW hit event from a vest
+    FRAME_WS_UP,
+    FRAME_WS_DOWN,
+    FRAME_KIND_COUNT
+} arena_frame_kind_t;
+
+typedef struct
+{
+    arena_frame_kind_t kind;
+    int32_t src;       // station
+    int32_t dst;       // station, -1 for broadcast
+    uint16_t payload;  // bytes handed to the driver
+    int64_t queued_us; // entered the station's TX queue
+    int64_t origin_us; // data produced (WebSocket delivery latency)
+    int64_t shot;      // shot a hit frame confirms, -1 otherwise
+    int32_t weapon;    // weapon a WebSocket frame belongs to
+    int32_t client;    // WebSocket client it is headed for
+    uint8_t attempts;
+    bool collided;
+} arena_frame_t;
+
+typedef struct
+{
+    double espnow_rate_mbps;
+    double wifi_rate_mbps; // WebSocket data frames
+    double loss;           // per receiver for broadcasts, per attempt for unicast
+    uint32_t latency_us;   // driver and task wakeup after the last bit
+    uint32_t jitter_us;
+} arena_radio_cfg_t;
+
+typedef struct
+{
+    uint64_t frames[FRAME_KIND_COUNT];
+    uint64_t collided[FRAME_KIND_COUNT];
+    uint64_t lost_rx;   // broadcast copies dropped at a receiver
+    uint64_t retries;   // unicast retransmissions
+    uint64_t drops;     // unicast frames out of retries
+    int64_t busy_us;    // union of on-air time, ACKs included
+} arena_medium_stats_t;
+
+// Event queue and randomness shared by the medium and the devices
+void arena_schedule(int64_t t_us, arena_event_kind_t kind, int32_t a, int64_t b);
+int64_t arena_now(void);
+double arena_uniform(void);
+uint32_t arena_uniform_int(uint32_t max_inclusive);
+
+// Radio. Stations [0, listeners) receive broadcasts.
+void medium_init(const arena_radio_cfg_t* cfg, int stations, int listeners);
+int32_t medium_new_frame(arena_frame_kind_t kind, int32_t src, int32_t dst, uint16_t payload);
+arena_frame_t* medium_frame(int32_t id);
+void medium_send(int32_t frame);
+void medium_on_tx_start(int32_t station, int64_t token);
+void medium_on_tx_end(int32_t station);
+uint32_t medium_airtime_us(arena_frame_kind_t kind, uint16_t payload);
+const arena_medium_stats_t* medium_stats(void);
+// Queue entry to first bit of every ESP-NOW frame, in microseconds
+const int64_t* medium_access_samples(size_t* count);
+
+// Delivery, implemented by the devices. A broadcast copy reaches listener
+// at t_us; a unicast frame was acknowledged (ok) or dropped.
+void arena_on_broadcast_rx(const arena_frame_t* f, int32_t listener, int64_t t_us);
+void arena_on_unicast_done(const arena_frame_t* f, bool ok);
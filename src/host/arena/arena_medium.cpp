@@ -0,0 +1,288 @@
+// Shared broadcast medium of the arena: one 2.4 GHz channel used by every
+// weapon, vest and the access point. Access follows 802.11 DCF closely
+// enough for load studies: DIFS plus random backoff that freezes while the
+// channel is busy, and stations that pick the same slot collide. Broadcasts
+// (all ESP-NOW here) are sent once; unicast (WebSocket over Wi-Fi) is
+// acknowledged and retried with a doubling contention window.
+#include "arena.h"
+#include <math.h>
+#include <deque>
+#include <vector>
+
+#define SLOT_US 20
+#define SIFS_US 10
+#define DIFS_US (SIFS_US + 2 * SLOT_US)
+#define CW_MIN 15
+#define CW_MAX 1023
+#define RETRY_LIMIT 7
+
+// ESP-NOW vendor action frame around the payload: MAC header, category,
+// OUI, random bytes, vendor element header, FCS
+#define ESPNOW_OVERHEAD_BYTES (24 + 1 + 3 + 4 + 7 + 4)
+// QoS data header, LLC/SNAP, IPv4, TCP, WebSocket header, FCS
+#define WS_OVERHEAD_BYTES (26 + 8 + 20 + 20 + 2 + 4)
+#define ACK_BYTES 14
+
+typedef struct
+{
+    std::deque<int32_t> queue;
+    int backoff; // slots left, -1 when none is pending
+    int cw;
+    bool on_air;
+    int64_t token;       // invalidates superseded EV_TX_START events
+    int64_t count_from; // backoff countdown began here
+    size_t seen_starts; // transmissions started when the countdown was planned
+    int64_t last_end_us;
+} station_t;
+
+static arena_radio_cfg_t s_cfg;
+static std::vector<station_t> s_stations;
+static int s_listeners;
+static std::vector<arena_frame_t> s_frames;
+static std::vector<int32_t> s_free_frames;
+static std::vector<int32_t> s_on_air;
+static int64_t s_busy_until;
+static std::vector<int64_t> s_starts; // first bit of every transmission, in order
+static arena_medium_stats_t s_stats;
+static std::vector<int64_t> s_access_us;
+
+static bool is_dsss(double rate_mbps)
+{
+    return rate_mbps == 1 || rate_mbps == 2 || rate_mbps == 5.5 || rate_mbps == 11;
+}
+
+static uint32_t phy_us(uint32_t bytes, double rate_mbps)
+{
+    if (is_dsss(rate_mbps))
+        return 192 + (uint32_t)ceil(bytes * 8 / rate_mbps); // long preamble
+    // OFDM: preamble + SIGNAL, then 4 us symbols carrying SERVICE, data and tail
+    const double bits_per_symbol = 4 * rate_mbps;
+    return 20 + 4 * (uint32_t)ceil((16 + 8.0 * bytes + 6) / bits_per_symbol);
+}
+
+static bool is_unicast(arena_frame_kind_t kind)
+{
+    return kind == FRAME_WS_UP || kind == FRAME_WS_DOWN;
+}
+
+uint32_t medium_airtime_us(arena_frame_kind_t kind, uint16_t payload)
+{
+    if (!is_unicast(kind))
+        return phy_us(payload + ESPNOW_OVERHEAD_BYTES, s_cfg.espnow_rate_mbps);
+    // The ACK (or the ACK timeout after a collision) holds the channel as well
+    const double ack_rate = s_cfg.wifi_rate_mbps < 24 ? s_cfg.wifi_rate_mbps : 24;
+    return phy_us(payload + WS_OVERHEAD_BYTES, s_cfg.wifi_rate_mbps) + SIFS_US + phy_us(ACK_BYTES, ack_rate);
+}
+
+void medium_init(const arena_radio_cfg_t* cfg, int stations, int listeners)
+{
+    s_cfg = *cfg;
+    s_stations.assign(stations, station_t());
+    for (station_t& st : s_stations)
+    {
+        st.backoff = -1;
+        st.cw = CW_MIN;
+        st.on_air = false;
+        st.token = 0;
+        st.count_from = 0;
+        st.seen_starts = 0;
+        st.last_end_us = INT64_MIN / 2;
+    }
+    s_listeners = listeners;
+    s_frames.clear();
+    s_free_frames.clear();
+    s_on_air.clear();
+    s_busy_until = 0;
+    s_starts.clear();
+    s_stats = arena_medium_stats_t();
+    s_access_us.clear();
+}
+
+int32_t medium_new_frame(arena_frame_kind_t kind, int32_t src, int32_t dst, uint16_t payload)
+{
+    int32_t id;
+    if (!s_free_frames.empty())
+    {
+        id = s_free_frames.back();
+        s_free_frames.pop_back();
+    }
+    else
+    {
+        id = (int32_t)s_frames.size();
+        s_frames.emplace_back();
+    }
+    arena_frame_t* f = &s_frames[id];
+    *f = arena_frame_t();
+    f->kind = kind;
+    f->src = src;
+    f->dst = dst;
+    f->payload = payload;
+    f->origin_us = arena_now();
+    f->shot = -1;
+    f->weapon = -1;
+    return id;
+}
+
+arena_frame_t* medium_frame(int32_t id)
+{
+    return &s_frames[id];
+}
+
+// Plan the first bit of the head frame: DIFS of idle channel, then the
+// remaining backoff slots
+static void plan_start(int32_t s)
+{
+    station_t& st = s_stations[s];
+    const int64_t now = arena_now();
+    const int64_t idle_from = s_busy_until > st.last_end_us ? s_busy_until : st.last_end_us;
+
+    if (st.backoff < 0)
+    {
+        // A fresh frame goes straight out after DIFS of idle channel,
+        // otherwise it contends like everyone else
+        st.backoff = now - s_busy_until >= DIFS_US ? 0 : (int)arena_uniform_int(st.cw);
+    }
+    else if (now - idle_from >= DIFS_US + (int64_t)st.backoff * SLOT_US)
+    {
+        st.backoff = 0; // post-transmit backoff already ran out while idle
+    }
+
+    st.count_from = now > s_busy_until + DIFS_US ? now : s_busy_until + DIFS_US;
+    st.seen_starts = s_starts.size();
+    st.token++;
+    arena_schedule(st.count_from + (int64_t)st.backoff * SLOT_US, EV_TX_START, s, st.token);
+}
+
+void medium_send(int32_t frame)
+{
+    arena_frame_t* f = &s_frames[frame];
+    f->queued_us = arena_now();
+    station_t& st = s_stations[f->src];
+    st.queue.push_back(frame);
+    if (st.queue.size() == 1 && !st.on_air)
+        plan_start(f->src);
+}
+
+void medium_on_tx_start(int32_t s, int64_t token)
+{
+    station_t& st = s_stations[s];
+    if (token != st.token || st.on_air || st.queue.empty())
+        return;
+
+    const int64_t now = arena_now();
+    arena_frame_t* f = &s_frames[st.queue.front()];
+    for (size_t i = st.seen_starts; i < s_starts.size(); i++)
+    {
+        if (now - s_starts[i] < SLOT_US)
+        {
+            // Started within the same slot as us: nobody decodes either
+            for (int32_t id : s_on_air)
+                s_frames[id].collided = true;
+            f->collided = true;
+            break;
+        }
+        // Heard it during our countdown: keep the slots not yet counted and
+        // wait for the channel again
+        const int64_t counted = s_starts[i] > st.count_from ? (s_starts[i] - st.count_from) / SLOT_US : 0;
+        st.backoff -= counted < st.backoff ? (int)counted : st.backoff - 1;
+        plan_start(s);
+        return;
+    }
+
+    if (f->attempts == 0 && !is_unicast(f->kind))
+        s_access_us.push_back(now - f->queued_us);
+
+    const int64_t end = now + medium_airtime_us(f->kind, f->payload);
+    s_stats.busy_us += end > s_busy_until ? end - (now > s_busy_until ? now : s_busy_until) : 0;
+    if (end > s_busy_until)
+        s_busy_until = end;
+    s_starts.push_back(now);
+    s_on_air.push_back(st.queue.front());
+    st.on_air = true;
+    st.backoff = -1;
+    arena_schedule(end, EV_TX_END, s, 0);
+}
+
+void medium_on_tx_end(int32_t s)
+{
+    station_t& st = s_stations[s];
+    const int32_t id = st.queue.front();
+    arena_frame_t* f = &s_frames[id];
+    const int64_t now = arena_now();
+
+    for (size_t i = 0; i < s_on_air.size(); i++)
+    {
+        if (s_on_air[i] == id)
+        {
+            s_on_air[i] = s_on_air.back();
+            s_on_air.pop_back();
+            break;
+        }
+    }
+    st.on_air = false;
+    st.last_end_us = now;
+    s_stats.frames[f->kind]++;
+    if (f->collided)
+        s_stats.collided[f->kind]++;
+
+    bool done = true;
+    if (!is_unicast(f->kind))
+    {
+        if (!f->collided)
+        {
+            for (int32_t r = 0; r < s_listeners; r++)
+            {
+                if (r == f->src)
+                    continue;
+                if (arena_uniform() < s_cfg.loss)
+                {
+                    s_stats.lost_rx++;
+                    continue;
+                }
+                const int64_t t = now + s_cfg.latency_us + (s_cfg.jitter_us ? arena_uniform_int(s_cfg.jitter_us) : 0);
+                arena_on_broadcast_rx(f, r, t);
+            }
+        }
+        st.cw = CW_MIN;
+    }
+    else if (!f->collided && arena_uniform() >= s_cfg.loss)
+    {
+        arena_on_unicast_done(f, true);
+        st.cw = CW_MIN;
+    }
+    else if (++f->attempts > RETRY_LIMIT)
+    {
+        s_stats.drops++;
+        arena_on_unicast_done(f, false);
+        st.cw = CW_MIN;
+    }
+    else
+    {
+        s_stats.retries++;
+        st.cw = st.cw * 2 + 1 > CW_MAX ? CW_MAX : st.cw * 2 + 1;
+        f->collided = false;
+        done = false;
+    }
+
+    if (done)
+    {
+        st.queue.pop_front();
+        s_free_frames.push_back(id);
+    }
+
+    // Post-transmit backoff, also taken before a retry
+    st.backoff = 1 + (int)arena_uniform_int(st.cw);
+    if (!st.queue.empty())
+        plan_start(s);
+}
+
+const arena_medium_stats_t* medium_stats(void)
+{
+    return &s_stats;
+}
+
+const int64_t* medium_access_samples(size_t* count)
+{
+    *count = s_access_us.size();
+    return s_access_us.data();
+}
@@ -0,0 +1,10 @@
+# Versions of FreeRTOS-Kernel and LVGL the simulation builds against. Read by
+# sim.cmake and by fetch_deps.cmake, which caches them for offline builds.
+set(WEAPON_SIM_FREERTOS_KERNEL_URL https://github.com/FreeRTOS/FreeRTOS-Kernel.git)
+set(WEAPON_SIM_FREERTOS_KERNEL_TAG V11.1.0)
+set(WEAPON_SIM_LVGL_URL https://github.com/lvgl/lvgl.git)
+set(WEAPON_SIM_LVGL_TAG v8.3.11)
+
+# Checkouts in WEAPON_SIM_DEPS_DIR, one directory per dependency
+set(WEAPON_SIM_FREERTOS_KERNEL_DIR FreeRTOS-Kernel)
+set(WEAPON_SIM_LVGL_DIR lvgl)
@@ -0,0 +1,31 @@
+# Clone the simulation's dependencies at their pinned tags into the offline
+# cache that sim.cmake picks up. Run once while online:
+#   cmake [-DWEAPON_SIM_DEPS_DIR=<dir>] -P src/host/fetch_deps.cmake
+include("${CMAKE_CURRENT_LIST_DIR}/deps.cmake")
+
+if(NOT WEAPON_SIM_DEPS_DIR)
+    get_filename_component(WEAPON_SIM_DEPS_DIR "${CMAKE_CURRENT_LIST_DIR}/../../.sim-deps" ABSOLUTE)
+endif()
+
+find_package(Git REQUIRED)
+
+foreach(dep FREERTOS_KERNEL LVGL)
+    set(dir "${WEAPON_SIM_DEPS_DIR}/${WEAPON_SIM_${dep}_DIR}")
+    set(tag "${WEAPON_SIM_${dep}_TAG}")
+    if(EXISTS "${dir}/CMakeLists.txt")
+        execute_process(COMMAND "${GIT_EXECUTABLE}" -C "${dir}" describe --tags --exact-match
+            OUTPUT_VARIABLE have OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+        if(NOT have STREQUAL tag)
+            message(FATAL_ERROR "${dir} is not at ${tag}; remove it and run again")
+        endif()
+        message(STATUS "${dir}: ${tag}, already cached")
+        continue()
+    endif()
+    message(STATUS "Cloning ${WEAPON_SIM_${dep}_URL} ${tag} into ${dir}")
+    execute_process(COMMAND "${GIT_EXECUTABLE}" clone --depth 1 --branch "${tag}"
+            "${WEAPON_SIM_${dep}_URL}" "${dir}"
+        RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "Could not clone ${WEAPON_SIM_${dep}_URL} at ${tag}")
+    endif()
+endforeach()
@@ -0,0 +1,62 @@
+#pragma once
+
+// Kernel configuration for the host simulation (FreeRTOS POSIX port). Tick
+// rate and priorities match the ESP-IDF defaults the firmware is tuned for.
+
+#define configUSE_PREEMPTION 1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_TIME_SLICING 1
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+// Words. Each task is a pthread and needs at least PTHREAD_STACK_MIN.
+#define configMINIMAL_STACK_SIZE 4096
+#define configSTACK_DEPTH_TYPE uint32_t
+#define configMAX_TASK_NAME_LEN 16
+#define configTICK_TYPE_WIDTH_IN_BITS TICK_TYPE_WIDTH_32_BITS
+#define configUSE_MUTEXES 1
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_COUNTING_SEMAPHORES 1
+#define configUSE_TASK_NOTIFICATIONS 1
+#define configUSE_QUEUE_SETS 0
+#define configQUEUE_REGISTRY_SIZE 0
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configSUPPORT_STATIC_ALLOCATION 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configUSE_TRACE_FACILITY 1
+#define configUSE_STATS_FORMATTING_FUNCTIONS 1
+// The POSIX port clocks run-time stats from process CPU time
+#define configGENERATE_RUN_TIME_STATS 1
+#define configENABLE_BACKWARD_COMPATIBILITY 1
+
+#define configUSE_TIMERS 1
+#define configTIMER_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+#define configTIMER_QUEUE_LENGTH 20
+#define configTIMER_TASK_STACK_DEPTH configMINIMAL_STACK_SIZE
+
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskDelayUntil 1
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_vTaskPrioritySet 1
+#define INCLUDE_uxTaskPriorityGet 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetIdleTaskHandle 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_eTaskGetState 1
+#define INCLUDE_xTimerPendFunctionCall 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void vAssertCalled(const char* file, unsigned long line);
+#ifdef __cplusplus
+}
+#endif
+#define configASSERT(x)                        \
+    if (!(x))                                  \
+    vAssertCalled(__FILE__, __LINE__)
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// GPIO for the host simulation. Inputs are driven by the sim (trigger script
+// or gpio_sim_drive); ISR handlers run on the driving task.
+typedef int gpio_num_t;
+
+#define GPIO_NUM_MAX 22
+
+typedef enum
+{
+    GPIO_INTR_DISABLE,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+typedef enum
+{
+    GPIO_MODE_DISABLE,
+    GPIO_MODE_INPUT,
+    GPIO_MODE_OUTPUT,
+    GPIO_MODE_INPUT_OUTPUT,
+    GPIO_MODE_INPUT_OUTPUT_OD,
+} gpio_mode_t;
+
+typedef enum
+{
+    GPIO_PULLUP_DISABLE,
+    GPIO_PULLUP_ENABLE
+} gpio_pullup_t;
+
+typedef enum
+{
+    GPIO_PULLDOWN_DISABLE,
+    GPIO_PULLDOWN_ENABLE
+} gpio_pulldown_t;
+
+typedef struct
+{
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+typedef void (*gpio_isr_t)(void* arg);
+
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    esp_err_t gpio_config(const gpio_config_t* cfg);
+    esp_err_t gpio_reset_pin(gpio_num_t gpio_num);
+    esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+    esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, int pull);
+    int gpio_get_level(gpio_num_t gpio_num);
+    esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+    esp_err_t gpio_install_isr_service(int intr_alloc_flags);
+    esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args);
+    esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num);
+
+    // Sim only: set the external level on an input pin and fire its ISR
+    void gpio_sim_drive(gpio_num_t gpio_num, int level);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// I2C master for the host simulation. The only device on the bus is the
+// SSD1306 model in sim_i2c.cpp.
+typedef enum
+{
+    I2C_NUM_0 = 0,
+    I2C_NUM_MAX,
+} i2c_port_num_t;
+
+typedef enum
+{
+    I2C_ADDR_BIT_LEN_7 = 0,
+    I2C_ADDR_BIT_LEN_10,
+} i2c_addr_bit_len_t;
+
+typedef enum
+{
+    I2C_CLK_SRC_DEFAULT = 0,
+} i2c_clock_source_t;
+
+typedef struct i2c_master_bus_t* i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t* i2c_master_dev_handle_t;
+
+typedef struct
+{
+    i2c_port_num_t i2c_port;
+    int sda_io_num;
+    int scl_io_num;
+    i2c_clock_source_t clk_source;
+    uint8_t glitch_ignore_cnt;
+    int intr_priority;
+    size_t trans_queue_depth;
+    struct
+    {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct
+{
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+} i2c_device_config_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* cfg, i2c_master_bus_handle_t* ret_bus);
+    esp_err_t i2c_master_get_bus_handle(i2c_port_num_t port, i2c_master_bus_handle_t* ret_bus);
+    esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t* cfg,
+                                        i2c_master_dev_handle_t* ret_dev);
+    esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t* data, size_t len, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// esp_log.h for the host simulation: same line format as the device,
+// "I (1234) Tag: message", on stdout.
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void esp_log_level_set(const char* tag, esp_log_level_t level);
+    uint32_t esp_log_timestamp(void);
+    void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+        __attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ESP_LOG_LEVEL_LOCAL(level, letter, tag, format, ...) \
+    esp_log_write(level, tag, letter " (%lu) %s: " format "\n", (unsigned long)esp_log_timestamp(), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
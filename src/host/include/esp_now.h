@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_KEY_LEN 16
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef enum
+{
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef struct
+{
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[ESP_NOW_KEY_LEN];
+    uint8_t channel;
+    wifi_interface_t ifidx;
+    bool encrypt;
+    void* priv;
+} esp_now_peer_info_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Frames are written to the ESP-NOW trace instead of the air
+    esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len);
+    esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+    esp_err_t esp_now_del_peer(const uint8_t* peer_addr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // The simulation reports a fixed heap the size of a C3's free DRAM
+    uint32_t esp_get_free_heap_size(void);
+    uint32_t esp_get_minimum_free_heap_size(void);
+    const char* esp_get_idf_version(void);
+    void esp_restart(void) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
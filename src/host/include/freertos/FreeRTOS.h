@@ -0,0 +1,49 @@
+#pragma once
+
+// ESP-IDF flavour of FreeRTOS.h on top of the vanilla kernel's POSIX port.
+// Only what the firmware uses is mapped.
+#include <FreeRTOS.h>
+#include <stdint.h>
+
+// Single simulated core: an IDF spinlock is the kernel critical section
+typedef struct
+{
+    uint32_t owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+#undef portENTER_CRITICAL
+#undef portEXIT_CRITICAL
+#define portENTER_CRITICAL(mux) \
+    do                          \
+    {                           \
+        (void)(mux);            \
+        vPortEnterCritical();   \
+    } while (0)
+#define portEXIT_CRITICAL(mux) \
+    do                         \
+    {                          \
+        (void)(mux);           \
+        vPortExitCritical();   \
+    } while (0)
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+#define portENTER_CRITICAL_SAFE(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux) portEXIT_CRITICAL(mux)
+
+#define portNUM_PROCESSORS 1
+#define xPortGetCoreID() 0
+
+#ifndef pdTICKS_TO_MS
+#define pdTICKS_TO_MS(xTicks) ((TickType_t)((uint64_t)(xTicks) * 1000 / configTICK_RATE_HZ))
+#endif
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// Like ESP-IDF's idf_additions.h: FreeRTOS.h alone brings in the task, queue
+// and semaphore APIs
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
@@ -0,0 +1,4 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <event_groups.h>
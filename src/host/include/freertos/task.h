@@ -0,0 +1,17 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <task.h>
+
+// ESP-IDF sizes stacks in bytes, the kernel in words. Using the byte count as
+// words over-provisions (fine on a host) and the floor keeps every pthread
+// above PTHREAD_STACK_MIN.
+static inline configSTACK_DEPTH_TYPE sim_stack_depth(uint32_t idf_bytes)
+{
+    return idf_bytes < configMINIMAL_STACK_SIZE ? configMINIMAL_STACK_SIZE : idf_bytes;
+}
+
+#define xTaskCreate(fn, name, depth, arg, prio, handle) \
+    xTaskCreate((fn), (name), sim_stack_depth(depth), (arg), (prio), (handle))
+#define xTaskCreatePinnedToCore(fn, name, depth, arg, prio, handle, core) \
+    xTaskCreate((fn), (name), (depth), (arg), (prio), (handle))
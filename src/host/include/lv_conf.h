@@ -0,0 +1,38 @@
+// LVGL configuration for the host simulation: 1-bit colour like the
+// device's SSD1306 build, ticks from the simulated esp_timer clock.
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#include <stdint.h>
+
+#define LV_COLOR_DEPTH 1
+#define LV_COLOR_SCREEN_TRANSP 0
+
+#define LV_MEM_CUSTOM 1
+#define LV_MEM_CUSTOM_INCLUDE <stdlib.h>
+#define LV_MEM_CUSTOM_ALLOC malloc
+#define LV_MEM_CUSTOM_FREE free
+#define LV_MEM_CUSTOM_REALLOC realloc
+
+#define LV_DISP_DEF_REFR_PERIOD 30
+#define LV_DPI_DEF 130
+
+#define LV_TICK_CUSTOM 1
+#define LV_TICK_CUSTOM_INCLUDE "esp_timer.h"
+#define LV_TICK_CUSTOM_SYS_TIME_EXPR ((uint32_t)(esp_timer_get_time() / 1000))
+
+#define LV_USE_LOG 0
+#define LV_USE_ASSERT_NULL 1
+#define LV_USE_ASSERT_MALLOC 1
+
+#define LV_FONT_MONTSERRAT_14 1
+#define LV_FONT_UNSCII_8 1
+#define LV_FONT_DEFAULT &lv_font_montserrat_14
+
+#define LV_USE_THEME_DEFAULT 0
+#define LV_USE_THEME_BASIC 0
+#define LV_USE_THEME_MONO 1
+
+#define LV_BUILD_EXAMPLES 0
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// In-memory NVS for the host simulation; contents live for one run
+typedef uint32_t nvs_handle_t;
+
+typedef enum
+{
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle);
+    void nvs_close(nvs_handle_t handle);
+    esp_err_t nvs_commit(nvs_handle_t handle);
+    esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key);
+    esp_err_t nvs_erase_all(nvs_handle_t handle);
+
+    esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length);
+    esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length);
+    esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length);
+    esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value);
+
+    esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value);
+    esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value);
+    esp_err_t nvs_get_u16(nvs_handle_t handle, const char* key, uint16_t* out_value);
+    esp_err_t nvs_set_u16(nvs_handle_t handle, const char* key, uint16_t value);
+    esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value);
+    esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value);
+    esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value);
+    esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,4 @@
+#pragma once
+
+// The simulated GPIO has no glitch filter; the software debounce still runs
+#define SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER 0
@@ -0,0 +1,165 @@
+// Host backend for laser_tx.h. Instead of driving a pin it records every
+// level change with the time it would occur on hardware, so edge timing and
+// jitter can be inspected on Linux. Like the RMT channel it holds at most
+// LASER_TX_QUEUE_DEPTH frames that have not finished playing; a send beyond
+// that waits up to its timeout for the oldest to finish.
+#include "laser_tx.h"
+#include <freertos/task.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+static std::mutex s_lock;
+static std::vector<laser_edge_t> s_edges;
+static int64_t (*s_now_us)(void) = nullptr;
+static int64_t s_busy_until_us = 0;
+static int64_t s_slot_end_us[LASER_TX_QUEUE_DEPTH];
+static int64_t s_last_start_us = 0;
+static uint32_t s_bit_us = 0;
+static uint32_t s_gap_us = 0;
+static bool s_initialized = false;
+
+static int64_t host_now_us(void)
+{
+    if (s_now_us)
+        return s_now_us();
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool laser_tx_init(int gpio_num, uint32_t bit_us, uint32_t gap_us)
+{
+    (void)gpio_num;
+    std::lock_guard<std::mutex> guard(s_lock);
+    s_bit_us = bit_us;
+    s_gap_us = gap_us;
+    s_busy_until_us = 0;
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+        s_slot_end_us[i] = 0;
+    s_initialized = true;
+    return true;
+}
+
+// Caller holds s_lock. A slot is free once its frame has left the pin.
+static int free_slot(int64_t now)
+{
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+    {
+        if (s_slot_end_us[i] <= now)
+            return i;
+    }
+    return -1;
+}
+
+// Caller holds s_lock
+static void play(int slot, const laser_frame_t* frame, int64_t now)
+{
+    int64_t t = now > s_busy_until_us ? now : s_busy_until_us;
+    s_last_start_us = t;
+
+    uint8_t level = 0;
+    for (uint8_t i = 0; i < frame->count; i++)
+    {
+        if (frame->symbols[i].level != level)
+        {
+            level = frame->symbols[i].level;
+            s_edges.push_back({t, level});
+        }
+        t += frame->symbols[i].duration_us;
+    }
+    if (level != 0)
+    {
+        s_edges.push_back({t, 0});
+    }
+    s_busy_until_us = t;
+    s_slot_end_us[slot] = t;
+}
+
+// Sleeps a tick at a time, so a clock set with laser_tx_host_set_clock
+// only frees slots as fast as it advances
+static bool wait_tick(TickType_t start, TickType_t timeout)
+{
+    if (timeout == 0 || (timeout != portMAX_DELAY && xTaskGetTickCount() - start >= timeout))
+        return false;
+    vTaskDelay(1);
+    return true;
+}
+
+bool laser_tx_send(const laser_frame_t* frame, TickType_t timeout)
+{
+    if (!s_initialized || !frame)
+        return false;
+
+    const TickType_t start = timeout ? xTaskGetTickCount() : 0;
+    do
+    {
+        std::lock_guard<std::mutex> guard(s_lock);
+        const int64_t now = host_now_us();
+        const int slot = free_slot(now);
+        if (slot >= 0)
+        {
+            play(slot, frame, now);
+            return true;
+        }
+    } while (wait_tick(start, timeout));
+    return false;
+}
+
+bool laser_tx_wait_idle(TickType_t timeout)
+{
+    if (!s_initialized)
+        return false;
+
+    const TickType_t start = timeout ? xTaskGetTickCount() : 0;
+    do
+    {
+        std::lock_guard<std::mutex> guard(s_lock);
+        if (s_busy_until_us <= host_now_us())
+            return true;
+    } while (wait_tick(start, timeout));
+    return false;
+}
+
+uint32_t laser_tx_bit_us(void)
+{
+    return s_bit_us;
+}
+
+uint32_t laser_tx_gap_us(void)
+{
+    return s_gap_us;
+}
+
+uint32_t laser_tx_frame_interval_us(void)
+{
+    return MESSAGE_TOTAL_BITS * s_bit_us + s_gap_us;
+}
+
+int64_t laser_tx_last_start_us(void)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    return s_last_start_us;
+}
+
+void laser_tx_host_set_clock(int64_t (*now_us)(void))
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    s_now_us = now_us;
+}
+
+const laser_edge_t* laser_tx_host_edges(size_t* count)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (count)
+        *count = s_edges.size();
+    return s_edges.data();
+}
+
+void laser_tx_host_clear(void)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    s_edges.clear();
+    s_busy_until_us = 0;
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+        s_slot_end_us[i] = 0;
+}
@@ -0,0 +1,116 @@
+# Host-native simulation of the weapon firmware. app_main and every task run
+# on the FreeRTOS POSIX port; GPIO, the laser, the OLED, ESP-NOW and Wi-Fi are
+# replaced by the sim drivers in this directory. Included from
+# src/CMakeLists.txt when ESP-IDF is not driving the build.
+include(FetchContent)
+
+set(WEAPON_SHARED_DIR "${CMAKE_CURRENT_LIST_DIR}/../../../shared" CACHE PATH
+    "Directory of the shared component")
+
+# Shared modules that talk to hardware; the sim provides its own versions.
+# display_manager is built from this tree (WEAPON_SRCS) instead.
+set(WEAPON_SIM_REPLACED
+    espnow_comm wifi_manager ws_server display_init display_manager gpio_init debug_print
+    CACHE STRING "Shared sources replaced by sim drivers")
+
+# The kernel and LVGL come from WEAPON_SIM_DEPS_DIR when host/fetch_deps.cmake
+# has cached them there, and are fetched otherwise.
+# FETCHCONTENT_SOURCE_DIR_FREERTOS_KERNEL / _LVGL still take precedence.
+include("${CMAKE_CURRENT_LIST_DIR}/deps.cmake")
+set(WEAPON_SIM_DEPS_DIR "${CMAKE_CURRENT_LIST_DIR}/../../.sim-deps" CACHE PATH
+    "Offline cache of the simulation's dependencies (host/fetch_deps.cmake)")
+foreach(dep FREERTOS_KERNEL LVGL)
+    set(dir "${WEAPON_SIM_DEPS_DIR}/${WEAPON_SIM_${dep}_DIR}")
+    if(NOT FETCHCONTENT_SOURCE_DIR_${dep} AND EXISTS "${dir}/CMakeLists.txt")
+        set(FETCHCONTENT_SOURCE_DIR_${dep} "${dir}")
+    endif()
+endforeach()
+FetchContent_Declare(freertos_kernel
+    GIT_REPOSITORY ${WEAPON_SIM_FREERTOS_KERNEL_URL}
+    GIT_TAG ${WEAPON_SIM_FREERTOS_KERNEL_TAG}
+    GIT_SHALLOW TRUE)
+FetchContent_Declare(lvgl
+    GIT_REPOSITORY ${WEAPON_SIM_LVGL_URL}
+    GIT_TAG ${WEAPON_SIM_LVGL_TAG}
+    GIT_SHALLOW TRUE)
+
+add_library(freertos_config INTERFACE)
+target_include_directories(freertos_config SYSTEM INTERFACE "${CMAKE_CURRENT_LIST_DIR}/include")
+set(FREERTOS_PORT GCC_POSIX CACHE STRING "" FORCE)
+set(FREERTOS_HEAP 3 CACHE STRING "" FORCE)
+
+set(LV_CONF_PATH "${CMAKE_CURRENT_LIST_DIR}/include/lv_conf.h" CACHE STRING "" FORCE)
+
+# Populate by hand so the libraries' own examples and demos stay out of "all"
+if(POLICY CMP0169)
+    cmake_policy(SET CMP0169 OLD)
+endif()
+foreach(dep freertos_kernel lvgl)
+    FetchContent_GetProperties(${dep})
+    if(NOT ${dep}_POPULATED)
+        FetchContent_Populate(${dep})
+        add_subdirectory(${${dep}_SOURCE_DIR} ${${dep}_BINARY_DIR} EXCLUDE_FROM_ALL)
+    endif()
+endforeach()
+
+file(GLOB WEAPON_SHARED_SRCS CONFIGURE_DEPENDS
+    "${WEAPON_SHARED_DIR}/src/*.c"
+    "${WEAPON_SHARED_DIR}/src/*.cpp")
+foreach(name ${WEAPON_SIM_REPLACED})
+    list(FILTER WEAPON_SHARED_SRCS EXCLUDE REGEX "/${name}\\.c(pp)?$")
+endforeach()
+
+# ESP-IDF services on the host: logging, esp_timer and NVS. Shared by the
+# sim and the host tests (test/), which provide sim_options() and sim_stop().
+add_library(weapon_host STATIC
+    "host/sim_idf.cpp"
+    "host/sim_nvs.cpp"
+    "host/sim_timer.cpp")
+target_include_directories(weapon_host PUBLIC
+    "${CMAKE_CURRENT_LIST_DIR}/include"
+    "${CMAKE_CURRENT_LIST_DIR}"
+    "${CMAKE_CURRENT_LIST_DIR}/../../include"
+    "${WEAPON_SHARED_DIR}/include")
+target_compile_definitions(weapon_host PUBLIC WEAPON_SIM=1 WEAPON_DEVICE)
+target_compile_features(weapon_host PUBLIC cxx_std_17)
+target_link_libraries(weapon_host PUBLIC freertos_kernel pthread)
+# LVGL's tick is esp_timer_get_time() (lv_conf.h); resolve it whatever the
+# link order of the target using LVGL
+target_link_libraries(lvgl INTERFACE weapon_host)
+
+set(WEAPON_SIM_SRCS ${WEAPON_SRCS})
+list(REMOVE_ITEM WEAPON_SIM_SRCS "laser_tx.cpp")
+list(APPEND WEAPON_SIM_SRCS
+    "host/laser_tx_host.cpp"
+    "host/sim_board.cpp"
+    "host/sim_display.cpp"
+    "host/sim_espnow.cpp"
+    "host/sim_gpio.cpp"
+    "host/sim_i2c.cpp"
+    "host/sim_main.cpp"
+    "host/sim_net.cpp")
+
+add_executable(weapon_sim ${WEAPON_SIM_SRCS} ${WEAPON_SHARED_SRCS})
+target_compile_definitions(weapon_sim PRIVATE
+    RAYZ_VERSION="sim"
+    LATENCY_BENCH=1)
+target_link_libraries(weapon_sim PRIVATE weapon_host lvgl)
+
+# Many weapons and vests on one simulated channel. A discrete-event model over
+# the firmware's pure modules rather than N firmware instances; no scheduler.
+add_executable(weapon_arena
+    "host/arena/arena.cpp"
+    "host/arena/arena_medium.cpp"
+    "espnow_tx_policy.cpp"
+    "fire_mode.cpp"
+    "hit_dedup.cpp"
+    "laser_frame.cpp"
+    "ws_codec.cpp")
+target_include_directories(weapon_arena PRIVATE
+    "${CMAKE_CURRENT_LIST_DIR}/include"
+    "${CMAKE_CURRENT_LIST_DIR}/../../include"
+    "${WEAPON_SHARED_DIR}/include")
+target_compile_definitions(weapon_arena PRIVATE WEAPON_SIM=1 WEAPON_DEVICE)
+target_compile_features(weapon_arena PRIVATE cxx_std_17)
+# fire_mode's config lock uses the port's critical sections
+target_link_libraries(weapon_arena PRIVATE freertos_kernel)
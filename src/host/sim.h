@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Options of one simulation run, filled from the command line
+    typedef struct
+    {
+        const char* trigger_script; // "<t_ms> press|release" per line, or NULL
+        const char* trace_dir;      // laser.trace, espnow.trace and frames/ go here
+        uint32_t duration_ms;       // 0 runs until SIGINT
+        uint32_t frame_ms;          // minimum spacing of dumped OLED frames
+        uint8_t mac[6];
+        uint32_t bench_shots;       // trigger pulls by the latency bench, 0 = off
+        const char* bench_baseline; // latency baseline to check against, or NULL
+        const char* ws_script;      // "<t_ms> <command>" lines of a WebSocket client, or NULL
+    } sim_options_t;
+
+    const sim_options_t* sim_options(void);
+
+    // Open a file in the trace directory, "w" mode. NULL on failure.
+    FILE* sim_trace_open(const char* name);
+
+    // End the run from any task: the supervisor runs the exit hooks and exits
+    void sim_stop(void);
+
+    // Make the process exit non-zero once the run ends
+    void sim_fail(void);
+
+    // Hook run once on the supervisor task when the run ends
+    void sim_at_exit(void (*fn)(void));
+
+    // Start the esp_timer dispatch task; called before the scheduler starts
+    void sim_timer_start(void);
+
+    // Start the task that plays the trigger script
+    void sim_gpio_start_script(const char* path);
+
+    // Start the task that dumps OLED frames as PGM images
+    void sim_i2c_start_panel(void);
+
+    // Log every key in the in-memory NVS
+    void sim_nvs_dump(void);
+
+    // Deliver a frame to espnow_comm_receive as if it came over the air
+    bool espnow_sim_inject(const uint8_t src_mac[6], const uint8_t* data, int len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+// Board bring-up from the shared gpio_init/debug_print modules, for the host
+// simulation.
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include "config.h"
+#include "debug_print.h"
+#include "gpio_init.h"
+#include "sim.h"
+
+static const char* TAG = "SimBoard";
+
+void init_reset_button_and_check_factory_reset(void)
+{
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = (1ULL << RESET_BUTTON_PIN);
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    gpio_config(&io_conf);
+
+    if (gpio_get_level((gpio_num_t)RESET_BUTTON_PIN) == 0)
+        ESP_LOGW(TAG, "Reset button held at boot; factory reset is not simulated");
+}
+
+void init_laser_gpio(int pin)
+{
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = (1ULL << pin);
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    gpio_config(&io_conf);
+    gpio_set_level((gpio_num_t)pin, 0);
+}
+
+void debug_print_nvs_contents(void)
+{
+    sim_nvs_dump();
+}
@@ -0,0 +1,99 @@
+// init_display() for the host simulation. Sets up LVGL the way the device's
+// SSD1306 port does: 1-bit colour rendered straight into panel page layout
+// (set_px_cb plus an 8-row rounder), flushed over the simulated I2C bus.
+#include <driver/i2c_master.h>
+#include <esp_log.h>
+#include <lvgl.h>
+#include <string.h>
+#include "config.h"
+#include "display_init.h"
+
+static const char* TAG = "SimDisplay";
+
+#define SIM_OLED_FB_SIZE (OLED_WIDTH * OLED_HEIGHT / 8)
+
+static i2c_master_dev_handle_t s_dev;
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_disp_drv_t s_drv;
+// LVGL sizes the draw buffer in lv_color_t units; page layout needs one bit
+// per pixel, so this is oversized by 8x like the device port's buffer
+static lv_color_t s_buf[OLED_WIDTH * OLED_HEIGHT];
+static uint8_t s_tx[SIM_OLED_FB_SIZE + 1];
+
+static void rounder_cb(lv_disp_drv_t* drv, lv_area_t* area)
+{
+    (void)drv;
+    area->y1 = area->y1 & ~7;
+    area->y2 = area->y2 | 7;
+}
+
+static void set_px_cb(lv_disp_drv_t* drv, uint8_t* buf, lv_coord_t buf_w, lv_coord_t x, lv_coord_t y,
+                      lv_color_t color, lv_opa_t opa)
+{
+    (void)drv;
+    (void)opa;
+    uint8_t* byte = &buf[(y / 8) * buf_w + x];
+    const uint8_t bit = 1u << (y % 8);
+    if (color.full)
+        *byte |= bit;
+    else
+        *byte &= ~bit;
+}
+
+// Full-window flush, used until oled_flush_attach() takes over
+static void flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map)
+{
+    const uint8_t p0 = area->y1 / 8;
+    const uint8_t p1 = area->y2 / 8;
+    const uint8_t cmd[] = {0x00, 0x21, (uint8_t)area->x1, (uint8_t)area->x2, 0x22, p0, p1};
+    const size_t len = (size_t)(area->x2 - area->x1 + 1) * (p1 - p0 + 1);
+
+    if (i2c_master_transmit(s_dev, cmd, sizeof(cmd), 50) == ESP_OK && len <= SIM_OLED_FB_SIZE)
+    {
+        s_tx[0] = 0x40;
+        memcpy(&s_tx[1], color_map, len);
+        i2c_master_transmit(s_dev, s_tx, len + 1, 50);
+    }
+    lv_disp_flush_ready(drv);
+}
+
+lv_disp_t* init_display(void)
+{
+    i2c_master_bus_config_t bus_cfg = {};
+    bus_cfg.i2c_port = I2C_NUM_0;
+    bus_cfg.clk_source = I2C_CLK_SRC_DEFAULT;
+    i2c_master_bus_handle_t bus;
+    if (i2c_new_master_bus(&bus_cfg, &bus) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "I2C bus init failed");
+        return NULL;
+    }
+
+    i2c_device_config_t dev_cfg = {};
+    dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_cfg.device_address = OLED_I2C_ADDR;
+    dev_cfg.scl_speed_hz = 400000;
+    if (i2c_master_bus_add_device(bus, &dev_cfg, &s_dev) != ESP_OK)
+        return NULL;
+
+    const uint8_t init_cmds[] = {0x00, 0xAE, 0xA8, OLED_HEIGHT - 1, 0x20, 0x00, 0x8D, 0x14, 0xAF};
+    if (i2c_master_transmit(s_dev, init_cmds, sizeof(init_cmds), 50) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "OLED not responding at 0x%02X", OLED_I2C_ADDR);
+        return NULL;
+    }
+
+    lv_init();
+    lv_disp_draw_buf_init(&s_draw_buf, s_buf, NULL, OLED_WIDTH * OLED_HEIGHT);
+    lv_disp_drv_init(&s_drv);
+    s_drv.hor_res = OLED_WIDTH;
+    s_drv.ver_res = OLED_HEIGHT;
+    s_drv.draw_buf = &s_draw_buf;
+    s_drv.rounder_cb = rounder_cb;
+    s_drv.set_px_cb = set_px_cb;
+    s_drv.flush_cb = flush_cb;
+
+    lv_disp_t* disp = lv_disp_drv_register(&s_drv);
+    ESP_LOGI(TAG, "Simulated SSD1306 %dx%d at 0x%02X", OLED_WIDTH, OLED_HEIGHT, OLED_I2C_ADDR);
+    return disp;
+}
@@ -0,0 +1,131 @@
+// ESP-NOW for the host simulation. Everything the firmware puts on the air is
+// appended to espnow.trace as "<t_us> tx <dst> <len> <hex>"; received frames
+// come from espnow_sim_inject() and are unpacked like the shared driver does.
+#include <esp_now.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <string.h>
+#include "espnow_comm.h"
+#include "espnow_tx.h"
+#include "sim.h"
+
+static const char* TAG = "SimEspNow";
+
+#define SIM_ESPNOW_RX_DEPTH 16
+
+static QueueHandle_t s_rx;
+static FILE* s_trace;
+static uint32_t s_tx_frames;
+
+static void close_trace(void)
+{
+    if (s_trace)
+        fclose(s_trace);
+    s_trace = NULL;
+    ESP_LOGI(TAG, "%lu frames sent", (unsigned long)s_tx_frames);
+}
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len)
+{
+    if (!s_rx)
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    if (!peer_addr || !data || len == 0 || len > ESP_NOW_MAX_DATA_LEN)
+        return ESP_ERR_INVALID_ARG;
+
+    char line[40 + 2 * ESP_NOW_MAX_DATA_LEN];
+    int n = snprintf(line, sizeof(line), "%lld tx %02x:%02x:%02x:%02x:%02x:%02x %u ",
+                     (long long)esp_timer_get_time(), peer_addr[0], peer_addr[1], peer_addr[2], peer_addr[3],
+                     peer_addr[4], peer_addr[5], (unsigned)len);
+    for (size_t i = 0; i < len; i++)
+        n += snprintf(&line[n], sizeof(line) - n, "%02x", data[i]);
+    line[n++] = '\n';
+
+    vTaskSuspendAll();
+    if (!s_trace)
+    {
+        s_trace = sim_trace_open("espnow.trace");
+        if (s_trace)
+            sim_at_exit(close_trace);
+    }
+    if (s_trace)
+    {
+        fwrite(line, 1, n, s_trace);
+        fflush(s_trace);
+    }
+    s_tx_frames++;
+    xTaskResumeAll();
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer)
+{
+    return peer ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t* peer_addr)
+{
+    return peer_addr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t espnow_comm_init(const EspnowCommConfig* cfg)
+{
+    if (!s_rx)
+    {
+        s_rx = xQueueCreate(SIM_ESPNOW_RX_DEPTH, sizeof(EspnowMessageEnvelope));
+        if (!s_rx)
+            return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Simulated ESP-NOW on channel %u", cfg ? cfg->channel : 0);
+    return ESP_OK;
+}
+
+bool espnow_comm_broadcast(const PlayerMessage* msg)
+{
+    static const uint8_t broadcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    return esp_now_send(broadcast_mac, (const uint8_t*)msg, sizeof(*msg)) == ESP_OK;
+}
+
+bool espnow_comm_receive(EspnowMessageEnvelope* env, TickType_t timeout)
+{
+    if (!s_rx)
+    {
+        vTaskDelay(timeout == portMAX_DELAY ? pdMS_TO_TICKS(1000) : timeout);
+        return false;
+    }
+    return xQueueReceive(s_rx, env, timeout) == pdTRUE;
+}
+
+void espnow_comm_load_peers_from_csv(const char* csv)
+{
+    ESP_LOGI(TAG, "Peer list: %s", csv ? csv : "(none)");
+}
+
+bool espnow_sim_inject(const uint8_t src_mac[6], const uint8_t* data, int len)
+{
+    if (!s_rx || !data)
+        return false;
+
+    EspnowMessageEnvelope env;
+    memcpy(env.src_mac, src_mac, sizeof(env.src_mac));
+    if (len == (int)sizeof(PlayerMessage))
+    {
+        memcpy(&env.msg, data, sizeof(env.msg));
+        return xQueueSend(s_rx, &env, 0) == pdTRUE;
+    }
+
+    const EspnowShotBatch* batch = (const EspnowShotBatch*)data;
+    if (len < (int)sizeof(EspnowShotBatch) || batch->magic != ESPNOW_SHOT_BATCH_MAGIC ||
+        len != (int)(sizeof(EspnowShotBatch) + batch->count * sizeof(PlayerMessage)))
+        return false;
+    for (uint8_t i = 0; i < batch->count; i++)
+    {
+        memcpy(&env.msg, &batch->msgs[i], sizeof(env.msg));
+        if (xQueueSend(s_rx, &env, 0) != pdTRUE)
+            return false;
+    }
+    return true;
+}
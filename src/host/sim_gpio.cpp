@@ -0,0 +1,276 @@
+// GPIO for the host simulation. Outputs only store their level; inputs take
+// an external level set by gpio_sim_drive(), which runs the pin's ISR handler
+// on the calling task the way the interrupt would preempt on hardware. A pin
+// that is input and output at once sees its own writes, so those fire the
+// ISR too.
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "sim.h"
+
+static const char* TAG = "SimGpio";
+
+#define SIM_SCRIPT_MAX_STEPS 256
+
+typedef struct
+{
+    gpio_mode_t mode;
+    gpio_int_type_t intr;
+    bool pull_up;
+    bool driven;   // external level set by the sim
+    uint8_t level; // external input level when driven
+    uint8_t out;   // output register
+    gpio_isr_t isr;
+    void* isr_arg;
+} sim_pin_t;
+
+typedef struct
+{
+    uint32_t t_ms;
+    uint8_t level;
+} script_step_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static sim_pin_t s_pins[GPIO_NUM_MAX];
+static bool s_isr_service;
+static script_step_t s_steps[SIM_SCRIPT_MAX_STEPS];
+static int s_step_count;
+
+static bool valid_pin(gpio_num_t gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+// Callers hold s_mux
+static int read_level(const sim_pin_t* pin)
+{
+    if (pin->mode == GPIO_MODE_OUTPUT || pin->mode == GPIO_MODE_INPUT_OUTPUT)
+        return pin->out;
+    // Open drain only ever pulls low
+    if (pin->mode == GPIO_MODE_INPUT_OUTPUT_OD && pin->out == 0)
+        return 0;
+    if (pin->driven)
+        return pin->level;
+    return pin->pull_up ? 1 : 0;
+}
+
+static bool edge_fires(gpio_int_type_t intr, int before, int after);
+
+esp_err_t gpio_config(const gpio_config_t* cfg)
+{
+    if (!cfg)
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    for (int i = 0; i < GPIO_NUM_MAX; i++)
+    {
+        if (!(cfg->pin_bit_mask & (1ULL << i)))
+            continue;
+        s_pins[i].mode = cfg->mode;
+        s_pins[i].intr = cfg->intr_type;
+        s_pins[i].pull_up = cfg->pull_up_en == GPIO_PULLUP_ENABLE;
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    if (!valid_pin(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    const bool driven = s_pins[gpio_num].driven;
+    const uint8_t level = s_pins[gpio_num].level;
+    memset(&s_pins[gpio_num], 0, sizeof(s_pins[gpio_num]));
+    s_pins[gpio_num].pull_up = true;
+    s_pins[gpio_num].driven = driven;
+    s_pins[gpio_num].level = driven ? level : 0;
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    if (!valid_pin(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    s_pins[gpio_num].mode = mode;
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, int pull)
+{
+    if (!valid_pin(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    s_pins[gpio_num].pull_up = pull == 0; // GPIO_PULLUP_ONLY
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (!valid_pin(gpio_num))
+        return 0;
+    portENTER_CRITICAL(&s_mux);
+    const int level = read_level(&s_pins[gpio_num]);
+    portEXIT_CRITICAL(&s_mux);
+    return level;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!valid_pin(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    sim_pin_t* pin = &s_pins[gpio_num];
+    const int before = read_level(pin);
+    pin->out = level ? 1 : 0;
+    const int after = read_level(pin);
+    const bool loops_back = pin->mode == GPIO_MODE_INPUT_OUTPUT || pin->mode == GPIO_MODE_INPUT_OUTPUT_OD;
+    const gpio_isr_t isr = loops_back && edge_fires(pin->intr, before, after) ? pin->isr : NULL;
+    void* arg = pin->isr_arg;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (isr)
+        isr(arg);
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    if (s_isr_service)
+        return ESP_ERR_INVALID_STATE;
+    s_isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args)
+{
+    if (!valid_pin(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    if (!s_isr_service)
+        return ESP_ERR_INVALID_STATE;
+    portENTER_CRITICAL(&s_mux);
+    s_pins[gpio_num].isr = isr_handler;
+    s_pins[gpio_num].isr_arg = args;
+    portEXIT_CRITICAL(&s_mux);
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
+
+static bool edge_fires(gpio_int_type_t intr, int before, int after)
+{
+    switch (intr)
+    {
+    case GPIO_INTR_POSEDGE:
+        return before == 0 && after == 1;
+    case GPIO_INTR_NEGEDGE:
+        return before == 1 && after == 0;
+    case GPIO_INTR_ANYEDGE:
+        return before != after;
+    case GPIO_INTR_LOW_LEVEL:
+        return after == 0;
+    case GPIO_INTR_HIGH_LEVEL:
+        return after == 1;
+    default:
+        return false;
+    }
+}
+
+void gpio_sim_drive(gpio_num_t gpio_num, int level)
+{
+    if (!valid_pin(gpio_num))
+        return;
+
+    portENTER_CRITICAL(&s_mux);
+    sim_pin_t* pin = &s_pins[gpio_num];
+    const int before = read_level(pin);
+    pin->driven = true;
+    pin->level = level ? 1 : 0;
+    const int after = read_level(pin);
+    const gpio_isr_t isr = edge_fires(pin->intr, before, after) ? pin->isr : NULL;
+    void* arg = pin->isr_arg;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (isr)
+        isr(arg);
+}
+
+static bool load_script(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        ESP_LOGE(TAG, "Cannot open trigger script %s", path);
+        return false;
+    }
+
+    char line[128];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        line_no++;
+        char* hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        unsigned long t_ms;
+        char action[16];
+        const int fields = sscanf(line, "%lu %15s", &t_ms, action);
+        if (fields <= 0)
+            continue;
+        if (fields != 2 || (strcmp(action, "press") != 0 && strcmp(action, "release") != 0))
+        {
+            ESP_LOGW(TAG, "%s:%d: expected \"<t_ms> press|release\"", path, line_no);
+            continue;
+        }
+        if (s_step_count == SIM_SCRIPT_MAX_STEPS)
+        {
+            ESP_LOGW(TAG, "%s: only the first %d steps are played", path, SIM_SCRIPT_MAX_STEPS);
+            break;
+        }
+        // Button is active LOW
+        s_steps[s_step_count].t_ms = (uint32_t)t_ms;
+        s_steps[s_step_count].level = strcmp(action, "press") == 0 ? 0 : 1;
+        s_step_count++;
+    }
+    fclose(f);
+    return true;
+}
+
+static void script_task(void* arg)
+{
+    (void)arg;
+    for (int i = 0; i < s_step_count; i++)
+    {
+        const int64_t now_ms = esp_timer_get_time() / 1000;
+        if (s_steps[i].t_ms > now_ms)
+            vTaskDelay(pdMS_TO_TICKS(s_steps[i].t_ms - now_ms));
+        ESP_LOGD(TAG, "Trigger %s", s_steps[i].level ? "release" : "press");
+        gpio_sim_drive((gpio_num_t)TRIGGER_BUTTON_PIN, s_steps[i].level);
+    }
+    ESP_LOGI(TAG, "Trigger script finished (%d steps)", s_step_count);
+    vTaskDelete(NULL);
+}
+
+void sim_gpio_start_script(const char* path)
+{
+    // Released until the script says otherwise
+    gpio_sim_drive((gpio_num_t)TRIGGER_BUTTON_PIN, 1);
+    if (!path || !load_script(path))
+        return;
+    // Just below esp_timer: edges land as promptly as an interrupt would
+    xTaskCreate(script_task, "sim_trigger", 4096, NULL, configMAX_PRIORITIES - 2, NULL);
+}
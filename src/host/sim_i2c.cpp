@@ -0,0 +1,283 @@
+// I2C master for the host simulation with an SSD1306 model at OLED_I2C_ADDR.
+// Command and data streams are decoded into the controller's GDDRAM exactly
+// as the panel would, so partial flushes are checked by what ends up on
+// screen. The panel task dumps the visible rows as PGM frames.
+#include <driver/i2c_master.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "sim.h"
+
+static const char* TAG = "SimI2c";
+
+#define SSD1306_COLUMNS 128
+#define SSD1306_RAM_PAGES 8
+#define SSD1306_CTRL_CMD 0x00
+#define SSD1306_CTRL_DATA 0x40
+
+typedef enum
+{
+    ADDR_HORIZONTAL = 0,
+    ADDR_VERTICAL = 1,
+    ADDR_PAGE = 2,
+} addr_mode_t;
+
+typedef struct
+{
+    uint8_t ram[SSD1306_RAM_PAGES * SSD1306_COLUMNS];
+    addr_mode_t mode;
+    uint8_t col_start, col_end;
+    uint8_t page_start, page_end;
+    uint8_t col, page;
+    bool on;
+    bool inverted;
+    bool dirty;
+} ssd1306_model_t;
+
+struct i2c_master_bus_t
+{
+    i2c_port_num_t port;
+};
+
+struct i2c_master_dev_t
+{
+    uint16_t address;
+};
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static i2c_master_bus_t* s_buses[I2C_NUM_MAX];
+// Power-on state: page addressing, full windows, display off
+static ssd1306_model_t s_oled = {
+    {0}, ADDR_PAGE, 0, SSD1306_COLUMNS - 1, 0, SSD1306_RAM_PAGES - 1, 0, 0, false, false, false,
+};
+static TaskHandle_t s_panel_task;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* cfg, i2c_master_bus_handle_t* ret_bus)
+{
+    if (!cfg || !ret_bus || cfg->i2c_port < 0 || cfg->i2c_port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if (s_buses[cfg->i2c_port])
+        return ESP_ERR_INVALID_STATE;
+    i2c_master_bus_t* bus = (i2c_master_bus_t*)calloc(1, sizeof(i2c_master_bus_t));
+    if (!bus)
+        return ESP_ERR_NO_MEM;
+    bus->port = cfg->i2c_port;
+    s_buses[cfg->i2c_port] = bus;
+    *ret_bus = bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_get_bus_handle(i2c_port_num_t port, i2c_master_bus_handle_t* ret_bus)
+{
+    if (port < 0 || port >= I2C_NUM_MAX || !ret_bus)
+        return ESP_ERR_INVALID_ARG;
+    if (!s_buses[port])
+        return ESP_ERR_INVALID_STATE;
+    *ret_bus = s_buses[port];
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t* cfg,
+                                    i2c_master_dev_handle_t* ret_dev)
+{
+    if (!bus || !cfg || !ret_dev)
+        return ESP_ERR_INVALID_ARG;
+    i2c_master_dev_t* dev = (i2c_master_dev_t*)calloc(1, sizeof(i2c_master_dev_t));
+    if (!dev)
+        return ESP_ERR_NO_MEM;
+    dev->address = cfg->device_address;
+    *ret_dev = dev;
+    return ESP_OK;
+}
+
+// Arguments following each command byte
+static int command_args(uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case 0x20: // memory addressing mode
+    case 0x81: // contrast
+    case 0x8D: // charge pump
+    case 0xA8: // multiplex ratio
+    case 0xD3: // display offset
+    case 0xD5: // clock divide
+    case 0xD9: // pre-charge
+    case 0xDA: // COM pins
+    case 0xDB: // VCOMH
+        return 1;
+    case 0x21: // column window
+    case 0x22: // page window
+    case 0xA3: // vertical scroll area
+        return 2;
+    case 0x29:
+    case 0x2A:
+        return 5;
+    case 0x26:
+    case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+// Callers hold s_mux
+static void run_command(ssd1306_model_t* m, const uint8_t* c)
+{
+    switch (c[0])
+    {
+    case 0x20:
+        m->mode = (addr_mode_t)(c[1] & 0x03);
+        break;
+    case 0x21:
+        m->col_start = c[1] & 0x7F;
+        m->col_end = c[2] & 0x7F;
+        m->col = m->col_start;
+        break;
+    case 0x22:
+        m->page_start = c[1] & 0x07;
+        m->page_end = c[2] & 0x07;
+        m->page = m->page_start;
+        break;
+    case 0xA6:
+    case 0xA7:
+        m->inverted = c[0] == 0xA7;
+        m->dirty = true;
+        break;
+    case 0xAE:
+    case 0xAF:
+        m->on = c[0] == 0xAF;
+        m->dirty = true;
+        break;
+    default:
+        if (c[0] >= 0xB0 && c[0] <= 0xB7)
+            m->page = c[0] & 0x07;
+        else if (c[0] <= 0x0F)
+            m->col = (m->col & 0xF0) | c[0];
+        else if (c[0] >= 0x10 && c[0] <= 0x17)
+            m->col = (uint8_t)((m->col & 0x0F) | ((c[0] & 0x07) << 4));
+        break;
+    }
+}
+
+// Callers hold s_mux
+static void write_data(ssd1306_model_t* m, uint8_t b)
+{
+    m->ram[m->page * SSD1306_COLUMNS + m->col] = b;
+    m->dirty = true;
+
+    switch (m->mode)
+    {
+    case ADDR_HORIZONTAL:
+        if (m->col++ >= m->col_end)
+        {
+            m->col = m->col_start;
+            m->page = m->page >= m->page_end ? m->page_start : m->page + 1;
+        }
+        break;
+    case ADDR_VERTICAL:
+        if (m->page++ >= m->page_end)
+        {
+            m->page = m->page_start;
+            m->col = m->col >= m->col_end ? m->col_start : m->col + 1;
+        }
+        break;
+    default:
+        // Page mode wraps within the page
+        m->col = (m->col + 1) % SSD1306_COLUMNS;
+        break;
+    }
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t* data, size_t len, int timeout_ms)
+{
+    (void)timeout_ms;
+    if (!dev || !data || len == 0)
+        return ESP_ERR_INVALID_ARG;
+    if (dev->address != OLED_I2C_ADDR)
+        return ESP_FAIL; // nobody acknowledges
+
+    portENTER_CRITICAL(&s_mux);
+    const uint8_t ctrl = data[0];
+    if (ctrl == SSD1306_CTRL_DATA)
+    {
+        for (size_t i = 1; i < len; i++)
+            write_data(&s_oled, data[i]);
+    }
+    else if (ctrl == SSD1306_CTRL_CMD)
+    {
+        size_t i = 1;
+        while (i < len)
+        {
+            const int args = command_args(data[i]);
+            if (i + args >= len)
+                break; // truncated command is ignored, as on the panel
+            run_command(&s_oled, &data[i]);
+            i += 1 + args;
+        }
+    }
+    const bool wake = s_oled.dirty;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (wake && s_panel_task)
+        xTaskNotifyGive(s_panel_task);
+    return ESP_OK;
+}
+
+static void write_frame(uint32_t index, const uint8_t* ram, bool on, bool inverted)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "frames/oled_%05lu_%08lld.pgm", (unsigned long)index,
+             (long long)(esp_timer_get_time() / 1000));
+    FILE* f = sim_trace_open(name);
+    if (!f)
+        return;
+
+    static uint8_t pixels[OLED_WIDTH * OLED_HEIGHT];
+    for (int y = 0; y < OLED_HEIGHT; y++)
+    {
+        for (int x = 0; x < OLED_WIDTH; x++)
+        {
+            const bool lit = (ram[(y / 8) * SSD1306_COLUMNS + x] >> (y % 8)) & 1;
+            pixels[y * OLED_WIDTH + x] = on && (lit != inverted) ? 255 : 0;
+        }
+    }
+    fprintf(f, "P5\n%d %d\n255\n", OLED_WIDTH, OLED_HEIGHT);
+    fwrite(pixels, 1, sizeof(pixels), f);
+    fclose(f);
+}
+
+static void panel_task(void* arg)
+{
+    (void)arg;
+    static uint8_t ram[sizeof(s_oled.ram)];
+    uint32_t index = 0;
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        portENTER_CRITICAL(&s_mux);
+        const bool dirty = s_oled.dirty;
+        memcpy(ram, s_oled.ram, sizeof(ram));
+        const bool on = s_oled.on;
+        const bool inverted = s_oled.inverted;
+        s_oled.dirty = false;
+        portEXIT_CRITICAL(&s_mux);
+
+        if (dirty)
+            write_frame(index++, ram, on, inverted);
+
+        // Rate limit: changes during the wait are merged into the next frame
+        vTaskDelay(pdMS_TO_TICKS(sim_options()->frame_ms));
+    }
+}
+
+void sim_i2c_start_panel(void)
+{
+    if (xTaskCreate(panel_task, "sim_panel", 4096, NULL, 1, &s_panel_task) != pdPASS)
+        ESP_LOGE(TAG, "Failed to create panel task");
+}
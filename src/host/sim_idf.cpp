@@ -0,0 +1,177 @@
+// Small ESP-IDF services for the host simulation: logging, error names,
+// heap figures, restart and the base MAC.
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+
+#define SIM_LOG_TAG_SLOTS 16
+#define SIM_LOG_LINE_MAX 512
+
+// Free DRAM of a C3 running the weapon firmware; the host heap has no
+// meaningful equivalent
+#define SIM_FREE_HEAP_BYTES (180 * 1024)
+
+typedef struct
+{
+    const char* tag;
+    esp_log_level_t level;
+} tag_level_t;
+
+static esp_log_level_t s_default_level = ESP_LOG_INFO;
+static tag_level_t s_tag_levels[SIM_LOG_TAG_SLOTS];
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0)
+    {
+        s_default_level = level;
+        return;
+    }
+    for (int i = 0; i < SIM_LOG_TAG_SLOTS; i++)
+    {
+        if (!s_tag_levels[i].tag || strcmp(s_tag_levels[i].tag, tag) == 0)
+        {
+            s_tag_levels[i].tag = tag;
+            s_tag_levels[i].level = level;
+            return;
+        }
+    }
+}
+
+static esp_log_level_t level_for(const char* tag)
+{
+    for (int i = 0; i < SIM_LOG_TAG_SLOTS && s_tag_levels[i].tag; i++)
+    {
+        if (strcmp(s_tag_levels[i].tag, tag) == 0)
+            return s_tag_levels[i].level;
+    }
+    return s_default_level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    if (level > level_for(tag))
+        return;
+
+    // Format first and emit with one write(): stdio's lock must not be held
+    // by a task the kernel suspends
+    char line[SIM_LOG_LINE_MAX];
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(line, sizeof(line), format, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    if (n >= (int)sizeof(line))
+    {
+        n = sizeof(line) - 1;
+        line[n - 1] = '\n';
+    }
+    ssize_t rc = write(STDOUT_FILENO, line, (size_t)n);
+    (void)rc;
+}
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_INITIALIZED:
+        return "ESP_ERR_NVS_NOT_INITIALIZED";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_TYPE_MISMATCH:
+        return "ESP_ERR_NVS_TYPE_MISMATCH";
+    case ESP_ERR_NVS_READ_ONLY:
+        return "ESP_ERR_NVS_READ_ONLY";
+    case ESP_ERR_NVS_INVALID_HANDLE:
+        return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH:
+        return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_ESPNOW_NOT_INIT:
+        return "ESP_ERR_ESPNOW_NOT_INIT";
+    case ESP_ERR_ESPNOW_EXIST:
+        return "ESP_ERR_ESPNOW_EXIST";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+void sim_error_check_failed(esp_err_t rc, const char* file, int line, const char* expr)
+{
+    char msg[SIM_LOG_LINE_MAX];
+    const int n = snprintf(msg, sizeof(msg), "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\nexpression: %s\n",
+                           rc, esp_err_to_name(rc), file, line, expr);
+    ssize_t wr = write(STDERR_FILENO, msg, n > 0 && n < (int)sizeof(msg) ? (size_t)n : strlen(msg));
+    (void)wr;
+    abort();
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return SIM_FREE_HEAP_BYTES;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return SIM_FREE_HEAP_BYTES;
+}
+
+const char* esp_get_idf_version(void)
+{
+    return "sim";
+}
+
+void esp_restart(void)
+{
+    ESP_LOGW("SimIdf", "esp_restart() called, ending the run");
+    sim_stop();
+    for (;;)
+        vTaskSuspend(NULL);
+}
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type)
+{
+    (void)type;
+    if (!mac)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(mac, sim_options()->mac, 6);
+    return ESP_OK;
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac)
+{
+    return esp_read_mac(mac, ESP_MAC_WIFI_STA);
+}
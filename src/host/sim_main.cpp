@@ -0,0 +1,266 @@
+// Entry point of the host simulation. Starts the FreeRTOS POSIX port, runs
+// app_main on a task as ESP-IDF does, and ends the run after --duration-ms or
+// on Ctrl-C, writing the traces on the way out.
+//
+//   weapon_sim [--trigger FILE] [--trace-dir DIR] [--duration-ms N]
+//              [--frame-ms N] [--mac AA:BB:CC:DD:EE:FF]
+//              [--bench N] [--bench-baseline FILE] [--ws-script FILE]
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "laser_tx.h"
+#include "latency_bench.h"
+#include "sim.h"
+
+static const char* TAG = "Sim";
+
+#define SIM_EXIT_HOOKS 8
+#define SIM_SUPERVISOR_POLL_MS 50
+
+extern "C" void app_main(void);
+
+static sim_options_t s_opts = {
+    NULL, "sim_out", 0, 100, {0x02, 0x00, 0x00, 0x00, 0x00, 0x01}, 0, NULL, NULL,
+};
+static void (*s_exit_hooks[SIM_EXIT_HOOKS])(void);
+static int s_exit_hook_count;
+static volatile sig_atomic_t s_stop;
+static volatile sig_atomic_t s_exit_code;
+
+const sim_options_t* sim_options(void)
+{
+    return &s_opts;
+}
+
+FILE* sim_trace_open(const char* name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", s_opts.trace_dir, name);
+    FILE* f = fopen(path, "w");
+    if (!f)
+        ESP_LOGW(TAG, "Cannot write %s: %s", path, strerror(errno));
+    return f;
+}
+
+void sim_at_exit(void (*fn)(void))
+{
+    if (s_exit_hook_count < SIM_EXIT_HOOKS)
+        s_exit_hooks[s_exit_hook_count++] = fn;
+}
+
+void sim_stop(void)
+{
+    s_stop = 1;
+}
+
+void sim_fail(void)
+{
+    s_exit_code = 1;
+}
+
+void vAssertCalled(const char* file, unsigned long line)
+{
+    fprintf(stderr, "FreeRTOS assert at %s:%lu\n", file, line);
+    abort();
+}
+
+static void on_sigint(int sig)
+{
+    (void)sig;
+    s_stop = 1;
+}
+
+// "<t_us> <level>" per recorded laser edge
+static void write_laser_trace(void)
+{
+    size_t count = 0;
+    const laser_edge_t* edges = laser_tx_host_edges(&count);
+    FILE* f = sim_trace_open("laser.trace");
+    if (!f)
+        return;
+    for (size_t i = 0; i < count; i++)
+        fprintf(f, "%lld %u\n", (long long)edges[i].t_us, edges[i].level);
+    fclose(f);
+    ESP_LOGI(TAG, "%u laser edges recorded", (unsigned)count);
+}
+
+// Trigger-to-photon percentiles of every shot of the run, in baseline format
+static void write_latency_report(void)
+{
+    lb_report_t report;
+    latency_bench_report(&report);
+    if (report.shots == 0)
+        return;
+    char text[512];
+    const size_t len = latency_bench_format(&report, text, sizeof(text));
+    FILE* f = sim_trace_open("latency.txt");
+    if (!f)
+        return;
+    fwrite(text, 1, len, f);
+    fclose(f);
+}
+
+static void on_bench_done(const lb_report_t* report, int regressions)
+{
+    (void)report;
+    if (regressions)
+        sim_fail();
+    sim_stop();
+}
+
+static char* read_file(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* text = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    if (text)
+        text[fread(text, 1, (size_t)size, f)] = '\0';
+    fclose(f);
+    return text;
+}
+
+static void main_task(void* arg)
+{
+    (void)arg;
+    app_main();
+    vTaskDelete(NULL);
+}
+
+static void supervisor_task(void* arg)
+{
+    (void)arg;
+    while (!s_stop && (s_opts.duration_ms == 0 || esp_timer_get_time() / 1000 < s_opts.duration_ms))
+        vTaskDelay(pdMS_TO_TICKS(SIM_SUPERVISOR_POLL_MS));
+
+    ESP_LOGI(TAG, "Run ended at %lld ms", (long long)(esp_timer_get_time() / 1000));
+    for (int i = 0; i < s_exit_hook_count; i++)
+        s_exit_hooks[i]();
+    fflush(NULL);
+    // Other tasks are parked threads that may hold locks; skip static teardown
+    _exit(s_exit_code);
+}
+
+static bool parse_mac(const char* s, uint8_t* mac)
+{
+    unsigned v[6];
+    if (sscanf(s, "%x:%x:%x:%x:%x:%x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+        return false;
+    for (int i = 0; i < 6; i++)
+        mac[i] = (uint8_t)v[i];
+    return true;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [--trigger FILE] [--trace-dir DIR] [--duration-ms N] [--frame-ms N] [--mac MAC]\n"
+            "          [--bench N] [--bench-baseline FILE] [--ws-script FILE]\n"
+            "  --trigger      script of \"<t_ms> press|release\" lines ('#' comments)\n"
+            "  --trace-dir    where laser.trace, espnow.trace and frames/ go (default sim_out)\n"
+            "  --duration-ms  end the run after N ms (default: run until Ctrl-C)\n"
+            "  --frame-ms     minimum spacing of dumped OLED frames (default 100)\n"
+            "  --mac          base MAC of the simulated device\n"
+            "  --bench        pull the trigger N times, write latency.txt and stop\n"
+            "  --bench-baseline FILE  exit 1 if latency regressed against FILE\n"
+            "  --ws-script    connect a WebSocket client sending \"<t_ms> <command>\" lines;\n"
+            "                 what it receives goes to ws.trace\n",
+            prog);
+}
+
+static bool parse_args(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val)
+            return false;
+        if (strcmp(arg, "--trigger") == 0)
+            s_opts.trigger_script = val;
+        else if (strcmp(arg, "--trace-dir") == 0)
+            s_opts.trace_dir = val;
+        else if (strcmp(arg, "--duration-ms") == 0)
+            s_opts.duration_ms = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--frame-ms") == 0)
+            s_opts.frame_ms = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--bench") == 0)
+            s_opts.bench_shots = (uint32_t)strtoul(val, NULL, 0);
+        else if (strcmp(arg, "--bench-baseline") == 0)
+            s_opts.bench_baseline = val;
+        else if (strcmp(arg, "--ws-script") == 0)
+            s_opts.ws_script = val;
+        else if (strcmp(arg, "--mac") == 0)
+        {
+            if (!parse_mac(val, s_opts.mac))
+                return false;
+        }
+        else
+            return false;
+        i++;
+    }
+    return true;
+}
+
+static bool make_dir(const char* path)
+{
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+int main(int argc, char** argv)
+{
+    if (!parse_args(argc, argv))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char frames[512];
+    snprintf(frames, sizeof(frames), "%s/frames", s_opts.trace_dir);
+    if (!make_dir(s_opts.trace_dir) || !make_dir(frames))
+    {
+        fprintf(stderr, "cannot create %s: %s\n", frames, strerror(errno));
+        return 1;
+    }
+
+    struct sigaction sa = {};
+    sa.sa_handler = on_sigint;
+    sigaction(SIGINT, &sa, NULL);
+
+    latency_bench_cfg_t bench = {s_opts.bench_shots, 20, 0, NULL, on_bench_done};
+    if (s_opts.bench_baseline)
+    {
+        bench.baseline = read_file(s_opts.bench_baseline);
+        if (!bench.baseline)
+        {
+            fprintf(stderr, "cannot read %s: %s\n", s_opts.bench_baseline, strerror(errno));
+            return 1;
+        }
+    }
+    latency_bench_configure(&bench);
+
+    laser_tx_host_set_clock(esp_timer_get_time);
+    sim_at_exit(write_laser_trace);
+    sim_at_exit(write_latency_report);
+
+    sim_timer_start();
+    sim_gpio_start_script(s_opts.trigger_script);
+    sim_i2c_start_panel();
+    // ESP-IDF runs app_main on the main task at priority 1
+    xTaskCreate(main_task, "main", 3584, NULL, 1, NULL);
+    xTaskCreate(supervisor_task, "sim_supervisor", 4096, NULL, configMAX_PRIORITIES - 1, NULL);
+
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,281 @@
+// Wi-Fi manager and WebSocket server for the host simulation. The network is
+// up as soon as wifi_manager_init() runs. Without --ws-script the server never
+// has clients, so ws_task runs its housekeeping path only. With it one client
+// is connected over a socketpair: its "<t_ms> <command>" lines reach the
+// on_text hook at their time, and every frame written to it is logged to
+// ws.trace as "<t_us> <opcode> <len> <payload>", text as is and binary in hex.
+// The shared server's own messages are not modelled; each shows up as a
+// marker text frame naming the call.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "sim.h"
+#include "wifi_manager.h"
+#include "ws_out.h"
+#include "ws_server.h"
+
+static const char* TAG = "SimNet";
+
+#define SIM_WS_LINE_MAX 160
+#define SIM_WS_RX_MAX 4096
+
+static volatile bool s_connected;
+static char s_device_name[32];
+
+void wifi_manager_init(const char* device_prefix, const char* role)
+{
+    const uint8_t* mac = sim_options()->mac;
+    snprintf(s_device_name, sizeof(s_device_name), "%s-%02X%02X", device_prefix, mac[4], mac[5]);
+    s_connected = true;
+    ESP_LOGI(TAG, "Simulated network up as %s (%s)", s_device_name, role);
+}
+
+bool wifi_manager_is_connected(void)
+{
+    return s_connected;
+}
+
+uint8_t wifi_manager_get_channel(void)
+{
+    return 1;
+}
+
+bool wifi_manager_load_peer_list(char* buf, size_t len)
+{
+    (void)buf;
+    (void)len;
+    return false;
+}
+
+const char* wifi_manager_get_ip(void)
+{
+    return s_connected ? "127.0.0.1" : "0.0.0.0";
+}
+
+const char* wifi_manager_get_ssid(void)
+{
+    return "sim";
+}
+
+const char* wifi_manager_get_status_string(void)
+{
+    return s_connected ? "Connected" : "Connecting";
+}
+
+int wifi_manager_get_rssi(void)
+{
+    return s_connected ? -40 : 0;
+}
+
+const char* wifi_manager_get_device_name(void)
+{
+    return s_device_name;
+}
+
+static int s_ws_fd = -1;   // the firmware's end, as the server would pass it
+static int s_peer_fd = -1; // the scripted client's end
+static bool s_ws_open;
+static WsServerConfig s_cfg;
+static FILE* s_ws_trace;
+
+static void close_ws_trace(void)
+{
+    if (s_ws_trace)
+        fclose(s_ws_trace);
+    s_ws_trace = NULL;
+}
+
+static void trace_frame(uint8_t op, const uint8_t* payload, size_t len)
+{
+    if (!s_ws_trace)
+        return;
+    fprintf(s_ws_trace, "%lld %u %u ", (long long)esp_timer_get_time(), op, (unsigned)len);
+    if (op == 0x1)
+        fwrite(payload, 1, len, s_ws_trace);
+    else
+        for (size_t i = 0; i < len; i++)
+            fprintf(s_ws_trace, "%02x", payload[i]);
+    fputc('\n', s_ws_trace);
+    fflush(s_ws_trace);
+}
+
+// Logs every complete server frame in buf; returns the bytes consumed
+static size_t parse_frames(const uint8_t* buf, size_t len)
+{
+    size_t used = 0;
+    while (len - used >= 2)
+    {
+        const uint8_t* p = buf + used;
+        size_t hlen = 2;
+        uint64_t plen = p[1] & 0x7F;
+        if (plen == 126)
+        {
+            hlen = 4;
+            if (len - used < hlen)
+                break;
+            plen = (uint64_t)p[2] << 8 | p[3];
+        }
+        else if (plen == 127)
+        {
+            hlen = 10;
+            if (len - used < hlen)
+                break;
+            plen = 0;
+            for (int i = 0; i < 8; i++)
+                plen = plen << 8 | p[2 + i];
+        }
+        if (len - used < hlen + plen)
+            break;
+        trace_frame(p[0] & 0x0F, p + hlen, (size_t)plen);
+        used += hlen + (size_t)plen;
+    }
+    return used;
+}
+
+static bool next_command(FILE* f, uint32_t* at_ms, char* line)
+{
+    while (fgets(line, SIM_WS_LINE_MAX, f))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* end;
+        const unsigned long t = strtoul(line, &end, 10);
+        if (end == line || *end != ' ')
+            continue; // blank, comment or malformed
+        *at_ms = (uint32_t)t;
+        memmove(line, end + 1, strlen(end + 1) + 1);
+        return true;
+    }
+    return false;
+}
+
+static void ws_client_task(void* arg)
+{
+    FILE* script = (FILE*)arg;
+    static uint8_t rx[SIM_WS_RX_MAX];
+    size_t rx_len = 0;
+    char line[SIM_WS_LINE_MAX];
+    uint32_t at_ms = 0;
+    bool pending = next_command(script, &at_ms, line);
+
+    while (1)
+    {
+        if (pending && esp_timer_get_time() / 1000 >= at_ms)
+        {
+            if (!s_cfg.on_text || !s_cfg.on_text(s_ws_fd, line, strlen(line)))
+                ESP_LOGW(TAG, "Unknown command \"%s\"", line);
+            pending = next_command(script, &at_ms, line);
+            continue;
+        }
+
+        const ssize_t n = recv(s_peer_fd, rx + rx_len, sizeof(rx) - rx_len, MSG_DONTWAIT);
+        if (n > 0)
+        {
+            rx_len += (size_t)n;
+            const size_t used = parse_frames(rx, rx_len);
+            memmove(rx, rx + used, rx_len - used);
+            rx_len -= used;
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            ESP_LOGI(TAG, "WebSocket client disconnected");
+            break;
+        }
+        vTaskDelay(1);
+    }
+    fclose(script);
+    vTaskDelete(NULL);
+}
+
+// Stands in for a message the shared server writes itself
+static void send_marker(const char* what)
+{
+    if (!s_ws_open)
+        return;
+    uint8_t frame[2 + SIM_WS_LINE_MAX];
+    const size_t len = strlen(what);
+    const size_t hlen = ws_out_frame_header(frame, WS_OP_TEXT, len);
+    memcpy(frame + hlen, what, len);
+    if (send(s_ws_fd, frame, hlen + len, MSG_DONTWAIT) != (ssize_t)(hlen + len))
+        ESP_LOGW(TAG, "%s not delivered", what);
+}
+
+void ws_server_init(const WsServerConfig* cfg)
+{
+    s_cfg = *cfg;
+    const char* path = sim_options()->ws_script;
+    if (!path)
+    {
+        ESP_LOGI(TAG, "WebSocket server simulated without clients");
+        return;
+    }
+    FILE* script = fopen(path, "r");
+    int fds[2];
+    if (!script || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        ESP_LOGE(TAG, "Cannot start the scripted client %s: %s", path, strerror(errno));
+        if (script)
+            fclose(script);
+        return;
+    }
+    s_ws_fd = fds[0];
+    s_peer_fd = fds[1];
+    s_ws_trace = sim_trace_open("ws.trace");
+    sim_at_exit(close_ws_trace);
+
+    s_ws_open = true;
+    if (s_cfg.on_connect)
+        s_cfg.on_connect(s_ws_fd, true);
+    xTaskCreate(ws_client_task, "sim_ws", 4096, script, 2, NULL);
+}
+
+// Drops the session and reports it, as the server does
+void ws_server_close_client(int fd)
+{
+    if (fd != s_ws_fd || !s_ws_open)
+        return;
+    s_ws_open = false;
+    shutdown(fd, SHUT_RDWR);
+    if (s_cfg.on_connect)
+        s_cfg.on_connect(fd, false);
+}
+
+int ws_server_client_count(void)
+{
+    return s_ws_open ? 1 : 0;
+}
+
+bool ws_server_is_connected(void)
+{
+    return s_ws_open;
+}
+
+void ws_server_broadcast_shot(void)
+{
+    send_marker("ws_server shot");
+}
+
+void ws_server_broadcast_game_state(void)
+{
+    send_marker("ws_server game_state");
+}
+
+void ws_server_send_status(void)
+{
+    send_marker("ws_server status");
+}
+
+void ws_server_broadcast_respawn(void)
+{
+    send_marker("ws_server respawn");
+}
+
+void ws_server_cleanup_stale(void)
+{
+}
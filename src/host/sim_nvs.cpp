@@ -0,0 +1,257 @@
+// In-memory NVS for the host simulation. Namespaces and typed entries behave
+// like the flash implementation; contents live for one run.
+#include <nvs.h>
+#include <nvs_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "sim.h"
+
+static const char* TAG = "SimNvs";
+
+#define SIM_NVS_KEY_MAX 15
+
+typedef enum
+{
+    NVS_TYPE_U8,
+    NVS_TYPE_U16,
+    NVS_TYPE_U32,
+    NVS_TYPE_I32,
+    NVS_TYPE_STR,
+    NVS_TYPE_BLOB,
+} sim_nvs_type_t;
+
+typedef struct
+{
+    sim_nvs_type_t type;
+    std::vector<uint8_t> value;
+} sim_nvs_entry_t;
+
+typedef struct
+{
+    std::string ns;
+    bool writable;
+} sim_nvs_handle_t;
+
+// Guarded by suspending the scheduler, the way heap_3 guards malloc; the
+// containers allocate, so a critical section would be too tight
+static std::map<std::string, std::map<std::string, sim_nvs_entry_t>> s_store;
+static std::vector<sim_nvs_handle_t> s_handles;
+
+static const sim_nvs_handle_t* lookup(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > s_handles.size())
+        return NULL;
+    return &s_handles[handle - 1];
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    vTaskSuspendAll();
+    s_store.clear();
+    xTaskResumeAll();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    if (!name || !out_handle || strlen(name) > SIM_NVS_KEY_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_OK;
+    vTaskSuspendAll();
+    if (open_mode == NVS_READONLY && s_store.find(name) == s_store.end())
+    {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    }
+    else
+    {
+        s_store[name];
+        s_handles.push_back({name, open_mode == NVS_READWRITE});
+        *out_handle = (nvs_handle_t)s_handles.size();
+    }
+    xTaskResumeAll();
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    // Handles are never reused; closing only makes later use an error
+    vTaskSuspendAll();
+    if (handle > 0 && handle <= s_handles.size())
+        s_handles[handle - 1].ns.clear();
+    xTaskResumeAll();
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    vTaskSuspendAll();
+    const sim_nvs_handle_t* h = lookup(handle);
+    const bool ok = h && !h->ns.empty();
+    xTaskResumeAll();
+    return ok ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+static esp_err_t set_entry(nvs_handle_t handle, const char* key, sim_nvs_type_t type, const void* value,
+                           size_t len)
+{
+    if (!key || strlen(key) > SIM_NVS_KEY_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_OK;
+    vTaskSuspendAll();
+    const sim_nvs_handle_t* h = lookup(handle);
+    if (!h || h->ns.empty())
+    {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    else if (!h->writable)
+    {
+        err = ESP_ERR_NVS_READ_ONLY;
+    }
+    else
+    {
+        sim_nvs_entry_t& e = s_store[h->ns][key];
+        e.type = type;
+        e.value.assign((const uint8_t*)value, (const uint8_t*)value + len);
+    }
+    xTaskResumeAll();
+    return err;
+}
+
+// For strings and blobs *len is the buffer size in and the stored size out
+static esp_err_t get_entry(nvs_handle_t handle, const char* key, sim_nvs_type_t type, void* out, size_t* len)
+{
+    if (!key)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_OK;
+    vTaskSuspendAll();
+    const sim_nvs_handle_t* h = lookup(handle);
+    if (!h || h->ns.empty())
+    {
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    else
+    {
+        const auto& entries = s_store[h->ns];
+        const auto it = entries.find(key);
+        if (it == entries.end() || it->second.type != type)
+        {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        }
+        else
+        {
+            const std::vector<uint8_t>& v = it->second.value;
+            if (out && *len < v.size())
+                err = ESP_ERR_NVS_INVALID_LENGTH;
+            else if (out)
+                memcpy(out, v.data(), v.size());
+            *len = v.size();
+        }
+    }
+    xTaskResumeAll();
+    return err;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    esp_err_t err = ESP_OK;
+    vTaskSuspendAll();
+    const sim_nvs_handle_t* h = lookup(handle);
+    if (!h || h->ns.empty())
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    else if (!h->writable)
+        err = ESP_ERR_NVS_READ_ONLY;
+    else if (s_store[h->ns].erase(key ? key : "") == 0)
+        err = ESP_ERR_NVS_NOT_FOUND;
+    xTaskResumeAll();
+    return err;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    esp_err_t err = ESP_OK;
+    vTaskSuspendAll();
+    const sim_nvs_handle_t* h = lookup(handle);
+    if (!h || h->ns.empty())
+        err = ESP_ERR_NVS_INVALID_HANDLE;
+    else if (!h->writable)
+        err = ESP_ERR_NVS_READ_ONLY;
+    else
+        s_store[h->ns].clear();
+    xTaskResumeAll();
+    return err;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    if (!length)
+        return ESP_ERR_INVALID_ARG;
+    return get_entry(handle, key, NVS_TYPE_BLOB, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    if (!value && length)
+        return ESP_ERR_INVALID_ARG;
+    return set_entry(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length)
+{
+    if (!length)
+        return ESP_ERR_INVALID_ARG;
+    return get_entry(handle, key, NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value)
+{
+    if (!value)
+        return ESP_ERR_INVALID_ARG;
+    return set_entry(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+#define SIM_NVS_SCALAR(suffix, ctype, tag)                                                 \
+    esp_err_t nvs_get_##suffix(nvs_handle_t handle, const char* key, ctype* out_value)     \
+    {                                                                                      \
+        if (!out_value)                                                                    \
+            return ESP_ERR_INVALID_ARG;                                                    \
+        size_t len = sizeof(ctype);                                                        \
+        return get_entry(handle, key, tag, out_value, &len);                               \
+    }                                                                                      \
+    esp_err_t nvs_set_##suffix(nvs_handle_t handle, const char* key, ctype value)          \
+    {                                                                                      \
+        return set_entry(handle, key, tag, &value, sizeof(value));                         \
+    }
+
+SIM_NVS_SCALAR(u8, uint8_t, NVS_TYPE_U8)
+SIM_NVS_SCALAR(u16, uint16_t, NVS_TYPE_U16)
+SIM_NVS_SCALAR(u32, uint32_t, NVS_TYPE_U32)
+SIM_NVS_SCALAR(i32, int32_t, NVS_TYPE_I32)
+
+void sim_nvs_dump(void)
+{
+    // Copy out first so the scheduler is not held while logging
+    std::vector<std::string> lines;
+    vTaskSuspendAll();
+    for (const auto& ns : s_store)
+    {
+        for (const auto& kv : ns.second)
+            lines.push_back(ns.first + "/" + kv.first + " (" + std::to_string(kv.second.value.size()) + " bytes)");
+    }
+    xTaskResumeAll();
+
+    ESP_LOGI(TAG, "NVS (in memory): %u keys", (unsigned)lines.size());
+    for (const std::string& line : lines)
+        ESP_LOGI(TAG, "  %s", line.c_str());
+}
@@ -0,0 +1,198 @@
+// esp_timer for the host simulation. Armed timers sit in a list sorted by
+// alarm time; one top-priority task sleeps until the earliest alarm and runs
+// callbacks in order, like ESP_TIMER_TASK dispatch. Resolution is the kernel
+// tick (1 ms), coarser than the device's 1 us.
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sim.h"
+
+static const char* TAG = "SimTimer";
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+    int64_t alarm_us;
+    uint64_t period_us;
+    bool armed;
+    esp_timer* next;
+};
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer* s_armed;
+static TaskHandle_t s_task;
+
+static int64_t host_monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static const int64_t s_epoch_us = host_monotonic_us();
+
+int64_t esp_timer_get_time(void)
+{
+    return host_monotonic_us() - s_epoch_us;
+}
+
+// Callers hold the critical section
+static void unlink_timer(esp_timer* t)
+{
+    for (esp_timer** p = &s_armed; *p; p = &(*p)->next)
+    {
+        if (*p == t)
+        {
+            *p = t->next;
+            break;
+        }
+    }
+    t->next = NULL;
+    t->armed = false;
+}
+
+// Callers hold the critical section
+static void insert_timer(esp_timer* t)
+{
+    esp_timer** p = &s_armed;
+    while (*p && (*p)->alarm_us <= t->alarm_us)
+        p = &(*p)->next;
+    t->next = *p;
+    *p = t;
+    t->armed = true;
+}
+
+static void wake_dispatcher(void)
+{
+    if (s_task && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        xTaskNotifyGive(s_task);
+}
+
+static void timer_task(void* arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        esp_timer_cb_t cb = NULL;
+        void* cb_arg = NULL;
+        TickType_t wait = portMAX_DELAY;
+
+        portENTER_CRITICAL(&s_mux);
+        esp_timer* t = s_armed;
+        const int64_t now = esp_timer_get_time();
+        if (t && t->alarm_us <= now)
+        {
+            unlink_timer(t);
+            cb = t->callback;
+            cb_arg = t->arg;
+            if (t->period_us)
+            {
+                // Skip missed periods rather than firing a burst
+                t->alarm_us += t->period_us;
+                if (t->alarm_us <= now)
+                    t->alarm_us = now + t->period_us;
+                insert_timer(t);
+            }
+        }
+        else if (t)
+        {
+            wait = pdMS_TO_TICKS((t->alarm_us - now + 999) / 1000);
+            if (wait == 0)
+                wait = 1;
+        }
+        portEXIT_CRITICAL(&s_mux);
+
+        if (cb)
+            cb(cb_arg);
+        else
+            ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+void sim_timer_start(void)
+{
+    if (xTaskCreate(timer_task, "esp_timer", 4096, NULL, configMAX_PRIORITIES - 1, &s_task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create timer task");
+        abort();
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out)
+{
+    if (!args || !args->callback || !out)
+        return ESP_ERR_INVALID_ARG;
+    esp_timer* t = (esp_timer*)calloc(1, sizeof(esp_timer));
+    if (!t)
+        return ESP_ERR_NO_MEM;
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->name = args->name;
+    *out = t;
+    return ESP_OK;
+}
+
+static esp_err_t start_timer(esp_timer_handle_t t, uint64_t first_us, uint64_t period_us)
+{
+    if (!t)
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    if (t->armed)
+    {
+        portEXIT_CRITICAL(&s_mux);
+        return ESP_ERR_INVALID_STATE;
+    }
+    t->alarm_us = esp_timer_get_time() + (int64_t)first_us;
+    t->period_us = period_us;
+    insert_timer(t);
+    portEXIT_CRITICAL(&s_mux);
+    wake_dispatcher();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return start_timer(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (period_us == 0)
+        return ESP_ERR_INVALID_ARG;
+    return start_timer(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+    portENTER_CRITICAL(&s_mux);
+    const bool armed = timer->armed;
+    if (armed)
+        unlink_timer(timer);
+    portEXIT_CRITICAL(&s_mux);
+    return armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+    if (esp_timer_is_active(timer))
+        return ESP_ERR_INVALID_STATE;
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    portENTER_CRITICAL(&s_mux);
+    const bool armed = timer && timer->armed;
+    portEXIT_CRITICAL(&s_mux);
+    return armed;
+}
@@ -0,0 +1,73 @@
+// Host stand-in for the OLED I2C bus: counts what would go over the wire and
+// applies it to a model of the panel's GDDRAM (horizontal addressing)
+#include "ssd1306_diff.h"
+
+static void mock_command(ssd1306_mock_bus_t* mock, const uint8_t* cmd, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        switch (cmd[i])
+        {
+            case 0x20: // addressing mode, always horizontal here
+                i += 2;
+                break;
+            case 0x21:
+                if (i + 2 < len)
+                {
+                    mock->c0 = mock->col = cmd[i + 1];
+                    mock->c1 = cmd[i + 2];
+                }
+                i += 3;
+                break;
+            case 0x22:
+                if (i + 2 < len)
+                {
+                    mock->p0 = mock->page = cmd[i + 1];
+                    mock->p1 = cmd[i + 2];
+                }
+                i += 3;
+                break;
+            default:
+                i++;
+                break;
+        }
+    }
+}
+
+static void mock_data(ssd1306_mock_bus_t* mock, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (mock->page < SSD1306_PAGES && mock->col < OLED_WIDTH)
+            mock->panel[mock->page * OLED_WIDTH + mock->col] = data[i];
+        if (mock->col++ >= mock->c1)
+        {
+            mock->col = mock->c0;
+            if (mock->page++ >= mock->p1)
+                mock->page = mock->p0;
+        }
+    }
+}
+
+static bool mock_write(void* ctx, const uint8_t* data, size_t len)
+{
+    ssd1306_mock_bus_t* mock = (ssd1306_mock_bus_t*)ctx;
+    mock->transactions++;
+    mock->bytes += (uint32_t)len + 1; // + I2C address byte
+    if (len == 0)
+        return true;
+
+    const bool fail = mock->fail_at && mock->transactions == mock->fail_at;
+    if (data[0] == 0x40)
+        mock_data(mock, data + 1, fail ? (len - 1) / 2 : len - 1);
+    else if (!fail)
+        mock_command(mock, data + 1, len - 1);
+    return !fail;
+}
+
+ssd1306_bus_t ssd1306_mock_bus(ssd1306_mock_bus_t* mock)
+{
+    ssd1306_bus_t bus = {mock_write, mock};
+    return bus;
+}
@@ -0,0 +1,71 @@
+#include "laser_frame.h"
+
+void laser_frame_encode(laser_frame_t* frame, uint32_t message, uint32_t bit_us, uint32_t gap_us)
+{
+    frame->count = 0;
+    frame->message = message;
+    frame->total_us = 0;
+
+    for (int i = MESSAGE_TOTAL_BITS - 1; i >= 0; i--)
+    {
+        const uint8_t level = (message >> i) & 0x01;
+        if (frame->count > 0 && frame->symbols[frame->count - 1].level == level)
+        {
+            frame->symbols[frame->count - 1].duration_us += bit_us;
+        }
+        else
+        {
+            frame->symbols[frame->count].level = level;
+            frame->symbols[frame->count].duration_us = bit_us;
+            frame->count++;
+        }
+        frame->total_us += bit_us;
+    }
+
+    if (gap_us == 0)
+        return;
+    if (frame->symbols[frame->count - 1].level == 0)
+    {
+        frame->symbols[frame->count - 1].duration_us += gap_us;
+    }
+    else
+    {
+        frame->symbols[frame->count].level = 0;
+        frame->symbols[frame->count].duration_us = gap_us;
+        frame->count++;
+    }
+    frame->total_us += gap_us;
+}
+
+size_t laser_frame_split(const laser_frame_t* frame, uint32_t max_us, laser_symbol_t* out, size_t cap)
+{
+    size_t n = 0;
+    for (uint8_t i = 0; i < frame->count; i++)
+    {
+        uint32_t left = frame->symbols[i].duration_us;
+        while (left > 0)
+        {
+            if (n >= cap)
+                return 0;
+            const uint32_t d = left > max_us ? max_us : left;
+            out[n].duration_us = d;
+            out[n].level = frame->symbols[i].level;
+            n++;
+            left -= d;
+        }
+    }
+
+    if (n & 1)
+    {
+        // A zero duration is the RMT end marker, so the last piece is split
+        // rather than padded
+        const uint32_t d = out[n - 1].duration_us;
+        if (n >= cap || d < 2)
+            return 0;
+        out[n - 1].duration_us = d - d / 2;
+        out[n].duration_us = d / 2;
+        out[n].level = out[n - 1].level;
+        n++;
+    }
+    return n;
+}
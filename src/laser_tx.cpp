@@ -0,0 +1,183 @@
+#include "laser_tx.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <driver/rmt_tx.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+
+static const char* TAG = "LaserTx";
+
+// 1 tick == 1 us, so laser_symbol_t durations map 1:1 onto RMT ticks
+#define LASER_TX_RESOLUTION_HZ 1000000
+#define LASER_TX_MAX_HALF_TICKS 32767
+#define LASER_TX_MEM_BLOCK_SYMBOLS 48
+
+static rmt_channel_handle_t s_chan;
+static rmt_encoder_handle_t s_encoder;
+static SemaphoreHandle_t s_free_slots;
+static rmt_symbol_word_t* s_slots[LASER_TX_QUEUE_DEPTH];
+static size_t s_slot_symbols;
+static laser_symbol_t* s_pieces;
+static uint8_t s_next_slot;
+static uint32_t s_bit_us;
+static uint32_t s_gap_us;
+static int64_t s_busy_until_us;
+static int64_t s_last_start_us;
+
+static bool IRAM_ATTR on_trans_done(rmt_channel_handle_t chan, const rmt_tx_done_event_data_t* edata,
+                                    void* user_ctx)
+{
+    (void)chan;
+    (void)edata;
+    (void)user_ctx;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(s_free_slots, &woken);
+    return woken == pdTRUE;
+}
+
+// Worst case RMT symbols for one frame: every run may need splitting into
+// halves of at most LASER_TX_MAX_HALF_TICKS, two halves per RMT symbol.
+static size_t slot_symbols_for(uint32_t bit_us, uint32_t gap_us)
+{
+    const uint32_t total_us = MESSAGE_TOTAL_BITS * bit_us + gap_us;
+    const size_t halves = LASER_FRAME_MAX_SYMBOLS + total_us / LASER_TX_MAX_HALF_TICKS + 1;
+    return (halves + 1) / 2;
+}
+
+// laser_task is the only sender, so one scratch buffer serves every slot
+static size_t to_rmt_symbols(const laser_frame_t* frame, rmt_symbol_word_t* out, size_t cap)
+{
+    const size_t pieces = laser_frame_split(frame, LASER_TX_MAX_HALF_TICKS, s_pieces, 2 * cap);
+    for (size_t i = 0; i < pieces; i += 2)
+    {
+        rmt_symbol_word_t* w = &out[i / 2];
+        w->duration0 = s_pieces[i].duration_us;
+        w->level0 = s_pieces[i].level;
+        w->duration1 = s_pieces[i + 1].duration_us;
+        w->level1 = s_pieces[i + 1].level;
+    }
+    return pieces / 2;
+}
+
+bool laser_tx_init(int gpio_num, uint32_t bit_us, uint32_t gap_us)
+{
+    if (s_chan)
+        return true;
+
+    s_bit_us = bit_us;
+    s_gap_us = gap_us;
+    s_slot_symbols = slot_symbols_for(bit_us, gap_us);
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+    {
+        s_slots[i] = (rmt_symbol_word_t*)calloc(s_slot_symbols, sizeof(rmt_symbol_word_t));
+        if (!s_slots[i])
+        {
+            ESP_LOGE(TAG, "Failed to allocate symbol buffer");
+            return false;
+        }
+    }
+    s_pieces = (laser_symbol_t*)calloc(2 * s_slot_symbols, sizeof(laser_symbol_t));
+    if (!s_pieces)
+    {
+        ESP_LOGE(TAG, "Failed to allocate symbol buffer");
+        return false;
+    }
+
+    s_free_slots = xSemaphoreCreateCounting(LASER_TX_QUEUE_DEPTH, LASER_TX_QUEUE_DEPTH);
+    if (!s_free_slots)
+        return false;
+
+    rmt_tx_channel_config_t chan_cfg = {};
+    chan_cfg.gpio_num = gpio_num;
+    chan_cfg.clk_src = RMT_CLK_SRC_DEFAULT;
+    chan_cfg.resolution_hz = LASER_TX_RESOLUTION_HZ;
+    chan_cfg.mem_block_symbols = LASER_TX_MEM_BLOCK_SYMBOLS;
+    chan_cfg.trans_queue_depth = LASER_TX_QUEUE_DEPTH;
+
+    esp_err_t err = rmt_new_tx_channel(&chan_cfg, &s_chan);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "RMT channel init failed: %s", esp_err_to_name(err));
+        s_chan = NULL;
+        return false;
+    }
+
+    rmt_copy_encoder_config_t enc_cfg = {};
+    rmt_new_copy_encoder(&enc_cfg, &s_encoder);
+
+    rmt_tx_event_callbacks_t cbs = {};
+    cbs.on_trans_done = on_trans_done;
+    rmt_tx_register_event_callbacks(s_chan, &cbs, NULL);
+    rmt_enable(s_chan);
+
+    ESP_LOGI(TAG, "RMT laser TX on GPIO %d, %lu us/bit, %lu us gap", gpio_num, (unsigned long)bit_us,
+             (unsigned long)gap_us);
+    return true;
+}
+
+bool laser_tx_send(const laser_frame_t* frame, TickType_t timeout)
+{
+    if (!s_chan || !frame)
+        return false;
+
+    if (xSemaphoreTake(s_free_slots, timeout) != pdTRUE)
+        return false;
+
+    rmt_symbol_word_t* buf = s_slots[s_next_slot];
+    const size_t n = to_rmt_symbols(frame, buf, s_slot_symbols);
+    if (n == 0)
+    {
+        ESP_LOGW(TAG, "Frame does not fit symbol buffer");
+        xSemaphoreGive(s_free_slots);
+        return false;
+    }
+
+    rmt_transmit_config_t tx_cfg = {};
+    tx_cfg.loop_count = 0;
+    tx_cfg.flags.eot_level = 0;
+    esp_err_t err = rmt_transmit(s_chan, s_encoder, buf, n * sizeof(rmt_symbol_word_t), &tx_cfg);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "RMT transmit failed: %s", esp_err_to_name(err));
+        xSemaphoreGive(s_free_slots);
+        return false;
+    }
+
+    // Stamped after the driver call, so an idle channel reads a few us late
+    // rather than early
+    const int64_t now = esp_timer_get_time();
+    s_last_start_us = now > s_busy_until_us ? now : s_busy_until_us;
+    s_busy_until_us = s_last_start_us + frame->total_us;
+
+    s_next_slot = (s_next_slot + 1) % LASER_TX_QUEUE_DEPTH;
+    return true;
+}
+
+bool laser_tx_wait_idle(TickType_t timeout)
+{
+    if (!s_chan)
+        return false;
+    const int ms = timeout == portMAX_DELAY ? -1 : (int)pdTICKS_TO_MS(timeout);
+    return rmt_tx_wait_all_done(s_chan, ms) == ESP_OK;
+}
+
+uint32_t laser_tx_bit_us(void)
+{
+    return s_bit_us;
+}
+
+uint32_t laser_tx_gap_us(void)
+{
+    return s_gap_us;
+}
+
+uint32_t laser_tx_frame_interval_us(void)
+{
+    return MESSAGE_TOTAL_BITS * s_bit_us + s_gap_us;
+}
+
+int64_t laser_tx_last_start_us(void)
+{
+    return s_last_start_us;
+}
@@ -0,0 +1,331 @@
+#include "latency_bench.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include "config.h"
+#include "laser_tx.h"
+
+static const char* TAG = "LatencyBench";
+
+#define LB_PENDING 8 // power of two, above the laserMessageQueue depth
+#define LB_SETTLE_MS 1500
+#define LB_REPORT_MAX 512
+
+#ifdef LATENCY_BENCH_BASELINE_EMBEDDED
+extern const char s_embedded_baseline[] asm("_binary_latency_baseline_txt_start");
+#define LB_DEFAULT_BASELINE s_embedded_baseline
+#else
+#define LB_DEFAULT_BASELINE NULL
+#endif
+
+typedef struct
+{
+    uint32_t word;
+    int64_t edge_us;
+    int64_t decide_us;
+    int64_t queued_us;
+} pending_t;
+
+static const char* const s_stage_names[LB_STAGE_COUNT] = {"wake", "control", "queue", "encode", "tx", "total"};
+
+// Control task -> laser task hand-over, one slot per word in flight
+static pending_t s_pending[LB_PENDING];
+static std::atomic<uint32_t> s_head{0};
+static std::atomic<uint32_t> s_tail{0};
+static std::atomic<uint32_t> s_unmatched{0};
+static bool s_last_claimed; // control task only
+
+// Written by the laser task only
+static uint32_t s_samples[LB_STAGE_COUNT][LATENCY_BENCH_SAMPLES];
+static std::atomic<uint32_t> s_count{0};
+static uint32_t s_sorted[LATENCY_BENCH_SAMPLES];
+
+static latency_bench_cfg_t s_cfg = {LATENCY_BENCH_SHOTS, 20, 0, LB_DEFAULT_BASELINE, NULL};
+
+void latency_bench_queued(uint32_t word, int64_t edge_us, int64_t decide_us, int64_t queued_us)
+{
+    const uint32_t head = s_head.load(std::memory_order_relaxed);
+    s_last_claimed = head - s_tail.load(std::memory_order_acquire) < LB_PENDING;
+    if (!s_last_claimed)
+    {
+        s_unmatched.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pending_t* p = &s_pending[head & (LB_PENDING - 1)];
+    p->word = word;
+    p->edge_us = edge_us;
+    p->decide_us = decide_us;
+    p->queued_us = queued_us;
+    s_head.store(head + 1, std::memory_order_release);
+}
+
+void latency_bench_cancel(void)
+{
+    // The word never entered the queue, so the laser task cannot be reading
+    // the entry
+    if (s_last_claimed)
+        s_head.fetch_sub(1, std::memory_order_release);
+    s_last_claimed = false;
+}
+
+static uint32_t span(int64_t from_us, int64_t to_us)
+{
+    return to_us > from_us ? (uint32_t)(to_us - from_us) : 0;
+}
+
+void latency_bench_sent(uint32_t word, int64_t dequeued_us, int64_t handoff_us, int64_t photon_us)
+{
+    // Entries whose word never came out of the queue (bench reset while shots
+    // were in flight) are skipped; a frame laser_tx refused only consumes its
+    // entry.
+    uint32_t tail = s_tail.load(std::memory_order_relaxed);
+    const uint32_t head = s_head.load(std::memory_order_acquire);
+    bool matched = false;
+    while (tail != head && !matched)
+    {
+        const pending_t p = s_pending[tail & (LB_PENDING - 1)];
+        tail++;
+        if (p.word != word)
+        {
+            s_unmatched.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        matched = true;
+        if (photon_us < 0)
+            break;
+
+        const uint32_t n = s_count.load(std::memory_order_relaxed);
+        const uint32_t i = n % LATENCY_BENCH_SAMPLES;
+        s_samples[LB_STAGE_WAKE][i] = span(p.edge_us, p.decide_us);
+        s_samples[LB_STAGE_CONTROL][i] = span(p.decide_us, p.queued_us);
+        s_samples[LB_STAGE_QUEUE][i] = span(p.queued_us, dequeued_us);
+        s_samples[LB_STAGE_ENCODE][i] = span(dequeued_us, handoff_us);
+        s_samples[LB_STAGE_TX][i] = span(handoff_us, photon_us);
+        s_samples[LB_STAGE_TOTAL][i] = span(p.edge_us, photon_us);
+        s_count.store(n + 1, std::memory_order_release);
+    }
+    if (!matched)
+        s_unmatched.fetch_add(1, std::memory_order_relaxed);
+    s_tail.store(tail, std::memory_order_release);
+}
+
+void latency_bench_reset(void)
+{
+    s_tail.store(s_head.load(std::memory_order_acquire), std::memory_order_release);
+    s_count.store(0, std::memory_order_release);
+    s_unmatched.store(0, std::memory_order_relaxed);
+}
+
+// Nearest-rank percentile of a sorted array
+static uint32_t rank(const uint32_t* v, uint32_t n, uint32_t pct)
+{
+    const uint32_t r = (n * pct + 99) / 100;
+    return v[r > 0 ? r - 1 : 0];
+}
+
+void latency_bench_report(lb_report_t* out)
+{
+    memset(out, 0, sizeof(*out));
+    const uint32_t count = s_count.load(std::memory_order_acquire);
+    const uint32_t n = count < LATENCY_BENCH_SAMPLES ? count : LATENCY_BENCH_SAMPLES;
+    out->shots = n;
+    out->unmatched = s_unmatched.load(std::memory_order_relaxed);
+    if (n == 0)
+        return;
+    for (int s = 0; s < LB_STAGE_COUNT; s++)
+    {
+        memcpy(s_sorted, s_samples[s], n * sizeof(uint32_t));
+        std::sort(s_sorted, s_sorted + n);
+        out->stage[s].p50_us = rank(s_sorted, n, 50);
+        out->stage[s].p99_us = rank(s_sorted, n, 99);
+        out->stage[s].max_us = s_sorted[n - 1];
+    }
+}
+
+const char* latency_bench_stage_name(lb_stage_t stage)
+{
+    return stage < LB_STAGE_COUNT ? s_stage_names[stage] : "?";
+}
+
+size_t latency_bench_format(const lb_report_t* report, char* buf, size_t cap)
+{
+    int n = snprintf(buf, cap, "# trigger-to-photon latency in us, %lu shots, %lu unmatched\n"
+                               "# stage      p50     p99     max\n",
+                     (unsigned long)report->shots, (unsigned long)report->unmatched);
+    size_t len = n > 0 ? (size_t)n : 0;
+    for (int s = 0; s < LB_STAGE_COUNT && len < cap; s++)
+    {
+        const lb_stat_t* st = &report->stage[s];
+        n = snprintf(buf + len, cap - len, "%-8s %7lu %7lu %7lu\n", s_stage_names[s], (unsigned long)st->p50_us,
+                     (unsigned long)st->p99_us, (unsigned long)st->max_us);
+        len += n > 0 ? (size_t)n : 0;
+    }
+    return len < cap ? len : 0;
+}
+
+bool latency_bench_parse_baseline(const char* text, lb_baseline_t* out)
+{
+    memset(out, 0, sizeof(*out));
+    out->tolerance_pct = 25;
+    out->slack_us = 100;
+    out->max_tolerance_pct = 100;
+
+    bool any = false;
+    while (text && *text)
+    {
+        char line[96];
+        const char* nl = strchr(text, '\n');
+        const size_t len = nl ? (size_t)(nl - text) : strlen(text);
+        const size_t keep = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+        memcpy(line, text, keep);
+        line[keep] = '\0';
+        text = nl ? nl + 1 : text + len;
+
+        char* hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+        char name[16];
+        unsigned long a, b, c;
+        const int fields = sscanf(line, "%15s %lu %lu %lu", name, &a, &b, &c);
+        if (fields <= 0)
+            continue;
+        if (fields != 4)
+        {
+            ESP_LOGW(TAG, "Baseline line not understood: %s", line);
+            return false;
+        }
+        if (strcmp(name, "tolerance") == 0)
+        {
+            out->tolerance_pct = (uint32_t)a;
+            out->slack_us = (uint32_t)b;
+            out->max_tolerance_pct = (uint32_t)c;
+            continue;
+        }
+        int s = 0;
+        while (s < LB_STAGE_COUNT && strcmp(name, s_stage_names[s]) != 0)
+            s++;
+        if (s == LB_STAGE_COUNT)
+        {
+            ESP_LOGW(TAG, "Unknown stage in baseline: %s", name);
+            return false;
+        }
+        out->stage[s].p50_us = (uint32_t)a;
+        out->stage[s].p99_us = (uint32_t)b;
+        out->stage[s].max_us = (uint32_t)c;
+        out->present[s] = true;
+        any = true;
+    }
+    return any;
+}
+
+static int check(const char* stage, const char* metric, uint32_t value, uint32_t base, uint32_t pct, uint32_t slack)
+{
+    const uint64_t limit = (uint64_t)base * (100 + pct) / 100 + slack;
+    if (value <= limit)
+        return 0;
+    ESP_LOGE(TAG, "REGRESSION %s %s: %lu us, baseline %lu us, limit %lu us", stage, metric, (unsigned long)value,
+             (unsigned long)base, (unsigned long)limit);
+    return 1;
+}
+
+int latency_bench_compare(const lb_report_t* report, const lb_baseline_t* baseline)
+{
+    int regressions = 0;
+    for (int s = 0; s < LB_STAGE_COUNT; s++)
+    {
+        if (!baseline->present[s])
+            continue;
+        const lb_stat_t* now = &report->stage[s];
+        const lb_stat_t* base = &baseline->stage[s];
+        regressions += check(s_stage_names[s], "p50", now->p50_us, base->p50_us, baseline->tolerance_pct,
+                             baseline->slack_us);
+        regressions += check(s_stage_names[s], "p99", now->p99_us, base->p99_us, baseline->tolerance_pct,
+                             baseline->slack_us);
+        regressions += check(s_stage_names[s], "max", now->max_us, base->max_us, baseline->max_tolerance_pct,
+                             baseline->slack_us);
+    }
+    return regressions;
+}
+
+void latency_bench_configure(const latency_bench_cfg_t* cfg)
+{
+    s_cfg = *cfg;
+}
+
+static void bench_task(void* pvParameters)
+{
+    (void)pvParameters;
+    const gpio_num_t pin = (gpio_num_t)TRIGGER_BUTTON_PIN;
+    const uint32_t frame_ms = laser_tx_frame_interval_us() / 1000;
+    const uint32_t gap_ms = s_cfg.gap_ms ? s_cfg.gap_ms : frame_ms + 50;
+
+    // Let control_task arm the trigger interrupt first
+    vTaskDelay(pdMS_TO_TICKS(LB_SETTLE_MS));
+    ESP_LOGI(TAG, "Pulling the trigger %lu times, %lu ms apart", (unsigned long)s_cfg.shots,
+             (unsigned long)(s_cfg.press_ms + gap_ms));
+
+    // Open drain pulls low like the button and only floats high, so the real
+    // button stays safe to press. Released first: a low output is a press.
+    gpio_set_level(pin, 1);
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    latency_bench_reset();
+    for (uint32_t i = 0; i < s_cfg.shots; i++)
+    {
+        gpio_set_level(pin, 0);
+        vTaskDelay(pdMS_TO_TICKS(s_cfg.press_ms));
+        gpio_set_level(pin, 1);
+        vTaskDelay(pdMS_TO_TICKS(gap_ms));
+    }
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+    vTaskDelay(pdMS_TO_TICKS(frame_ms + 10));
+
+    lb_report_t report;
+    latency_bench_report(&report);
+    static char text[LB_REPORT_MAX];
+    latency_bench_format(&report, text, sizeof(text));
+    printf("%s", text);
+
+    int regressions = 0;
+    if (report.shots < s_cfg.shots / 2)
+    {
+        // Out of ammo, respawning or a stalled pipeline: nothing to compare
+        ESP_LOGE(TAG, "REGRESSION only %lu of %lu trigger pulls reached the laser", (unsigned long)report.shots,
+                 (unsigned long)s_cfg.shots);
+        regressions++;
+    }
+    lb_baseline_t baseline;
+    if (s_cfg.baseline && latency_bench_parse_baseline(s_cfg.baseline, &baseline))
+    {
+        regressions += latency_bench_compare(&report, &baseline);
+        if (regressions)
+            ESP_LOGE(TAG, "LATENCY BENCH FAILED: %d metric(s) over baseline", regressions);
+        else
+            ESP_LOGI(TAG, "Latency bench within baseline");
+    }
+    else if (s_cfg.baseline)
+    {
+        ESP_LOGE(TAG, "LATENCY BENCH FAILED: baseline unreadable");
+        regressions++;
+    }
+    else
+    {
+        ESP_LOGI(TAG, "No baseline set; the report above can serve as one");
+    }
+
+    if (s_cfg.done)
+        s_cfg.done(&report, regressions);
+    vTaskDelete(NULL);
+}
+
+bool latency_bench_start(void)
+{
+    if (s_cfg.shots == 0)
+        return false;
+    return xTaskCreate(bench_task, "latency_bench", 3072, NULL, 2, NULL) == pdPASS;
+}
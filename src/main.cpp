@@ -7,10 +7,18 @@
 #include "debug_print.h"
 #include "display_init.h"
 #include "display_manager.h"
+#include "espnow_tx.h"
+#include "event_log.h"
 #include "game_protocol.h"
+#include "game_sched.h"
+#include "game_snapshot.h"
 #include "game_state.h"
 #include "gpio_init.h"
+#include "laser_tx.h"
+#include "latency_bench.h"
+#include "oled_flush.h"
 #include "runtime_metrics.h"
+#include "task_profiler.h"
 #include "tasks.h"
 #include "wifi_manager.h"
 #include "ws_server.h"
@@ -34,18 +42,35 @@ extern "C" void app_main(void)
         ESP_LOGE(TAG, "Failed to initialize game state");
         return;
     }
+    if (!game_sched_init())
+    {
+        ESP_LOGE(TAG, "Failed to create game timers");
+        return;
+    }
+    game_snapshot_publish();
     ESP_LOGI(TAG, "Game state initialized - Device ID: %u", game_state_get_config()->device_id);
 
     init_reset_button_and_check_factory_reset();
     init_laser_gpio(LASER_PIN);
+    if (!laser_tx_init(LASER_PIN, LASER_BIT_DURATION_US, LASER_FRAME_GAP_US))
+    {
+        ESP_LOGE(TAG, "Failed to initialize laser transmitter");
+        return;
+    }
 
-    laserMessageQueue = xQueueCreate(5, sizeof(uint32_t));
+    laserMessageQueue = xQueueCreate(5, sizeof(laser_msg_t));
     if (!laserMessageQueue)
     {
         ESP_LOGE(TAG, "Failed to create laser message queue");
         return;
     }
 
+    if (!espnow_tx_init())
+    {
+        ESP_LOGE(TAG, "Failed to create ESP-NOW TX ring");
+        return;
+    }
+
     lv_disp_t* disp = init_display();
     if (!disp)
     {
@@ -53,6 +78,11 @@ extern "C" void app_main(void)
     }
     else
     {
+        if (!oled_flush_attach(disp))
+        {
+            ESP_LOGW(TAG, "Partial OLED flush unavailable, using full redraws");
+        }
+
         dm_sources_t dm_sources = {
             .wifi_connected = wifi_manager_is_connected,
             .wifi_ip = wifi_manager_get_ip,
@@ -86,11 +116,21 @@ extern "C" void app_main(void)
     debug_print_nvs_contents();
 
     ESP_LOGI(TAG, "Weapon device ready");
+    xTaskCreate(evlog_task, "evlog", 3072, NULL, 1, NULL);
     xTaskCreate(control_task, "control", 4096, NULL, 5, NULL);
     xTaskCreate(laser_task, "laser", 2048, NULL, 4, NULL);
     xTaskCreate(game_task, "game", 4096, NULL, 2, NULL);
     xTaskCreate(espnow_task, "espnow", 4096, NULL, 3, NULL);
+    xTaskCreate(espnow_tx_task, "espnow_tx", 3072, NULL, 3, NULL);
     xTaskCreate(wifi_task, "wifi", 4096, NULL, 1, NULL);
     xTaskCreate(ws_task, "websocket", 8192, NULL, 2, NULL);
     ESP_LOGI(TAG, "All tasks created");
+    if (!task_profiler_start())
+    {
+        ESP_LOGW(TAG, "Task profiler unavailable");
+    }
+
+#if LATENCY_BENCH
+    latency_bench_start();
+#endif
 }
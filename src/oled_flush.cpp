@@ -0,0 +1,81 @@
+#include "oled_flush.h"
+#include <driver/i2c_master.h>
+#include <esp_log.h>
+#include <string.h>
+#include "config.h"
+
+static const char* TAG = "OledFlush";
+
+#define OLED_I2C_PORT I2C_NUM_0
+#define OLED_I2C_SPEED_HZ 400000
+#define OLED_I2C_TIMEOUT_MS 50
+
+static i2c_master_dev_handle_t s_dev;
+static ssd1306_diff_t s_diff;
+static uint8_t s_fb[SSD1306_FB_SIZE];
+
+static bool i2c_write(void* ctx, const uint8_t* data, size_t len)
+{
+    (void)ctx;
+    return i2c_master_transmit(s_dev, data, len, OLED_I2C_TIMEOUT_MS) == ESP_OK;
+}
+
+static void flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map)
+{
+    // color_map holds the area in page layout, one byte per column per page
+    const uint8_t* src = (const uint8_t*)color_map;
+    const int w = area->x2 - area->x1 + 1;
+    for (int page = area->y1 / 8; page <= area->y2 / 8 && page < SSD1306_PAGES; page++)
+    {
+        memcpy(&s_fb[page * OLED_WIDTH + area->x1], src, w);
+        src += w;
+    }
+
+    if (lv_disp_flush_is_last(drv))
+        ssd1306_diff_flush(&s_diff, s_fb);
+    lv_disp_flush_ready(drv);
+}
+
+bool oled_flush_attach(lv_disp_t* disp)
+{
+    if (!disp)
+        return false;
+
+    // The panel driver owns the bus; add a second handle for the same address
+    i2c_master_bus_handle_t bus;
+    if (i2c_master_get_bus_handle(OLED_I2C_PORT, &bus) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "OLED I2C bus not initialized");
+        return false;
+    }
+
+    i2c_device_config_t dev_cfg = {};
+    dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_cfg.device_address = OLED_I2C_ADDR;
+    dev_cfg.scl_speed_hz = OLED_I2C_SPEED_HZ;
+    if (i2c_master_bus_add_device(bus, &dev_cfg, &s_dev) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to add OLED device");
+        return false;
+    }
+
+    const ssd1306_bus_t oled_bus = {i2c_write, NULL};
+    if (!ssd1306_diff_init(&s_diff, &oled_bus))
+    {
+        ESP_LOGW(TAG, "OLED did not accept addressing mode");
+        return false;
+    }
+
+    disp->driver->flush_cb = flush_cb;
+    lv_obj_invalidate(lv_scr_act());
+    ESP_LOGI(TAG, "Partial OLED flush enabled");
+    return true;
+}
+
+void oled_flush_get_stats(uint32_t* bytes_sent, uint32_t* transactions)
+{
+    if (bytes_sent)
+        *bytes_sent = s_diff.bytes_sent;
+    if (transactions)
+        *transactions = s_diff.transactions;
+}
@@ -0,0 +1,338 @@
+#include "peer_table.h"
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <nvs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "espnow_comm.h"
+#include "wifi_manager.h"
+#include "ws_commands.h"
+
+static const char* TAG = "PeerTable";
+
+#define SLOT_MASK (PEER_TABLE_SLOTS - 1)
+#define PEER_BLOB_MAGIC 0x54505A52u // "RZPT"
+#define PEER_BLOB_VERSION 1
+#define PEER_NVS_NAMESPACE "peers"
+#define PEER_NVS_KEY "table"
+#define PEER_RECORD_SIZE 9
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t record_size;
+    uint16_t count;
+} peer_blob_header_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static peer_map_t s_map;
+
+static uint32_t mac_home(const uint8_t mac[6])
+{
+    // Vendor bytes repeat across a fleet; the NIC-specific tail carries the entropy
+    uint32_t h = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+    h ^= ((uint32_t)mac[0] << 8) ^ mac[1] ^ ((uint32_t)mac[2] << 4);
+    h *= 0x9E3779B1u;
+    return (h >> 16) & SLOT_MASK;
+}
+
+static int find_slot(const peer_map_t* m, const uint8_t mac[6])
+{
+    for (uint32_t s = mac_home(mac);; s = (s + 1) & SLOT_MASK)
+    {
+        if (!m->used[s])
+            return -1;
+        if (memcmp(m->entries[s].mac, mac, 6) == 0)
+            return (int)s;
+    }
+}
+
+void peer_map_clear(peer_map_t* m)
+{
+    memset(m, 0, sizeof(*m));
+}
+
+bool peer_map_put(peer_map_t* m, const peer_info_t* peer)
+{
+    uint32_t s = mac_home(peer->mac);
+    while (m->used[s])
+    {
+        if (memcmp(m->entries[s].mac, peer->mac, 6) == 0)
+        {
+            m->entries[s] = *peer;
+            return true;
+        }
+        s = (s + 1) & SLOT_MASK;
+    }
+    if (m->count >= PEER_TABLE_CAPACITY)
+        return false;
+    m->entries[s] = *peer;
+    m->used[s] = 1;
+    m->count++;
+    return true;
+}
+
+bool peer_map_remove(peer_map_t* m, const uint8_t mac[6])
+{
+    const int found = find_slot(m, mac);
+    if (found < 0)
+        return false;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    uint32_t i = (uint32_t)found;
+    uint32_t j = i;
+    for (;;)
+    {
+        j = (j + 1) & SLOT_MASK;
+        if (!m->used[j])
+            break;
+        const uint32_t k = mac_home(m->entries[j].mac);
+        const bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if (stays)
+            continue;
+        m->entries[i] = m->entries[j];
+        i = j;
+    }
+    m->used[i] = 0;
+    m->count--;
+    return true;
+}
+
+const peer_info_t* peer_map_find(const peer_map_t* m, const uint8_t mac[6])
+{
+    const int found = find_slot(m, mac);
+    return found < 0 ? NULL : &m->entries[found];
+}
+
+size_t peer_map_serialize(const peer_map_t* m, uint8_t* out, size_t cap)
+{
+    const size_t need = sizeof(peer_blob_header_t) + (size_t)m->count * PEER_RECORD_SIZE;
+    if (cap < need)
+        return 0;
+
+    peer_blob_header_t hdr = {PEER_BLOB_MAGIC, PEER_BLOB_VERSION, PEER_RECORD_SIZE, m->count};
+    memcpy(out, &hdr, sizeof(hdr));
+    uint8_t* p = out + sizeof(hdr);
+    for (uint32_t s = 0; s < PEER_TABLE_SLOTS; s++)
+    {
+        if (!m->used[s])
+            continue;
+        memcpy(p, m->entries[s].mac, 6);
+        p[6] = m->entries[s].player_id;
+        p[7] = m->entries[s].device_id;
+        p[8] = m->entries[s].team_id;
+        p += PEER_RECORD_SIZE;
+    }
+    return need;
+}
+
+bool peer_map_deserialize(peer_map_t* m, const uint8_t* blob, size_t len)
+{
+    peer_blob_header_t hdr;
+    if (len < sizeof(hdr))
+        return false;
+    memcpy(&hdr, blob, sizeof(hdr));
+    if (hdr.magic != PEER_BLOB_MAGIC || hdr.version != PEER_BLOB_VERSION || hdr.record_size < PEER_RECORD_SIZE)
+        return false;
+    if (len < sizeof(hdr) + (size_t)hdr.count * hdr.record_size)
+        return false;
+
+    peer_map_clear(m);
+    const uint8_t* p = blob + sizeof(hdr);
+    for (uint16_t i = 0; i < hdr.count; i++, p += hdr.record_size)
+    {
+        peer_info_t peer;
+        memcpy(peer.mac, p, 6);
+        peer.player_id = p[6];
+        peer.device_id = p[7];
+        peer.team_id = p[8];
+        if (!peer_map_put(m, &peer))
+            break;
+    }
+    return true;
+}
+
+bool peer_table_parse_mac(const char* text, uint8_t mac[6])
+{
+    unsigned v[6];
+    if (sscanf(text, "%2x:%2x:%2x:%2x:%2x:%2x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+        return false;
+    for (int i = 0; i < 6; i++)
+        mac[i] = (uint8_t)v[i];
+    return true;
+}
+
+static bool load_blob(void)
+{
+    nvs_handle_t h;
+    if (nvs_open(PEER_NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK)
+        return false;
+
+    size_t len = 0;
+    bool ok = false;
+    if (nvs_get_blob(h, PEER_NVS_KEY, NULL, &len) == ESP_OK && len > 0)
+    {
+        uint8_t* blob = (uint8_t*)malloc(len);
+        if (blob && nvs_get_blob(h, PEER_NVS_KEY, blob, &len) == ESP_OK)
+        {
+            portENTER_CRITICAL(&s_mux);
+            ok = peer_map_deserialize(&s_map, blob, len);
+            portEXIT_CRITICAL(&s_mux);
+        }
+        free(blob);
+    }
+    nvs_close(h);
+    return ok;
+}
+
+// Applies the legacy "MAC,MAC,..." peer list. The CSV carries no ids; they
+// are learned from the peers' own frames.
+static void merge_csv(void)
+{
+    char peers[256] = {0};
+    if (!wifi_manager_load_peer_list(peers, sizeof(peers)))
+        return;
+
+    espnow_comm_load_peers_from_csv(peers);
+
+    unsigned added = 0;
+    char* save = NULL;
+    for (char* tok = strtok_r(peers, ",", &save); tok; tok = strtok_r(NULL, ",", &save))
+    {
+        while (*tok == ' ')
+            tok++;
+        peer_info_t peer;
+        if (!peer_table_parse_mac(tok, peer.mac) || peer_table_find(peer.mac, NULL))
+            continue;
+        peer.player_id = PEER_ID_UNKNOWN;
+        peer.device_id = PEER_ID_UNKNOWN;
+        peer.team_id = PEER_ID_UNKNOWN;
+        if (peer_table_put(&peer))
+            added++;
+    }
+
+    if (added > 0 && peer_table_save())
+        ESP_LOGI(TAG, "Added %u peers from CSV list", added);
+}
+
+void peer_table_load(void)
+{
+    if (load_blob())
+        ESP_LOGI(TAG, "Loaded %u peers", (unsigned)peer_table_count());
+    merge_csv();
+}
+
+bool peer_table_put(const peer_info_t* peer)
+{
+    portENTER_CRITICAL(&s_mux);
+    const bool ok = peer_map_put(&s_map, peer);
+    portEXIT_CRITICAL(&s_mux);
+    return ok;
+}
+
+bool peer_table_remove(const uint8_t mac[6])
+{
+    portENTER_CRITICAL(&s_mux);
+    const bool ok = peer_map_remove(&s_map, mac);
+    portEXIT_CRITICAL(&s_mux);
+    return ok;
+}
+
+bool peer_table_find(const uint8_t mac[6], peer_info_t* out)
+{
+    portENTER_CRITICAL(&s_mux);
+    const peer_info_t* p = peer_map_find(&s_map, mac);
+    if (p && out)
+        *out = *p;
+    portEXIT_CRITICAL(&s_mux);
+    return p != NULL;
+}
+
+bool peer_table_learn(const uint8_t mac[6], uint8_t player_id, uint8_t device_id, uint8_t team_id)
+{
+    bool changed = false;
+    portENTER_CRITICAL(&s_mux);
+    const peer_info_t* p = peer_map_find(&s_map, mac);
+    if (p && p->player_id == PEER_ID_UNKNOWN)
+    {
+        peer_info_t peer = *p;
+        peer.player_id = player_id;
+        peer.device_id = device_id;
+        peer.team_id = team_id;
+        changed = peer_map_put(&s_map, &peer);
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    if (changed)
+    {
+        ESP_LOGI(TAG, "Peer %02X:%02X:%02X:%02X:%02X:%02X is player %u device %u", mac[0], mac[1], mac[2], mac[3],
+                 mac[4], mac[5], player_id, device_id);
+        peer_table_save();
+    }
+    return changed;
+}
+
+size_t peer_table_count(void)
+{
+    return s_map.count;
+}
+
+bool peer_table_save(void)
+{
+    const size_t cap = sizeof(peer_blob_header_t) + PEER_TABLE_CAPACITY * PEER_RECORD_SIZE;
+    uint8_t* blob = (uint8_t*)malloc(cap);
+    if (!blob)
+        return false;
+
+    portENTER_CRITICAL(&s_mux);
+    const size_t len = peer_map_serialize(&s_map, blob, cap);
+    portEXIT_CRITICAL(&s_mux);
+
+    bool ok = false;
+    nvs_handle_t h;
+    if (len > 0 && nvs_open(PEER_NVS_NAMESPACE, NVS_READWRITE, &h) == ESP_OK)
+    {
+        ok = nvs_set_blob(h, PEER_NVS_KEY, blob, len) == ESP_OK && nvs_commit(h) == ESP_OK;
+        nvs_close(h);
+    }
+    free(blob);
+    if (!ok)
+        ESP_LOGW(TAG, "Failed to save peer table");
+    return ok;
+}
+
+// peer_add AA:BB:CC:DD:EE:FF <player> <device> <team>, all three ids required
+static bool cmd_peer_add(int client_fd, const char* args, void* ctx)
+{
+    (void)client_fd;
+    (void)ctx;
+    char mac_text[18];
+    unsigned player, device, team;
+    peer_info_t peer = {};
+    if (sscanf(args, "%17s %u %u %u", mac_text, &player, &device, &team) != 4 ||
+        !peer_table_parse_mac(mac_text, peer.mac) || player > UINT8_MAX || device > UINT8_MAX || team > UINT8_MAX)
+        return false;
+    peer.player_id = (uint8_t)player;
+    peer.device_id = (uint8_t)device;
+    peer.team_id = (uint8_t)team;
+    return peer_table_put(&peer) && peer_table_save();
+}
+
+// peer_del AA:BB:CC:DD:EE:FF
+static bool cmd_peer_del(int client_fd, const char* args, void* ctx)
+{
+    (void)client_fd;
+    (void)ctx;
+    uint8_t mac[6];
+    if (!peer_table_parse_mac(args, mac))
+        return false;
+    return peer_table_remove(mac) && peer_table_save();
+}
+
+void peer_table_register_commands(void)
+{
+    ws_commands_register("peer_add", cmd_peer_add, NULL);
+    ws_commands_register("peer_del", cmd_peer_del, NULL);
+}
@@ -0,0 +1,89 @@
+#include "perf_metrics.h"
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <atomic>
+
+typedef struct
+{
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> sum_us;
+    std::atomic<uint32_t> max_us;
+    std::atomic<uint32_t> buckets[PERF_HIST_BUCKETS];
+} perf_hist_state_t;
+
+static std::atomic<uint32_t> s_counters[PERF_CTR_COUNT];
+static std::atomic<int32_t> s_gauges[PERF_GAUGE_COUNT];
+static perf_hist_state_t s_hists[PERF_HIST_COUNT];
+
+void perf_count(perf_counter_t ctr, uint32_t n)
+{
+    s_counters[ctr].fetch_add(n, std::memory_order_relaxed);
+}
+
+void perf_gauge_set(perf_gauge_t gauge, int32_t value)
+{
+    s_gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+static unsigned bucket_of(uint32_t us)
+{
+    const unsigned b = us ? 32 - __builtin_clz(us) : 0;
+    return b < PERF_HIST_BUCKETS ? b : PERF_HIST_BUCKETS - 1;
+}
+
+void perf_hist_record(perf_hist_t hist, uint32_t us)
+{
+    perf_hist_state_t* h = &s_hists[hist];
+    h->count.fetch_add(1, std::memory_order_relaxed);
+    h->sum_us.fetch_add(us, std::memory_order_relaxed);
+    h->buckets[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t max = h->max_us.load(std::memory_order_relaxed);
+    while (us > max && !h->max_us.compare_exchange_weak(max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+size_t perf_metrics_snapshot(uint8_t* buf, size_t cap)
+{
+    if (cap < PERF_SNAPSHOT_LEN)
+        return 0;
+
+    perf_gauge_set(PERF_GAUGE_FREE_HEAP, (int32_t)esp_get_free_heap_size());
+    perf_gauge_set(PERF_GAUGE_MIN_FREE_HEAP, (int32_t)esp_get_minimum_free_heap_size());
+
+    uint8_t* p = buf;
+    *p++ = PERF_SNAPSHOT_MAGIC;
+    *p++ = PERF_SNAPSHOT_VERSION;
+    *p++ = PERF_CTR_COUNT;
+    *p++ = PERF_GAUGE_COUNT;
+    *p++ = PERF_HIST_COUNT;
+    *p++ = PERF_HIST_BUCKETS;
+    *p++ = 0;
+    *p++ = 0;
+    p = put_u32(p, (uint32_t)(esp_timer_get_time() / 1000));
+
+    for (int i = 0; i < PERF_CTR_COUNT; i++)
+        p = put_u32(p, s_counters[i].load(std::memory_order_relaxed));
+    for (int i = 0; i < PERF_GAUGE_COUNT; i++)
+        p = put_u32(p, (uint32_t)s_gauges[i].load(std::memory_order_relaxed));
+    for (int i = 0; i < PERF_HIST_COUNT; i++)
+    {
+        const perf_hist_state_t* h = &s_hists[i];
+        p = put_u32(p, h->count.load(std::memory_order_relaxed));
+        p = put_u32(p, h->sum_us.load(std::memory_order_relaxed));
+        p = put_u32(p, h->max_us.load(std::memory_order_relaxed));
+        for (int b = 0; b < PERF_HIST_BUCKETS; b++)
+            p = put_u32(p, h->buckets[b].load(std::memory_order_relaxed));
+    }
+    return (size_t)(p - buf);
+}
@@ -0,0 +1,68 @@
+#include "shot_cache.h"
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+#include "game_snapshot.h"
+#include "laser_tx.h"
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static armed_shot_t s_armed;
+static bool s_valid = false;
+static uint32_t s_config_generation;
+
+static void rebuild(const DeviceConfig* config)
+{
+    armed_shot_t next = {};
+    next.player_id = config->player_id;
+    next.device_id = config->device_id;
+    next.team_id = config->team_id;
+    next.color_rgb = config->color_rgb;
+    next.laser_word = createLaserMessage(config->player_id, config->device_id);
+
+    next.shot.type = ESPNOW_MSG_SHOT;
+    next.shot.version = 1;
+    next.shot.player_id = config->player_id;
+    next.shot.device_id = config->device_id;
+    next.shot.team_id = config->team_id;
+    next.shot.color_rgb = config->color_rgb;
+    next.shot.data = next.laser_word;
+
+    laser_frame_encode(&next.frame, next.laser_word, laser_tx_bit_us(), laser_tx_gap_us());
+
+    portENTER_CRITICAL(&s_mux);
+    s_armed = next;
+    s_valid = true;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+const armed_shot_t* shot_cache_arm(void)
+{
+    // One atomic load per shot; the snapshot is only copied when config moved
+    if (!s_valid || s_config_generation != game_snapshot_config_generation())
+    {
+        game_snapshot_t snap;
+        game_snapshot_read(&snap);
+        rebuild(&snap.config);
+        s_config_generation = snap.config_generation;
+    }
+    return &s_armed;
+}
+
+bool shot_cache_copy_frame(uint32_t laser_word, laser_frame_t* out)
+{
+    bool hit = false;
+    portENTER_CRITICAL(&s_mux);
+    if (s_valid && s_armed.laser_word == laser_word)
+    {
+        *out = s_armed.frame;
+        hit = true;
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return hit;
+}
+
+void shot_cache_invalidate(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    s_valid = false;
+    portEXIT_CRITICAL(&s_mux);
+}
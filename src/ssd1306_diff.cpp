@@ -0,0 +1,164 @@
+#include "ssd1306_diff.h"
+#include <string.h>
+
+#define SSD1306_CTRL_CMD 0x00
+#define SSD1306_CTRL_DATA 0x40
+#define SSD1306_MAX_SPANS 8
+
+typedef struct
+{
+    uint8_t lo;
+    uint8_t hi;
+} span_t;
+
+static bool bus_write(ssd1306_diff_t* d, const uint8_t* data, size_t len)
+{
+    d->transactions++;
+    d->bytes_sent += len;
+    return d->bus.write(d->bus.ctx, data, len);
+}
+
+bool ssd1306_diff_init(ssd1306_diff_t* d, const ssd1306_bus_t* bus)
+{
+    memset(d, 0, sizeof(*d));
+    d->bus = *bus;
+    const uint8_t cmd[] = {SSD1306_CTRL_CMD, 0x20, 0x00}; // horizontal addressing
+    return bus_write(d, cmd, sizeof(cmd));
+}
+
+void ssd1306_diff_invalidate(ssd1306_diff_t* d)
+{
+    d->valid = false;
+}
+
+// Changed column spans of one page, merging gaps cheaper to resend than to skip
+static uint8_t page_spans(const uint8_t* shadow, const uint8_t* fb, span_t* spans)
+{
+    uint8_t n = 0;
+    int x = 0;
+    while (x < OLED_WIDTH)
+    {
+        if (shadow[x] == fb[x])
+        {
+            x++;
+            continue;
+        }
+        int end = x;
+        int gap = 0;
+        for (int i = x + 1; i < OLED_WIDTH && gap <= SSD1306_SPAN_OVERHEAD; i++)
+        {
+            if (shadow[i] != fb[i])
+            {
+                end = i;
+                gap = 0;
+            }
+            else
+            {
+                gap++;
+            }
+        }
+        if (n == SSD1306_MAX_SPANS)
+        {
+            spans[n - 1].hi = (uint8_t)end;
+        }
+        else
+        {
+            spans[n].lo = (uint8_t)x;
+            spans[n].hi = (uint8_t)end;
+            n++;
+        }
+        x = end + 1;
+    }
+    return n;
+}
+
+static size_t send_window(ssd1306_diff_t* d, const uint8_t* fb, uint8_t p0, uint8_t p1, uint8_t c0, uint8_t c1)
+{
+    const uint8_t cmd[] = {SSD1306_CTRL_CMD, 0x21, c0, c1, 0x22, p0, p1};
+    if (!bus_write(d, cmd, sizeof(cmd)))
+        return 0;
+
+    static uint8_t buf[SSD1306_FB_SIZE + 1];
+    const size_t w = (size_t)c1 - c0 + 1;
+    size_t len = 0;
+    buf[len++] = SSD1306_CTRL_DATA;
+    for (uint8_t p = p0; p <= p1; p++)
+    {
+        memcpy(&buf[len], &fb[p * OLED_WIDTH + c0], w);
+        len += w;
+    }
+    if (!bus_write(d, buf, len))
+    {
+        // Part of the window may have landed
+        d->valid = false;
+        return 0;
+    }
+    for (uint8_t p = p0; p <= p1; p++)
+    {
+        memcpy(&d->shadow[p * OLED_WIDTH + c0], &fb[p * OLED_WIDTH + c0], w);
+    }
+    return sizeof(cmd) + len;
+}
+
+size_t ssd1306_diff_flush(ssd1306_diff_t* d, const uint8_t* fb)
+{
+    if (!d->valid)
+    {
+        // Unknown panel contents: send everything as one window
+        memset(d->shadow, 0, sizeof(d->shadow));
+        const size_t sent = send_window(d, fb, 0, SSD1306_PAGES - 1, 0, OLED_WIDTH - 1);
+        d->valid = sent > 0;
+        return sent;
+    }
+
+    size_t sent = 0;
+    // Pending single-span rectangle, extended downwards while that is cheaper
+    // than starting a new transfer
+    bool open = false;
+    uint8_t rp0 = 0, rp1 = 0, rc0 = 0, rc1 = 0;
+
+    for (uint8_t p = 0; p < SSD1306_PAGES; p++)
+    {
+        span_t spans[SSD1306_MAX_SPANS];
+        const uint8_t n = page_spans(&d->shadow[p * OLED_WIDTH], &fb[p * OLED_WIDTH], spans);
+
+        if (n == 1 && open && rp1 + 1 == p)
+        {
+            const uint8_t c0 = spans[0].lo < rc0 ? spans[0].lo : rc0;
+            const uint8_t c1 = spans[0].hi > rc1 ? spans[0].hi : rc1;
+            const size_t merged = (size_t)(p - rp0 + 1) * (c1 - c0 + 1);
+            const size_t separate = (size_t)(rp1 - rp0 + 1) * (rc1 - rc0 + 1) + (spans[0].hi - spans[0].lo + 1) +
+                                    SSD1306_SPAN_OVERHEAD;
+            if (merged <= separate)
+            {
+                rp1 = p;
+                rc0 = c0;
+                rc1 = c1;
+                continue;
+            }
+        }
+
+        if (open)
+        {
+            sent += send_window(d, fb, rp0, rp1, rc0, rc1);
+            open = false;
+        }
+
+        if (n == 1)
+        {
+            open = true;
+            rp0 = rp1 = p;
+            rc0 = spans[0].lo;
+            rc1 = spans[0].hi;
+            continue;
+        }
+        for (uint8_t i = 0; i < n; i++)
+        {
+            sent += send_window(d, fb, p, p, spans[i].lo, spans[i].hi);
+        }
+    }
+
+    if (open)
+        sent += send_window(d, fb, rp0, rp1, rc0, rc1);
+    return sent;
+}
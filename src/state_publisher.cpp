@@ -0,0 +1,55 @@
+#include "state_publisher.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_pending = 0;
+static TaskHandle_t s_consumer = NULL;
+static int64_t s_first_mark_us = 0;
+static int64_t s_batch_start_us = 0;
+
+void state_publisher_bind(void)
+{
+    s_consumer = xTaskGetCurrentTaskHandle();
+}
+
+void state_publisher_mark(uint32_t bits)
+{
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    if (s_pending == 0)
+        s_first_mark_us = now;
+    s_pending |= bits;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (s_consumer)
+        xTaskNotifyGive(s_consumer);
+}
+
+static uint32_t take_pending(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    const uint32_t bits = s_pending;
+    s_pending = 0;
+    s_batch_start_us = s_first_mark_us;
+    portEXIT_CRITICAL(&s_mux);
+    return bits;
+}
+
+uint32_t state_publisher_wait(TickType_t timeout, TickType_t coalesce)
+{
+    if (ulTaskNotifyTake(pdTRUE, timeout) == 0)
+        return take_pending();
+
+    // Let the rest of a burst land before publishing
+    if (coalesce)
+        vTaskDelay(coalesce);
+    ulTaskNotifyTake(pdTRUE, 0);
+    return take_pending();
+}
+
+int64_t state_publisher_batch_start_us(void)
+{
+    return s_batch_start_us;
+}
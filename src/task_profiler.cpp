@@ -0,0 +1,200 @@
+#include "task_profiler.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "TaskProf";
+
+#if configGENERATE_RUN_TIME_STATS
+typedef configRUN_TIME_COUNTER_TYPE run_time_t;
+#else
+typedef uint32_t run_time_t;
+#endif
+
+// Room for tasks created between counting them and reading their states
+#define TASK_STATUS_SLACK 2
+#define TASK_STATUS_ATTEMPTS 3
+
+static esp_timer_handle_t s_timer;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static task_prof_report_t s_report;
+
+// Only touched by the timer callback, and by task_profiler_start() before
+// the timer runs. s_prev is the last sample of every task, on the heap.
+static task_prof_report_t s_next;
+static TaskStatus_t* s_prev;
+static UBaseType_t s_prev_count;
+static run_time_t s_prev_total;
+static bool s_have_prev;
+static bool s_warned;
+
+#if configGENERATE_RUN_TIME_STATS
+static uint16_t cpu_share(const TaskStatus_t* t, uint32_t period)
+{
+    if (!s_have_prev || period == 0)
+        return TASK_PROFILER_CPU_UNKNOWN;
+
+    run_time_t before = 0;
+    for (UBaseType_t i = 0; i < s_prev_count; i++)
+    {
+        if (s_prev[i].xTaskNumber == t->xTaskNumber)
+        {
+            before = s_prev[i].ulRunTimeCounter;
+            break;
+        }
+    }
+    // A task created during the period counted from zero
+    const uint32_t run = (uint32_t)(t->ulRunTimeCounter - before);
+    const uint64_t bp = (uint64_t)run * 10000 / period;
+    return bp > 10000 ? 10000 : (uint16_t)bp;
+}
+#endif
+
+// Every task's state in a heap array sized from the current count. The
+// kernel fills nothing if the array is short, so a burst of task creation
+// gets another try with a fresh count.
+static TaskStatus_t* read_tasks(UBaseType_t* n, run_time_t* total)
+{
+    for (int attempt = 0; attempt < TASK_STATUS_ATTEMPTS; attempt++)
+    {
+        const UBaseType_t cap = uxTaskGetNumberOfTasks() + TASK_STATUS_SLACK;
+        TaskStatus_t* status = (TaskStatus_t*)malloc(cap * sizeof(TaskStatus_t));
+        if (!status)
+            return NULL;
+#if configGENERATE_RUN_TIME_STATS
+        *n = uxTaskGetSystemState(status, cap, total);
+#else
+        *n = uxTaskGetSystemState(status, cap, NULL);
+#endif
+        if (*n)
+            return status;
+        free(status);
+    }
+    return NULL;
+}
+
+static void sample(void* arg)
+{
+    (void)arg;
+    UBaseType_t n = 0;
+    run_time_t total = 0;
+    TaskStatus_t* status = read_tasks(&n, &total);
+    if (!status)
+    {
+        ESP_LOGW(TAG, "Could not read %u task states", (unsigned)uxTaskGetNumberOfTasks());
+        return;
+    }
+
+    const UBaseType_t shown = n < TASK_PROFILER_MAX_TASKS ? n : TASK_PROFILER_MAX_TASKS;
+    if (shown < n && !s_warned)
+    {
+        ESP_LOGW(TAG, "%u tasks, listing the first %d; raise TASK_PROFILER_MAX_TASKS", (unsigned)n,
+                 TASK_PROFILER_MAX_TASKS);
+        s_warned = true;
+    }
+
+    const uint32_t period = (uint32_t)(total - s_prev_total);
+    memset(&s_next, 0, sizeof(s_next));
+    s_next.uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    s_next.period = period;
+    s_next.count = (uint8_t)shown;
+    s_next.total = (uint8_t)(n < 0xFF ? n : 0xFF);
+    s_next.truncated = shown < n;
+    for (UBaseType_t i = 0; i < shown; i++)
+    {
+        const TaskStatus_t* t = &status[i];
+        task_prof_entry_t* e = &s_next.tasks[i];
+        strncpy(e->name, t->pcTaskName, TASK_PROFILER_NAME_LEN);
+        e->priority = (uint8_t)t->uxCurrentPriority;
+        e->state = (uint8_t)t->eCurrentState;
+        // Bytes on ESP-IDF, where StackType_t is a byte
+        e->stack_free = (uint32_t)t->usStackHighWaterMark * sizeof(StackType_t);
+#if configGENERATE_RUN_TIME_STATS
+        e->cpu_bp = cpu_share(t, period);
+#else
+        e->cpu_bp = TASK_PROFILER_CPU_UNKNOWN;
+#endif
+    }
+
+    // Kept whole, so a task's share is right whichever position it lists at
+    free(s_prev);
+    s_prev = status;
+    s_prev_count = n;
+    s_prev_total = total;
+
+    // The first call only sets the baseline for the deltas
+    if (!s_have_prev)
+    {
+        s_have_prev = true;
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_report = s_next;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool task_profiler_start(void)
+{
+    if (s_timer)
+        return true;
+
+    esp_timer_create_args_t args = {};
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.callback = sample;
+    args.name = "task_prof";
+    args.skip_unhandled_events = true;
+    if (esp_timer_create(&args, &s_timer) != ESP_OK)
+        return false;
+    sample(NULL);
+    return esp_timer_start_periodic(s_timer, (uint64_t)TASK_PROFILER_PERIOD_MS * 1000) == ESP_OK;
+}
+
+void task_profiler_get(task_prof_report_t* out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_report;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+size_t task_profiler_encode(uint8_t* buf, size_t cap)
+{
+    if (cap < TASK_PROF_MAX_LEN)
+        return 0;
+
+    task_prof_report_t r;
+    task_profiler_get(&r);
+
+    uint8_t* p = buf;
+    *p++ = TASK_PROF_MAGIC;
+    *p++ = TASK_PROF_VERSION;
+    *p++ = r.count;
+    *p++ = TASK_PROFILER_NAME_LEN;
+    p = put_u32(p, r.uptime_ms);
+    p = put_u32(p, r.period);
+    *p++ = r.total;
+    *p++ = r.truncated ? TASK_PROF_FLAG_TRUNCATED : 0;
+    for (uint8_t i = 0; i < r.count; i++)
+    {
+        const task_prof_entry_t* e = &r.tasks[i];
+        memcpy(p, e->name, TASK_PROFILER_NAME_LEN);
+        p += TASK_PROFILER_NAME_LEN;
+        *p++ = (uint8_t)e->cpu_bp;
+        *p++ = (uint8_t)(e->cpu_bp >> 8);
+        *p++ = e->priority;
+        *p++ = e->state;
+        p = put_u32(p, e->stack_free);
+    }
+    return (size_t)(p - buf);
+}
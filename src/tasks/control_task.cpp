@@ -2,122 +2,178 @@
 #include <freertos/task.h>
 #include <esp_log.h>
 #include <esp_timer.h>
-#include <driver/gpio.h>
 #include "config.h"
-#include "espnow_comm.h"
+#include "display_hud.h"
+#include "espnow_tx.h"
+#include "event_log.h"
+#include "fire_mode.h"
 #include "game_protocol.h"
+#include "game_snapshot.h"
 #include "game_state.h"
 #include "hash.h"
+#include "laser_tx.h"
+#include "latency_bench.h"
+#include "perf_metrics.h"
 #include "protocol_config.h"
+#include "shot_cache.h"
+#include "state_publisher.h"
 #include "tasks.h"
-#include "utils.h"
+#include "trigger_input.h"
 #include "wifi_manager.h"
-#include "ws_server.h"
+#include "ws_publisher.h"
 
 static const char* TAG = "ControlTask";
-static bool s_trigger_initialized = false;
 
 extern QueueHandle_t laserMessageQueue;
 static uint16_t g_message_count = 0;
+static uint32_t s_laser_stalls = 0;
 
-static void init_trigger_button(void)
+static bool can_fire(void)
 {
-    if (s_trigger_initialized)
-        return;
-
-    gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pin_bit_mask = (1ULL << TRIGGER_BUTTON_PIN);
-    io_conf.pull_up_en = GPIO_PULLUP_ENABLE; // Button pulls to GND when pressed
-    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    gpio_config(&io_conf);
-
-    s_trigger_initialized = true;
-    ESP_LOGI(TAG, "Trigger button initialized on GPIO %d", TRIGGER_BUTTON_PIN);
+    game_snapshot_t snap;
+    game_snapshot_read(&snap);
+    // game_state starts a respawn on its own and the snapshot only follows on
+    // the next publish; ask it directly and publish so the watch starts now
+    if (game_state_is_respawning())
+    {
+        if (!snap.respawning)
+            game_snapshot_publish();
+        return false;
+    }
+    return snap.game.unlimited_ammo || snap.game.max_ammo != 0;
 }
 
-static bool is_trigger_pressed(void)
+// Returns false when the laser pipeline is full; the shot is then retried
+// instead of being dropped. origin_us is where trigger-to-photon latency
+// starts for this shot; stamp_us is the time the shot carries on the wire.
+static bool fire_shot(int64_t t_us, int64_t origin_us, int64_t stamp_us)
 {
-    // Button is active LOW (pressed = 0)
-    return gpio_get_level((gpio_num_t)TRIGGER_BUTTON_PIN) == 0;
+    const armed_shot_t* armed = shot_cache_arm();
+    const uint32_t laser_msg = armed->laser_word;
+
+    // Back-pressure: wait up to one frame for the laser task to take a slot
+    const TickType_t wait = pdMS_TO_TICKS(laser_tx_frame_interval_us() / 1000) + 1;
+    // Stamped before the send: the laser task may run first
+    const int64_t queued_us = esp_timer_get_time();
+#if LATENCY_BENCH
+    latency_bench_queued(laser_msg, origin_us, t_us, queued_us);
+#else
+    (void)origin_us;
+#endif
+    const laser_msg_t item = {laser_msg, (uint32_t)queued_us};
+    if (xQueueSend(laserMessageQueue, &item, wait) != pdTRUE)
+    {
+#if LATENCY_BENCH
+        latency_bench_cancel();
+#endif
+        s_laser_stalls++;
+        perf_count(PERF_CTR_LASER_STALLS, 1);
+        EVLOG(EVLOG_TAG_SHOT, EVLOG_LEVEL_WARN, EVLOG_SHOT_QUEUE_FULL, laser_msg, s_laser_stalls);
+        return false;
+    }
+
+    g_message_count++;
+    perf_count(PERF_CTR_SHOTS, 1);
+    game_state_record_shot();
+    game_snapshot_publish();
+    state_publisher_mark(STATE_DIRTY_SHOT);
+    display_hud_sync();
+
+    PlayerMessage shot_msg = armed->shot;
+    shot_msg.timestamp_ms = (uint32_t)(stamp_us / 1000);
+    if (!espnow_tx_post(&shot_msg))
+    {
+        EVLOG(EVLOG_TAG_SHOT, EVLOG_LEVEL_WARN, EVLOG_SHOT_ESPNOW_FAILED, laser_msg, 0);
+    }
+
+    // Formatted off the trigger path by evlog_task
+    game_snapshot_t snap;
+    game_snapshot_read(&snap);
+    EVLOG(EVLOG_TAG_SHOT, EVLOG_LEVEL_INFO, EVLOG_SHOT_FIRED, laser_msg, snap.state.shots_fired);
+
+    // Encoded and sent by ws_task, so a client never stalls the trigger path
+    ws_event_t evt = {};
+    evt.type = WS_EVT_SHOT;
+    evt.player_id = armed->player_id;
+    evt.device_id = armed->device_id;
+    evt.team_id = armed->team_id;
+    evt.victim = -1;
+    evt.data = laser_msg;
+    evt.ts_ms = shot_msg.timestamp_ms;
+    ws_publisher_post_event(&evt);
+    return true;
 }
 
 void control_task(void* pvParameters)
 {
     ESP_LOGI(TAG, "Control task started");
-    uint8_t shot_counter = 0;
-    bool was_pressed = false;
 
-    init_trigger_button();
+    if (!trigger_input_init(TRIGGER_GLITCH_US))
+    {
+        ESP_LOGE(TAG, "Trigger input init failed");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    fire_mode_config_t fm;
+    uint32_t fm_gen = fire_mode_get_config(&fm);
+    fire_engine_t engine;
+    fire_engine_init(&engine, &fm, laser_tx_frame_interval_us());
+    int64_t wake_us = -1;
+    int64_t press_us = 0;
+    int64_t edge_us = -1; // debounced press edge not yet answered by a shot
 
     while (1)
     {
-        const DeviceConfig* config = game_state_get_config();
-        const GameConfig* gcfg = game_state_get_game_config();
-
-        if (game_state_is_respawning())
+        // Sleeps until a trigger edge, or until the next burst/auto shot is due
+        TickType_t timeout = portMAX_DELAY;
+        if (wake_us >= 0)
         {
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
+            const int64_t us = wake_us - esp_timer_get_time();
+            timeout = us <= 0 ? 0 : pdMS_TO_TICKS((us + 999) / 1000);
         }
 
-        if (!gcfg->unlimited_ammo && gcfg->max_ammo == 0)
+        trigger_event_t evt;
+        if (trigger_input_wait(&evt, timeout))
         {
-            vTaskDelay(pdMS_TO_TICKS(200));
-            continue;
+            if (evt.type == TRIGGER_EVT_PRESS)
+            {
+                fire_engine_press(&engine, evt.t_us);
+                press_us = evt.t_us;
+                edge_us = evt.t_us;
+            }
+            else if (evt.type == TRIGGER_EVT_RELEASE)
+                fire_engine_release(&engine, evt.t_us);
         }
 
-        bool is_pressed = is_trigger_pressed();
-        if (!is_pressed)
+        if (fire_mode_generation() != fm_gen)
         {
-            was_pressed = false;
-            vTaskDelay(pdMS_TO_TICKS(10));
-            continue;
+            fm_gen = fire_mode_get_config(&fm);
+            fire_engine_init(&engine, &fm, laser_tx_frame_interval_us());
+            ESP_LOGI(TAG, "Fire mode %d, burst %u, %u rpm", (int)fm.mode, fm.burst_count, fm.rounds_per_minute);
         }
 
-        if (was_pressed)
-        {
-            vTaskDelay(pdMS_TO_TICKS(10));
+        const int64_t now = esp_timer_get_time();
+        if (!fire_engine_due(&engine, now, &wake_us))
             continue;
-        }
-        was_pressed = true;
-
-        shot_counter++;
-        g_message_count++;
-
-        uint32_t laser_msg = createLaserMessage(config->player_id, config->device_id);
 
-        game_state_record_shot();
-
-        PlayerMessage shot_msg = {};
-        shot_msg.type = ESPNOW_MSG_SHOT;
-        shot_msg.version = 1;
-        shot_msg.player_id = config->player_id;
-        shot_msg.device_id = config->device_id;
-        shot_msg.team_id = config->team_id;
-        shot_msg.color_rgb = config->color_rgb;
-        shot_msg.data = laser_msg;
-        shot_msg.timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000);
-        if (!espnow_comm_broadcast(&shot_msg))
-        {
-            ESP_LOGW(TAG, "ESP-NOW shot broadcast failed");
-        }
-
-        if (xQueueSend(laserMessageQueue, &laser_msg, 0) != pdTRUE)
+        if (!can_fire())
         {
-            ESP_LOGW(TAG, "Failed to send to laser queue");
+            fire_engine_cancel(&engine);
+            wake_us = -1;
+            edge_us = -1;
+            continue;
         }
 
-        ESP_LOGI(TAG, "[Laser] %lu ms | %s | Shots: %lu", pdTICKS_TO_MS(xTaskGetTickCount()),
-                 toBinaryString(laser_msg, MESSAGE_TOTAL_BITS).c_str(),
-                 (unsigned long)game_state_get()->shots_fired);
-
-        if (ws_server_is_connected())
+        // From the trigger edge, or from the due time of a burst/auto follow-up
+        const int64_t origin_us = engine.next_shot_us > press_us ? engine.next_shot_us : press_us;
+        // The first shot of a press carries its trigger edge, follow-ups their due time
+        const int64_t stamp_us = edge_us >= 0 ? edge_us : origin_us;
+        if (fire_shot(now, origin_us, stamp_us))
         {
-            ws_server_broadcast_shot();
+            fire_engine_fired(&engine, now);
+            edge_us = -1;
         }
-
-        vTaskDelay(pdMS_TO_TICKS(TRANSMISSION_PAUSE_MS));
+        fire_engine_due(&engine, esp_timer_get_time(), &wake_us);
     }
 }
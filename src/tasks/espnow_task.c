@@ -1,24 +1,84 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "display_hud.h"
 #include "espnow_comm.h"
+#include "espnow_dispatch.h"
+#include "espnow_tx.h"
+#include "game_sched.h"
+#include "game_snapshot.h"
 #include "game_state.h"
+#include "hit_dedup.h"
+#include "peer_table.h"
 #include "tasks.h"
 #include "wifi_manager.h"
-#include "ws_server.h"
+#include "ws_publisher.h"
 
 static const char* TAG = "EspNowTask";
+static uint8_t s_self_device_id = 0;
+static hit_dedup_t s_hit_dedup;
 
-static void load_peers_from_nvs(void)
+static void on_hit_event(const EspnowMessageEnvelope* env, void* ctx)
 {
-    char peers[256] = {0};
-    if (wifi_manager_load_peer_list(peers, sizeof(peers)))
+    (void)ctx;
+    if (env->msg.device_id != s_self_device_id)
+        return;
+
+    // Retransmissions and repeated confirmations must not inflate the score
+    const uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    if (!hit_dedup_check(&s_hit_dedup, env->src_mac, env->msg.timestamp_ms, env->msg.data, now_ms))
+    {
+        ESP_LOGD(TAG, "Duplicate hit dropped (total %lu)", (unsigned long)s_hit_dedup.duplicates);
+        return;
+    }
+
+    // A hit that ends in a respawn is timed from here, not from when the
+    // snapshot next notices it
+    const int64_t hit_us = esp_timer_get_time();
+    game_state_record_hit();
+    game_state_record_kill();
+    game_sched_respawn_watch(hit_us);
+    game_snapshot_publish();
+    display_hud_sync();
+
+    peer_info_t peer;
+    const int victim =
+        peer_table_find(env->src_mac, &peer) && peer.player_id != PEER_ID_UNKNOWN ? peer.player_id : -1;
+
+    // ws_task sends the hit event and the coalesced state delta
+    ws_event_t evt = {
+        .type = WS_EVT_HIT,
+        .player_id = env->msg.player_id,
+        .device_id = env->msg.device_id,
+        .team_id = env->msg.team_id,
+        .victim = (int16_t)victim,
+        .data = env->msg.data,
+        .ts_ms = env->msg.timestamp_ms,
+    };
+    ws_publisher_post_event(&evt);
+    ESP_LOGI(TAG, "Hit confirmed by peer (%02X:%02X:%02X:%02X:%02X:%02X) player=%d data=%u", env->src_mac[0],
+             env->src_mac[1], env->src_mac[2], env->src_mac[3], env->src_mac[4], env->src_mac[5], victim,
+             env->msg.data);
+}
+
+// A peer's own shots name it; fills in peers known only by MAC
+static void on_shot(const EspnowMessageEnvelope* env, void* ctx)
+{
+    (void)ctx;
+    peer_table_learn(env->src_mac, env->msg.player_id, env->msg.device_id, env->msg.team_id);
+}
+
+// Drains the shot TX ring so radio latency never lands on the trigger path
+void espnow_tx_task(void* pvParameters)
+{
+    (void)pvParameters;
+    while (1)
     {
-        espnow_comm_load_peers_from_csv(peers);
-        ESP_LOGI(TAG, "Applied peer list: %s", peers);
+        espnow_tx_service(portMAX_DELAY);
     }
 }
 
@@ -26,7 +86,7 @@ void espnow_task(void* pvParameters)
 {
     (void)pvParameters;
     const DeviceConfig* config = game_state_get_config();
-    const uint8_t self_device_id = config ? config->device_id : 0;
+    s_self_device_id = config ? config->device_id : 0;
 
     while (!wifi_manager_is_connected())
     {
@@ -46,25 +106,23 @@ void espnow_task(void* pvParameters)
         return;
     }
 
-    load_peers_from_nvs();
+    peer_table_load();
+    peer_table_register_commands();
     ESP_LOGI(TAG, "ESP-NOW ready on channel %u", wifi_manager_get_channel());
+    // Shots fired before this point have been waiting in the TX ring
+    espnow_tx_set_link_up();
+
+    hit_dedup_init(&s_hit_dedup);
+    espnow_dispatch_register(ESPNOW_MSG_HIT_EVENT, on_hit_event, NULL);
+    espnow_dispatch_register(ESPNOW_MSG_SHOT, on_shot, NULL);
 
     EspnowMessageEnvelope env;
     while (1)
     {
-        if (espnow_comm_receive(&env, pdMS_TO_TICKS(500)))
+        // Blocks until a frame arrives; no periodic wakeups
+        if (espnow_comm_receive(&env, portMAX_DELAY))
         {
-            if (env.msg.type == ESPNOW_MSG_HIT_EVENT && env.msg.device_id == self_device_id)
-            {
-                game_state_record_hit();
-                game_state_record_kill();
-                ws_server_broadcast_game_state();
-                ESP_LOGI(TAG,
-                         "Hit confirmed by peer (%02X:%02X:%02X:%02X:%02X:%02X) data=%u",
-                         env.src_mac[0], env.src_mac[1], env.src_mac[2],
-                         env.src_mac[3], env.src_mac[4], env.src_mac[5],
-                         env.msg.data);
-            }
+            espnow_dispatch(&env);
         }
     }
 }
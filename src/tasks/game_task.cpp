@@ -1,43 +1,70 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include "display_hud.h"
 #include "game_protocol.h"
+#include "game_sched.h"
+#include "game_snapshot.h"
 #include "game_state.h"
+#include "state_publisher.h"
 #include "tasks.h"
-#include "ws_server.h"
 
 static const char* TAG = "GameTask";
 
-void game_task(void* pvParameters)
+#define GAME_TICK_MS 1000
+#define GAME_STATS_EVERY_TICKS 30
+
+static void on_game_event(game_evt_t evt, void* ctx)
 {
-    ESP_LOGI(TAG, "Game task started");
+    (void)ctx;
+    static uint32_t ticks = 0;
 
-    while (1)
+    switch (evt)
     {
-        const GameStateData* state = game_state_get();
-        if (game_state_is_respawning())
+        case GAME_EVT_RESPAWN_STARTED:
+            ESP_LOGI(TAG, "Respawning...");
+            display_hud_sync();
+            break;
+        case GAME_EVT_RESPAWN_DONE:
+            ESP_LOGI(TAG, "Respawn complete after %lu ms - ready to play!",
+                     (unsigned long)(game_sched_last_respawn_us() / 1000));
+            display_hud_sync();
+            break;
+        case GAME_EVT_TICK:
         {
-            if (game_state_check_respawn())
-            {
-                ESP_LOGI(TAG, "Respawn complete - ready to play!");
-            }
-            else
-            {
-                vTaskDelay(pdMS_TO_TICKS(100));
-                continue;
-            }
-        }
+            // Picks up changes made inside game_state itself (hearts, deaths,
+            // respawn start); only changed fields reach the display
+            if (game_snapshot_publish())
+                state_publisher_mark(STATE_DIRTY_OTHER);
+            display_hud_sync();
 
-        static uint32_t last_log = 0;
-        uint32_t now = xTaskGetTickCount() / configTICK_RATE_HZ;
-        if (now - last_log >= 30)
-        {
+            if (++ticks % GAME_STATS_EVERY_TICKS != 0)
+                break;
+            game_snapshot_t snap;
+            game_snapshot_read(&snap);
             ESP_LOGI(TAG, "Stats | K/D: %lu/%lu | Shots: %lu | Hits: %lu | Hearts: %u",
-                     (unsigned long)state->kills, (unsigned long)state->deaths, (unsigned long)state->shots_fired,
-                     (unsigned long)state->hits_landed, (unsigned)state->hearts_remaining);
-            last_log = now;
+                     (unsigned long)snap.state.kills, (unsigned long)snap.state.deaths,
+                     (unsigned long)snap.state.shots_fired, (unsigned long)snap.state.hits_landed,
+                     (unsigned)snap.state.hearts_remaining);
+            break;
         }
+        default:
+            break;
+    }
+}
 
-        vTaskDelay(pdMS_TO_TICKS(100));
+void game_task(void* pvParameters)
+{
+    ESP_LOGI(TAG, "Game task started");
+
+    game_sched_bind();
+    game_sched_subscribe(on_game_event, NULL);
+    game_sched_every(GAME_EVT_TICK, GAME_TICK_MS);
+    game_sched_respawn_watch(esp_timer_get_time());
+
+    while (1)
+    {
+        game_sched_service(portMAX_DELAY);
     }
 }
@@ -1,39 +1,53 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
-#include <driver/gpio.h>
+#include <esp_timer.h>
 #include "config.h"
+#include "laser_frame.h"
+#include "laser_tx.h"
+#include "latency_bench.h"
+#include "perf_metrics.h"
 #include "protocol_config.h"
+#include "shot_cache.h"
 #include "tasks.h"
 
 static const char* TAG = "LaserTask";
 
 extern QueueHandle_t laserMessageQueue;
 
-static void sendMessage(uint32_t message)
-{
-    TickType_t nextWake = xTaskGetTickCount();
-    const TickType_t bitPeriod = pdMS_TO_TICKS(BIT_DURATION_MS);
-
-    for (int i = MESSAGE_TOTAL_BITS - 1; i >= 0; i--)
-    {
-        bool bit = (message >> i) & 0x01;
-        gpio_set_level((gpio_num_t)LASER_PIN, bit ? 1 : 0);
-        vTaskDelayUntil(&nextWake, bitPeriod);
-    }
-    gpio_set_level((gpio_num_t)LASER_PIN, 0);
-}
-
 void laser_task(void* pvParameters)
 {
     ESP_LOGI(TAG, "Laser task started");
-    uint32_t message;
+    laser_msg_t item;
+    laser_frame_t frame;
+    bool have_frame = false;
 
     while (1)
     {
-        if (xQueueReceive(laserMessageQueue, &message, portMAX_DELAY) == pdTRUE)
+        if (xQueueReceive(laserMessageQueue, &item, portMAX_DELAY) == pdTRUE)
         {
-            sendMessage(message);
+            const int64_t dequeued_us = esp_timer_get_time();
+            const uint32_t message = item.word;
+            perf_hist_record(PERF_HIST_LASER_QUEUE, (uint32_t)dequeued_us - item.queued_us);
+            perf_gauge_set(PERF_GAUGE_LASER_QUEUE, (int32_t)uxQueueMessagesWaiting(laserMessageQueue));
+            // The RMT peripheral plays frames out back to back; we only block
+            // while all of its transmit slots are queued, never per bit.
+            if (!have_frame || frame.message != message)
+            {
+                if (!shot_cache_copy_frame(message, &frame))
+                    laser_frame_encode(&frame, message, laser_tx_bit_us(), laser_tx_gap_us());
+                have_frame = true;
+            }
+            perf_hist_record(PERF_HIST_SHOT_ENCODE, (uint32_t)(esp_timer_get_time() - dequeued_us));
+            const bool sent = laser_tx_send(&frame, portMAX_DELAY);
+            if (!sent)
+            {
+                perf_count(PERF_CTR_LASER_DROPPED, 1);
+                ESP_LOGW(TAG, "Laser frame dropped");
+            }
+#if LATENCY_BENCH
+            latency_bench_sent(message, dequeued_us, esp_timer_get_time(), sent ? laser_tx_last_start_us() : -1);
+#endif
         }
     }
 }
@@ -2,10 +2,16 @@
 #include <freertos/task.h>
 #include <esp_log.h>
 #include <stdio.h>
+#include "config.h"
 #include "display_manager.h"
+#include "game_sched.h"
 #include "game_state.h"
+#include "state_publisher.h"
 #include "tasks.h"
 #include "wifi_manager.h"
+#include "ws_commands.h"
+#include "ws_out.h"
+#include "ws_publisher.h"
 #include "ws_server.h"
 
 
@@ -16,19 +22,48 @@ static void ws_on_connect(int client_fd, bool connected)
     int count = ws_server_client_count();
     ESP_LOGI(TAG, "WebSocket %s (fd=%d, total=%d)", connected ? "connected" : "disconnected", client_fd, count);
 
+    if (connected)
+    {
+        ws_out_client_add(client_fd);
+        state_publisher_mark(STATE_DIRTY_CLIENT);
+    }
+    else
+    {
+        ws_out_client_remove(client_fd);
+    }
+
     dm_event_t evt = {};
     evt.type = DM_EVT_MSG;
     snprintf(evt.msg.text, sizeof(evt.msg.text), connected ? "WS ON" : "WS OFF");
     display_manager_post(&evt);
 }
 
+// Runs on game_task; respawn is pushed as soon as the scheduler sees it
+static void on_game_event(game_evt_t evt, void* ctx)
+{
+    (void)ctx;
+    if (evt == GAME_EVT_RESPAWN_DONE)
+        state_publisher_mark(STATE_DIRTY_RESPAWN);
+}
+
 void ws_task(void* pvParameters)
 {
     ESP_LOGI(TAG, "WebSocket task started");
 
+    state_publisher_bind();
+    game_sched_subscribe(on_game_event, NULL);
+    if (!ws_publisher_init())
+    {
+        ESP_LOGE(TAG, "Failed to create WebSocket event queue");
+    }
+
+    // Commands are registered before the first client can send one. Sessions
+    // ws_out gives up on are closed by the server that owns the socket.
     WsServerConfig ws_cfg = {};
     ws_cfg.on_connect = ws_on_connect;
+    ws_cfg.on_text = ws_commands_handle;
     ws_server_init(&ws_cfg);
+    ws_out_set_close_fn(ws_server_close_client);
 
     while (!wifi_manager_is_connected())
     {
@@ -37,21 +72,71 @@ void ws_task(void* pvParameters)
 
     ESP_LOGI(TAG, "WiFi connected, WebSocket server already running");
 
+    const TickType_t housekeeping = pdMS_TO_TICKS(1000);
+    TickType_t last_periodic = xTaskGetTickCount();
+    TickType_t last_push = last_periodic;
+    bool backlog = false;
+    // The server's own status and respawn messages, held back while a ws_out
+    // frame is half-written so the two never interleave on a socket
+    bool status_due = false;
+    bool respawn_due = false;
     while (1)
     {
-        // Cleanup stale clients (handles browser refresh without close frame)
-        ws_server_cleanup_stale();
+        // Sleep until game state changes or housekeeping is due; a burst of
+        // changes within the coalesce window becomes one delta. While a
+        // client socket is full, come back soon to resume writing it.
+        const TickType_t since = xTaskGetTickCount() - last_periodic;
+        TickType_t timeout = since >= housekeeping ? 0 : housekeeping - since;
+        if ((backlog || status_due || respawn_due) && timeout > pdMS_TO_TICKS(WS_OUT_RETRY_MS))
+            timeout = pdMS_TO_TICKS(WS_OUT_RETRY_MS);
+        const uint32_t dirty = state_publisher_wait(timeout, pdMS_TO_TICKS(WS_PUBLISH_COALESCE_MS));
 
-        if (ws_server_is_connected() && game_state_heartbeat_due())
+        // Shot and hit events first, each as its own message
+        ws_publisher_drain_events();
+
+        if (dirty & STATE_DIRTY_CLIENT)
+        {
+            // Device info for the new client; its first delta carries all fields
+            status_due = true;
+        }
+        if (dirty & (STATE_DIRTY_GAME | STATE_DIRTY_CLIENT))
+        {
+            ws_publisher_push();
+            last_push = xTaskGetTickCount();
+        }
+        if (dirty & STATE_DIRTY_RESPAWN)
         {
-            ws_server_send_status();
+            respawn_due = true;
         }
 
-        if (game_state_check_respawn())
+        backlog = ws_publisher_service();
+
+        if (xTaskGetTickCount() - last_periodic >= housekeeping)
         {
-            ws_server_broadcast_respawn();
+            last_periodic = xTaskGetTickCount();
+
+            // Cleanup stale clients (handles browser refresh without close frame)
+            ws_server_cleanup_stale();
+
+            // Heartbeat is a fallback for idle periods only
+            if (ws_server_is_connected() && last_periodic - last_push >= pdMS_TO_TICKS(WS_HEARTBEAT_IDLE_MS) &&
+                game_state_heartbeat_due())
+            {
+                status_due = true;
+                ws_publisher_count_heartbeat();
+                last_push = last_periodic;
+            }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        // The shared server writes these synchronously from this task
+        if ((status_due || respawn_due) && ws_out_between_frames())
+        {
+            if (respawn_due)
+                ws_server_broadcast_respawn();
+            if (status_due)
+                ws_server_send_status();
+            status_due = false;
+            respawn_due = false;
+        }
     }
 }
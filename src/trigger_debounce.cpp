@@ -0,0 +1,49 @@
+#include "trigger_debounce.h"
+
+static trigger_evt_type_t accept(trigger_debounce_t* d, bool pressed, int64_t t_us)
+{
+    d->pressed = pressed;
+    d->last_edge_us = t_us;
+    if (pressed)
+    {
+        d->press_us = t_us;
+        return TRIGGER_EVT_PRESS;
+    }
+    d->release_us = t_us;
+    return TRIGGER_EVT_RELEASE;
+}
+
+void trigger_debounce_init(trigger_debounce_t* d, uint32_t glitch_us, bool pressed, int64_t now_us)
+{
+    d->glitch_us = glitch_us;
+    d->pressed = pressed;
+    d->raw = pressed;
+    d->last_edge_us = now_us - glitch_us;
+    d->press_us = 0;
+    d->release_us = 0;
+}
+
+trigger_evt_type_t trigger_debounce_edge(trigger_debounce_t* d, bool pressed, int64_t t_us)
+{
+    d->raw = pressed;
+    if (pressed == d->pressed)
+        return TRIGGER_EVT_NONE;
+    if (t_us - d->last_edge_us < (int64_t)d->glitch_us)
+        return TRIGGER_EVT_NONE;
+    return accept(d, pressed, t_us);
+}
+
+trigger_evt_type_t trigger_debounce_settle(trigger_debounce_t* d, int64_t now_us)
+{
+    const int64_t deadline = trigger_debounce_deadline(d);
+    if (deadline < 0 || now_us < deadline)
+        return TRIGGER_EVT_NONE;
+    return accept(d, d->raw, now_us);
+}
+
+int64_t trigger_debounce_deadline(const trigger_debounce_t* d)
+{
+    if (d->raw == d->pressed)
+        return -1;
+    return d->last_edge_us + d->glitch_us;
+}
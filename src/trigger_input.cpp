@@ -0,0 +1,169 @@
+#include "trigger_input.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <soc/soc_caps.h>
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+#include <driver/gpio_filter.h>
+#endif
+#include "config.h"
+
+static const char* TAG = "TriggerInput";
+
+#define TRIGGER_EVENT_RING 8
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static trigger_debounce_t s_db;
+static trigger_event_t s_ring[TRIGGER_EVENT_RING];
+static uint8_t s_head;
+static uint8_t s_tail;
+static TaskHandle_t s_task;
+static uint32_t s_overflow;
+
+static inline bool read_pressed(void)
+{
+    // Button is active LOW (pressed = 0)
+    return gpio_get_level((gpio_num_t)TRIGGER_BUTTON_PIN) == 0;
+}
+
+// Callers hold s_mux
+static void push_event(trigger_evt_type_t type, int64_t t_us)
+{
+    const uint8_t next = (s_head + 1) % TRIGGER_EVENT_RING;
+    if (next == s_tail)
+    {
+        s_overflow++;
+        return;
+    }
+    s_ring[s_head].type = type;
+    s_ring[s_head].t_us = t_us;
+    s_head = next;
+}
+
+static bool pop_event(trigger_event_t* evt)
+{
+    if (s_tail == s_head)
+        return false;
+    *evt = s_ring[s_tail];
+    s_tail = (s_tail + 1) % TRIGGER_EVENT_RING;
+    return true;
+}
+
+static void trigger_isr(void* arg)
+{
+    (void)arg;
+    const int64_t t = esp_timer_get_time();
+    const bool pressed = read_pressed();
+
+    portENTER_CRITICAL_ISR(&s_mux);
+    const bool was_pending = trigger_debounce_deadline(&s_db) >= 0;
+    const trigger_evt_type_t type = trigger_debounce_edge(&s_db, pressed, t);
+    if (type != TRIGGER_EVT_NONE)
+        push_event(type, t);
+    const bool wake = type != TRIGGER_EVT_NONE || (!was_pending && trigger_debounce_deadline(&s_db) >= 0);
+    portEXIT_CRITICAL_ISR(&s_mux);
+
+    if (wake)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(s_task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+bool trigger_input_init(uint32_t glitch_us)
+{
+    if (s_task)
+        return true;
+    s_task = xTaskGetCurrentTaskHandle();
+
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pin_bit_mask = (1ULL << TRIGGER_BUTTON_PIN);
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE; // Button pulls to GND when pressed
+    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    gpio_config(&io_conf);
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+    // Hardware filter drops sub-microsecond spikes before they raise an interrupt
+    gpio_glitch_filter_handle_t filter = NULL;
+    gpio_pin_glitch_filter_config_t filter_cfg = {};
+    filter_cfg.clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT;
+    filter_cfg.gpio_num = (gpio_num_t)TRIGGER_BUTTON_PIN;
+    if (gpio_new_pin_glitch_filter(&filter_cfg, &filter) == ESP_OK)
+    {
+        gpio_glitch_filter_enable(filter);
+    }
+#endif
+
+    trigger_debounce_init(&s_db, glitch_us, read_pressed(), esp_timer_get_time());
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "ISR service install failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    err = gpio_isr_handler_add((gpio_num_t)TRIGGER_BUTTON_PIN, trigger_isr, NULL);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Trigger ISR add failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Trigger button initialized on GPIO %d (glitch %lu us)", TRIGGER_BUTTON_PIN,
+             (unsigned long)glitch_us);
+    return true;
+}
+
+bool trigger_input_wait(trigger_event_t* evt, TickType_t timeout)
+{
+    const TickType_t start = xTaskGetTickCount();
+    for (;;)
+    {
+        const int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&s_mux);
+        const trigger_evt_type_t late = trigger_debounce_settle(&s_db, now);
+        if (late != TRIGGER_EVT_NONE)
+            push_event(late, now);
+        const bool got = pop_event(evt);
+        const int64_t deadline = trigger_debounce_deadline(&s_db);
+        portEXIT_CRITICAL(&s_mux);
+
+        if (got)
+            return true;
+
+        TickType_t wait = portMAX_DELAY;
+        if (timeout != portMAX_DELAY)
+        {
+            const TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout)
+                return false;
+            wait = timeout - elapsed;
+        }
+
+        if (deadline >= 0)
+        {
+            const int64_t us = deadline - esp_timer_get_time();
+            if (us <= 0)
+                continue;
+            const TickType_t settle = pdMS_TO_TICKS((us + 999) / 1000) + 1;
+            if (settle < wait)
+                wait = settle;
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+bool trigger_input_is_pressed(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    const bool pressed = s_db.pressed;
+    portEXIT_CRITICAL(&s_mux);
+    return pressed;
+}
@@ -0,0 +1,259 @@
+#include "ws_codec.h"
+#include <string.h>
+
+typedef struct
+{
+    ws_fmt_t fmt;
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    uint8_t fields;
+    bool ok;
+} enc_t;
+
+static void put(enc_t* e, const void* p, size_t n)
+{
+    if (!e->ok || e->len + n > e->cap)
+    {
+        e->ok = false;
+        return;
+    }
+    memcpy(e->buf + e->len, p, n);
+    e->len += n;
+}
+
+static void put_byte(enc_t* e, uint8_t b)
+{
+    put(e, &b, 1);
+}
+
+static void put_decimal(enc_t* e, uint32_t v)
+{
+    char tmp[10];
+    int n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    char out[10];
+    for (int i = 0; i < n; i++)
+        out[i] = tmp[n - 1 - i];
+    put(e, out, n);
+}
+
+static void put_mp_str(enc_t* e, const char* s)
+{
+    const size_t n = strlen(s); // keys and type names stay below 32 bytes
+    put_byte(e, (uint8_t)(0xA0 | n));
+    put(e, s, n);
+}
+
+static void put_mp_uint(enc_t* e, uint32_t v)
+{
+    if (v < 0x80)
+    {
+        put_byte(e, (uint8_t)v);
+    }
+    else if (v <= 0xFF)
+    {
+        const uint8_t b[] = {0xCC, (uint8_t)v};
+        put(e, b, sizeof(b));
+    }
+    else if (v <= 0xFFFF)
+    {
+        const uint8_t b[] = {0xCD, (uint8_t)(v >> 8), (uint8_t)v};
+        put(e, b, sizeof(b));
+    }
+    else
+    {
+        const uint8_t b[] = {0xCE, (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v};
+        put(e, b, sizeof(b));
+    }
+}
+
+static void put_mp_int(enc_t* e, int32_t v)
+{
+    if (v >= 0)
+    {
+        put_mp_uint(e, (uint32_t)v);
+    }
+    else if (v >= -32)
+    {
+        put_byte(e, (uint8_t)(int8_t)v);
+    }
+    else
+    {
+        const uint8_t b[] = {0xD2, (uint8_t)((uint32_t)v >> 24), (uint8_t)((uint32_t)v >> 16),
+                             (uint8_t)((uint32_t)v >> 8), (uint8_t)v};
+        put(e, b, sizeof(b));
+    }
+}
+
+// Every message is a flat map starting with "type"; the MessagePack fixmap
+// header is patched with the field count at the end.
+static void begin(enc_t* e, ws_fmt_t fmt, uint8_t* buf, size_t cap, const char* type)
+{
+    e->fmt = fmt;
+    e->buf = buf;
+    e->cap = cap;
+    e->len = 0;
+    e->fields = 1;
+    e->ok = true;
+    if (fmt == WS_FMT_MSGPACK)
+    {
+        put_byte(e, 0x80);
+        put_mp_str(e, "type");
+        put_mp_str(e, type);
+    }
+    else
+    {
+        put(e, "{\"type\":\"", 9);
+        put(e, type, strlen(type));
+        put_byte(e, '"');
+    }
+}
+
+static void field_key(enc_t* e, const char* key)
+{
+    e->fields++;
+    if (e->fmt == WS_FMT_MSGPACK)
+    {
+        put_mp_str(e, key);
+        return;
+    }
+    put(e, ",\"", 2);
+    put(e, key, strlen(key));
+    put(e, "\":", 2);
+}
+
+static void field_u32(enc_t* e, const char* key, uint32_t v)
+{
+    field_key(e, key);
+    if (e->fmt == WS_FMT_MSGPACK)
+        put_mp_uint(e, v);
+    else
+        put_decimal(e, v);
+}
+
+static void field_i32(enc_t* e, const char* key, int32_t v)
+{
+    field_key(e, key);
+    if (e->fmt == WS_FMT_MSGPACK)
+    {
+        put_mp_int(e, v);
+        return;
+    }
+    if (v < 0)
+    {
+        put_byte(e, '-');
+        put_decimal(e, (uint32_t)(-(int64_t)v));
+        return;
+    }
+    put_decimal(e, (uint32_t)v);
+}
+
+static size_t finish(enc_t* e)
+{
+    if (e->fmt == WS_FMT_MSGPACK)
+    {
+        if (e->ok && e->fields <= 15)
+            e->buf[0] = (uint8_t)(0x80 | e->fields);
+        else
+            e->ok = false;
+    }
+    else
+    {
+        put_byte(e, '}');
+    }
+    return e->ok ? e->len : 0;
+}
+
+size_t ws_codec_event(ws_fmt_t fmt, const ws_event_t* evt, uint8_t* buf, size_t cap)
+{
+    enc_t e;
+    begin(&e, fmt, buf, cap, evt->type == WS_EVT_HIT ? "hit" : "shot");
+    field_u32(&e, "player", evt->player_id);
+    field_u32(&e, "device", evt->device_id);
+    field_u32(&e, "team", evt->team_id);
+    if (evt->type == WS_EVT_HIT)
+        field_i32(&e, "victim", evt->victim);
+    field_u32(&e, "data", evt->data);
+    field_u32(&e, "ts", evt->ts_ms);
+    return finish(&e);
+}
+
+enum
+{
+    DELTA_KILLS = 1 << 0,
+    DELTA_DEATHS = 1 << 1,
+    DELTA_SHOTS = 1 << 2,
+    DELTA_HITS = 1 << 3,
+    DELTA_HEARTS = 1 << 4,
+    DELTA_RESPAWNING = 1 << 5,
+    DELTA_MAX_AMMO = 1 << 6,
+    DELTA_UNLIMITED = 1 << 7,
+    DELTA_ALL = (1 << 8) - 1,
+};
+
+uint32_t ws_codec_delta_fields(const ws_delta_t* delta)
+{
+    const game_snapshot_t* prev = delta->prev;
+    const game_snapshot_t* cur = delta->cur;
+    if (!prev)
+        return DELTA_ALL;
+    uint32_t m = 0;
+    m |= cur->state.kills != prev->state.kills ? DELTA_KILLS : 0;
+    m |= cur->state.deaths != prev->state.deaths ? DELTA_DEATHS : 0;
+    m |= cur->state.shots_fired != prev->state.shots_fired ? DELTA_SHOTS : 0;
+    m |= cur->state.hits_landed != prev->state.hits_landed ? DELTA_HITS : 0;
+    m |= cur->state.hearts_remaining != prev->state.hearts_remaining ? DELTA_HEARTS : 0;
+    m |= cur->respawning != prev->respawning ? DELTA_RESPAWNING : 0;
+    m |= cur->game.max_ammo != prev->game.max_ammo ? DELTA_MAX_AMMO : 0;
+    m |= cur->game.unlimited_ammo != prev->game.unlimited_ammo ? DELTA_UNLIMITED : 0;
+    return m;
+}
+
+size_t ws_codec_delta(ws_fmt_t fmt, const ws_delta_t* delta, uint8_t* buf, size_t cap)
+{
+    const uint32_t m = ws_codec_delta_fields(delta);
+    if (m == 0)
+        return 0;
+    const game_snapshot_t* cur = delta->cur;
+
+    enc_t e;
+    begin(&e, fmt, buf, cap, "delta");
+    field_u32(&e, "gen", cur->generation);
+    if (m & DELTA_KILLS)
+        field_u32(&e, "kills", cur->state.kills);
+    if (m & DELTA_DEATHS)
+        field_u32(&e, "deaths", cur->state.deaths);
+    if (m & DELTA_SHOTS)
+        field_u32(&e, "shots", cur->state.shots_fired);
+    if (m & DELTA_HITS)
+        field_u32(&e, "hits", cur->state.hits_landed);
+    if (m & DELTA_HEARTS)
+        field_u32(&e, "hearts", cur->state.hearts_remaining);
+    if (m & DELTA_RESPAWNING)
+        field_u32(&e, "respawning", cur->respawning ? 1 : 0);
+    if (m & DELTA_MAX_AMMO)
+        field_u32(&e, "max_ammo", cur->game.max_ammo);
+    if (m & DELTA_UNLIMITED)
+        field_u32(&e, "unlimited", cur->game.unlimited_ammo ? 1 : 0);
+    return finish(&e);
+}
+
+bool ws_codec_parse_fmt(const char* name, ws_fmt_t* out)
+{
+    if (strcmp(name, "msgpack") == 0)
+    {
+        *out = WS_FMT_MSGPACK;
+        return true;
+    }
+    if (strcmp(name, "json") == 0)
+    {
+        *out = WS_FMT_JSON;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,78 @@
+#include "ws_commands.h"
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <string.h>
+
+static const char* TAG = "WsCommands";
+
+#define WS_COMMAND_MAX_LEN 128
+
+typedef struct
+{
+    const char* name;
+    ws_command_fn fn;
+    void* ctx;
+} ws_command_entry_t;
+
+// Registration runs on several tasks while the server task may be looking
+// commands up, so the table is only touched under the lock
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static ws_command_entry_t s_commands[WS_COMMANDS_MAX];
+static size_t s_count = 0;
+
+bool ws_commands_register(const char* name, ws_command_fn fn, void* ctx)
+{
+    portENTER_CRITICAL(&s_mux);
+    const bool ok = s_count < WS_COMMANDS_MAX;
+    if (ok)
+    {
+        s_commands[s_count].name = name;
+        s_commands[s_count].fn = fn;
+        s_commands[s_count].ctx = ctx;
+        s_count++;
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (!ok)
+        ESP_LOGE(TAG, "No room for command '%s', raise WS_COMMANDS_MAX", name);
+    return ok;
+}
+
+static bool lookup(const char* name, ws_command_entry_t* out)
+{
+    bool found = false;
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; i < s_count && !found; i++)
+    {
+        if (strcmp(s_commands[i].name, name) == 0)
+        {
+            *out = s_commands[i];
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return found;
+}
+
+bool ws_commands_handle(int client_fd, const char* text, size_t len)
+{
+    if (!text || len == 0 || len >= WS_COMMAND_MAX_LEN)
+        return false;
+
+    char line[WS_COMMAND_MAX_LEN];
+    memcpy(line, text, len);
+    line[len] = '\0';
+
+    char* args = strchr(line, ' ');
+    if (args)
+        *args++ = '\0';
+    else
+        args = line + len;
+
+    // Run outside the lock so commands may register or look up others
+    ws_command_entry_t cmd;
+    if (!lookup(line, &cmd))
+        return false;
+    if (!cmd.fn(client_fd, args, cmd.ctx))
+        ESP_LOGW(TAG, "Command '%s' failed", line);
+    return true;
+}
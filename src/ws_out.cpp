@@ -0,0 +1,509 @@
+#include "ws_out.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "perf_metrics.h"
+
+static const char* TAG = "WsOut";
+
+#define WS_OUT_FRAME_MAX (10 + WS_CODEC_MAX_LEN)
+
+typedef struct
+{
+    uint8_t len;
+    uint8_t op;
+    uint8_t payload[WS_OUT_EVENT_MAX_LEN];
+} ws_event_slot_t;
+
+typedef struct
+{
+    bool used;
+    bool fresh;
+    bool state_dirty;
+    int fd;
+    ws_fmt_t fmt;
+
+    // Frame being written from out, either frame or the shared reply
+    // buffer; off bytes of len already on the socket
+    uint8_t frame[WS_OUT_FRAME_MAX];
+    const uint8_t* out;
+    uint16_t len;
+    uint16_t off;
+    ws_out_reply_fn replies[WS_OUT_REPLY_SLOTS];
+    uint8_t reply_count;
+
+    // Pending control frame (0 = none); closing once a CLOSE is on its way
+    uint8_t ctl_op;
+    uint8_t ctl_len;
+    uint8_t ctl_payload[WS_OUT_CONTROL_MAX_LEN];
+    bool closing;
+
+    ws_event_slot_t events[WS_OUT_EVENT_SLOTS];
+    uint8_t ev_head;
+    uint8_t ev_count;
+
+    int64_t stalled_since_us;
+} ws_client_t;
+
+typedef enum
+{
+    WS_OP_ADD = 0,
+    WS_OP_REMOVE,
+    WS_OP_FORMAT,
+    WS_OP_REPLY,
+    WS_OP_CONTROL,
+} ws_client_op_kind_t;
+
+typedef struct
+{
+    uint8_t kind;
+    uint8_t arg; // format, or opcode for WS_OP_CONTROL
+    uint8_t len;
+    int fd;
+    ws_out_reply_fn reply;
+    uint8_t payload[WS_OUT_CONTROL_MAX_LEN];
+} ws_client_op_t;
+
+static ws_client_t s_clients[WS_OUT_MAX_CLIENTS];
+static QueueHandle_t s_ops;
+static ws_out_state_fn s_state_fn;
+static ws_out_close_fn s_close_fn;
+static ws_out_stats_t s_stats;
+static uint8_t s_reply[10 + WS_OUT_REPLY_MAX_LEN];
+static ws_client_t* s_reply_owner;
+
+// Ops are posted from any task; the count is kept apart from s_stats, which
+// only ws_task writes
+static portMUX_TYPE s_drop_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_ops_dropped;
+
+bool ws_out_init(void)
+{
+    if (!s_ops)
+        s_ops = xQueueCreate(WS_OUT_OPS_DEPTH, sizeof(ws_client_op_t));
+    return s_ops != NULL;
+}
+
+static void post_op(const ws_client_op_t* op)
+{
+    if (s_ops && xQueueSend(s_ops, op, 0) == pdTRUE)
+        return;
+    portENTER_CRITICAL(&s_drop_lock);
+    const uint32_t dropped = ++s_ops_dropped;
+    portEXIT_CRITICAL(&s_drop_lock);
+    ESP_LOGW(TAG, "Client op %u for fd=%d dropped (%lu total)", (unsigned)op->kind, op->fd, (unsigned long)dropped);
+}
+
+static void post_simple(ws_client_op_kind_t kind, int fd, uint8_t arg, ws_out_reply_fn reply)
+{
+    ws_client_op_t op;
+    op.kind = (uint8_t)kind;
+    op.arg = arg;
+    op.len = 0;
+    op.fd = fd;
+    op.reply = reply;
+    post_op(&op);
+}
+
+void ws_out_client_add(int fd)
+{
+    post_simple(WS_OP_ADD, fd, WS_FMT_JSON, NULL);
+}
+
+void ws_out_client_remove(int fd)
+{
+    post_simple(WS_OP_REMOVE, fd, WS_FMT_JSON, NULL);
+}
+
+void ws_out_set_format(int fd, ws_fmt_t fmt)
+{
+    post_simple(WS_OP_FORMAT, fd, (uint8_t)fmt, NULL);
+}
+
+void ws_out_reply(int fd, ws_out_reply_fn fn)
+{
+    post_simple(WS_OP_REPLY, fd, WS_FMT_JSON, fn);
+}
+
+void ws_out_control(int fd, ws_opcode_t op, const uint8_t* payload, size_t len)
+{
+    ws_client_op_t item;
+    item.kind = WS_OP_CONTROL;
+    item.arg = (uint8_t)op;
+    item.len = (uint8_t)(len < WS_OUT_CONTROL_MAX_LEN ? len : WS_OUT_CONTROL_MAX_LEN);
+    item.fd = fd;
+    item.reply = NULL;
+    if (item.len)
+        memcpy(item.payload, payload, item.len);
+    post_op(&item);
+}
+
+void ws_out_set_state_source(ws_out_state_fn fn)
+{
+    s_state_fn = fn;
+}
+
+void ws_out_set_close_fn(ws_out_close_fn fn)
+{
+    s_close_fn = fn;
+}
+
+static ws_client_t* find(int fd)
+{
+    for (int i = 0; i < WS_OUT_MAX_CLIENTS; i++)
+    {
+        if (s_clients[i].used && s_clients[i].fd == fd)
+            return &s_clients[i];
+    }
+    return NULL;
+}
+
+static void release_reply(ws_client_t* c)
+{
+    if (s_reply_owner == c)
+        s_reply_owner = NULL;
+}
+
+static void queue_reply(ws_client_t* c, ws_out_reply_fn fn)
+{
+    for (uint8_t i = 0; i < c->reply_count; i++)
+    {
+        if (c->replies[i] == fn)
+            return;
+    }
+    if (c->reply_count == WS_OUT_REPLY_SLOTS)
+    {
+        ESP_LOGW(TAG, "Reply dropped for fd=%d", c->fd);
+        return;
+    }
+    c->replies[c->reply_count++] = fn;
+}
+
+static void apply_ops(void)
+{
+    ws_client_op_t op;
+    bool changed = false;
+    while (s_ops && xQueueReceive(s_ops, &op, 0) == pdTRUE)
+    {
+        ws_client_t* c = find(op.fd);
+        switch (op.kind)
+        {
+            case WS_OP_ADD:
+                for (int i = 0; !c && i < WS_OUT_MAX_CLIENTS; i++)
+                {
+                    if (s_clients[i].used)
+                        continue;
+                    c = &s_clients[i];
+                    memset(c, 0, sizeof(*c));
+                    c->used = true;
+                    c->fresh = true;
+                    c->state_dirty = true;
+                    c->fd = op.fd;
+                    c->fmt = WS_FMT_JSON;
+                }
+                if (!c)
+                    ESP_LOGW(TAG, "No slot for fd=%d", op.fd);
+                changed = true;
+                break;
+            case WS_OP_REMOVE:
+                if (c)
+                {
+                    release_reply(c);
+                    c->used = false;
+                }
+                changed = true;
+                break;
+            case WS_OP_FORMAT:
+                if (c)
+                {
+                    // Deltas in the new format start over from a full frame
+                    c->fmt = (ws_fmt_t)op.arg;
+                    c->fresh = true;
+                    c->state_dirty = true;
+                }
+                break;
+            case WS_OP_REPLY:
+                if (c)
+                    queue_reply(c, op.reply);
+                break;
+            case WS_OP_CONTROL:
+                if (c && c->ctl_op != WS_OP_CLOSE)
+                {
+                    c->ctl_op = op.arg;
+                    c->ctl_len = op.len;
+                    memcpy(c->ctl_payload, op.payload, op.len);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (changed)
+        perf_gauge_set(PERF_GAUGE_WS_CLIENTS, ws_out_client_count());
+}
+
+static void end_session(ws_client_t* c)
+{
+    // The server owns the socket and reports the close back as a remove
+    if (s_close_fn)
+        s_close_fn(c->fd);
+    else
+        shutdown(c->fd, SHUT_RDWR);
+    release_reply(c);
+    c->used = false;
+}
+
+static void evict(ws_client_t* c, const char* why)
+{
+    ESP_LOGW(TAG, "Evicting fd=%d: %s", c->fd, why);
+    end_session(c);
+    s_stats.evictions++;
+    perf_count(PERF_CTR_WS_EVICTIONS, 1);
+    perf_gauge_set(PERF_GAUGE_WS_CLIENTS, ws_out_client_count());
+}
+
+size_t ws_out_frame_header(uint8_t* hdr, ws_opcode_t op, size_t payload_len)
+{
+    hdr[0] = 0x80 | (uint8_t)op; // FIN, no fragmentation
+    if (payload_len < 126)
+    {
+        hdr[1] = (uint8_t)payload_len;
+        return 2;
+    }
+    if (payload_len <= 0xFFFF)
+    {
+        hdr[1] = 126;
+        hdr[2] = (uint8_t)(payload_len >> 8);
+        hdr[3] = (uint8_t)payload_len;
+        return 4;
+    }
+    hdr[1] = 127;
+    for (int i = 0; i < 8; i++)
+        hdr[2 + i] = (uint8_t)((uint64_t)payload_len >> (56 - 8 * i));
+    return 10;
+}
+
+static ws_opcode_t opcode_for(ws_fmt_t fmt)
+{
+    return fmt == WS_FMT_JSON ? WS_OP_TEXT : WS_OP_BINARY;
+}
+
+static void load_frame(ws_client_t* c, ws_opcode_t op, const uint8_t* payload, size_t len)
+{
+    const size_t hlen = ws_out_frame_header(c->frame, op, len);
+    memcpy(c->frame + hlen, payload, len);
+    c->out = c->frame;
+    c->len = (uint16_t)(hlen + len);
+    c->off = 0;
+}
+
+int ws_out_enqueue(ws_out_encode_fn encode, const void* msg)
+{
+    apply_ops();
+
+    uint8_t enc[WS_FMT_COUNT][WS_OUT_EVENT_MAX_LEN];
+    size_t len[WS_FMT_COUNT] = {};
+    bool done[WS_FMT_COUNT] = {};
+    int queued = 0;
+
+    for (int i = 0; i < WS_OUT_MAX_CLIENTS; i++)
+    {
+        ws_client_t* c = &s_clients[i];
+        if (!c->used)
+            continue;
+        if (!done[c->fmt])
+        {
+            len[c->fmt] = encode(c->fmt, msg, enc[c->fmt], WS_OUT_EVENT_MAX_LEN);
+            done[c->fmt] = true;
+        }
+        if (len[c->fmt] == 0)
+            continue;
+
+        // Guaranteed delivery: a client that cannot keep up is dropped
+        // rather than silently losing events
+        if (c->ev_count == WS_OUT_EVENT_SLOTS)
+        {
+            evict(c, "event backlog full");
+            continue;
+        }
+        ws_event_slot_t* slot = &c->events[(c->ev_head + c->ev_count) % WS_OUT_EVENT_SLOTS];
+        slot->len = (uint8_t)len[c->fmt];
+        slot->op = (uint8_t)opcode_for(c->fmt);
+        memcpy(slot->payload, enc[c->fmt], slot->len);
+        c->ev_count++;
+        if (c->ev_count > s_stats.event_high_water)
+            s_stats.event_high_water = c->ev_count;
+        queued++;
+    }
+    s_stats.events_queued += queued;
+    return queued;
+}
+
+void ws_out_mark_state(void)
+{
+    apply_ops();
+    for (int i = 0; i < WS_OUT_MAX_CLIENTS; i++)
+    {
+        if (!s_clients[i].used)
+            continue;
+        if (s_clients[i].state_dirty)
+            s_stats.states_superseded++;
+        s_clients[i].state_dirty = true;
+    }
+}
+
+// Encodes the reply right behind the longest possible header and moves the
+// real header up against it
+static bool load_reply(ws_client_t* c)
+{
+    const ws_out_reply_fn fn = c->replies[0];
+    c->reply_count--;
+    memmove(c->replies, c->replies + 1, c->reply_count * sizeof(c->replies[0]));
+    uint8_t* payload = s_reply + 10;
+    const size_t n = fn(payload, WS_OUT_REPLY_MAX_LEN);
+    if (n == 0)
+        return false;
+
+    uint8_t hdr[10];
+    const size_t hlen = ws_out_frame_header(hdr, WS_OP_BINARY, n);
+    memcpy(payload - hlen, hdr, hlen);
+    c->out = payload - hlen;
+    c->len = (uint16_t)(hlen + n);
+    c->off = 0;
+    s_reply_owner = c;
+    return true;
+}
+
+// Next frame: a control frame, guaranteed events in order, then a pending
+// reply, then the folded state
+static bool next_frame(int slot, ws_client_t* c)
+{
+    if (c->ctl_op)
+    {
+        load_frame(c, (ws_opcode_t)c->ctl_op, c->ctl_payload, c->ctl_len);
+        c->closing = c->ctl_op == WS_OP_CLOSE;
+        c->ctl_op = 0;
+        return true;
+    }
+    if (c->ev_count)
+    {
+        const ws_event_slot_t* ev = &c->events[c->ev_head];
+        load_frame(c, (ws_opcode_t)ev->op, ev->payload, ev->len);
+        c->ev_head = (c->ev_head + 1) % WS_OUT_EVENT_SLOTS;
+        c->ev_count--;
+        return true;
+    }
+    // Another client's reply may still hold the buffer; retried next service
+    if (c->reply_count && !s_reply_owner && load_reply(c))
+        return true;
+    if (c->state_dirty && s_state_fn)
+    {
+        c->state_dirty = false;
+        uint8_t payload[WS_CODEC_MAX_LEN];
+        const size_t n = s_state_fn(slot, c->fresh, c->fmt, payload, sizeof(payload));
+        c->fresh = false;
+        if (n == 0)
+            return false;
+        load_frame(c, opcode_for(c->fmt), payload, n);
+        return true;
+    }
+    return false;
+}
+
+static bool service_client(int slot, ws_client_t* c, int64_t now)
+{
+    for (;;)
+    {
+        if (c->off == c->len)
+        {
+            release_reply(c);
+            if (c->closing)
+            {
+                // Our CLOSE answered the client's; the handshake is complete
+                end_session(c);
+                return false;
+            }
+            if (!next_frame(slot, c))
+            {
+                c->stalled_since_us = 0;
+                return c->reply_count != 0;
+            }
+        }
+
+        const int64_t send_us = esp_timer_get_time();
+        const ssize_t n = send(c->fd, c->out + c->off, c->len - c->off, MSG_DONTWAIT);
+        perf_hist_record(PERF_HIST_WS_SEND, (uint32_t)(esp_timer_get_time() - send_us));
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            s_stats.would_block++;
+            if (!c->stalled_since_us)
+                c->stalled_since_us = now;
+            else if (now - c->stalled_since_us > (int64_t)WS_OUT_EVICT_MS * 1000)
+            {
+                evict(c, "stalled");
+                return false;
+            }
+            return true;
+        }
+        if (n <= 0)
+        {
+            evict(c, "send failed");
+            return false;
+        }
+
+        c->stalled_since_us = 0;
+        c->off += (uint16_t)n;
+        s_stats.bytes_sent += (uint32_t)n;
+        if (c->off == c->len)
+        {
+            s_stats.frames_sent++;
+            perf_count(PERF_CTR_WS_FRAMES, 1);
+            if (s_reply_owner == c)
+                s_stats.replies_sent++;
+        }
+    }
+}
+
+bool ws_out_service(void)
+{
+    apply_ops();
+    const int64_t now = esp_timer_get_time();
+    bool pending = false;
+    for (int i = 0; i < WS_OUT_MAX_CLIENTS; i++)
+    {
+        if (s_clients[i].used)
+            pending |= service_client(i, &s_clients[i], now);
+    }
+    return pending;
+}
+
+bool ws_out_between_frames(void)
+{
+    for (int i = 0; i < WS_OUT_MAX_CLIENTS; i++)
+    {
+        const ws_client_t* c = &s_clients[i];
+        if (c->used && c->off > 0 && c->off < c->len)
+            return false;
+    }
+    return true;
+}
+
+int ws_out_client_count(void)
+{
+    int n = 0;
+    for (int i = 0; i < WS_OUT_MAX_CLIENTS; i++)
+        n += s_clients[i].used ? 1 : 0;
+    return n;
+}
+
+void ws_out_get_stats(ws_out_stats_t* out)
+{
+    *out = s_stats;
+    portENTER_CRITICAL(&s_drop_lock);
+    out->ops_dropped = s_ops_dropped;
+    portEXIT_CRITICAL(&s_drop_lock);
+}
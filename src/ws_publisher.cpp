@@ -0,0 +1,185 @@
+#include "ws_publisher.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "fire_mode.h"
+#include "perf_metrics.h"
+#include "state_publisher.h"
+#include "task_profiler.h"
+#include "ws_commands.h"
+#include "ws_out.h"
+
+static_assert(PERF_SNAPSHOT_LEN <= WS_OUT_REPLY_MAX_LEN, "metrics snapshot does not fit a reply frame");
+static_assert(TASK_PROF_MAX_LEN <= WS_OUT_REPLY_MAX_LEN, "task profile does not fit a reply frame");
+
+static const char* TAG = "WsPub";
+
+static QueueHandle_t s_events;
+static game_snapshot_t s_base[WS_OUT_MAX_CLIENTS];
+static ws_publisher_stats_t s_stats;
+
+// Events are posted from the trigger and ESP-NOW paths, which must not log;
+// drops are counted there and reported by ws_task
+static portMUX_TYPE s_drop_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_events_dropped;
+static uint32_t s_drops_logged;
+
+static size_t encode_event(ws_fmt_t fmt, const void* msg, uint8_t* buf, size_t cap)
+{
+    return ws_codec_event(fmt, (const ws_event_t*)msg, buf, cap);
+}
+
+static void record_latency(void)
+{
+    const int64_t start = state_publisher_batch_start_us();
+    const uint32_t latency = start ? (uint32_t)(esp_timer_get_time() - start) : 0;
+    s_stats.last_latency_us = latency;
+    if (latency > s_stats.max_latency_us)
+        s_stats.max_latency_us = latency;
+    s_stats.avg_latency_us = s_stats.avg_latency_us
+                                 ? s_stats.avg_latency_us - s_stats.avg_latency_us / 8 + latency / 8
+                                 : latency;
+}
+
+// Called by ws_out when a client's backlog has drained; a fresh client gets
+// every field once, zeros included, and deltas against that from then on
+static size_t state_source(int slot, bool fresh, ws_fmt_t fmt, uint8_t* buf, size_t cap)
+{
+    game_snapshot_t cur;
+    game_snapshot_read(&cur);
+    const ws_delta_t delta = {fresh ? NULL : &s_base[slot], &cur};
+    const size_t n = ws_codec_delta(fmt, &delta, buf, cap);
+    if (n == 0)
+        return 0;
+
+    s_base[slot] = cur;
+    s_stats.deltas_sent++;
+    record_latency();
+    return n;
+}
+
+// "proto json" / "proto msgpack", sent by a client right after connecting
+static bool cmd_proto(int client_fd, const char* args, void* ctx)
+{
+    (void)ctx;
+    ws_fmt_t fmt;
+    if (!ws_codec_parse_fmt(args, &fmt))
+        return false;
+    ws_out_set_format(client_fd, fmt);
+    ESP_LOGI(TAG, "Client fd=%d uses %s", client_fd, fmt == WS_FMT_MSGPACK ? "msgpack" : "json");
+    return true;
+}
+
+// "metrics": one binary perf_metrics snapshot back to the asking client
+static bool cmd_metrics(int client_fd, const char* args, void* ctx)
+{
+    (void)args;
+    (void)ctx;
+    ws_out_reply(client_fd, perf_metrics_snapshot);
+    state_publisher_mark(STATE_DIRTY_REPLY);
+    return true;
+}
+
+// "tasks": the latest task_profiler sample, CPU share and stack headroom
+static bool cmd_tasks(int client_fd, const char* args, void* ctx)
+{
+    (void)args;
+    (void)ctx;
+    ws_out_reply(client_fd, task_profiler_encode);
+    state_publisher_mark(STATE_DIRTY_REPLY);
+    return true;
+}
+
+// "fire <semi|burst|auto> [burst_count] [rpm]": control_task applies it
+// before its next shot
+static bool cmd_fire(int client_fd, const char* args, void* ctx)
+{
+    (void)ctx;
+    fire_mode_config_t cfg;
+    fire_mode_get_config(&cfg);
+    if (!fire_mode_parse(args, &cfg, &cfg))
+        return false;
+    fire_mode_set_config(&cfg);
+    ESP_LOGI(TAG, "Client fd=%d set fire mode %d, burst %u, %u rpm", client_fd, (int)cfg.mode,
+             (unsigned)cfg.burst_count, (unsigned)cfg.rounds_per_minute);
+    return true;
+}
+
+bool ws_publisher_init(void)
+{
+    if (s_events)
+        return true;
+    if (!ws_out_init())
+        return false;
+    s_events = xQueueCreate(WS_EVENT_QUEUE_LEN, sizeof(ws_event_t));
+    if (!s_events)
+        return false;
+    ws_out_set_state_source(state_source);
+    ws_commands_register("proto", cmd_proto, NULL);
+    ws_commands_register("metrics", cmd_metrics, NULL);
+    ws_commands_register("tasks", cmd_tasks, NULL);
+    ws_commands_register("fire", cmd_fire, NULL);
+    return true;
+}
+
+bool ws_publisher_post_event(const ws_event_t* evt)
+{
+    if (!s_events || xQueueSend(s_events, evt, 0) != pdTRUE)
+    {
+        portENTER_CRITICAL(&s_drop_lock);
+        s_events_dropped++;
+        portEXIT_CRITICAL(&s_drop_lock);
+        return false;
+    }
+    state_publisher_mark(evt->type == WS_EVT_HIT ? STATE_DIRTY_HIT : STATE_DIRTY_SHOT);
+    return true;
+}
+
+int ws_publisher_drain_events(void)
+{
+    if (!s_events)
+        return 0;
+    int n = 0;
+    ws_event_t evt;
+    while (xQueueReceive(s_events, &evt, 0) == pdTRUE)
+    {
+        ws_out_enqueue(encode_event, &evt);
+        n++;
+    }
+    s_stats.events_sent += n;
+
+    portENTER_CRITICAL(&s_drop_lock);
+    const uint32_t dropped = s_events_dropped;
+    portEXIT_CRITICAL(&s_drop_lock);
+    if (dropped != s_drops_logged)
+    {
+        ESP_LOGW(TAG, "%lu shot/hit events dropped, queue of %d full (%lu total)",
+                 (unsigned long)(dropped - s_drops_logged), WS_EVENT_QUEUE_LEN, (unsigned long)dropped);
+        s_drops_logged = dropped;
+    }
+    return n;
+}
+
+void ws_publisher_push(void)
+{
+    ws_out_mark_state();
+}
+
+bool ws_publisher_service(void)
+{
+    return ws_out_service();
+}
+
+void ws_publisher_count_heartbeat(void)
+{
+    s_stats.heartbeats++;
+}
+
+void ws_publisher_get_stats(ws_publisher_stats_t* out)
+{
+    *out = s_stats;
+    portENTER_CRITICAL(&s_drop_lock);
+    out->events_dropped = s_events_dropped;
+    portEXIT_CRITICAL(&s_drop_lock);
+}
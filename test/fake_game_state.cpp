@@ -0,0 +1,81 @@
+#include "fake_game_state.h"
+#include <esp_timer.h>
+#include <string.h>
+#include "game_protocol.h"
+
+fake_game_state_t g_fake_game;
+
+void fake_game_state_reset(void)
+{
+    memset(&g_fake_game, 0, sizeof(g_fake_game));
+    g_fake_game.config.player_id = 7;
+    g_fake_game.config.device_id = 3;
+    g_fake_game.config.team_id = 1;
+    g_fake_game.config.color_rgb = 0x00FF00;
+    g_fake_game.game.unlimited_ammo = true;
+    g_fake_game.state.hearts_remaining = 3;
+}
+
+bool game_state_init(DeviceRole role)
+{
+    (void)role;
+    fake_game_state_reset();
+    return true;
+}
+
+const GameStateData* game_state_get(void)
+{
+    return &g_fake_game.state;
+}
+
+const DeviceConfig* game_state_get_config(void)
+{
+    return &g_fake_game.config;
+}
+
+const GameConfig* game_state_get_game_config(void)
+{
+    return &g_fake_game.game;
+}
+
+void game_state_record_shot(void)
+{
+    g_fake_game.state.shots_fired++;
+}
+
+void game_state_record_hit(void)
+{
+    g_fake_game.state.hits_landed++;
+}
+
+void game_state_record_kill(void)
+{
+    g_fake_game.state.kills++;
+}
+
+bool game_state_is_respawning(void)
+{
+    return g_fake_game.respawning;
+}
+
+bool game_state_check_respawn(void)
+{
+    g_fake_game.respawn_checks++;
+    const bool over = g_fake_game.respawn_over ||
+                      (g_fake_game.respawn_until_us && esp_timer_get_time() >= g_fake_game.respawn_until_us);
+    if (!g_fake_game.respawning || !over)
+        return false;
+    g_fake_game.respawning = false;
+    return true;
+}
+
+bool game_state_heartbeat_due(void)
+{
+    return false;
+}
+
+// Same layout idea as the protocol's word: a marker, then player and device
+uint32_t createLaserMessage(uint8_t player_id, uint8_t device_id)
+{
+    return 0xA5000000u | ((uint32_t)player_id << 8) | device_id;
+}
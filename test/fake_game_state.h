@@ -0,0 +1,21 @@
+#pragma once
+
+#include "game_state.h"
+
+// The host tests do not link the shared component. This stand-in for its
+// game_state keeps plain structs that a test edits directly; the record_*
+// calls only bump the counters they are named after.
+typedef struct
+{
+    DeviceConfig config;
+    GameConfig game;
+    GameStateData state;
+    bool respawning;
+    bool respawn_over;       // game_state_check_respawn() ends the respawn
+    int64_t respawn_until_us; // or ends it from this esp_timer time on, if set
+    uint32_t respawn_checks;  // calls to game_state_check_respawn()
+} fake_game_state_t;
+
+extern fake_game_state_t g_fake_game;
+
+void fake_game_state_reset(void);
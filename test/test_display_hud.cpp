@@ -0,0 +1,285 @@
+// display_hud on pixels: the model is rendered, its rows are drawn at the
+// label positions of the device UI into a 128x32 framebuffer in panel page
+// layout, and regions of it are checked for the ammo bar, hearts and the
+// respawn countdown. The test draws with its own 5x7 font, so it checks what
+// the HUD puts where, not LVGL's text rendering.
+#include <stdio.h>
+#include <string.h>
+#include "display_hud.h"
+#include "ssd1306_diff.h"
+#include "test_util.h"
+
+#define CELL_W 6 // 5 columns of glyph, 1 of spacing
+#define GLYPH_H 7
+#define COUNTDOWN_STEP_MS 100 // the countdown shows tenths
+#define ROW_CELLS (OLED_WIDTH / CELL_W)
+
+// Label y offsets in display_manager's ui_init
+static const int s_row_y[DM_ROWS] = {0, 11, 22};
+
+typedef struct
+{
+    char ch;
+    uint8_t cols[5]; // bit n is glyph row n
+} glyph_t;
+
+// Only what the HUD prints. '#' is a solid cell so filled bar cells can be
+// counted.
+static const glyph_t s_font[] = {
+    {' ', {0x00, 0x00, 0x00, 0x00, 0x00}}, {'#', {0x7F, 0x7F, 0x7F, 0x7F, 0x7F}},
+    {'-', {0x08, 0x08, 0x08, 0x08, 0x08}}, {'.', {0x00, 0x60, 0x60, 0x00, 0x00}},
+    {'/', {0x20, 0x10, 0x08, 0x04, 0x02}}, {'[', {0x00, 0x7F, 0x41, 0x41, 0x00}},
+    {']', {0x00, 0x41, 0x41, 0x7F, 0x00}}, {'0', {0x3E, 0x51, 0x49, 0x45, 0x3E}},
+    {'1', {0x00, 0x42, 0x7F, 0x40, 0x00}}, {'2', {0x42, 0x61, 0x51, 0x49, 0x46}},
+    {'3', {0x21, 0x41, 0x45, 0x4B, 0x31}}, {'4', {0x18, 0x14, 0x12, 0x7F, 0x10}},
+    {'5', {0x27, 0x45, 0x45, 0x45, 0x39}}, {'6', {0x3C, 0x4A, 0x49, 0x49, 0x30}},
+    {'7', {0x01, 0x71, 0x09, 0x05, 0x03}}, {'8', {0x36, 0x49, 0x49, 0x49, 0x36}},
+    {'9', {0x06, 0x49, 0x49, 0x29, 0x1E}}, {'A', {0x7E, 0x11, 0x11, 0x11, 0x7E}},
+    {'D', {0x7F, 0x41, 0x41, 0x22, 0x1C}}, {'E', {0x7F, 0x49, 0x49, 0x49, 0x41}},
+    {'H', {0x7F, 0x08, 0x08, 0x08, 0x7F}}, {'K', {0x7F, 0x08, 0x14, 0x22, 0x41}},
+    {'M', {0x7F, 0x02, 0x0C, 0x02, 0x7F}}, {'N', {0x7F, 0x04, 0x08, 0x10, 0x7F}},
+    {'O', {0x3E, 0x41, 0x41, 0x41, 0x3E}}, {'P', {0x7F, 0x09, 0x09, 0x09, 0x06}},
+    {'R', {0x7F, 0x09, 0x19, 0x29, 0x46}}, {'S', {0x46, 0x49, 0x49, 0x49, 0x31}},
+    {'W', {0x3F, 0x40, 0x38, 0x40, 0x3F}}, {'f', {0x08, 0x7E, 0x09, 0x01, 0x02}},
+    {'i', {0x00, 0x44, 0x7D, 0x40, 0x00}}, {'n', {0x7C, 0x08, 0x04, 0x04, 0x78}},
+    {'s', {0x48, 0x54, 0x54, 0x54, 0x20}}, {'t', {0x04, 0x3F, 0x44, 0x40, 0x20}},
+};
+
+static const glyph_t* glyph(char ch)
+{
+    for (size_t i = 0; i < sizeof(s_font) / sizeof(s_font[0]); i++)
+    {
+        if (s_font[i].ch == ch)
+            return &s_font[i];
+    }
+    return NULL;
+}
+
+typedef struct
+{
+    uint8_t px[SSD1306_FB_SIZE]; // panel page layout
+} fb_t;
+
+static bool pixel(const fb_t* fb, int x, int y)
+{
+    return fb->px[(y / 8) * OLED_WIDTH + x] & (1u << (y % 8));
+}
+
+static void set_pixel(fb_t* fb, int x, int y)
+{
+    fb->px[(y / 8) * OLED_WIDTH + x] |= (uint8_t)(1u << (y % 8));
+}
+
+static void draw(const hud_model_t* m, uint32_t now_ms, fb_t* fb)
+{
+    char rows[DM_ROWS][DM_ROW_LEN];
+    hud_render(m, now_ms, rows);
+    memset(fb, 0, sizeof(*fb));
+    for (int r = 0; r < DM_ROWS; r++)
+    {
+        const size_t len = strlen(rows[r]);
+        CHECK(len <= ROW_CELLS);
+        for (size_t c = 0; c < len && c < ROW_CELLS; c++)
+        {
+            const glyph_t* g = glyph(rows[r][c]);
+            CHECK(g != NULL);
+            if (!g)
+                continue;
+            for (int gx = 0; gx < 5; gx++)
+            {
+                for (int gy = 0; gy < GLYPH_H; gy++)
+                {
+                    if (g->cols[gx] & (1u << gy))
+                        set_pixel(fb, (int)c * CELL_W + gx, s_row_y[r] + gy);
+                }
+            }
+        }
+    }
+}
+
+// Lit pixels in a text cell
+static int cell_lit(const fb_t* fb, int row, int cell)
+{
+    int n = 0;
+    for (int gx = 0; gx < CELL_W; gx++)
+    {
+        for (int gy = 0; gy < GLYPH_H; gy++)
+            n += pixel(fb, cell * CELL_W + gx, s_row_y[row] + gy) ? 1 : 0;
+    }
+    return n;
+}
+
+// The cells from `cell` on show text, and nothing is lit after it in the row
+static bool row_shows(const fb_t* fb, int row, int cell, const char* text)
+{
+    const int end = cell + (int)strlen(text);
+    for (int c = cell; c < ROW_CELLS; c++)
+    {
+        const glyph_t* g = c < end ? glyph(text[c - cell]) : glyph(' ');
+        for (int gx = 0; gx < CELL_W; gx++)
+        {
+            const uint8_t col = gx < 5 ? g->cols[gx] : 0;
+            for (int gy = 0; gy < GLYPH_H; gy++)
+            {
+                if (pixel(fb, c * CELL_W + gx, s_row_y[row] + gy) != ((col >> gy) & 1))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Solid cells in the ammo row: the filled part of the bar
+static int bar_filled(const fb_t* fb)
+{
+    int n = 0;
+    for (int c = 0; c < ROW_CELLS; c++)
+        n += cell_lit(fb, 0, c) == 5 * GLYPH_H ? 1 : 0;
+    return n;
+}
+
+// Whether any pixel differs outside the band of the given row
+static bool changed_outside(const fb_t* a, const fb_t* b, int row)
+{
+    for (int y = 0; y < OLED_HEIGHT; y++)
+    {
+        if (y >= s_row_y[row] && y < s_row_y[row] + GLYPH_H)
+            continue;
+        for (int x = 0; x < OLED_WIDTH; x++)
+        {
+            if (pixel(a, x, y) != pixel(b, x, y))
+                return true;
+        }
+    }
+    return false;
+}
+
+static void test_ammo(void)
+{
+    hud_model_t m;
+    hud_model_init(&m);
+    fb_t fb;
+
+    hud_model_apply(&m, DM_HUD_MAX_AMMO, 30, 0);
+    hud_model_apply(&m, DM_HUD_AMMO, 30, 0);
+    draw(&m, 0, &fb);
+    CHECK_EQ(bar_filled(&fb), DM_HUD_BAR_CELLS);
+    CHECK(row_shows(&fb, 0, 0, "30/30 [##########]"));
+
+    // Any ammo left keeps a cell lit; an empty magazine shows none
+    static const struct
+    {
+        int32_t ammo;
+        int filled;
+    } steps[] = {{29, 10}, {15, 5}, {14, 5}, {1, 1}, {0, 0}};
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+    {
+        hud_model_apply(&m, DM_HUD_AMMO, steps[i].ammo, 0);
+        fb_t next;
+        draw(&m, 0, &next);
+        CHECK_EQ(bar_filled(&next), steps[i].filled);
+        CHECK(!changed_outside(&fb, &next, 0));
+        fb = next;
+    }
+
+    // Unlimited: a count and no bar
+    hud_model_apply(&m, DM_HUD_MAX_AMMO, -1, 0);
+    hud_model_apply(&m, DM_HUD_AMMO, 7, 0);
+    draw(&m, 0, &fb);
+    CHECK_EQ(bar_filled(&fb), 0);
+    CHECK(row_shows(&fb, 0, 0, "AMMO 7 inf"));
+}
+
+static void test_hearts(void)
+{
+    hud_model_t m;
+    hud_model_init(&m);
+    fb_t before, after;
+
+    hud_model_apply(&m, DM_HUD_HEARTS, 3, 0);
+    draw(&m, 0, &before);
+    CHECK(row_shows(&before, 1, 0, "HP 3  K0/D0"));
+
+    // Losing a heart changes the digit after "HP " and nothing else
+    hud_model_apply(&m, DM_HUD_HEARTS, 2, 0);
+    draw(&m, 0, &after);
+    CHECK(row_shows(&after, 1, 3, "2  K0/D0"));
+    CHECK(!changed_outside(&before, &after, 1));
+    int changed_cells = 0;
+    for (int c = 0; c < ROW_CELLS; c++)
+    {
+        for (int gx = 0; gx < CELL_W; gx++)
+        {
+            bool differs = false;
+            for (int gy = 0; gy < GLYPH_H; gy++)
+                differs |= pixel(&before, c * CELL_W + gx, s_row_y[1] + gy) !=
+                           pixel(&after, c * CELL_W + gx, s_row_y[1] + gy);
+            if (differs)
+            {
+                CHECK_EQ(c, 3);
+                changed_cells++;
+                break;
+            }
+        }
+    }
+    CHECK_EQ(changed_cells, 1);
+
+    hud_model_apply(&m, DM_HUD_HEARTS, 0, 0);
+    hud_model_apply(&m, DM_HUD_DEATHS, 1, 0);
+    draw(&m, 0, &after);
+    CHECK(row_shows(&after, 1, 0, "HP 0  K0/D1"));
+}
+
+static void test_respawn_countdown(void)
+{
+    hud_model_t m;
+    hud_model_init(&m);
+    hud_model_apply(&m, DM_HUD_HITS, 4, 0);
+    const uint32_t start = 1000;
+    hud_model_apply(&m, DM_HUD_RESPAWN, 1, start);
+
+    char text[DM_ROW_LEN];
+    fb_t fb, next;
+    draw(&m, start, &fb);
+    snprintf(text, sizeof(text), "RESPAWN %lu.%lus", (unsigned long)(DM_RESPAWN_COUNTDOWN_MS / 1000),
+             (unsigned long)(DM_RESPAWN_COUNTDOWN_MS % 1000 / 100));
+    CHECK(row_shows(&fb, 2, 0, text));
+
+    // The pixels change exactly when hud_next_change_ms says, only in the
+    // countdown row, and count down to zero in tenths
+    uint32_t now = start;
+    int steps = 0;
+    while (hud_next_change_ms(&m, now) != UINT32_MAX)
+    {
+        const uint32_t wait = hud_next_change_ms(&m, now);
+        if (wait > 1)
+        {
+            draw(&m, now + wait - 1, &next);
+            CHECK(memcmp(&fb, &next, sizeof(fb)) == 0);
+        }
+        now += wait;
+        draw(&m, now, &next);
+        CHECK(memcmp(&fb, &next, sizeof(fb)) != 0);
+        CHECK(!changed_outside(&fb, &next, 2));
+        fb = next;
+        steps++;
+    }
+    // The last change is to 0.0, a step before the end; no wakeup after it
+    CHECK_EQ(steps, DM_RESPAWN_COUNTDOWN_MS / COUNTDOWN_STEP_MS);
+    CHECK_EQ(now, start + DM_RESPAWN_COUNTDOWN_MS - (COUNTDOWN_STEP_MS - 1));
+    draw(&m, start + DM_RESPAWN_COUNTDOWN_MS + 500, &next);
+    CHECK(memcmp(&fb, &next, sizeof(fb)) == 0);
+    CHECK(row_shows(&fb, 2, 0, "RESPAWN 0.0s"));
+
+    hud_model_apply(&m, DM_HUD_RESPAWN, 0, now);
+    draw(&m, now, &fb);
+    CHECK(row_shows(&fb, 2, 0, "Hits 4"));
+}
+
+int main(void)
+{
+    test_ammo();
+    test_hearts();
+    test_respawn_countdown();
+    return test_report("test_display_hud");
+}
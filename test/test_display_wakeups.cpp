@@ -0,0 +1,130 @@
+// display_manager_task on the sim's display: a static HUD costs no wakeups
+// and no flushes, a pushed change is still drawn at once, and the respawn
+// countdown wakes the task once per tenth. The byte rate is what oled_flush
+// put on the bus. Prints the wakeup and byte rates.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lvgl.h>
+#include <atomic>
+#include "display_hud.h"
+#include "display_init.h"
+#include "display_manager.h"
+#include "display_stats.h"
+#include "oled_flush.h"
+#include "runtime_metrics.h"
+#include "sim.h"
+#include "test_util.h"
+
+#define IDLE_WINDOW_MS 3000
+#define COUNTDOWN_WINDOW_MS 2000
+#define FRAME_BYTES (128 * 32 / 8)
+
+// Shared runtime_metrics stand-in for display_hud_sync(), which this test
+// does not call
+int metric_ammo(void)
+{
+    return 0;
+}
+
+static std::atomic<uint32_t> s_flushes{0};
+static void (*s_flush)(lv_disp_drv_t*, const lv_area_t*, lv_color_t*);
+
+static void count_flush(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map)
+{
+    s_flushes++;
+    s_flush(drv, area, color_map);
+}
+
+static uint32_t wakeups_per_s(void)
+{
+    dm_stats_t st;
+    display_manager_get_stats(&st);
+    return st.wakeups_per_s;
+}
+
+static uint32_t bus_bytes(void)
+{
+    uint32_t bytes = 0;
+    oled_flush_get_stats(&bytes, NULL);
+    return bytes;
+}
+
+static void test_idle(void)
+{
+    // Past the boot screen, with the HUD drawn once
+    display_manager_push(DM_HUD_MAX_AMMO, 30);
+    display_manager_push(DM_HUD_AMMO, 30);
+    display_manager_push(DM_HUD_HEARTS, 3);
+    vTaskDelay(pdMS_TO_TICKS(1200));
+    const uint32_t drawn = s_flushes;
+    const uint32_t bytes = bus_bytes();
+    CHECK(bytes > 0);
+
+    // Nothing changes: nothing goes on the bus, and the idle window in
+    // progress shows no wakeups and less than a frame a second (the HUD
+    // drawn at its start)
+    vTaskDelay(pdMS_TO_TICKS(IDLE_WINDOW_MS));
+    const uint32_t idle = wakeups_per_s();
+    dm_stats_t st;
+    display_manager_get_stats(&st);
+    test_log("idle: %u wakeups/s, %u flushes, %u bytes/s\n", (unsigned)idle, (unsigned)(s_flushes - drawn),
+             (unsigned)st.flush_bytes_per_s);
+    CHECK(idle <= 1);
+    CHECK_EQ(s_flushes, drawn);
+    CHECK_EQ(bus_bytes(), bytes);
+    CHECK(st.flush_bytes_per_s < FRAME_BYTES);
+
+    // A delta is on the panel within a tick or two
+    display_manager_push(DM_HUD_AMMO, 29);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    CHECK(s_flushes > drawn);
+}
+
+static void test_countdown(void)
+{
+    display_manager_push(DM_HUD_RESPAWN, 1);
+    vTaskDelay(pdMS_TO_TICKS(1100)); // one full stats window inside the countdown
+    const uint32_t before = s_flushes;
+    const uint32_t bytes_before = bus_bytes();
+    vTaskDelay(pdMS_TO_TICKS(COUNTDOWN_WINDOW_MS - 1100));
+    dm_stats_t st;
+    display_manager_get_stats(&st);
+    const uint32_t rate = st.wakeups_per_s;
+    const uint32_t flushes = s_flushes - before;
+    const uint32_t bus_rate = (bus_bytes() - bytes_before) * 1000 / (COUNTDOWN_WINDOW_MS - 1100);
+    test_log("countdown: %u wakeups/s, %u flushes in %u ms, %u bytes/s (bus %u bytes/s)\n", (unsigned)rate,
+             (unsigned)flushes, (unsigned)(COUNTDOWN_WINDOW_MS - 1100), (unsigned)st.flush_bytes_per_s,
+             (unsigned)bus_rate);
+    // Ten redraws a second, give or take the window edges
+    CHECK(rate >= 8 && rate <= 13);
+    CHECK(flushes >= 6);
+    // The last full window's bytes, as oled_flush counted them
+    CHECK(st.flush_bytes_per_s > 0);
+    CHECK(st.flush_bytes_per_s >= bus_rate / 2 && st.flush_bytes_per_s <= bus_rate * 2);
+    display_manager_push(DM_HUD_RESPAWN, 0);
+}
+
+static void body(void)
+{
+    sim_timer_start();
+    lv_disp_t* disp = init_display();
+    CHECK(disp != NULL);
+    if (!disp)
+        return;
+    // As main.cpp does: only changed bytes go to the panel
+    CHECK(oled_flush_attach(disp));
+    s_flush = disp->driver->flush_cb;
+    disp->driver->flush_cb = count_flush;
+
+    const dm_sources_t src = {};
+    CHECK(display_manager_init(disp, &src));
+    xTaskCreate(display_manager_task, "display", 4096, NULL, 3, NULL);
+
+    test_idle();
+    test_countdown();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_display_wakeups", body);
+}
@@ -0,0 +1,168 @@
+// espnow_dispatch replay: thousands of recorded-style envelopes (shots,
+// confirmed hits for this and other devices, retransmitted duplicates,
+// unknown types) through the dispatcher with espnow_task's hit handling.
+// Checks routing, dedup and that the publisher coalesces the burst, and
+// prints the per-message handling cost.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <string.h>
+#include <atomic>
+#include "espnow_dispatch.h"
+#include "fake_game_state.h"
+#include "game_snapshot.h"
+#include "hit_dedup.h"
+#include "state_publisher.h"
+#include "test_util.h"
+
+#define REPLAY_LEN 20000
+#define BURST_LEN 50
+#define SELF_DEVICE 3
+#define MSG_UNKNOWN 0x7E
+
+static EspnowMessageEnvelope s_replay[REPLAY_LEN];
+static uint32_t s_expected_hits;
+static uint32_t s_expected_unhandled;
+
+static hit_dedup_t s_dedup;
+static uint32_t s_handled;
+
+// espnow_task's on_hit_event minus the display, peer lookup and WebSocket
+// event, which only forward what is counted here
+static void on_hit_event(const EspnowMessageEnvelope* env, void* ctx)
+{
+    (void)ctx;
+    s_handled++;
+    if (env->msg.device_id != SELF_DEVICE)
+        return;
+    const uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    if (!hit_dedup_check(&s_dedup, env->src_mac, env->msg.timestamp_ms, env->msg.data, now_ms))
+        return;
+    game_state_record_hit();
+    game_state_record_kill();
+    game_snapshot_publish();
+    state_publisher_mark(STATE_DIRTY_HIT);
+}
+
+// A deterministic stand-in for a recorded session: eight vests and eight
+// weapons on the channel, each confirmed hit retransmitted now and then
+static void record(void)
+{
+    uint32_t rng = 0xC0FFEE;
+    uint32_t unique_ts = 1;
+    for (int i = 0; i < REPLAY_LEN; i++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        const uint32_t r = rng >> 8;
+        EspnowMessageEnvelope* env = &s_replay[i];
+        memset(env, 0, sizeof(*env));
+        env->src_mac[0] = 0x24;
+        env->src_mac[5] = (uint8_t)(r % 8);
+        env->msg.version = 1;
+        env->msg.player_id = (uint8_t)(r % 8);
+
+        const uint32_t kind = r % 100;
+        if (kind < 40)
+        {
+            env->msg.type = ESPNOW_MSG_SHOT;
+            env->msg.device_id = (uint8_t)(1 + r % 8);
+            s_expected_unhandled++;
+        }
+        else if (kind < 95)
+        {
+            if (kind >= 80 && i > 0)
+            {
+                // Retransmission of an earlier hit event
+                const EspnowMessageEnvelope* prev = &s_replay[i - 1 - (r >> 12) % (i < 16 ? i : 16)];
+                if (prev->msg.type == ESPNOW_MSG_HIT_EVENT)
+                {
+                    *env = *prev;
+                    continue;
+                }
+            }
+            env->msg.type = ESPNOW_MSG_HIT_EVENT;
+            env->msg.device_id = (r & 0x10000) ? SELF_DEVICE : (uint8_t)(4 + r % 4);
+            env->msg.timestamp_ms = unique_ts++;
+            env->msg.data = 0xA5000000u | r;
+            if (env->msg.device_id == SELF_DEVICE)
+                s_expected_hits++;
+        }
+        else
+        {
+            env->msg.type = MSG_UNKNOWN;
+            s_expected_unhandled++;
+        }
+    }
+}
+
+static std::atomic<bool> s_stop{false};
+static std::atomic<uint32_t> s_pushes{0};
+static std::atomic<bool> s_consumer_done{false};
+
+// ws_task's side: one state push per coalesced batch
+static void consumer(void* arg)
+{
+    (void)arg;
+    state_publisher_bind();
+    while (!s_stop.load())
+    {
+        if (state_publisher_wait(pdMS_TO_TICKS(10), pdMS_TO_TICKS(5)) & STATE_DIRTY_HIT)
+            s_pushes.fetch_add(1);
+    }
+    s_consumer_done.store(true);
+    vTaskDelete(NULL);
+}
+
+static void run(void)
+{
+    fake_game_state_reset();
+    game_snapshot_publish();
+    hit_dedup_init(&s_dedup);
+    record();
+    CHECK(espnow_dispatch_register(ESPNOW_MSG_HIT_EVENT, on_hit_event, NULL));
+
+    xTaskCreate(consumer, "ws", 4096, NULL, 4, NULL);
+    vTaskDelay(1);
+
+    // Bursts as they come off the radio, with a tick between bursts
+    const uint32_t unhandled_before = espnow_dispatch_unhandled();
+    int64_t busy_us = 0;
+    for (int i = 0; i < REPLAY_LEN; i += BURST_LEN)
+    {
+        const int64_t start = esp_timer_get_time();
+        for (int k = i; k < i + BURST_LEN && k < REPLAY_LEN; k++)
+            espnow_dispatch(&s_replay[k]);
+        busy_us += esp_timer_get_time() - start;
+        vTaskDelay(1);
+    }
+    vTaskDelay(pdMS_TO_TICKS(30));
+    s_stop.store(true);
+    while (!s_consumer_done.load())
+        vTaskDelay(1);
+
+    const uint32_t unhandled = espnow_dispatch_unhandled() - unhandled_before;
+    CHECK_EQ(unhandled, s_expected_unhandled);
+    CHECK_EQ(s_handled + unhandled, REPLAY_LEN);
+    CHECK_EQ(g_fake_game.state.hits_landed, s_expected_hits);
+    CHECK_EQ(g_fake_game.state.kills, s_expected_hits);
+    CHECK_EQ(s_dedup.accepted, s_expected_hits);
+    CHECK(s_dedup.duplicates > 0);
+
+    game_snapshot_t snap;
+    game_snapshot_read(&snap);
+    CHECK_EQ(snap.state.hits_landed, s_expected_hits);
+
+    // Many hits per push: the burst is coalesced, not one push per hit
+    const uint32_t pushes = s_pushes.load();
+    CHECK(pushes > 0);
+    CHECK(pushes * 4 < s_expected_hits);
+
+    test_log("replay: %d envelopes, %u hits (%u duplicates), %u unhandled, %u state pushes, %.0f ns/message\n",
+             REPLAY_LEN, (unsigned)s_expected_hits, (unsigned)s_dedup.duplicates, (unsigned)unhandled,
+             (unsigned)pushes, busy_us * 1000.0 / REPLAY_LEN);
+}
+
+int main(void)
+{
+    test_run_scheduled("test_espnow_dispatch", run);
+}
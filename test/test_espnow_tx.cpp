@@ -0,0 +1,184 @@
+// espnow_tx over a loopback transport: records wait for the link, idle shots
+// go out at once, a busy stream is packed into fewer frames, and nothing is
+// lost that was not counted. Prints frames per second and added latency.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <string.h>
+#include <atomic>
+#include "espnow_tx.h"
+#include "test_util.h"
+
+#define MAX_RECORDS 512
+
+typedef struct
+{
+    int64_t posted_us[MAX_RECORDS];
+    uint32_t next_expected;
+    uint32_t records;
+    uint32_t frames;
+    uint32_t max_batch;
+    int64_t latency_sum_us;
+    int64_t latency_max_us;
+    bool in_order;
+} loopback_t;
+
+static loopback_t s_lb;
+static std::atomic<bool> s_stop{false};
+
+// Stands in for the radio: PlayerMessage.data carries the record's index
+static bool loopback(const PlayerMessage* msgs, uint8_t count, void* ctx)
+{
+    loopback_t* lb = (loopback_t*)ctx;
+    const int64_t now = esp_timer_get_time();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const uint32_t idx = msgs[i].data;
+        if (idx != lb->next_expected)
+            lb->in_order = false;
+        lb->next_expected = idx + 1;
+        if (idx < MAX_RECORDS)
+        {
+            const int64_t latency = now - lb->posted_us[idx];
+            lb->latency_sum_us += latency;
+            if (latency > lb->latency_max_us)
+                lb->latency_max_us = latency;
+        }
+    }
+    lb->records += count;
+    lb->frames++;
+    if (count > lb->max_batch)
+        lb->max_batch = count;
+    return true;
+}
+
+static void tx_task(void* arg)
+{
+    (void)arg;
+    while (!s_stop.load())
+        espnow_tx_service(pdMS_TO_TICKS(10));
+    s_stop.store(false);
+    vTaskDelete(NULL);
+}
+
+static void reset_loopback(void)
+{
+    memset(&s_lb, 0, sizeof(s_lb));
+    s_lb.in_order = true;
+}
+
+static bool post(uint32_t idx)
+{
+    PlayerMessage msg = {};
+    msg.type = ESPNOW_MSG_SHOT;
+    msg.data = idx;
+    s_lb.posted_us[idx] = esp_timer_get_time();
+    return espnow_tx_post(&msg);
+}
+
+static void wait_drained(uint32_t records)
+{
+    for (int i = 0; i < 1000 && s_lb.records < records; i++)
+        vTaskDelay(pdMS_TO_TICKS(1));
+    // One more coalescing window so a late frame would still be seen
+    vTaskDelay(pdMS_TO_TICKS(ESPNOW_TX_COALESCE_US / 1000 + 5));
+}
+
+static void report(const char* name, uint32_t records, int64_t elapsed_us)
+{
+    const double fps = elapsed_us > 0 ? s_lb.frames * 1e6 / elapsed_us : 0;
+    test_log("%s: %u records in %u frames (max batch %u), %.1f frames/s, added latency avg %lld us max %lld us\n",
+             name, (unsigned)records, (unsigned)s_lb.frames, (unsigned)s_lb.max_batch, fps,
+             (long long)(s_lb.records ? s_lb.latency_sum_us / s_lb.records : 0), (long long)s_lb.latency_max_us);
+}
+
+// Shots posted before ESP-NOW is up are sent once it is, not failed
+static void test_link_up(void)
+{
+    reset_loopback();
+    for (uint32_t i = 0; i < 3; i++)
+        CHECK(post(i));
+    CHECK(!espnow_tx_service(pdMS_TO_TICKS(5)));
+    CHECK_EQ(s_lb.frames, 0);
+
+    espnow_tx_set_link_up();
+    CHECK(espnow_tx_service(0));
+    CHECK_EQ(s_lb.records, 3);
+    CHECK_EQ(s_lb.frames, 1);
+    CHECK(s_lb.in_order);
+}
+
+static void test_idle(void)
+{
+    // Let the link-up frame age out of the busy window first
+    vTaskDelay(pdMS_TO_TICKS(ESPNOW_TX_BUSY_GAP_US / 1000 + 20));
+    reset_loopback();
+    const int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        CHECK(post(i));
+        vTaskDelay(pdMS_TO_TICKS(ESPNOW_TX_BUSY_GAP_US / 1000 + 20));
+    }
+    wait_drained(10);
+    report("idle", 10, esp_timer_get_time() - start);
+    CHECK_EQ(s_lb.records, 10);
+    CHECK_EQ(s_lb.frames, 10);
+    CHECK(s_lb.in_order);
+    // Sent straight away: no coalescing hold while idle
+    CHECK(s_lb.latency_max_us < ESPNOW_TX_COALESCE_US / 2);
+}
+
+static void test_stream(void)
+{
+    reset_loopback();
+    const uint32_t n = 300;
+    const int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        CHECK(post(i));
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+    wait_drained(n);
+    report("stream", n, esp_timer_get_time() - start);
+    CHECK_EQ(s_lb.records, n);
+    CHECK(s_lb.in_order);
+    CHECK(s_lb.frames < n / 2);
+    CHECK(s_lb.max_batch > 1 && s_lb.max_batch <= ESPNOW_TX_MAX_BATCH);
+    // Held at most one coalescing window plus scheduling slack
+    CHECK(s_lb.latency_max_us < ESPNOW_TX_COALESCE_US + 10000);
+}
+
+static void test_overflow(void)
+{
+    reset_loopback();
+    espnow_tx_stats_t before, after;
+    espnow_tx_get_stats(&before);
+    const uint32_t n = 4 * ESPNOW_TX_RING_DEPTH;
+    uint32_t accepted = 0;
+    vTaskSuspendAll();
+    for (uint32_t i = 0; i < n; i++)
+        accepted += post(accepted) ? 1 : 0;
+    xTaskResumeAll();
+    wait_drained(accepted);
+    espnow_tx_get_stats(&after);
+    CHECK_EQ(s_lb.records, accepted);
+    CHECK_EQ(accepted + (after.overflows - before.overflows), n);
+    CHECK(s_lb.in_order);
+}
+
+static void run(void)
+{
+    CHECK(espnow_tx_init());
+    espnow_tx_set_transport(loopback, &s_lb);
+    test_link_up();
+
+    xTaskCreate(tx_task, "espnow_tx", 4096, NULL, 6, NULL);
+    test_idle();
+    test_stream();
+    test_overflow();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_espnow_tx", run);
+}
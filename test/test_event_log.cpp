@@ -0,0 +1,250 @@
+// event_log: the MPSC ring keeps per-producer order, loses nothing it did not
+// count as dropped, and the shot path's logging and arming allocate nothing.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include "event_log.h"
+#include "fake_game_state.h"
+#include "game_snapshot.h"
+#include "laser_tx.h"
+#include "shot_cache.h"
+#include "test_util.h"
+
+#define RING_SIZE 64 // EVLOG_RING_SIZE
+#define PRODUCERS 3
+#define PER_PRODUCER 20000
+
+// Allocation hook: operator new is replaced here, malloc and friends are
+// wrapped at link time (see test/CMakeLists.txt)
+static std::atomic<bool> s_counting{false};
+static std::atomic<uint32_t> s_allocs{0};
+
+static void count_alloc(void)
+{
+    if (s_counting.load(std::memory_order_relaxed))
+        s_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C"
+{
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t n, size_t size);
+    void* __real_realloc(void* p, size_t size);
+
+    void* __wrap_malloc(size_t size)
+    {
+        count_alloc();
+        return __real_malloc(size);
+    }
+    void* __wrap_calloc(size_t n, size_t size)
+    {
+        count_alloc();
+        return __real_calloc(n, size);
+    }
+    void* __wrap_realloc(void* p, size_t size)
+    {
+        count_alloc();
+        return __real_realloc(p, size);
+    }
+}
+
+void* operator new(size_t size)
+{
+    count_alloc();
+    void* p = __real_malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+static void drain(void)
+{
+    evlog_record_t rec;
+    while (evlog_pop(&rec))
+    {
+    }
+}
+
+static void test_fill_and_order(void)
+{
+    drain();
+    const uint32_t dropped = evlog_dropped();
+
+    for (uint32_t i = 0; i < RING_SIZE; i++)
+        CHECK(evlog_push(EVLOG_TAG_SHOT, EVLOG_LEVEL_INFO, EVLOG_SHOT_FIRED, 0xA5000000u | i, i));
+    CHECK(!evlog_push(EVLOG_TAG_SHOT, EVLOG_LEVEL_INFO, EVLOG_SHOT_FIRED, 0, 0));
+    CHECK_EQ(evlog_dropped(), dropped + 1);
+
+    evlog_record_t rec;
+    for (uint32_t i = 0; i < RING_SIZE; i++)
+    {
+        CHECK(evlog_pop(&rec));
+        CHECK_EQ(rec.tag, EVLOG_TAG_SHOT);
+        CHECK_EQ(rec.level, EVLOG_LEVEL_INFO);
+        CHECK_EQ(rec.code, EVLOG_SHOT_FIRED);
+        CHECK_EQ(rec.a, 0xA5000000u | i);
+        CHECK_EQ(rec.b, i);
+    }
+    CHECK(!evlog_pop(&rec));
+
+    // Many laps, so the sequence numbers wrap through every lap base
+    for (uint32_t i = 0; i < RING_SIZE * 100; i++)
+    {
+        CHECK(evlog_push(EVLOG_TAG_WS, EVLOG_LEVEL_WARN, 7, i, ~i));
+        if (i % 3 == 2)
+        {
+            for (uint32_t k = i - 2; k <= i; k++)
+            {
+                CHECK(evlog_pop(&rec));
+                CHECK_EQ(rec.a, k);
+                CHECK_EQ(rec.b, ~k);
+            }
+        }
+    }
+    drain();
+}
+
+static std::atomic<uint32_t> s_pushed[PRODUCERS];
+static std::atomic<int> s_running{0};
+
+static void producer(void* arg)
+{
+    const uint32_t id = (uint32_t)(uintptr_t)arg;
+    uint32_t ok = 0;
+    for (uint32_t i = 0; i < PER_PRODUCER; i++)
+    {
+        // A full ring counts a drop; give the consumer a turn then
+        if (evlog_push(EVLOG_TAG_SHOT, EVLOG_LEVEL_INFO, (uint16_t)id, id, i))
+            ok++;
+        else
+            taskYIELD();
+    }
+    s_pushed[id].store(ok);
+    s_running.fetch_sub(1);
+    vTaskDelete(NULL);
+}
+
+static void test_mpsc(void)
+{
+    drain();
+    const uint32_t dropped = evlog_dropped();
+    int64_t last[PRODUCERS];
+    uint32_t popped[PRODUCERS] = {};
+    for (int i = 0; i < PRODUCERS; i++)
+        last[i] = -1;
+
+    s_running.store(PRODUCERS);
+    for (uintptr_t i = 0; i < PRODUCERS; i++)
+        xTaskCreate(producer, "prod", 4096, (void*)i, 5, NULL);
+
+    const TickType_t start = xTaskGetTickCount();
+    evlog_record_t rec;
+    bool ordered = true;
+    bool well_formed = true;
+    for (;;)
+    {
+        const bool done = s_running.load() == 0;
+        bool any = false;
+        while (evlog_pop(&rec))
+        {
+            any = true;
+            if (rec.a >= PRODUCERS || rec.code != rec.a)
+            {
+                well_formed = false;
+                continue;
+            }
+            // A producer's records come out in its push order, gaps are drops
+            if ((int64_t)rec.b <= last[rec.a])
+                ordered = false;
+            last[rec.a] = rec.b;
+            popped[rec.a]++;
+        }
+        if (done && !any)
+            break;
+        if (!any)
+            taskYIELD();
+    }
+    const uint32_t ms = pdTICKS_TO_MS(xTaskGetTickCount() - start);
+
+    CHECK(well_formed);
+    CHECK(ordered);
+    uint32_t total = 0;
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        CHECK_EQ(popped[i], s_pushed[i].load());
+        total += popped[i];
+    }
+    CHECK_EQ(total + (evlog_dropped() - dropped), (uint32_t)(PRODUCERS * PER_PRODUCER));
+    CHECK(total > 0);
+    test_log("mpsc: %u pushed, %u delivered, %u dropped in %u ms\n", (unsigned)(PRODUCERS * PER_PRODUCER),
+             (unsigned)total, (unsigned)(evlog_dropped() - dropped), (unsigned)ms);
+}
+
+// What control_task does per shot around the log: arm, copy the template,
+// read the snapshot, log; plus laser_task's frame copy
+static void shot_path(int64_t t_us)
+{
+    const armed_shot_t* armed = shot_cache_arm();
+    PlayerMessage msg = armed->shot;
+    msg.timestamp_ms = (uint32_t)(t_us / 1000);
+    game_snapshot_t snap;
+    game_snapshot_read(&snap);
+    EVLOG(EVLOG_TAG_SHOT, EVLOG_LEVEL_INFO, EVLOG_SHOT_FIRED, armed->laser_word, snap.state.shots_fired);
+    EVLOG(EVLOG_TAG_SHOT, EVLOG_LEVEL_WARN, EVLOG_SHOT_ESPNOW_FAILED, armed->laser_word, msg.timestamp_ms);
+    laser_frame_t frame;
+    CHECK(shot_cache_copy_frame(armed->laser_word, &frame));
+}
+
+static void test_no_allocation(void)
+{
+    fake_game_state_reset();
+    CHECK(laser_tx_init(0, 10000, 100000));
+    game_snapshot_publish();
+    shot_path(0); // first arm builds the cache
+    drain();
+
+    // The hook sees allocations at all
+    s_counting.store(true);
+    int* probe = new int(1);
+    s_counting.store(false);
+    CHECK_EQ(s_allocs.load(), 1);
+    delete probe;
+    s_allocs.store(0);
+
+    s_counting.store(true);
+    for (int i = 0; i < 1000; i++)
+    {
+        shot_path(i * 1000LL);
+        // Full ring: the drop path must not allocate either
+        if (i % 200 == 199)
+            drain();
+    }
+    s_counting.store(false);
+    CHECK_EQ(s_allocs.load(), 0);
+    drain();
+}
+
+static void run(void)
+{
+    test_fill_and_order();
+    test_mpsc();
+    test_no_allocation();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_event_log", run);
+}
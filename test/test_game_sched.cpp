@@ -0,0 +1,190 @@
+// game_sched respawn timing against the fake game_state: completion must be
+// seen within 1 ms of the configured duration with one timer firing (at the
+// median; the host's own scheduling adds the odd late wakeup), a
+// game_state running a little late must be caught by the backoff, and every
+// respawn must notify its subscribers exactly once per event. A watch armed
+// well after the death still completes at the death time plus the duration.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include "config.h"
+#include "fake_game_state.h"
+#include "game_sched.h"
+#include "game_snapshot.h"
+#include "sim.h"
+#include "test_util.h"
+
+#define RESPAWNS 15
+#define TOLERANCE_US 1000
+// Host scheduler noise on a loaded machine, far below the old 1 s tick
+#define HOST_JITTER_US 50000
+#define LATE_US 5000
+// A respawn noticed halfway through, as game_task's 1 s tick could on the
+// device's 5 s respawn
+#define NOTICE_LATE_MS (GAME_RESPAWN_MS / 2)
+
+static uint32_t s_started;
+static uint32_t s_done;
+static int64_t s_done_at_us;
+
+static void on_event(game_evt_t evt, void* ctx)
+{
+    (void)ctx;
+    if (evt == GAME_EVT_RESPAWN_STARTED)
+        s_started++;
+    else if (evt == GAME_EVT_RESPAWN_DONE)
+    {
+        s_done++;
+        s_done_at_us = esp_timer_get_time();
+    }
+}
+
+// Services events like game_task until the respawn is reported done
+static bool wait_done(uint32_t timeout_ms)
+{
+    const TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+    while (s_done == 0 && xTaskGetTickCount() < until)
+        game_sched_service(pdMS_TO_TICKS(10));
+    return s_done != 0;
+}
+
+// game_state begins a respawn that it ends late_us after the configured time;
+// returns when it began
+static int64_t begin_respawn(int64_t late_us)
+{
+    s_started = 0;
+    s_done = 0;
+    g_fake_game.respawn_checks = 0;
+    g_fake_game.respawning = true;
+    const int64_t start_us = esp_timer_get_time();
+    g_fake_game.respawn_until_us = start_us + (int64_t)GAME_RESPAWN_MS * 1000 + late_us;
+    game_snapshot_publish();
+    return start_us;
+}
+
+static void drain(uint32_t ms)
+{
+    const TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+    while (xTaskGetTickCount() < until)
+        game_sched_service(pdMS_TO_TICKS(10));
+}
+
+static int cmp_i64(const void* a, const void* b)
+{
+    const int64_t x = *(const int64_t*)a;
+    const int64_t y = *(const int64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_on_time(void)
+{
+    int64_t late_us[RESPAWNS];
+    for (int i = 0; i < RESPAWNS; i++)
+    {
+        const int64_t start_us = begin_respawn(0);
+        CHECK(wait_done(GAME_RESPAWN_MS * 2));
+
+        // Never before the configured time, by the timer callback's clock or
+        // where subscribers see it
+        CHECK(game_sched_last_respawn_us() >= (uint32_t)GAME_RESPAWN_MS * 1000);
+        late_us[i] = s_done_at_us - start_us - GAME_RESPAWN_MS * 1000;
+        CHECK(late_us[i] >= 0);
+        CHECK(late_us[i] <= HOST_JITTER_US);
+
+        // One check at the deadline, no polling before it
+        CHECK_EQ(g_fake_game.respawn_checks, 1);
+
+        game_snapshot_t snap;
+        game_snapshot_read(&snap);
+        CHECK(!snap.respawning);
+
+        // Publishing again must not restart anything
+        game_snapshot_publish();
+        drain(20);
+        CHECK_EQ(s_started, 1);
+        CHECK_EQ(s_done, 1);
+    }
+    qsort(late_us, RESPAWNS, sizeof(late_us[0]), cmp_i64);
+    CHECK(late_us[RESPAWNS / 2] <= TOLERANCE_US);
+    test_log("on time: %lld us median, %lld us worst after the configured %d ms\n",
+             (long long)late_us[RESPAWNS / 2], (long long)late_us[RESPAWNS - 1], GAME_RESPAWN_MS);
+}
+
+static void test_late_game_state(void)
+{
+    const int64_t start_us = begin_respawn(LATE_US);
+    // Seen respawning, then not before the deadline
+    CHECK(wait_done(GAME_RESPAWN_MS * 2));
+    const int64_t late_by = s_done_at_us - start_us - GAME_RESPAWN_MS * 1000;
+    CHECK(late_by >= LATE_US);
+    // Backoff 1, 2, 4 ms passes 5 ms at 7 ms
+    CHECK(late_by <= 2 * LATE_US + HOST_JITTER_US);
+    CHECK(g_fake_game.respawn_checks <= 5);
+    drain(20);
+    CHECK_EQ(s_started, 1);
+    CHECK_EQ(s_done, 1);
+    test_log("late game_state: done %lld us after the deadline with %u checks\n", (long long)late_by,
+             (unsigned)g_fake_game.respawn_checks);
+}
+
+static void test_repeated_watch(void)
+{
+    begin_respawn(0);
+    // Every caller may ask; only one watch runs
+    game_sched_respawn_watch(esp_timer_get_time());
+    game_sched_respawn_watch(esp_timer_get_time());
+    game_snapshot_publish();
+    CHECK(wait_done(GAME_RESPAWN_MS * 2));
+    drain(20);
+    CHECK_EQ(s_started, 1);
+    CHECK_EQ(s_done, 1);
+    CHECK_EQ(g_fake_game.respawn_checks, 1);
+}
+
+// The death is stamped where the hit lands; the watch is armed later, the way
+// a respawn game_state starts on its own is only seen on a later publish
+static void test_armed_late(void)
+{
+    s_started = 0;
+    s_done = 0;
+    g_fake_game.respawn_checks = 0;
+    const int64_t death_us = esp_timer_get_time();
+    g_fake_game.respawning = true;
+    g_fake_game.respawn_until_us = death_us + (int64_t)GAME_RESPAWN_MS * 1000;
+    vTaskDelay(pdMS_TO_TICKS(NOTICE_LATE_MS));
+
+    game_sched_respawn_watch(death_us);
+    game_snapshot_publish();
+    CHECK(wait_done(GAME_RESPAWN_MS * 2));
+    const int64_t late_us = s_done_at_us - death_us - GAME_RESPAWN_MS * 1000;
+    CHECK(late_us >= 0);
+    CHECK(late_us <= HOST_JITTER_US);
+    CHECK(game_sched_last_respawn_us() >= (uint32_t)GAME_RESPAWN_MS * 1000);
+    CHECK(game_sched_last_respawn_us() <= (uint32_t)GAME_RESPAWN_MS * 1000 + HOST_JITTER_US);
+    CHECK_EQ(g_fake_game.respawn_checks, 1);
+    drain(20);
+    CHECK_EQ(s_started, 1);
+    CHECK_EQ(s_done, 1);
+    test_log("armed %d ms late: done %lld us after death + %d ms\n", NOTICE_LATE_MS, (long long)late_us,
+             GAME_RESPAWN_MS);
+}
+
+static void body(void)
+{
+    fake_game_state_reset();
+    sim_timer_start();
+    CHECK(game_sched_init());
+    game_sched_bind();
+    CHECK(game_sched_subscribe(on_event, NULL));
+
+    test_on_time();
+    test_late_game_state();
+    test_repeated_watch();
+    test_armed_late();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_game_sched", body);
+}
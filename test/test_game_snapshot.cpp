@@ -0,0 +1,165 @@
+// game_snapshot seqlock under load: writer tasks publish states whose fields
+// all encode the same counter while reader tasks check that every copy they
+// get is whole (fields agree, generation matches the counter) and never goes
+// backwards. Prints read and publish throughput and the retries. Readers
+// only overlap a publish on a multi-core host; on one core, as on the C3
+// where publish runs in a critical section, retries stay at zero.
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "fake_game_state.h"
+#include "game_snapshot.h"
+#include "test_util.h"
+
+#define WRITERS 2
+#define READERS 3
+#define STRESS_MS 1500
+#define WORKER_PRIO 4
+
+static SemaphoreHandle_t s_state_mutex;
+static std::atomic<bool> s_stop{false};
+static std::atomic<int> s_running{0};
+static uint32_t s_counter;
+static uint32_t s_gen_offset;
+
+static std::atomic<uint32_t> s_torn{0};
+static std::atomic<uint32_t> s_backwards{0};
+static std::atomic<uint32_t> s_reads{0};
+
+// Every field the snapshot copies follows one counter, so a copy mixing two
+// publishes shows up as fields that disagree
+static void write_state(uint32_t k)
+{
+    g_fake_game.state.kills = k;
+    g_fake_game.state.deaths = k;
+    g_fake_game.state.shots_fired = k;
+    g_fake_game.state.hits_landed = k;
+    g_fake_game.state.hearts_remaining = (uint8_t)k;
+    g_fake_game.config.color_rgb = k;
+    g_fake_game.game.max_ammo = (uint16_t)k;
+}
+
+static bool whole(const game_snapshot_t* s)
+{
+    const uint32_t k = s->state.kills;
+    return s->state.deaths == k && s->state.shots_fired == k && s->state.hits_landed == k &&
+           s->state.hearts_remaining == (uint8_t)k && s->config.color_rgb == k &&
+           s->game.max_ammo == (uint16_t)k && s->generation == k + s_gen_offset &&
+           s->config_generation <= s->generation;
+}
+
+static void writer_task(void* arg)
+{
+    (void)arg;
+    uint32_t n = 0;
+    while (!s_stop.load(std::memory_order_relaxed))
+    {
+        // Mutate and publish as one step, as game_state's owners do
+        xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+        write_state(++s_counter);
+        game_snapshot_publish();
+        xSemaphoreGive(s_state_mutex);
+        if ((++n & 63) == 0)
+            taskYIELD();
+    }
+    s_running.fetch_sub(1);
+    vTaskDelete(NULL);
+}
+
+static void reader_task(void* arg)
+{
+    (void)arg;
+    uint32_t last_gen = 0;
+    uint32_t reads = 0;
+    while (!s_stop.load(std::memory_order_relaxed))
+    {
+        game_snapshot_t s;
+        game_snapshot_read(&s);
+        reads++;
+        if (!whole(&s))
+            s_torn.fetch_add(1);
+        if (s.generation < last_gen)
+            s_backwards.fetch_add(1);
+        last_gen = s.generation;
+        if ((reads & 255) == 0)
+            taskYIELD();
+    }
+    s_reads.fetch_add(reads);
+    s_running.fetch_sub(1);
+    vTaskDelete(NULL);
+}
+
+static void test_uncontended(void)
+{
+    const int n = 200000;
+    game_snapshot_t s;
+    const int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < n; i++)
+        game_snapshot_read(&s);
+    const int64_t t1 = esp_timer_get_time();
+    CHECK(whole(&s));
+    test_log("uncontended read: %lld ns\n", (long long)((t1 - t0) * 1000 / n));
+}
+
+static void test_stress(void)
+{
+    game_snapshot_stats_t before;
+    game_snapshot_get_stats(&before);
+
+    s_running = WRITERS + READERS;
+    for (int i = 0; i < WRITERS; i++)
+        xTaskCreate(writer_task, "snap_wr", 4096, NULL, WORKER_PRIO, NULL);
+    for (int i = 0; i < READERS; i++)
+        xTaskCreate(reader_task, "snap_rd", 4096, NULL, WORKER_PRIO, NULL);
+
+    const int64_t t0 = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(STRESS_MS));
+    s_stop = true;
+    while (s_running.load() > 0)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    const int64_t elapsed_us = esp_timer_get_time() - t0;
+
+    game_snapshot_stats_t after;
+    game_snapshot_get_stats(&after);
+    const uint32_t publishes = after.publishes - before.publishes;
+    const uint32_t reads = after.reads - before.reads;
+    const uint32_t retries = after.read_retries - before.read_retries;
+
+    CHECK_EQ(s_torn.load(), 0);
+    CHECK_EQ(s_backwards.load(), 0);
+    CHECK_EQ(reads, s_reads.load());
+    CHECK(publishes > 0);
+    CHECK(reads > 0);
+
+    game_snapshot_t last;
+    game_snapshot_read(&last);
+    CHECK(whole(&last));
+    CHECK_EQ(last.state.kills, s_counter);
+
+    test_log("stress: %u reads/s, %u publishes/s, %u retries in %u reads\n",
+             (unsigned)((uint64_t)reads * 1000000 / elapsed_us),
+             (unsigned)((uint64_t)publishes * 1000000 / elapsed_us), (unsigned)retries, (unsigned)reads);
+}
+
+static void body(void)
+{
+    fake_game_state_reset();
+    s_state_mutex = xSemaphoreCreateMutex();
+
+    // Generation and counter move together from here on
+    write_state(0);
+    game_snapshot_publish();
+    game_snapshot_t s;
+    game_snapshot_read(&s);
+    s_gen_offset = s.generation;
+
+    test_uncontended();
+    test_stress();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_game_snapshot", body);
+}
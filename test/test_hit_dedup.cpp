@@ -0,0 +1,177 @@
+// hit_dedup against a linear-scan model of the same window: a high-rate hit
+// stream with injected retransmissions (inside the window, after eviction,
+// after the TTL) must get the same verdict for every event. Prints the
+// per-lookup cost of both.
+#include <string.h>
+#include <chrono>
+#include "hit_dedup.h"
+#include "test_util.h"
+
+#define STREAM_LEN 200000
+
+typedef struct
+{
+    hit_key_t keys[HIT_DEDUP_WINDOW];
+    uint32_t seen_ms[HIT_DEDUP_WINDOW];
+    unsigned next;
+    unsigned used;
+} model_t;
+
+// Same rules as hit_dedup_check(), by brute force
+static bool model_check(model_t* m, const uint8_t mac[6], uint32_t ts, uint32_t data, uint32_t now_ms)
+{
+    for (unsigned i = 0; i < m->used; i++)
+    {
+        const hit_key_t* k = &m->keys[i];
+        if (k->timestamp_ms == ts && k->data == data && memcmp(k->mac, mac, 6) == 0)
+        {
+            if (now_ms - m->seen_ms[i] <= HIT_DEDUP_TTL_MS)
+                return false;
+            m->seen_ms[i] = now_ms;
+            return true;
+        }
+    }
+    hit_key_t* k = &m->keys[m->next];
+    memcpy(k->mac, mac, 6);
+    k->timestamp_ms = ts;
+    k->data = data;
+    m->seen_ms[m->next] = now_ms;
+    m->next = (m->next + 1) % HIT_DEDUP_WINDOW;
+    if (m->used < HIT_DEDUP_WINDOW)
+        m->used++;
+    return true;
+}
+
+typedef struct
+{
+    uint8_t mac[6];
+    uint32_t ts;
+    uint32_t data;
+    uint32_t now_ms;
+} event_t;
+
+static event_t s_stream[STREAM_LEN];
+
+// Hits every 2 ms from 16 vests; about a quarter are repeats of an earlier
+// event, picked from just now, from beyond the window, or from long ago
+static void make_stream(void)
+{
+    uint32_t rng = 42;
+    uint32_t now = 1000;
+    for (int i = 0; i < STREAM_LEN; i++)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        const uint32_t r = rng >> 8;
+        event_t* e = &s_stream[i];
+        now += 1 + r % 3;
+        const uint32_t kind = r % 100;
+        if (i > 0 && kind < 25)
+        {
+            uint32_t back;
+            if (kind < 15)
+                back = 1 + (r >> 8) % 16; // retransmission burst
+            else if (kind < 22)
+                back = HIT_DEDUP_WINDOW + (r >> 8) % 64; // already evicted
+            else
+                back = 1500 + (r >> 8) % 1000; // past the TTL
+            *e = s_stream[(uint32_t)i > back ? i - back : 0];
+        }
+        else
+        {
+            memset(e->mac, 0, 6);
+            e->mac[0] = 0x24;
+            e->mac[5] = (uint8_t)(r % 16);
+            e->ts = now - r % 50;
+            e->data = 0xA5000000u | (r & 0xFFFF);
+        }
+        e->now_ms = now;
+    }
+}
+
+static void test_matches_model(void)
+{
+    static hit_dedup_t d;
+    static model_t m;
+    hit_dedup_init(&d);
+    memset(&m, 0, sizeof(m));
+
+    int mismatches = 0;
+    uint32_t dups = 0;
+    for (int i = 0; i < STREAM_LEN; i++)
+    {
+        const event_t* e = &s_stream[i];
+        const bool want = model_check(&m, e->mac, e->ts, e->data, e->now_ms);
+        const bool got = hit_dedup_check(&d, e->mac, e->ts, e->data, e->now_ms);
+        if (want != got && mismatches++ < 5)
+            test_log("event %d: model %d, hit_dedup %d\n", i, want, got);
+        dups += want ? 0 : 1;
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(d.duplicates, dups);
+    CHECK_EQ(d.accepted + d.duplicates, STREAM_LEN);
+    CHECK(dups > STREAM_LEN / 10);
+    test_log("stream: %d events, %u duplicates dropped\n", STREAM_LEN, (unsigned)dups);
+}
+
+static void test_edges(void)
+{
+    hit_dedup_t d;
+    hit_dedup_init(&d);
+    const uint8_t a[6] = {1, 2, 3, 4, 5, 6};
+    const uint8_t b[6] = {1, 2, 3, 4, 5, 7};
+
+    CHECK(hit_dedup_check(&d, a, 100, 7, 0));
+    CHECK(!hit_dedup_check(&d, a, 100, 7, HIT_DEDUP_TTL_MS));
+    // Any field differing makes a new event
+    CHECK(hit_dedup_check(&d, b, 100, 7, 10));
+    CHECK(hit_dedup_check(&d, a, 101, 7, 10));
+    CHECK(hit_dedup_check(&d, a, 100, 8, 10));
+    // Older than the TTL counts again
+    CHECK(hit_dedup_check(&d, a, 100, 7, HIT_DEDUP_TTL_MS + 1));
+
+    // The oldest key leaves the window after HIT_DEDUP_WINDOW newer ones
+    hit_dedup_init(&d);
+    CHECK(hit_dedup_check(&d, a, 1, 1, 0));
+    for (uint32_t i = 0; i < HIT_DEDUP_WINDOW - 1; i++)
+        CHECK(hit_dedup_check(&d, b, 1000 + i, 1, 0));
+    CHECK(!hit_dedup_check(&d, a, 1, 1, 0));
+    CHECK(hit_dedup_check(&d, b, 5000, 1, 0));
+    CHECK(hit_dedup_check(&d, a, 1, 1, 0));
+}
+
+template <typename F>
+static double ns_per_lookup(F check)
+{
+    const auto start = std::chrono::steady_clock::now();
+    uint32_t kept = 0;
+    for (int i = 0; i < STREAM_LEN; i++)
+    {
+        const event_t* e = &s_stream[i];
+        kept += check(e) ? 1 : 0;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    CHECK(kept > 0);
+    return (double)ns.count() / STREAM_LEN;
+}
+
+static void bench(void)
+{
+    static hit_dedup_t d;
+    static model_t m;
+    hit_dedup_init(&d);
+    memset(&m, 0, sizeof(m));
+    const double hashed =
+        ns_per_lookup([](const event_t* e) { return hit_dedup_check(&d, e->mac, e->ts, e->data, e->now_ms); });
+    const double linear =
+        ns_per_lookup([](const event_t* e) { return model_check(&m, e->mac, e->ts, e->data, e->now_ms); });
+    test_log("per lookup: hit_dedup %.1f ns, linear scan of %d keys %.1f ns\n", hashed, HIT_DEDUP_WINDOW, linear);
+}
+
+int main(void)
+{
+    make_stream();
+    test_edges();
+    test_matches_model();
+    bench();
+    return test_report("test_hit_dedup");
+}
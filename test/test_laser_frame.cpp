@@ -0,0 +1,133 @@
+// laser_frame: run-length encoding of a laser word and the split into pieces
+// short enough for the RMT duration field.
+#include <string.h>
+#include "laser_frame.h"
+#include "test_util.h"
+
+#define RMT_MAX_HALF 32767
+
+static uint64_t sum_us(const laser_symbol_t* s, size_t n)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += s[i].duration_us;
+    return total;
+}
+
+// Expand the runs back into bits and compare them with the word
+static void check_bits(const laser_frame_t* f, uint32_t message, uint32_t bit_us)
+{
+    int bit = MESSAGE_TOTAL_BITS - 1;
+    for (uint8_t i = 0; i < f->count && bit >= 0; i++)
+    {
+        CHECK_EQ(f->symbols[i].duration_us % bit_us, 0);
+        for (uint32_t k = 0; k < f->symbols[i].duration_us / bit_us && bit >= 0; k++, bit--)
+            CHECK_EQ(f->symbols[i].level, (message >> bit) & 1);
+    }
+    CHECK_EQ(bit, -1);
+}
+
+static void test_encode(void)
+{
+    const uint32_t words[] = {0x00000000u, 0xFFFFFFFFu, 0xAAAAAAAAu, 0xA5000101u, 0x80000001u};
+    for (uint32_t w : words)
+    {
+        w &= (uint32_t)((1ull << MESSAGE_TOTAL_BITS) - 1);
+        laser_frame_t f;
+        laser_frame_encode(&f, w, 250, 3000);
+        CHECK_EQ(f.message, w);
+        CHECK_EQ(f.total_us, MESSAGE_TOTAL_BITS * 250 + 3000);
+        CHECK_EQ(sum_us(f.symbols, f.count), f.total_us);
+        CHECK(f.count <= LASER_FRAME_MAX_SYMBOLS);
+        CHECK_EQ(f.symbols[f.count - 1].level, 0);
+        for (uint8_t i = 1; i < f.count; i++)
+            CHECK(f.symbols[i].level != f.symbols[i - 1].level);
+
+        // The gap is a run of its own only after a trailing 1
+        laser_frame_t bare;
+        laser_frame_encode(&bare, w, 250, 0);
+        CHECK_EQ(bare.total_us, MESSAGE_TOTAL_BITS * 250);
+        check_bits(&bare, w, 250);
+        CHECK_EQ(f.count, bare.count + ((w & 1) ? 1 : 0));
+    }
+
+    laser_frame_t f;
+    laser_frame_encode(&f, 0, 100, 500);
+    CHECK_EQ(f.count, 1);
+    CHECK_EQ(f.symbols[0].duration_us, MESSAGE_TOTAL_BITS * 100 + 500);
+}
+
+static void check_split(const laser_frame_t* f, const laser_symbol_t* p, size_t n, uint32_t max_us)
+{
+    CHECK(n > 0);
+    CHECK_EQ(n % 2, 0);
+    CHECK_EQ(sum_us(p, n), f->total_us);
+    for (size_t i = 0; i < n; i++)
+    {
+        CHECK(p[i].duration_us > 0);
+        CHECK(p[i].duration_us <= max_us);
+    }
+
+    // Merging equal neighbours gives the frame back
+    size_t run = 0;
+    uint32_t acc = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        acc += p[i].duration_us;
+        if (i + 1 < n && p[i + 1].level == p[i].level)
+            continue;
+        CHECK(run < f->count);
+        if (run >= f->count)
+            return;
+        CHECK_EQ(p[i].level, f->symbols[run].level);
+        CHECK_EQ(acc, f->symbols[run].duration_us);
+        run++;
+        acc = 0;
+    }
+    CHECK_EQ(run, f->count);
+}
+
+static void test_split(void)
+{
+    laser_symbol_t pieces[256];
+    laser_frame_t f;
+
+    // Short bits: nothing to cut, an odd run count gets its last run halved
+    laser_frame_encode(&f, 0xA5000101u, 250, 3000);
+    size_t n = laser_frame_split(&f, RMT_MAX_HALF, pieces, 256);
+    check_split(&f, pieces, n, RMT_MAX_HALF);
+    CHECK_EQ(n, f.count + (f.count & 1));
+
+    // The protocol's 10 ms bits and 100 ms gap need cutting
+    laser_frame_encode(&f, 0xF000000Fu, 10000, 100000);
+    n = laser_frame_split(&f, RMT_MAX_HALF, pieces, 256);
+    check_split(&f, pieces, n, RMT_MAX_HALF);
+    CHECK(n > f.count);
+
+    // Every cut lands on the limit except the remainder
+    laser_frame_encode(&f, 0, 1000, 0);
+    n = laser_frame_split(&f, 7000, pieces, 256);
+    check_split(&f, pieces, n, 7000);
+    CHECK_EQ(pieces[0].duration_us, 7000);
+
+    // Too small a buffer is refused rather than truncated
+    laser_frame_encode(&f, 0xAAAAAAAAu, 100, 1000);
+    CHECK_EQ(laser_frame_split(&f, RMT_MAX_HALF, pieces, f.count - 1), 0);
+    n = laser_frame_split(&f, RMT_MAX_HALF, pieces, f.count + 1);
+    check_split(&f, pieces, n, RMT_MAX_HALF);
+
+    // A 1 us last piece cannot be halved without a zero duration
+    memset(&f, 0, sizeof(f));
+    f.count = 1;
+    f.symbols[0].level = 1;
+    f.symbols[0].duration_us = 1;
+    f.total_us = 1;
+    CHECK_EQ(laser_frame_split(&f, RMT_MAX_HALF, pieces, 4), 0);
+}
+
+int main(void)
+{
+    test_encode();
+    test_split();
+    return test_report("test_laser_frame");
+}
@@ -0,0 +1,113 @@
+// The host laser backend against the RMT channel it stands in for: at most
+// LASER_TX_QUEUE_DEPTH unfinished frames, sends beyond that wait up to their
+// timeout, and queued frames play back to back.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "laser_frame.h"
+#include "laser_tx.h"
+#include "test_util.h"
+
+#define BIT_US 100
+#define GAP_US 1000
+
+static int64_t s_fake_us;
+
+static int64_t fake_clock(void)
+{
+    return s_fake_us;
+}
+
+// MSB and LSB set: high for a bit, low, high for the last bit, then the gap
+static uint32_t test_word(void)
+{
+    return (1u << (MESSAGE_TOTAL_BITS - 1)) | 1u;
+}
+
+static void test_slots_and_spacing(void)
+{
+    laser_frame_t frame;
+    laser_frame_encode(&frame, test_word(), BIT_US, GAP_US);
+    const int64_t frame_us = frame.total_us;
+    CHECK_EQ(frame_us, (int64_t)MESSAGE_TOTAL_BITS * BIT_US + GAP_US);
+
+    laser_tx_host_set_clock(fake_clock);
+    CHECK(laser_tx_init(0, BIT_US, GAP_US));
+    laser_tx_host_clear();
+    s_fake_us = 0;
+
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+    {
+        CHECK(laser_tx_send(&frame, 0));
+        CHECK_EQ(laser_tx_last_start_us(), i * frame_us);
+    }
+    // Every slot holds a frame that has not finished
+    CHECK(!laser_tx_send(&frame, 0));
+    CHECK(!laser_tx_wait_idle(0));
+
+    s_fake_us = frame_us - 1;
+    CHECK(!laser_tx_send(&frame, 0));
+
+    // The first frame has left the pin; the new one queues behind the rest
+    s_fake_us = frame_us;
+    CHECK(laser_tx_send(&frame, 0));
+    CHECK_EQ(laser_tx_last_start_us(), LASER_TX_QUEUE_DEPTH * frame_us);
+    CHECK(!laser_tx_send(&frame, 0));
+
+    size_t count = 0;
+    const laser_edge_t* edges = laser_tx_host_edges(&count);
+    CHECK_EQ(count, 4 * (LASER_TX_QUEUE_DEPTH + 1));
+    for (size_t f = 0; f + 1 < count / 4; f++)
+    {
+        const laser_edge_t* e = &edges[4 * f];
+        const int64_t start = (int64_t)f * frame_us;
+        CHECK_EQ(e[0].t_us, start);
+        CHECK_EQ(e[0].level, 1);
+        CHECK_EQ(e[1].t_us, start + BIT_US);
+        CHECK_EQ(e[1].level, 0);
+        CHECK_EQ(e[2].t_us, start + (MESSAGE_TOTAL_BITS - 1) * BIT_US);
+        CHECK_EQ(e[3].t_us, start + MESSAGE_TOTAL_BITS * BIT_US);
+        CHECK_EQ(e[3].level, 0);
+    }
+
+    s_fake_us = (LASER_TX_QUEUE_DEPTH + 1) * frame_us;
+    CHECK(laser_tx_wait_idle(0));
+}
+
+static void test_timeout(void)
+{
+    laser_tx_host_set_clock(esp_timer_get_time);
+    laser_tx_host_clear();
+
+    // 5 ms frames: the fourth send has to wait for the first to finish
+    laser_frame_t frame;
+    laser_frame_encode(&frame, test_word(), 100, 5000 - MESSAGE_TOTAL_BITS * 100);
+    const int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+        CHECK(laser_tx_send(&frame, 0));
+    CHECK(laser_tx_send(&frame, pdMS_TO_TICKS(100)));
+    CHECK(esp_timer_get_time() - t0 >= frame.total_us);
+    CHECK(laser_tx_wait_idle(pdMS_TO_TICKS(100)));
+
+    // Frames much longer than the timeout: the send gives up
+    laser_frame_encode(&frame, test_word(), 100, 1000000);
+    for (int i = 0; i < LASER_TX_QUEUE_DEPTH; i++)
+        CHECK(laser_tx_send(&frame, 0));
+    const int64_t t1 = esp_timer_get_time();
+    CHECK(!laser_tx_send(&frame, pdMS_TO_TICKS(20)));
+    const int64_t waited = esp_timer_get_time() - t1;
+    CHECK(waited >= 19000);
+    CHECK(waited < 500000);
+    CHECK(!laser_tx_wait_idle(pdMS_TO_TICKS(5)));
+}
+
+static void run(void)
+{
+    test_slots_and_spacing();
+    test_timeout();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_laser_tx_host", run);
+}
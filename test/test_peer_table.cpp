@@ -0,0 +1,381 @@
+// peer_table against the sim's NVS: the legacy CSV is merged on every load
+// with unknown ids, a peer's own frame fills them in once, and the blob keeps
+// what was learned across a reload. Also covers the map's backward-shift
+// delete, the blob's version checks and the peer_add / peer_del commands,
+// and prints lookup and boot load times at 64 and PEER_TABLE_CAPACITY peers.
+#include <esp_timer.h>
+#include <stdio.h>
+#include <string.h>
+#include "espnow_comm.h"
+#include "peer_table.h"
+#include "test_util.h"
+#include "wifi_manager.h"
+#include "ws_commands.h"
+
+static const char* s_csv;
+static int s_csv_applied;
+
+bool wifi_manager_load_peer_list(char* buf, size_t len)
+{
+    if (!s_csv)
+        return false;
+    strncpy(buf, s_csv, len - 1);
+    return true;
+}
+
+void espnow_comm_load_peers_from_csv(const char* csv)
+{
+    (void)csv;
+    s_csv_applied++;
+}
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x02};
+static const uint8_t MAC_C[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x03};
+
+static void test_migrate_and_learn(void)
+{
+    s_csv = "24:6F:28:00:00:01, 24:6F:28:00:00:02,garbage";
+    peer_table_load();
+    CHECK_EQ(s_csv_applied, 1);
+    CHECK_EQ(peer_table_count(), 2);
+
+    peer_info_t peer;
+    CHECK(peer_table_find(MAC_A, &peer));
+    CHECK_EQ(peer.player_id, PEER_ID_UNKNOWN);
+    CHECK_EQ(peer.device_id, PEER_ID_UNKNOWN);
+
+    CHECK(peer_table_learn(MAC_A, 3, 7, 1));
+    CHECK(peer_table_find(MAC_A, &peer));
+    CHECK_EQ(peer.player_id, 3);
+    CHECK_EQ(peer.device_id, 7);
+    CHECK_EQ(peer.team_id, 1);
+    // Known ids stay; unknown MACs are not added
+    CHECK(!peer_table_learn(MAC_A, 4, 8, 2));
+    CHECK(peer_table_find(MAC_A, &peer));
+    CHECK_EQ(peer.player_id, 3);
+    CHECK(!peer_table_learn(MAC_C, 5, 9, 1));
+    CHECK(!peer_table_find(MAC_C, NULL));
+}
+
+static void test_csv_still_honored(void)
+{
+    // Next boot: the blob holds the learned ids, a MAC added to the CSV joins
+    s_csv = "24:6F:28:00:00:01,24:6F:28:00:00:02,24:6F:28:00:00:03";
+    peer_table_load();
+    CHECK_EQ(s_csv_applied, 2);
+    CHECK_EQ(peer_table_count(), 3);
+
+    peer_info_t peer;
+    CHECK(peer_table_find(MAC_A, &peer));
+    CHECK_EQ(peer.player_id, 3);
+    CHECK(peer_table_find(MAC_B, &peer));
+    CHECK_EQ(peer.player_id, PEER_ID_UNKNOWN);
+    CHECK(peer_table_find(MAC_C, &peer));
+    CHECK_EQ(peer.player_id, PEER_ID_UNKNOWN);
+
+    // Dropping a MAC from the CSV leaves the table as it is
+    s_csv = "24:6F:28:00:00:01";
+    peer_table_load();
+    CHECK_EQ(peer_table_count(), 3);
+}
+
+// A fleet shares the vendor prefix; the tails of boards bought together are
+// scattered, so spread the index over them (odd multiplier, no repeats)
+static void fleet_mac(uint32_t i, uint8_t mac[6])
+{
+    i = (i * 0x5BD1E9u) & 0xFFFFFF;
+    mac[0] = 0x24;
+    mac[1] = 0x6F;
+    mac[2] = 0x28;
+    mac[3] = (uint8_t)(i >> 16);
+    mac[4] = (uint8_t)(i >> 8);
+    mac[5] = (uint8_t)i;
+}
+
+static uint32_t slot_of(const peer_map_t* m, const uint8_t mac[6])
+{
+    return (uint32_t)(peer_map_find(m, mac) - m->entries);
+}
+
+// Every entry is reachable: no free slot between its home and where it sits
+static bool chains_intact(const peer_map_t* m, const uint32_t* home, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint8_t mac[6];
+        fleet_mac(0x1000 + i, mac);
+        const peer_info_t* p = peer_map_find(m, mac);
+        if (!p)
+            continue;
+        for (uint32_t s = home[i]; s != slot_of(m, mac); s = (s + 1) % PEER_TABLE_SLOTS)
+        {
+            if (!m->used[s])
+                return false;
+        }
+    }
+    return true;
+}
+
+static peer_map_t s_map;
+static uint32_t s_home[PEER_TABLE_CAPACITY];
+
+static void test_map_remove(void)
+{
+    const uint32_t n = PEER_TABLE_CAPACITY;
+    peer_info_t peer = {};
+    for (uint32_t i = 0; i < n; i++)
+    {
+        // Alone in the map a MAC sits in its home slot
+        fleet_mac(0x1000 + i, peer.mac);
+        peer_map_clear(&s_map);
+        CHECK(peer_map_put(&s_map, &peer));
+        s_home[i] = slot_of(&s_map, peer.mac);
+    }
+
+    peer_map_clear(&s_map);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        fleet_mac(0x1000 + i, peer.mac);
+        peer.player_id = (uint8_t)i;
+        CHECK(peer_map_put(&s_map, &peer));
+    }
+    CHECK_EQ(s_map.count, n);
+    fleet_mac(0x1000 + n, peer.mac);
+    CHECK(!peer_map_put(&s_map, &peer));
+
+    // Half full, so some probe chains are long enough for removals to shift
+    uint32_t displaced = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        fleet_mac(0x1000 + i, peer.mac);
+        displaced += slot_of(&s_map, peer.mac) != s_home[i] ? 1 : 0;
+    }
+    CHECK(displaced > 0);
+    CHECK(chains_intact(&s_map, s_home, n));
+
+    // Remove every other peer in a scattered order, checking the rest each time
+    uint32_t left = n;
+    for (uint32_t k = 0; k < n / 2; k++)
+    {
+        const uint32_t i = (k * 37) % (n / 2) * 2;
+        uint8_t mac[6];
+        fleet_mac(0x1000 + i, mac);
+        CHECK(peer_map_remove(&s_map, mac));
+        CHECK(!peer_map_remove(&s_map, mac));
+        CHECK(peer_map_find(&s_map, mac) == NULL);
+        CHECK_EQ(s_map.count, --left);
+    }
+    CHECK(chains_intact(&s_map, s_home, n));
+    uint32_t used = 0;
+    for (uint32_t s = 0; s < PEER_TABLE_SLOTS; s++)
+        used += s_map.used[s];
+    CHECK_EQ(used, left);
+    for (uint32_t i = 1; i < n; i += 2)
+    {
+        fleet_mac(0x1000 + i, peer.mac);
+        const peer_info_t* p = peer_map_find(&s_map, peer.mac);
+        CHECK(p != NULL);
+        if (p)
+            CHECK_EQ(p->player_id, (uint8_t)i);
+    }
+}
+
+// Header: magic (4), version (1), record size (1), count (2)
+#define BLOB_VERSION_AT 4
+#define BLOB_RECORD_SIZE_AT 5
+#define BLOB_HEADER_LEN 8
+#define BLOB_RECORD_LEN 9
+
+static void test_blob_versions(void)
+{
+    peer_map_clear(&s_map);
+    const peer_info_t a = {{0x24, 0x6F, 0x28, 0x00, 0x00, 0x01}, 1, 2, 3};
+    const peer_info_t b = {{0x24, 0x6F, 0x28, 0x00, 0x00, 0x02}, 4, 5, 6};
+    CHECK(peer_map_put(&s_map, &a));
+    CHECK(peer_map_put(&s_map, &b));
+
+    uint8_t blob[BLOB_HEADER_LEN + 2 * (BLOB_RECORD_LEN + 1)];
+    CHECK_EQ(peer_map_serialize(&s_map, blob, BLOB_HEADER_LEN + BLOB_RECORD_LEN), 0);
+    const size_t len = peer_map_serialize(&s_map, blob, sizeof(blob));
+    CHECK_EQ(len, BLOB_HEADER_LEN + 2 * BLOB_RECORD_LEN);
+
+    peer_map_t* m = &s_map;
+    CHECK(peer_map_deserialize(m, blob, len));
+    CHECK_EQ(m->count, 2);
+    const peer_info_t* p = peer_map_find(m, b.mac);
+    CHECK(p && p->player_id == 4 && p->device_id == 5 && p->team_id == 6);
+
+    // Rejected blobs leave the map as it was
+    uint8_t bad[sizeof(blob)];
+    memcpy(bad, blob, len);
+    bad[BLOB_VERSION_AT]++;
+    CHECK(!peer_map_deserialize(m, bad, len));
+    memcpy(bad, blob, len);
+    bad[BLOB_VERSION_AT]--;
+    CHECK(!peer_map_deserialize(m, bad, len));
+    memcpy(bad, blob, len);
+    bad[0] ^= 0xFF;
+    CHECK(!peer_map_deserialize(m, bad, len));
+    memcpy(bad, blob, len);
+    bad[BLOB_RECORD_SIZE_AT] = BLOB_RECORD_LEN - 1;
+    CHECK(!peer_map_deserialize(m, bad, len));
+    CHECK(!peer_map_deserialize(m, blob, len - 1));
+    CHECK(!peer_map_deserialize(m, blob, BLOB_HEADER_LEN - 1));
+    CHECK_EQ(m->count, 2);
+    CHECK(peer_map_find(m, a.mac) != NULL);
+
+    // Longer records of the same version are read, the extra bytes skipped
+    uint8_t wide[sizeof(blob)];
+    memcpy(wide, blob, BLOB_HEADER_LEN);
+    wide[BLOB_RECORD_SIZE_AT] = BLOB_RECORD_LEN + 1;
+    for (int r = 0; r < 2; r++)
+    {
+        uint8_t* rec = wide + BLOB_HEADER_LEN + r * (BLOB_RECORD_LEN + 1);
+        memcpy(rec, blob + BLOB_HEADER_LEN + r * BLOB_RECORD_LEN, BLOB_RECORD_LEN);
+        rec[BLOB_RECORD_LEN] = 0xEE;
+    }
+    peer_map_clear(m);
+    CHECK(peer_map_deserialize(m, wide, sizeof(wide)));
+    CHECK_EQ(m->count, 2);
+    p = peer_map_find(m, a.mac);
+    CHECK(p && p->player_id == 1 && p->device_id == 2 && p->team_id == 3);
+}
+
+// The commands are found either way; their effect shows in the table
+static void command(const char* text)
+{
+    CHECK(ws_commands_handle(0, text, strlen(text)));
+}
+
+static void test_commands(void)
+{
+    static const uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x10};
+    peer_table_register_commands();
+    const size_t before = peer_table_count();
+
+    command("peer_add 24:6F:28:00:00:10 4 9 2");
+    CHECK_EQ(peer_table_count(), before + 1);
+    peer_info_t peer;
+    CHECK(peer_table_find(mac, &peer));
+    CHECK_EQ(peer.player_id, 4);
+    CHECK_EQ(peer.device_id, 9);
+    CHECK_EQ(peer.team_id, 2);
+
+    // Updating keeps one entry
+    command("peer_add 24:6F:28:00:00:10 5 9 1");
+    CHECK_EQ(peer_table_count(), before + 1);
+    CHECK(peer_table_find(mac, &peer));
+    CHECK_EQ(peer.player_id, 5);
+
+    // A bare MAC, missing ids, ids out of range or a bad MAC change nothing
+    command("peer_add 24:6F:28:00:00:11");
+    command("peer_add 24:6F:28:00:00:11 1 2");
+    command("peer_add 24:6F:28:00:00:11 1 2 256");
+    command("peer_add 24:6F:28:00:00 1 2 3");
+    command("peer_add");
+    CHECK_EQ(peer_table_count(), before + 1);
+
+    command("peer_del 24:6F:28:00:00:10");
+    CHECK(!peer_table_find(mac, NULL));
+    CHECK_EQ(peer_table_count(), before);
+    command("peer_del 24:6F:28:00:00:10");
+    command("peer_del nonsense");
+    CHECK_EQ(peer_table_count(), before);
+
+    // What the commands saved is what the next boot loads
+    s_csv = NULL;
+    command("peer_add 24:6F:28:00:00:10 6 1 1");
+    peer_table_load();
+    CHECK(peer_table_find(mac, &peer));
+    CHECK_EQ(peer.player_id, 6);
+}
+
+#define BENCH_ROUNDS 200
+
+// Fills the device table with exactly n fleet peers and saves it
+static void fill_table(uint32_t n)
+{
+    // Drop the earlier tests' peers and any previous fill
+    uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x00};
+    for (uint32_t i = 0; i <= 0xFF; i++)
+    {
+        mac[5] = (uint8_t)i;
+        peer_table_remove(mac);
+    }
+    for (uint32_t i = 0; i < PEER_TABLE_CAPACITY; i++)
+    {
+        fleet_mac(0x2000 + i, mac);
+        peer_table_remove(mac);
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        peer_info_t peer = {};
+        fleet_mac(0x2000 + i, peer.mac);
+        peer.player_id = (uint8_t)i;
+        CHECK(peer_table_put(&peer));
+    }
+    CHECK(peer_table_save());
+}
+
+static void bench(uint32_t n)
+{
+    fill_table(n);
+    CHECK_EQ(peer_table_count(), n);
+
+    // Boot: blob out of NVS into the map (no CSV)
+    s_csv = NULL;
+    int64_t t0 = esp_timer_get_time();
+    peer_table_load();
+    const int64_t load_us = esp_timer_get_time() - t0;
+    CHECK_EQ(peer_table_count(), n);
+
+    // Known senders, then MACs not in the table
+    uint32_t found = 0;
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint8_t mac[6];
+            fleet_mac(0x2000 + i, mac);
+            found += peer_table_find(mac, NULL) ? 1 : 0;
+        }
+    }
+    const int64_t hit_us = esp_timer_get_time() - t0;
+    CHECK_EQ(found, n * BENCH_ROUNDS);
+
+    found = 0;
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint8_t mac[6];
+            fleet_mac(0x3000 + i, mac);
+            found += peer_table_find(mac, NULL) ? 1 : 0;
+        }
+    }
+    const int64_t miss_us = esp_timer_get_time() - t0;
+    CHECK_EQ(found, 0);
+
+    const double lookups = (double)n * BENCH_ROUNDS;
+    test_log("%3u peers: load %lld us, lookup hit %.0f ns, miss %.0f ns\n", (unsigned)n, (long long)load_us,
+             hit_us * 1000.0 / lookups, miss_us * 1000.0 / lookups);
+}
+
+static void body(void)
+{
+    test_migrate_and_learn();
+    test_csv_still_honored();
+    test_map_remove();
+    test_blob_versions();
+    test_commands();
+    bench(64);
+    bench(PEER_TABLE_CAPACITY);
+}
+
+int main(void)
+{
+    test_run_scheduled("test_peer_table", body);
+}
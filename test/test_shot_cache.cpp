@@ -0,0 +1,137 @@
+// shot_cache: the armed shot matches what the trigger path used to build per
+// pull, is rebuilt only when the published config generation moves, and is
+// cheaper per shot. Prints the per-shot cost of both paths.
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+#include <chrono>
+#include "fake_game_state.h"
+#include "game_snapshot.h"
+#include "laser_frame.h"
+#include "laser_tx.h"
+#include "shot_cache.h"
+#include "test_util.h"
+
+#define BENCH_SHOTS 200000
+
+// The per-pull work before the cache: read config, build the word and the
+// ESP-NOW message field by field, and encode the frame in the laser task
+static void uncached_shot(int64_t stamp_us, PlayerMessage* msg, laser_frame_t* frame)
+{
+    const DeviceConfig* config = game_state_get_config();
+    const uint32_t word = createLaserMessage(config->player_id, config->device_id);
+    memset(msg, 0, sizeof(*msg));
+    msg->type = ESPNOW_MSG_SHOT;
+    msg->version = 1;
+    msg->player_id = config->player_id;
+    msg->device_id = config->device_id;
+    msg->team_id = config->team_id;
+    msg->color_rgb = config->color_rgb;
+    msg->data = word;
+    msg->timestamp_ms = (uint32_t)(stamp_us / 1000);
+    laser_frame_encode(frame, word, laser_tx_bit_us(), laser_tx_gap_us());
+}
+
+// The same work with the cache: control_task patches the template, laser_task
+// copies the prebuilt frame
+static void cached_shot(int64_t stamp_us, PlayerMessage* msg, laser_frame_t* frame)
+{
+    const armed_shot_t* armed = shot_cache_arm();
+    *msg = armed->shot;
+    msg->timestamp_ms = (uint32_t)(stamp_us / 1000);
+    shot_cache_copy_frame(armed->laser_word, frame);
+}
+
+static bool same_frame(const laser_frame_t* a, const laser_frame_t* b)
+{
+    if (a->count != b->count || a->total_us != b->total_us || a->message != b->message)
+        return false;
+    for (uint8_t i = 0; i < a->count; i++)
+    {
+        if (a->symbols[i].duration_us != b->symbols[i].duration_us || a->symbols[i].level != b->symbols[i].level)
+            return false;
+    }
+    return true;
+}
+
+static void test_matches_uncached(void)
+{
+    PlayerMessage want, got;
+    laser_frame_t want_frame, got_frame;
+    uncached_shot(123456789, &want, &want_frame);
+    cached_shot(123456789, &got, &got_frame);
+    CHECK(memcmp(&want, &got, sizeof(want)) == 0);
+    CHECK(same_frame(&want_frame, &got_frame));
+    CHECK_EQ(shot_cache_arm()->laser_word, createLaserMessage(7, 3));
+
+    // laser_task falls back to encoding for a word it was not armed with
+    CHECK(!shot_cache_copy_frame(createLaserMessage(8, 3), &got_frame));
+}
+
+static void test_invalidation(void)
+{
+    const uint32_t word = shot_cache_arm()->laser_word;
+
+    // State-only changes do not move the config generation
+    const uint32_t gen = game_snapshot_config_generation();
+    g_fake_game.state.shots_fired++;
+    game_snapshot_publish();
+    CHECK_EQ(game_snapshot_config_generation(), gen);
+
+    // Unpublished config is not seen: the cache follows the snapshot
+    g_fake_game.config.player_id = 9;
+    g_fake_game.config.team_id = 2;
+    CHECK_EQ(shot_cache_arm()->laser_word, word);
+
+    game_snapshot_publish();
+    CHECK(game_snapshot_config_generation() != gen);
+    const armed_shot_t* armed = shot_cache_arm();
+    CHECK_EQ(armed->laser_word, createLaserMessage(9, 3));
+    CHECK_EQ(armed->shot.player_id, 9);
+    CHECK_EQ(armed->shot.team_id, 2);
+    CHECK_EQ(armed->team_id, 2);
+}
+
+typedef void (*shot_fn)(int64_t, PlayerMessage*, laser_frame_t*);
+
+static double ns_per_shot(shot_fn fn)
+{
+    PlayerMessage msg;
+    laser_frame_t frame;
+    volatile uint32_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_SHOTS; i++)
+    {
+        fn(i * 1000LL, &msg, &frame);
+        sink += msg.timestamp_ms + frame.count;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    (void)sink;
+    return (double)ns.count() / BENCH_SHOTS;
+}
+
+static void bench(void)
+{
+    // Warm both paths, then time them
+    ns_per_shot(uncached_shot);
+    ns_per_shot(cached_shot);
+    const double before = ns_per_shot(uncached_shot);
+    const double after = ns_per_shot(cached_shot);
+    test_log("per shot: uncached %.1f ns, cached %.1f ns (%.1fx)\n", before, after, before / after);
+    CHECK(after < before);
+}
+
+static void run(void)
+{
+    fake_game_state_reset();
+    CHECK(laser_tx_init(0, 10000, 100000));
+    game_snapshot_publish();
+
+    test_matches_uncached();
+    test_invalidation();
+    bench();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_shot_cache", run);
+}
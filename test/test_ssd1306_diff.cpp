@@ -0,0 +1,153 @@
+// ssd1306_diff against the mock bus's model of the panel: after every clean
+// flush the panel must show the framebuffer, also when earlier flushes lost
+// command or data writes part-way. Prints the bytes sent against full-frame
+// resends.
+#include <stdlib.h>
+#include <string.h>
+#include "ssd1306_diff.h"
+#include "test_util.h"
+
+#define FRAMES 2000
+
+static uint32_t s_rng = 0x12345678u;
+
+static uint32_t rnd(uint32_t n)
+{
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return (s_rng >> 8) % n;
+}
+
+// A few label-sized changes, the way LVGL redraws a text row
+static void mutate(uint8_t* fb)
+{
+    const uint32_t edits = 1 + rnd(3);
+    for (uint32_t e = 0; e < edits; e++)
+    {
+        const uint32_t page = rnd(SSD1306_PAGES);
+        const uint32_t x = rnd(OLED_WIDTH);
+        const uint32_t w = 1 + rnd(24);
+        for (uint32_t i = x; i < x + w && i < OLED_WIDTH; i++)
+            fb[page * OLED_WIDTH + i] = (uint8_t)rnd(256);
+    }
+}
+
+static bool panel_matches(const ssd1306_mock_bus_t* mock, const uint8_t* fb)
+{
+    return memcmp(mock->panel, fb, SSD1306_FB_SIZE) == 0;
+}
+
+static void test_clean_bus(void)
+{
+    static ssd1306_mock_bus_t mock;
+    memset(&mock, 0, sizeof(mock));
+    const ssd1306_bus_t bus = ssd1306_mock_bus(&mock);
+    ssd1306_diff_t d;
+    CHECK(ssd1306_diff_init(&d, &bus));
+
+    uint8_t fb[SSD1306_FB_SIZE];
+    memset(fb, 0xA5, sizeof(fb));
+    CHECK(ssd1306_diff_flush(&d, fb) > 0);
+    CHECK(panel_matches(&mock, fb));
+
+    // Nothing changed, nothing sent
+    const uint32_t before = mock.transactions;
+    CHECK_EQ(ssd1306_diff_flush(&d, fb), 0);
+    CHECK_EQ(mock.transactions, before);
+
+    int mismatches = 0;
+    const uint32_t bytes_start = mock.bytes;
+    for (int i = 0; i < FRAMES; i++)
+    {
+        mutate(fb);
+        ssd1306_diff_flush(&d, fb);
+        mismatches += !panel_matches(&mock, fb);
+    }
+    CHECK_EQ(mismatches, 0);
+    test_log("clean: %u bytes per frame, full frame %u\n", (unsigned)((mock.bytes - bytes_start) / FRAMES),
+             (unsigned)(SSD1306_FB_SIZE + 1 + 8 + 2));
+}
+
+static void test_failed_command_write(void)
+{
+    static ssd1306_mock_bus_t mock;
+    memset(&mock, 0, sizeof(mock));
+    const ssd1306_bus_t bus = ssd1306_mock_bus(&mock);
+    ssd1306_diff_t d;
+    CHECK(ssd1306_diff_init(&d, &bus));
+
+    uint8_t fb[SSD1306_FB_SIZE] = {};
+    CHECK(ssd1306_diff_flush(&d, fb) > 0);
+
+    // The window command is refused: nothing reaches the panel, and the span
+    // must still count as changed
+    fb[5] = 0xFF;
+    mock.fail_at = mock.transactions + 1;
+    CHECK_EQ(ssd1306_diff_flush(&d, fb), 0);
+    CHECK(!panel_matches(&mock, fb));
+    CHECK(d.valid);
+    CHECK(ssd1306_diff_flush(&d, fb) > 0);
+    CHECK(panel_matches(&mock, fb));
+}
+
+static void test_failed_data_write(void)
+{
+    static ssd1306_mock_bus_t mock;
+    memset(&mock, 0, sizeof(mock));
+    const ssd1306_bus_t bus = ssd1306_mock_bus(&mock);
+    ssd1306_diff_t d;
+    CHECK(ssd1306_diff_init(&d, &bus));
+
+    uint8_t fb[SSD1306_FB_SIZE] = {};
+    CHECK(ssd1306_diff_flush(&d, fb) > 0);
+
+    // Half the span lands, then the frame goes back to what it was: only a
+    // full resend can repair the panel
+    memset(&fb[OLED_WIDTH], 0xFF, 20);
+    mock.fail_at = mock.transactions + 2;
+    CHECK_EQ(ssd1306_diff_flush(&d, fb), 0);
+    CHECK(!d.valid);
+    memset(&fb[OLED_WIDTH], 0x00, 20);
+    CHECK(!panel_matches(&mock, fb));
+    CHECK(ssd1306_diff_flush(&d, fb) > 0);
+    CHECK(panel_matches(&mock, fb));
+}
+
+static void test_random_failures(void)
+{
+    static ssd1306_mock_bus_t mock;
+    memset(&mock, 0, sizeof(mock));
+    const ssd1306_bus_t bus = ssd1306_mock_bus(&mock);
+    ssd1306_diff_t d;
+    CHECK(ssd1306_diff_init(&d, &bus));
+
+    uint8_t fb[SSD1306_FB_SIZE] = {};
+    int mismatches = 0;
+    int failed_frames = 0;
+    for (int i = 0; i < FRAMES; i++)
+    {
+        mutate(fb);
+        if (rnd(3) == 0)
+        {
+            mock.fail_at = mock.transactions + 1 + rnd(4);
+            ssd1306_diff_flush(&d, fb);
+            failed_frames++;
+            mock.fail_at = 0;
+            // The frame may change again before the retry
+            if (rnd(2))
+                mutate(fb);
+        }
+        ssd1306_diff_flush(&d, fb);
+        mismatches += !panel_matches(&mock, fb);
+    }
+    CHECK_EQ(mismatches, 0);
+    test_log("random failures: %d of %d frames hit a failed write\n", failed_frames, FRAMES);
+}
+
+int main(void)
+{
+    test_clean_bus();
+    test_failed_command_write();
+    test_failed_data_write();
+    test_random_failures();
+    return test_report("test_ssd1306_diff");
+}
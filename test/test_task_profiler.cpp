@@ -0,0 +1,81 @@
+// task_profiler with more tasks than it lists: the report keeps the first
+// TASK_PROFILER_MAX_TASKS, counts every task and says it was truncated, and
+// the encoded header carries the same.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "sim.h"
+#include "task_profiler.h"
+#include "test_util.h"
+
+#define EXTRA_TASKS 6
+
+static void idle_task(void* arg)
+{
+    (void)arg;
+    for (;;)
+        vTaskDelay(pdMS_TO_TICKS(1000));
+}
+
+// Waits for a sample taken after the call
+static bool wait_report(task_prof_report_t* r, uint32_t after_ms)
+{
+    const TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(TASK_PROFILER_PERIOD_MS * 5);
+    while (xTaskGetTickCount() < until)
+    {
+        task_profiler_get(r);
+        if (r->count && r->uptime_ms > after_ms)
+            return true;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+static void test_fits(void)
+{
+    task_prof_report_t r;
+    CHECK(wait_report(&r, 0));
+    CHECK(uxTaskGetNumberOfTasks() <= TASK_PROFILER_MAX_TASKS);
+    CHECK_EQ(r.count, r.total);
+    CHECK(!r.truncated);
+}
+
+static void test_truncated(void)
+{
+    for (int i = 0; i < EXTRA_TASKS; i++)
+        xTaskCreate(idle_task, "prof_extra", 2048, NULL, 1, NULL);
+    const UBaseType_t tasks = uxTaskGetNumberOfTasks();
+    CHECK(tasks > TASK_PROFILER_MAX_TASKS);
+
+    task_prof_report_t r;
+    CHECK(wait_report(&r, (uint32_t)(esp_timer_get_time() / 1000)));
+    CHECK_EQ(r.count, TASK_PROFILER_MAX_TASKS);
+    CHECK_EQ(r.total, tasks);
+    CHECK(r.truncated);
+    for (uint8_t i = 0; i < r.count; i++)
+        CHECK(r.tasks[i].name[0] != '\0');
+
+    uint8_t buf[TASK_PROF_MAX_LEN];
+    const size_t n = task_profiler_encode(buf, sizeof(buf));
+    CHECK(n > 0);
+    CHECK_EQ(buf[0], TASK_PROF_MAGIC);
+    CHECK_EQ(buf[1], TASK_PROF_VERSION);
+    CHECK_EQ(buf[2], TASK_PROFILER_MAX_TASKS);
+    CHECK(buf[12] > buf[2]);
+    CHECK_EQ(buf[13], TASK_PROF_FLAG_TRUNCATED);
+    CHECK_EQ(n, TASK_PROF_HEADER_LEN + (size_t)buf[2] * TASK_PROF_ENTRY_LEN);
+    test_log("truncated: %u of %u tasks listed, %u bytes\n", (unsigned)buf[2], (unsigned)buf[12], (unsigned)n);
+}
+
+static void body(void)
+{
+    sim_timer_start();
+    CHECK(task_profiler_start());
+    test_fits();
+    test_truncated();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_task_profiler", body);
+}
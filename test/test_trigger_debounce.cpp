@@ -0,0 +1,180 @@
+// trigger_debounce against recorded-style bounce traces: the first edge of a
+// press or release is reported at its own timestamp, bounce inside the glitch
+// window is swallowed, and a level that flips back late is settled once.
+#include <stdlib.h>
+#include "test_util.h"
+#include "trigger_debounce.h"
+
+#define GLITCH_US 5000
+#define TALLY_MAX 256
+
+typedef struct
+{
+    int64_t t_us;
+    bool pressed;
+} edge_t;
+
+typedef struct
+{
+    int presses;
+    int releases;
+    int64_t last_press_us;
+    int64_t last_release_us;
+    trigger_evt_type_t last;
+    bool alternating;
+    int64_t at_us[TALLY_MAX];
+    int events;
+} tally_t;
+
+static void count(tally_t* t, trigger_evt_type_t evt, int64_t at_us)
+{
+    if (evt == TRIGGER_EVT_NONE)
+        return;
+    if (evt == t->last)
+        t->alternating = false;
+    t->last = evt;
+    if (t->events < TALLY_MAX)
+        t->at_us[t->events++] = at_us;
+    if (evt == TRIGGER_EVT_PRESS)
+    {
+        t->presses++;
+        t->last_press_us = at_us;
+    }
+    else
+    {
+        t->releases++;
+        t->last_release_us = at_us;
+    }
+}
+
+// Feed edges as the ISR would, running settle() at its deadline like the
+// input task's timeout does
+static tally_t play(trigger_debounce_t* d, const edge_t* edges, size_t n, int64_t end_us)
+{
+    tally_t t = {};
+    t.last_press_us = -1;
+    t.last_release_us = -1;
+    t.alternating = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        int64_t dl;
+        while ((dl = trigger_debounce_deadline(d)) >= 0 && dl <= edges[i].t_us)
+            count(&t, trigger_debounce_settle(d, dl), dl);
+        count(&t, trigger_debounce_edge(d, edges[i].pressed, edges[i].t_us), edges[i].t_us);
+    }
+    int64_t dl;
+    while ((dl = trigger_debounce_deadline(d)) >= 0 && dl <= end_us)
+        count(&t, trigger_debounce_settle(d, dl), dl);
+    return t;
+}
+
+static void test_clean_and_bouncy_press(void)
+{
+    trigger_debounce_t d;
+    trigger_debounce_init(&d, GLITCH_US, false, 0);
+
+    // Press with contact bounce, held, release with bounce
+    const edge_t trace[] = {
+        {100000, true},  {100040, false}, {100090, true}, {100300, false}, {100310, true},
+        {180000, false}, {180020, true},  {180200, false},
+    };
+    const tally_t t = play(&d, trace, sizeof(trace) / sizeof(trace[0]), 300000);
+    CHECK_EQ(t.presses, 1);
+    CHECK_EQ(t.releases, 1);
+    // Leading edge: no debounce delay on either transition
+    CHECK_EQ(t.last_press_us, 100000);
+    CHECK_EQ(t.last_release_us, 180000);
+    CHECK_EQ(d.press_us, 100000);
+    CHECK(!d.pressed);
+    CHECK_EQ(trigger_debounce_deadline(&d), -1);
+}
+
+static void test_glitch_settles_back(void)
+{
+    trigger_debounce_t d;
+    trigger_debounce_init(&d, GLITCH_US, false, 0);
+
+    // A 200 us spike: reported as a press, then settled as a release once
+    // the window has passed with the contact open
+    CHECK_EQ(trigger_debounce_edge(&d, true, 50000), TRIGGER_EVT_PRESS);
+    CHECK_EQ(trigger_debounce_edge(&d, false, 50200), TRIGGER_EVT_NONE);
+    CHECK_EQ(trigger_debounce_deadline(&d), 50000 + GLITCH_US);
+    CHECK_EQ(trigger_debounce_settle(&d, 50000 + GLITCH_US - 1), TRIGGER_EVT_NONE);
+    CHECK_EQ(trigger_debounce_settle(&d, 50000 + GLITCH_US), TRIGGER_EVT_RELEASE);
+    CHECK_EQ(trigger_debounce_settle(&d, 60000), TRIGGER_EVT_NONE);
+    CHECK_EQ(trigger_debounce_deadline(&d), -1);
+
+    // Bounce that ends where it started needs no settle
+    CHECK_EQ(trigger_debounce_edge(&d, true, 100000), TRIGGER_EVT_PRESS);
+    CHECK_EQ(trigger_debounce_edge(&d, false, 100100), TRIGGER_EVT_NONE);
+    CHECK_EQ(trigger_debounce_edge(&d, true, 100200), TRIGGER_EVT_NONE);
+    CHECK_EQ(trigger_debounce_deadline(&d), -1);
+}
+
+static void test_init_state(void)
+{
+    trigger_debounce_t d;
+    // Held at boot: the first edge is a release and is accepted right away
+    trigger_debounce_init(&d, GLITCH_US, true, 1000);
+    CHECK_EQ(trigger_debounce_edge(&d, true, 1500), TRIGGER_EVT_NONE);
+    CHECK_EQ(trigger_debounce_edge(&d, false, 1600), TRIGGER_EVT_RELEASE);
+    CHECK_EQ(d.release_us, 1600);
+}
+
+// Random actuations, each with up to 8 bounce edges inside 2 ms; presses are
+// at least 20 ms apart. Every actuation must come out exactly once, at its
+// first edge.
+static void test_random_traces(void)
+{
+    srand(1234);
+    for (int run = 0; run < 200; run++)
+    {
+        edge_t edges[400];
+        size_t n = 0;
+        int actuations = 0;
+        int64_t starts[TALLY_MAX];
+        int64_t t = 10000;
+        bool level = false;
+        while (n < 380)
+        {
+            t += 20000 + rand() % 80000;
+            level = !level;
+            edges[n++] = {t, level};
+            starts[actuations++] = t;
+            const int bounces = rand() % 9;
+            int64_t bt = t;
+            for (int b = 0; b < bounces; b++)
+            {
+                bt += 1 + rand() % 250;
+                edges[n++] = {bt, (b & 1) ? level : !level};
+            }
+            // Contact ends on the intended level
+            if (bounces & 1)
+                edges[n++] = {bt + 1 + rand() % 250, level};
+        }
+
+        trigger_debounce_t d;
+        trigger_debounce_init(&d, GLITCH_US, false, 0);
+        const tally_t tally = play(&d, edges, n, t + 10 * GLITCH_US);
+        CHECK_EQ(tally.presses + tally.releases, actuations);
+        CHECK(tally.alternating);
+        CHECK_EQ(d.pressed, level);
+        CHECK_EQ(trigger_debounce_deadline(&d), -1);
+        for (int i = 0; i < actuations && i < tally.events; i++)
+            CHECK_EQ(tally.at_us[i], starts[i]);
+        if (test_failures())
+        {
+            test_log("random trace %d failed\n", run);
+            return;
+        }
+    }
+}
+
+int main(void)
+{
+    test_clean_and_bouncy_press();
+    test_glitch_settles_back();
+    test_init_state();
+    test_random_traces();
+    return test_report("test_trigger_debounce");
+}
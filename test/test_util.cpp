@@ -0,0 +1,117 @@
+#include "test_util.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "sim.h"
+
+#define TEST_LINE_MAX 512
+#define TEST_TASK_STACK 16384
+
+static volatile int s_failures;
+static const char* s_name;
+static void (*s_body)(void);
+
+void test_log(const char* format, ...)
+{
+    char line[TEST_LINE_MAX];
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(line, sizeof(line), format, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    if (n >= (int)sizeof(line))
+        n = sizeof(line) - 1;
+    ssize_t rc = write(STDOUT_FILENO, line, (size_t)n);
+    (void)rc;
+}
+
+void test_check(bool ok, const char* expr, const char* file, int line)
+{
+    if (ok)
+        return;
+    s_failures++;
+    test_log("FAIL %s:%d: %s\n", file, line, expr);
+}
+
+void test_check_eq(long long actual, long long expected, const char* expr_a, const char* expr_b, const char* file,
+                   int line)
+{
+    if (actual == expected)
+        return;
+    s_failures++;
+    test_log("FAIL %s:%d: %s == %s (%lld vs %lld)\n", file, line, expr_a, expr_b, actual, expected);
+}
+
+int test_failures(void)
+{
+    return s_failures;
+}
+
+int test_report(const char* name)
+{
+    if (s_failures)
+        test_log("%s: %d check(s) failed\n", name, s_failures);
+    else
+        test_log("%s: passed\n", name);
+    return s_failures ? 1 : 0;
+}
+
+static void test_task(void* arg)
+{
+    (void)arg;
+    s_body();
+    // Other tasks may hold locks; skip static teardown like the sim does
+    _exit(test_report(s_name));
+}
+
+void test_run_scheduled(const char* name, void (*body)(void))
+{
+    s_name = name;
+    s_body = body;
+    xTaskCreate(test_task, "test", TEST_TASK_STACK, NULL, 5, NULL);
+    vTaskStartScheduler();
+    test_log("%s: scheduler did not start\n", name);
+    _exit(1);
+}
+
+// Run control the sim's IDF services (host/sim_idf.cpp, sim_timer.cpp) expect
+// from sim_main.cpp
+static sim_options_t s_opts = {
+    NULL, ".", 0, 100, {0x02, 0x00, 0x00, 0x00, 0x00, 0x01}, 0, NULL, NULL,
+};
+
+const sim_options_t* sim_options(void)
+{
+    return &s_opts;
+}
+
+// Tests write no traces and have no supervisor to run exit hooks
+FILE* sim_trace_open(const char* name)
+{
+    (void)name;
+    return NULL;
+}
+
+void sim_stop(void)
+{
+}
+
+void sim_at_exit(void (*fn)(void))
+{
+    (void)fn;
+}
+
+void sim_fail(void)
+{
+    s_failures++;
+}
+
+void vAssertCalled(const char* file, unsigned long line)
+{
+    test_log("FreeRTOS assert at %s:%lu\n", file, line);
+    abort();
+}
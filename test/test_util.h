@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// Minimal harness for the host tests. A failed check is reported and counted
+// and the test carries on; the exit code is what ctest reads.
+
+void test_check(bool ok, const char* expr, const char* file, int line);
+void test_check_eq(long long actual, long long expected, const char* expr_a, const char* expr_b, const char* file,
+                   int line);
+
+#define CHECK(cond) test_check((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(a, b) test_check_eq((long long)(a), (long long)(b), #a, #b, __FILE__, __LINE__)
+
+// printf to stdout with one write(), safe from any task
+void test_log(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+int test_failures(void);
+
+// Print the tally; returns the process exit code
+int test_report(const char* name);
+
+// Run body on a FreeRTOS task once the scheduler is up, then exit with the
+// report. For tests of code that blocks or relies on critical sections.
+// Start the sim's esp_timer task first if the code under test uses timers.
+[[noreturn]] void test_run_scheduled(const char* name, void (*body)(void));
@@ -0,0 +1,334 @@
+// ws_codec state deltas and format names: a client's first frame carries
+// every field, zeros included; unlimited ammo travels as its own flag next to
+// the real max_ammo; only the exact format names are accepted. Shot, hit and
+// delta messages decode from MessagePack to the same map as from JSON, with
+// the values they were encoded from. Prints bytes and encode time per
+// message in both formats.
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include "ws_codec.h"
+#include "test_util.h"
+
+#define DELTA_ALL_FIELDS 10 // type, gen and the eight state fields
+#define BENCH_ROUNDS 100000
+
+// A decoded message: "type" as a string, every other field as a number
+typedef struct
+{
+    std::string type;
+    std::map<std::string, int64_t> fields;
+} msg_t;
+
+static size_t encode(ws_fmt_t fmt, const game_snapshot_t* prev, const game_snapshot_t* cur, char* out)
+{
+    const ws_delta_t delta = {prev, cur};
+    const size_t n = ws_codec_delta(fmt, &delta, (uint8_t*)out, WS_CODEC_MAX_LEN);
+    out[n] = '\0';
+    return n;
+}
+
+static void test_first_frame_is_full(void)
+{
+    game_snapshot_t zero;
+    memset(&zero, 0, sizeof(zero));
+    char buf[WS_CODEC_MAX_LEN + 1];
+
+    // Against a zeroed baseline nothing differs; without one everything is sent
+    CHECK_EQ(encode(WS_FMT_JSON, &zero, &zero, buf), 0);
+    CHECK(encode(WS_FMT_JSON, NULL, &zero, buf) > 0);
+    CHECK(strcmp(buf, "{\"type\":\"delta\",\"gen\":0,\"kills\":0,\"deaths\":0,\"shots\":0,\"hits\":0,"
+                      "\"hearts\":0,\"respawning\":0,\"max_ammo\":0,\"unlimited\":0}") == 0);
+
+    CHECK(encode(WS_FMT_MSGPACK, NULL, &zero, buf) > 0);
+    CHECK_EQ((uint8_t)buf[0], 0x80 | DELTA_ALL_FIELDS);
+
+    const ws_delta_t delta = {NULL, &zero};
+    CHECK(ws_codec_delta_fields(&delta) != 0);
+}
+
+static void test_unlimited_flag(void)
+{
+    game_snapshot_t prev;
+    memset(&prev, 0, sizeof(prev));
+    prev.game.max_ammo = 30;
+    game_snapshot_t cur = prev;
+    char buf[WS_CODEC_MAX_LEN + 1];
+
+    // Turning unlimited on leaves max_ammo as it was and says so explicitly
+    cur.game.unlimited_ammo = true;
+    CHECK(encode(WS_FMT_JSON, &prev, &cur, buf) > 0);
+    CHECK(strcmp(buf, "{\"type\":\"delta\",\"gen\":0,\"unlimited\":1}") == 0);
+
+    // An empty magazine is no longer mistaken for unlimited ammo
+    prev = cur;
+    cur.game.unlimited_ammo = false;
+    cur.game.max_ammo = 0;
+    CHECK(encode(WS_FMT_JSON, &prev, &cur, buf) > 0);
+    CHECK(strcmp(buf, "{\"type\":\"delta\",\"gen\":0,\"max_ammo\":0,\"unlimited\":0}") == 0);
+
+    CHECK(encode(WS_FMT_JSON, NULL, &cur, buf) > 0);
+    CHECK(strstr(buf, "\"max_ammo\":0,\"unlimited\":0") != NULL);
+}
+
+static void test_parse_fmt(void)
+{
+    ws_fmt_t fmt = WS_FMT_COUNT;
+    CHECK(ws_codec_parse_fmt("json", &fmt));
+    CHECK_EQ(fmt, WS_FMT_JSON);
+    CHECK(ws_codec_parse_fmt("msgpack", &fmt));
+    CHECK_EQ(fmt, WS_FMT_MSGPACK);
+
+    static const char* const bad[] = {"", "jsonx", "json ", "msgpack2", "msg", "JSON", "js"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        fmt = WS_FMT_COUNT;
+        CHECK(!ws_codec_parse_fmt(bad[i], &fmt));
+        CHECK_EQ(fmt, WS_FMT_COUNT);
+    }
+}
+
+// Just what ws_codec writes: a fixmap of fixstr keys to a fixstr type or
+// integers
+static bool mp_decode(const uint8_t* p, size_t n, msg_t* out)
+{
+    size_t i = 0;
+    auto str = [&](std::string* s) {
+        if (i >= n || (p[i] & 0xE0) != 0xA0 || i + 1 + (p[i] & 0x1F) > n)
+            return false;
+        const size_t len = p[i] & 0x1F;
+        s->assign((const char*)p + i + 1, len);
+        i += 1 + len;
+        return true;
+    };
+    auto be = [&](size_t bytes, uint32_t* v) {
+        if (i + 1 + bytes > n)
+            return false;
+        *v = 0;
+        for (size_t k = 0; k < bytes; k++)
+            *v = *v << 8 | p[i + 1 + k];
+        i += 1 + bytes;
+        return true;
+    };
+    auto num = [&](int64_t* v) {
+        if (i >= n)
+            return false;
+        const uint8_t b = p[i];
+        uint32_t u;
+        if (b < 0x80 || b >= 0xE0)
+        {
+            *v = b < 0x80 ? (int64_t)b : (int64_t)(int8_t)b;
+            i++;
+            return true;
+        }
+        if (b == 0xCC || b == 0xCD || b == 0xCE)
+        {
+            if (!be(b == 0xCC ? 1 : b == 0xCD ? 2 : 4, &u))
+                return false;
+            *v = u;
+            return true;
+        }
+        if (b == 0xD2 && be(4, &u))
+        {
+            *v = (int32_t)u;
+            return true;
+        }
+        return false;
+    };
+
+    if (n == 0 || (p[0] & 0xF0) != 0x80)
+        return false;
+    const int count = p[i++] & 0x0F;
+    std::string key;
+    if (count < 1 || !str(&key) || key != "type" || !str(&out->type))
+        return false;
+    for (int f = 1; f < count; f++)
+    {
+        int64_t v;
+        if (!str(&key) || !num(&v) || out->fields.count(key))
+            return false;
+        out->fields[key] = v;
+    }
+    return i == n;
+}
+
+// The same for JSON: one flat object, "type" first
+static bool json_decode(const char* s, msg_t* out)
+{
+    static const char prefix[] = "{\"type\":\"";
+    if (strncmp(s, prefix, sizeof(prefix) - 1) != 0)
+        return false;
+    s += sizeof(prefix) - 1;
+    const char* end = strchr(s, '"');
+    if (!end)
+        return false;
+    out->type.assign(s, end - s);
+    s = end + 1;
+    while (*s == ',')
+    {
+        if (s[1] != '"' || !(end = strchr(s + 2, '"')) || end[1] != ':')
+            return false;
+        const std::string key(s + 2, end - s - 2);
+        char* after;
+        const long long v = strtoll(end + 2, &after, 10);
+        if (after == end + 2 || out->fields.count(key))
+            return false;
+        out->fields[key] = v;
+        s = after;
+    }
+    return s[0] == '}' && s[1] == '\0';
+}
+
+// Encodes with fn in both formats; the two decode to one message
+static bool both_formats(size_t (*fn)(ws_fmt_t, const void*, uint8_t*, size_t), const void* msg, msg_t* out)
+{
+    uint8_t mp[WS_CODEC_MAX_LEN];
+    char js[WS_CODEC_MAX_LEN + 1];
+    const size_t mp_len = fn(WS_FMT_MSGPACK, msg, mp, sizeof(mp));
+    const size_t js_len = fn(WS_FMT_JSON, msg, (uint8_t*)js, WS_CODEC_MAX_LEN);
+    js[js_len] = '\0';
+    msg_t from_json;
+    if (!mp_len || !js_len || !mp_decode(mp, mp_len, out) || !json_decode(js, &from_json))
+        return false;
+    return out->type == from_json.type && out->fields == from_json.fields;
+}
+
+static size_t event_fn(ws_fmt_t fmt, const void* msg, uint8_t* buf, size_t cap)
+{
+    return ws_codec_event(fmt, (const ws_event_t*)msg, buf, cap);
+}
+
+static size_t delta_fn(ws_fmt_t fmt, const void* msg, uint8_t* buf, size_t cap)
+{
+    return ws_codec_delta(fmt, (const ws_delta_t*)msg, buf, cap);
+}
+
+static void test_round_trip(void)
+{
+    // Values at each MessagePack integer width
+    ws_event_t shot = {};
+    shot.type = WS_EVT_SHOT;
+    shot.player_id = 7;
+    shot.device_id = 200;
+    shot.team_id = 2;
+    shot.victim = -1;
+    shot.data = 0x12345678;
+    shot.ts_ms = 65535;
+    msg_t m;
+    CHECK(both_formats(event_fn, &shot, &m));
+    CHECK(m.type == "shot");
+    CHECK(m.fields == (std::map<std::string, int64_t>{
+                          {"player", 7}, {"device", 200}, {"team", 2}, {"data", 0x12345678}, {"ts", 65535}}));
+
+    ws_event_t hit = shot;
+    hit.type = WS_EVT_HIT;
+    const int16_t victims[] = {-1, -32, -33, -300, 0, 127, 300};
+    for (int16_t victim : victims)
+    {
+        hit.victim = victim;
+        m = msg_t();
+        CHECK(both_formats(event_fn, &hit, &m));
+        CHECK(m.type == "hit");
+        CHECK_EQ(m.fields.size(), 6);
+        CHECK_EQ(m.fields["victim"], victim);
+        CHECK_EQ(m.fields["data"], 0x12345678);
+    }
+
+    game_snapshot_t prev;
+    memset(&prev, 0, sizeof(prev));
+    game_snapshot_t cur = prev;
+    cur.generation = 70000;
+    cur.state.kills = 3;
+    cur.state.deaths = 1;
+    cur.state.shots_fired = 1000;
+    cur.state.hits_landed = 128;
+    cur.state.hearts_remaining = 5;
+    cur.respawning = true;
+    cur.game.max_ammo = 30;
+    cur.game.unlimited_ammo = true;
+    const ws_delta_t full = {NULL, &cur};
+    m = msg_t();
+    CHECK(both_formats(delta_fn, &full, &m));
+    CHECK(m.type == "delta");
+    CHECK(m.fields == (std::map<std::string, int64_t>{{"gen", 70000},
+                                                      {"kills", 3},
+                                                      {"deaths", 1},
+                                                      {"shots", 1000},
+                                                      {"hits", 128},
+                                                      {"hearts", 5},
+                                                      {"respawning", 1},
+                                                      {"max_ammo", 30},
+                                                      {"unlimited", 1}}));
+
+    prev = cur;
+    cur.generation++;
+    cur.state.shots_fired++;
+    const ws_delta_t partial = {&prev, &cur};
+    m = msg_t();
+    CHECK(both_formats(delta_fn, &partial, &m));
+    CHECK(m.fields == (std::map<std::string, int64_t>{{"gen", 70001}, {"shots", 1001}}));
+}
+
+static void bench_one(const char* name, size_t (*fn)(ws_fmt_t, const void*, uint8_t*, size_t), const void* msg)
+{
+    size_t bytes[WS_FMT_COUNT];
+    double ns[WS_FMT_COUNT];
+    for (int fmt = 0; fmt < WS_FMT_COUNT; fmt++)
+    {
+        uint8_t buf[WS_CODEC_MAX_LEN];
+        size_t total = 0;
+        const int64_t t0 = esp_timer_get_time();
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+            total += fn((ws_fmt_t)fmt, msg, buf, sizeof(buf));
+        ns[fmt] = (esp_timer_get_time() - t0) * 1000.0 / BENCH_ROUNDS;
+        bytes[fmt] = total / BENCH_ROUNDS;
+        CHECK(bytes[fmt] > 0);
+    }
+    CHECK(bytes[WS_FMT_MSGPACK] < bytes[WS_FMT_JSON]);
+    test_log("%-13s json %3u bytes %4.0f ns, msgpack %3u bytes %4.0f ns\n", name, (unsigned)bytes[WS_FMT_JSON],
+             ns[WS_FMT_JSON], (unsigned)bytes[WS_FMT_MSGPACK], ns[WS_FMT_MSGPACK]);
+}
+
+static void bench(void)
+{
+    ws_event_t shot = {};
+    shot.type = WS_EVT_SHOT;
+    shot.player_id = 12;
+    shot.device_id = 34;
+    shot.team_id = 1;
+    shot.victim = -1;
+    shot.data = 0x00C0FFEE;
+    shot.ts_ms = 1234567;
+    bench_one("shot", event_fn, &shot);
+
+    ws_event_t hit = shot;
+    hit.type = WS_EVT_HIT;
+    hit.victim = 21;
+    bench_one("hit", event_fn, &hit);
+
+    game_snapshot_t prev;
+    memset(&prev, 0, sizeof(prev));
+    prev.generation = 4000;
+    prev.state.shots_fired = 250;
+    prev.state.hearts_remaining = 3;
+    prev.game.max_ammo = 30;
+    game_snapshot_t cur = prev;
+    cur.generation++;
+    cur.state.shots_fired++;
+    const ws_delta_t shot_delta = {&prev, &cur};
+    bench_one("delta (shot)", delta_fn, &shot_delta);
+    const ws_delta_t full = {NULL, &cur};
+    bench_one("delta (full)", delta_fn, &full);
+}
+
+int main(void)
+{
+    test_first_frame_is_full();
+    test_unlimited_flag();
+    test_parse_fmt();
+    test_round_trip();
+    bench();
+    return test_report("test_ws_codec");
+}
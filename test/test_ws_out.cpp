@@ -0,0 +1,477 @@
+// ws_out against socketpair clients: a client that stops reading or
+// overflows its backlog is evicted through the server's close hook, which
+// alone closes the socket; without a hook ws_out shuts the socket down. A
+// new client, and one that changes format, is asked for a full state frame.
+// Events, replies, state and control frames posted from several tasks reach
+// a slow reader as whole frames, events in order; PONG and CLOSE go out
+// ahead of the backlog and nothing follows a CLOSE.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "ws_out.h"
+#include "test_util.h"
+
+#define MAX_CLOSED 8
+
+static int s_closed[MAX_CLOSED];
+static int s_closed_count;
+
+static void on_close(int fd)
+{
+    if (s_closed_count < MAX_CLOSED)
+        s_closed[s_closed_count] = fd;
+    s_closed_count++;
+}
+
+static size_t encode_fill(ws_fmt_t fmt, const void* msg, uint8_t* buf, size_t cap)
+{
+    (void)fmt;
+    const size_t n = *(const size_t*)msg < cap ? *(const size_t*)msg : cap;
+    memset(buf, 'x', n);
+    return n;
+}
+
+// Connected pair; fds[0] is ws_out's end with a small send buffer so it
+// fills quickly, fds[1] the client
+static void open_client(int fds[2])
+{
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    const int sndbuf = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    ws_out_client_add(fds[0]);
+    ws_out_service();
+}
+
+// Bytes waiting for the client; -1 once the socket reports end of stream
+static long drain(int fd)
+{
+    uint8_t buf[4096];
+    long total = 0;
+    for (;;)
+    {
+        const ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n == 0)
+            return -1;
+        if (n < 0)
+            return total;
+        total += n;
+    }
+}
+
+static void close_pair(const int fds[2])
+{
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void test_stalled_client_closed_by_hook(void)
+{
+    s_closed_count = 0;
+    ws_out_set_close_fn(on_close);
+    int fds[2];
+    open_client(fds);
+    CHECK_EQ(ws_out_client_count(), 1);
+
+    // The client never reads: one frame at a time, within the backlog, until
+    // the socket refuses
+    const size_t len = WS_OUT_EVENT_MAX_LEN;
+    while (!ws_out_service())
+        ws_out_enqueue(encode_fill, &len);
+
+    // Then only retries, as ws_task makes them, until ws_out gives up
+    const int64_t stalled_us = esp_timer_get_time();
+    const TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(WS_OUT_EVICT_MS * 5);
+    while (ws_out_client_count() > 0 && xTaskGetTickCount() < until)
+    {
+        vTaskDelay(pdMS_TO_TICKS(WS_OUT_RETRY_MS));
+        ws_out_service();
+    }
+    const int64_t waited_us = esp_timer_get_time() - stalled_us;
+
+    CHECK_EQ(ws_out_client_count(), 0);
+    CHECK(waited_us >= (int64_t)WS_OUT_EVICT_MS * 1000);
+    CHECK_EQ(s_closed_count, 1);
+    CHECK_EQ(s_closed[0], fds[0]);
+    // ws_out left the socket to the server: the client sees no end of stream
+    CHECK(drain(fds[1]) >= 0);
+
+    ws_out_stats_t st;
+    ws_out_get_stats(&st);
+    CHECK(st.would_block > 0);
+    CHECK(st.evictions >= 1);
+    close_pair(fds);
+}
+
+static void test_backlog_overflow_closed_by_hook(void)
+{
+    s_closed_count = 0;
+    ws_out_set_close_fn(on_close);
+    int fds[2];
+    open_client(fds);
+
+    // More guaranteed frames than the backlog holds before ws_task services
+    const size_t len = WS_OUT_EVENT_MAX_LEN;
+    for (int i = 0; i < WS_OUT_EVENT_SLOTS * 40 && ws_out_client_count() > 0; i++)
+        ws_out_enqueue(encode_fill, &len);
+    ws_out_service();
+
+    CHECK_EQ(ws_out_client_count(), 0);
+    CHECK_EQ(s_closed_count, 1);
+    CHECK_EQ(s_closed[0], fds[0]);
+    CHECK(drain(fds[1]) >= 0);
+    close_pair(fds);
+}
+
+static void test_no_hook_shuts_down(void)
+{
+    s_closed_count = 0;
+    ws_out_set_close_fn(NULL);
+    int fds[2];
+    open_client(fds);
+
+    const size_t len = WS_OUT_EVENT_MAX_LEN;
+    for (int i = 0; i < WS_OUT_EVENT_SLOTS * 40 && ws_out_client_count() > 0; i++)
+        ws_out_enqueue(encode_fill, &len);
+    ws_out_service();
+
+    CHECK_EQ(ws_out_client_count(), 0);
+    CHECK_EQ(s_closed_count, 0);
+    CHECK_EQ(drain(fds[1]), -1);
+    close_pair(fds);
+}
+
+static int s_state_calls;
+static bool s_last_fresh;
+static ws_fmt_t s_last_fmt;
+
+static size_t state_source(int slot, bool fresh, ws_fmt_t fmt, uint8_t* buf, size_t cap)
+{
+    (void)slot;
+    s_state_calls++;
+    s_last_fresh = fresh;
+    s_last_fmt = fmt;
+    memset(buf, 's', cap < 4 ? cap : 4);
+    return 4;
+}
+
+static void test_fresh_state(void)
+{
+    ws_out_set_close_fn(on_close);
+    ws_out_set_state_source(state_source);
+    s_state_calls = 0;
+    int fds[2];
+    open_client(fds);
+    CHECK_EQ(s_state_calls, 1);
+    CHECK(s_last_fresh);
+
+    ws_out_mark_state();
+    ws_out_service();
+    CHECK_EQ(s_state_calls, 2);
+    CHECK(!s_last_fresh);
+
+    // The new format starts over from a full frame
+    ws_out_set_format(fds[0], WS_FMT_MSGPACK);
+    ws_out_service();
+    CHECK_EQ(s_state_calls, 3);
+    CHECK(s_last_fresh);
+    CHECK_EQ(s_last_fmt, WS_FMT_MSGPACK);
+
+    ws_out_mark_state();
+    ws_out_service();
+    CHECK_EQ(s_state_calls, 4);
+    CHECK(!s_last_fresh);
+
+    ws_out_client_remove(fds[0]);
+    ws_out_service();
+    ws_out_set_state_source(NULL);
+    close_pair(fds);
+}
+
+typedef struct
+{
+    uint8_t op;
+    std::vector<uint8_t> payload;
+} frame_t;
+
+// Splits what the client read into frames; false on anything a client could
+// not parse (fragment, mask bit, unknown opcode, frame cut short at the end)
+static bool parse_frames(const std::vector<uint8_t>& in, std::vector<frame_t>* out)
+{
+    size_t pos = 0;
+    while (pos < in.size())
+    {
+        if (in.size() - pos < 2)
+            return false;
+        const uint8_t b0 = in[pos];
+        const uint8_t b1 = in[pos + 1];
+        const uint8_t op = b0 & 0x0F;
+        if (!(b0 & 0x80) || (b0 & 0x70) || (b1 & 0x80))
+            return false;
+        if (op != WS_OP_TEXT && op != WS_OP_BINARY && op != WS_OP_CLOSE && op != WS_OP_PING &&
+            op != WS_OP_PONG)
+            return false;
+        size_t hlen = 2;
+        size_t len = b1 & 0x7F;
+        if (len == 126)
+        {
+            if (in.size() - pos < 4)
+                return false;
+            len = (size_t)in[pos + 2] << 8 | in[pos + 3];
+            hlen = 4;
+        }
+        else if (len == 127)
+            return false;
+        if (in.size() - pos < hlen + len)
+            return false;
+        frame_t f;
+        f.op = op;
+        f.payload.assign(in.begin() + pos + hlen, in.begin() + pos + hlen + len);
+        out->push_back(f);
+        pos += hlen + len;
+    }
+    return true;
+}
+
+static bool all_bytes(const std::vector<uint8_t>& v, size_t from, uint8_t b)
+{
+    for (size_t i = from; i < v.size(); i++)
+    {
+        if (v[i] != b)
+            return false;
+    }
+    return true;
+}
+
+// Events carry their sequence number in the first byte and a length that
+// moves across the 126-byte header boundary
+static size_t encode_seq(ws_fmt_t fmt, const void* msg, uint8_t* buf, size_t cap)
+{
+    (void)fmt;
+    const uint32_t seq = *(const uint32_t*)msg;
+    const size_t n = 100 + seq % (WS_OUT_EVENT_MAX_LEN - 99);
+    if (n > cap)
+        return 0;
+    memset(buf, 'e', n);
+    buf[0] = (uint8_t)seq;
+    return n;
+}
+
+#define REPLY_LEN 300
+
+static size_t reply_a(uint8_t* buf, size_t cap)
+{
+    memset(buf, 'a', cap < REPLY_LEN ? cap : REPLY_LEN);
+    return cap < REPLY_LEN ? cap : REPLY_LEN;
+}
+
+static size_t reply_b(uint8_t* buf, size_t cap)
+{
+    memset(buf, 'b', cap < 40 ? cap : 40);
+    return cap < 40 ? cap : 40;
+}
+
+static size_t state_fill(int slot, bool fresh, ws_fmt_t fmt, uint8_t* buf, size_t cap)
+{
+    (void)slot;
+    (void)fresh;
+    (void)fmt;
+    memset(buf, 's', cap < 60 ? cap : 60);
+    return cap < 60 ? cap : 60;
+}
+
+#define INTERLEAVE_EVENTS 400
+#define SIDE_POSTS 40
+
+static volatile bool s_side_done;
+static int s_side_fd;
+
+// Commands and PINGs arrive on the HTTP server's task, not ws_task
+static void side_task(void* arg)
+{
+    (void)arg;
+    const uint8_t ping[3] = {'p', 'p', 'p'};
+    for (int i = 0; i < SIDE_POSTS; i++)
+    {
+        ws_out_reply(s_side_fd, i & 1 ? reply_b : reply_a);
+        ws_out_control(s_side_fd, WS_OP_PONG, ping, sizeof(ping));
+        vTaskDelay(pdMS_TO_TICKS(3));
+    }
+    s_side_done = true;
+    vTaskDelete(NULL);
+}
+
+static void test_no_interleave(void)
+{
+    s_closed_count = 0;
+    ws_out_set_close_fn(on_close);
+    ws_out_set_state_source(state_fill);
+    int fds[2];
+    open_client(fds);
+
+    ws_out_stats_t before;
+    ws_out_get_stats(&before);
+    s_side_fd = fds[0];
+    s_side_done = false;
+    xTaskCreate(side_task, "ws_side", 4096, NULL, 5, NULL);
+
+    // ws_task's loop, with a client that reads in uneven pieces and now and
+    // then not at all, so frames are regularly left half-written
+    std::vector<uint8_t> rx;
+    uint32_t seq = 0;
+    uint32_t iter = 0;
+    const TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(10000);
+    bool pending = true;
+    while ((seq < INTERLEAVE_EVENTS || !s_side_done || pending) && xTaskGetTickCount() < until)
+    {
+        iter++;
+        if ((iter & 1) && seq < INTERLEAVE_EVENTS && ws_out_enqueue(encode_seq, &seq) == 1)
+            seq++;
+        if ((iter & 7) == 0)
+            ws_out_mark_state();
+        pending = ws_out_service();
+
+        uint8_t buf[256];
+        const ssize_t n = iter % 48 < 12 ? 0 : recv(fds[1], buf, 61 + (iter * 37) % 190, MSG_DONTWAIT);
+        if (n > 0)
+            rx.insert(rx.end(), buf, buf + n);
+        vTaskDelay(1);
+    }
+    for (int i = 0; i < 50 && ws_out_service(); i++)
+        vTaskDelay(1);
+    uint8_t buf[4096];
+    ssize_t n;
+    while ((n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        rx.insert(rx.end(), buf, buf + n);
+
+    CHECK_EQ(seq, INTERLEAVE_EVENTS);
+    CHECK_EQ(s_closed_count, 0);
+    CHECK_EQ(ws_out_client_count(), 1);
+
+    std::vector<frame_t> frames;
+    CHECK(parse_frames(rx, &frames));
+    uint32_t next = 0;
+    int replies = 0;
+    int pongs = 0;
+    int states = 0;
+    int bad = 0;
+    for (const frame_t& f : frames)
+    {
+        if (f.op == WS_OP_PONG)
+        {
+            pongs++;
+            bad += f.payload.size() != 3 || !all_bytes(f.payload, 0, 'p');
+        }
+        else if (f.op == WS_OP_BINARY)
+        {
+            replies++;
+            bad += !(f.payload.size() == REPLY_LEN && all_bytes(f.payload, 0, 'a')) &&
+                   !(f.payload.size() == 40 && all_bytes(f.payload, 0, 'b'));
+        }
+        else if (f.op == WS_OP_TEXT && !f.payload.empty() && f.payload[0] == 's' && f.payload.size() == 60)
+        {
+            states++;
+            bad += !all_bytes(f.payload, 0, 's');
+        }
+        else if (f.op == WS_OP_TEXT)
+        {
+            // Events: every one, once, in order, whole
+            bad += f.payload.empty() || f.payload[0] != (uint8_t)next;
+            bad += f.payload.size() != 100 + next % (WS_OUT_EVENT_MAX_LEN - 99) || !all_bytes(f.payload, 1, 'e');
+            next++;
+        }
+        else
+            bad++;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(next, INTERLEAVE_EVENTS);
+    CHECK(replies > 0);
+    CHECK(pongs > 0);
+    CHECK(states > 0);
+    ws_out_stats_t after;
+    ws_out_get_stats(&after);
+    CHECK(after.would_block > before.would_block);
+    test_log("interleave: %u frames (%d replies, %d pongs, %d states) in %u bytes, %u sends resumed\n",
+             (unsigned)frames.size(), replies, pongs, states, (unsigned)rx.size(),
+             (unsigned)(after.would_block - before.would_block));
+
+    ws_out_client_remove(fds[0]);
+    ws_out_service();
+    ws_out_set_state_source(NULL);
+    close_pair(fds);
+}
+
+static std::vector<frame_t> read_frames(int fd)
+{
+    std::vector<uint8_t> rx;
+    uint8_t buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        rx.insert(rx.end(), buf, buf + n);
+    std::vector<frame_t> frames;
+    CHECK(parse_frames(rx, &frames));
+    return frames;
+}
+
+static void test_control_frames(void)
+{
+    s_closed_count = 0;
+    ws_out_set_close_fn(on_close);
+    int fds[2];
+    open_client(fds);
+    const size_t len = 20;
+
+    // A PONG echoes the PING's payload ahead of events already waiting
+    for (int i = 0; i < 3; i++)
+        ws_out_enqueue(encode_fill, &len);
+    const uint8_t ping[] = {1, 2, 3, 4};
+    ws_out_control(fds[0], WS_OP_PONG, ping, sizeof(ping));
+    ws_out_service();
+    std::vector<frame_t> frames = read_frames(fds[1]);
+    CHECK_EQ(frames.size(), 4);
+    CHECK_EQ(frames[0].op, WS_OP_PONG);
+    CHECK(frames[0].payload == std::vector<uint8_t>(ping, ping + sizeof(ping)));
+    for (size_t i = 1; i < frames.size(); i++)
+        CHECK_EQ(frames[i].op, WS_OP_TEXT);
+
+    // A CLOSE echoes the status code, is not replaced by a later PONG, and
+    // is the last thing sent before the session is ended through the hook
+    for (int i = 0; i < 3; i++)
+        ws_out_enqueue(encode_fill, &len);
+    const uint8_t code[] = {0x03, 0xE8};
+    ws_out_control(fds[0], WS_OP_CLOSE, code, sizeof(code));
+    ws_out_control(fds[0], WS_OP_PONG, ping, sizeof(ping));
+    ws_out_reply(fds[0], reply_b);
+    ws_out_service();
+    frames = read_frames(fds[1]);
+    CHECK_EQ(frames.size(), 1);
+    CHECK_EQ(frames[0].op, WS_OP_CLOSE);
+    CHECK(frames[0].payload == std::vector<uint8_t>(code, code + sizeof(code)));
+    CHECK_EQ(ws_out_client_count(), 0);
+    CHECK_EQ(s_closed_count, 1);
+    CHECK_EQ(s_closed[0], fds[0]);
+
+    CHECK_EQ(ws_out_enqueue(encode_fill, &len), 0);
+    ws_out_service();
+    CHECK(read_frames(fds[1]).empty());
+    close_pair(fds);
+}
+
+static void body(void)
+{
+    CHECK(ws_out_init());
+    test_stalled_client_closed_by_hook();
+    test_backlog_overflow_closed_by_hook();
+    test_no_hook_shuts_down();
+    test_fresh_state();
+    test_no_interleave();
+    test_control_frames();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_ws_out", body);
+}
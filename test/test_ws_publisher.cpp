@@ -0,0 +1,355 @@
+// ws_publisher between the trigger path and socketpair clients. A client
+// that stops reading must not slow the trigger path: its p99 with a stalled
+// client next to a healthy one stays near the p99 with the healthy one alone.
+// Events and client ops that find their queue full are counted, not lost
+// without a trace. A snapshot publish reaches a client's socket one coalesce
+// window later; prints p50/p99 of publish to frame read.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "config.h"
+#include "fake_game_state.h"
+#include "game_snapshot.h"
+#include "state_publisher.h"
+#include "ws_out.h"
+#include "ws_publisher.h"
+#include "sim.h"
+#include "test_util.h"
+
+#define SHOTS 400
+#define SHOT_GAP_MS 4
+// Host scheduling noise on top of the clean run's p99
+#define P99_SLACK_US 200
+#define PUBLISHES 200
+#define PUBLISH_GAP_MS 5
+// Host scheduling noise on top of the coalesce window
+#define PUBLISH_SLACK_MS 30
+
+static std::atomic<bool> s_stalled_wanted{false};
+static std::atomic<uint32_t> s_stalled_opened{0};
+static std::atomic<uint32_t> s_rx_bytes{0};
+static std::atomic<bool> s_reading{false};
+static int s_stalled[2] = {-1, -1};
+static int s_healthy[2] = {-1, -1};
+static int s_closed_fd = -1;
+
+static void on_close(int fd)
+{
+    s_closed_fd = fd;
+}
+
+// A client that never reads; ws_out's end gets a small send buffer so the
+// stall reaches ws_out within a few frames
+static void open_stalled(void)
+{
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, s_stalled) == 0);
+    const int sndbuf = 4096;
+    setsockopt(s_stalled[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    ws_out_client_add(s_stalled[0]);
+    state_publisher_mark(STATE_DIRTY_CLIENT);
+    s_stalled_opened++;
+}
+
+static void close_stalled(void)
+{
+    if (s_stalled[0] < 0)
+        return;
+    ws_out_client_remove(s_stalled[0]);
+    close(s_stalled[0]);
+    close(s_stalled[1]);
+    s_stalled[0] = s_stalled[1] = -1;
+}
+
+// ws_task's publishing loop without the shared server. A stalled client that
+// ws_out gives up on is replaced at once, so one is always there.
+static void ws_task_loop(void* arg)
+{
+    (void)arg;
+    state_publisher_bind();
+    bool backlog = false;
+    for (;;)
+    {
+        const TickType_t timeout = backlog ? pdMS_TO_TICKS(WS_OUT_RETRY_MS) : pdMS_TO_TICKS(100);
+        const uint32_t dirty = state_publisher_wait(timeout, pdMS_TO_TICKS(WS_PUBLISH_COALESCE_MS));
+        ws_publisher_drain_events();
+        if (dirty & (STATE_DIRTY_GAME | STATE_DIRTY_CLIENT))
+            ws_publisher_push();
+        backlog = ws_publisher_service();
+
+        if (s_closed_fd >= 0 && s_closed_fd == s_stalled[0])
+        {
+            s_closed_fd = -1;
+            close_stalled();
+        }
+        if (s_stalled_wanted && s_stalled[0] < 0)
+            open_stalled();
+        else if (!s_stalled_wanted)
+            close_stalled();
+    }
+}
+
+// The healthy client reads everything as it arrives
+static void reader_task(void* arg)
+{
+    (void)arg;
+    uint8_t buf[4096];
+    for (;;)
+    {
+        const ssize_t n = s_reading ? recv(s_healthy[1], buf, sizeof(buf), MSG_DONTWAIT) : 0;
+        if (n > 0)
+            s_rx_bytes += (uint32_t)n;
+        else
+            vTaskDelay(1);
+    }
+}
+
+// control_task's part of a shot after the laser queue: game state, the
+// snapshot, the ws_task wakeup and the event for the clients
+static uint32_t trigger_path_us(uint32_t i)
+{
+    const int64_t t0 = esp_timer_get_time();
+    game_state_record_shot();
+    game_snapshot_publish();
+    state_publisher_mark(STATE_DIRTY_SHOT);
+    ws_event_t evt = {};
+    evt.type = WS_EVT_SHOT;
+    evt.player_id = 1;
+    evt.device_id = 2;
+    evt.team_id = 1;
+    evt.victim = -1;
+    evt.data = i;
+    evt.ts_ms = (uint32_t)(t0 / 1000);
+    CHECK(ws_publisher_post_event(&evt));
+    return (uint32_t)(esp_timer_get_time() - t0);
+}
+
+typedef struct
+{
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_t;
+
+static latency_t fire(void)
+{
+    std::vector<uint32_t> us;
+    us.reserve(SHOTS);
+    for (uint32_t i = 0; i < SHOTS; i++)
+    {
+        us.push_back(trigger_path_us(i));
+        vTaskDelay(pdMS_TO_TICKS(SHOT_GAP_MS));
+    }
+    // Let ws_task drain the last batch
+    vTaskDelay(pdMS_TO_TICKS(WS_PUBLISH_COALESCE_MS * 5));
+    std::sort(us.begin(), us.end());
+    return {us[SHOTS / 2], us[SHOTS * 99 / 100], us[SHOTS - 1]};
+}
+
+static void test_drops_counted(void)
+{
+    ws_publisher_stats_t before;
+    ws_publisher_get_stats(&before);
+
+    // Nobody drains: the queue takes WS_EVENT_QUEUE_LEN, the rest are refused
+    ws_event_t evt = {};
+    evt.type = WS_EVT_HIT;
+    int refused = 0;
+    for (int i = 0; i < WS_EVENT_QUEUE_LEN + 5; i++)
+        refused += !ws_publisher_post_event(&evt);
+    CHECK_EQ(refused, 5);
+    CHECK_EQ(ws_publisher_drain_events(), WS_EVENT_QUEUE_LEN);
+
+    ws_publisher_stats_t after;
+    ws_publisher_get_stats(&after);
+    CHECK_EQ(after.events_dropped - before.events_dropped, 5);
+    CHECK_EQ(after.events_sent - before.events_sent, WS_EVENT_QUEUE_LEN);
+
+    // Client ops likewise, until ws_task applies them
+    ws_out_stats_t ops_before;
+    ws_out_get_stats(&ops_before);
+    for (int i = 0; i < WS_OUT_OPS_DEPTH + 3; i++)
+        ws_out_set_format(1000 + i, WS_FMT_MSGPACK);
+    ws_out_stats_t ops_after;
+    ws_out_get_stats(&ops_after);
+    CHECK_EQ(ops_after.ops_dropped - ops_before.ops_dropped, 3);
+    ws_publisher_service();
+}
+
+static void test_stalled_client(void)
+{
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, s_healthy) == 0);
+    ws_out_client_add(s_healthy[0]);
+    state_publisher_mark(STATE_DIRTY_CLIENT);
+    s_reading = true;
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    ws_publisher_stats_t pub0;
+    ws_publisher_get_stats(&pub0);
+    const latency_t clean = fire();
+    const uint32_t clean_rx = s_rx_bytes;
+
+    s_stalled_wanted = true;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    ws_out_stats_t out0;
+    ws_out_get_stats(&out0);
+    const latency_t stalled = fire();
+    s_stalled_wanted = false;
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    ws_publisher_stats_t pub1;
+    ws_publisher_get_stats(&pub1);
+    ws_out_stats_t out1;
+    ws_out_get_stats(&out1);
+
+    // Every shot reached ws_out and the healthy client kept receiving
+    CHECK_EQ(pub1.events_dropped, pub0.events_dropped);
+    CHECK_EQ(pub1.events_sent - pub0.events_sent, 2 * SHOTS);
+    CHECK_EQ(out1.ops_dropped, out0.ops_dropped);
+    CHECK(clean_rx > 0);
+    CHECK(s_rx_bytes > clean_rx);
+    // The stall was real: sends refused and stalled clients given up on
+    CHECK(out1.would_block > out0.would_block);
+    CHECK(out1.evictions > out0.evictions);
+
+    CHECK(stalled.p99_us <= 2 * clean.p99_us + P99_SLACK_US);
+    test_log("trigger path, healthy client only: p50 %u us, p99 %u us, max %u us\n", (unsigned)clean.p50_us,
+             (unsigned)clean.p99_us, (unsigned)clean.max_us);
+    test_log("trigger path, plus a stalled one:  p50 %u us, p99 %u us, max %u us (%u stalled clients, %u evicted)\n",
+             (unsigned)stalled.p50_us, (unsigned)stalled.p99_us, (unsigned)stalled.max_us,
+             (unsigned)s_stalled_opened, (unsigned)(out1.evictions - out0.evictions));
+
+    s_reading = false;
+    ws_out_client_remove(s_healthy[0]);
+}
+
+// Next whole frame's payload from the client end; false on timeout
+static bool read_frame(int fd, std::string* payload)
+{
+    static std::vector<uint8_t> rx;
+    for (;;)
+    {
+        if (rx.size() >= 2)
+        {
+            size_t hdr = 2;
+            size_t len = rx[1] & 0x7F;
+            if (len == 126 && rx.size() >= 4)
+            {
+                len = (size_t)rx[2] << 8 | rx[3];
+                hdr = 4;
+            }
+            if (len < 126 || hdr == 4)
+            {
+                if (rx.size() >= hdr + len)
+                {
+                    payload->assign((const char*)rx.data() + hdr, len);
+                    rx.erase(rx.begin(), rx.begin() + hdr + len);
+                    return true;
+                }
+            }
+        }
+        uint8_t buf[1024];
+        const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        // The POSIX port's tick signal interrupts a blocking call
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        rx.insert(rx.end(), buf, buf + n);
+    }
+}
+
+// Generation a JSON delta carries, 0 for any other frame
+static uint32_t delta_gen(const std::string& payload)
+{
+    static const char prefix[] = "{\"type\":\"delta\"";
+    if (payload.compare(0, sizeof(prefix) - 1, prefix) != 0)
+        return 0;
+    const size_t at = payload.find("\"gen\":");
+    unsigned gen = 0;
+    if (at == std::string::npos || sscanf(payload.c_str() + at + 6, "%u", &gen) != 1)
+        return 0;
+    return gen;
+}
+
+// game_task's tick: game_state changed on its own, the snapshot is published
+// and ws_task marked; the client's clock stops when it has read the delta
+static void test_publish_latency(void)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    const struct timeval rcv_timeout = {1, 0};
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVTIMEO, &rcv_timeout, sizeof(rcv_timeout));
+    ws_out_client_add(fds[0]);
+    state_publisher_mark(STATE_DIRTY_CLIENT);
+    std::string payload;
+    CHECK(read_frame(fds[1], &payload));
+    CHECK(delta_gen(payload) != 0);
+
+    std::vector<uint32_t> us;
+    us.reserve(PUBLISHES);
+    for (int i = 0; i < PUBLISHES; i++)
+    {
+        game_state_record_kill();
+        const int64_t t0 = esp_timer_get_time();
+        game_snapshot_publish();
+        state_publisher_mark(STATE_DIRTY_OTHER);
+        game_snapshot_t snap;
+        game_snapshot_read(&snap);
+
+        bool seen = false;
+        while (!seen && read_frame(fds[1], &payload))
+            seen = delta_gen(payload) >= snap.generation;
+        CHECK(seen);
+        if (!seen)
+            break;
+        us.push_back((uint32_t)(esp_timer_get_time() - t0));
+        vTaskDelay(pdMS_TO_TICKS(PUBLISH_GAP_MS));
+    }
+
+    if (us.size() == PUBLISHES)
+    {
+        std::sort(us.begin(), us.end());
+        const uint32_t p50 = us[PUBLISHES / 2];
+        const uint32_t p99 = us[PUBLISHES * 99 / 100];
+        // One coalesce window, then encode and send
+        CHECK(p50 >= (uint32_t)WS_PUBLISH_COALESCE_MS * 1000);
+        CHECK(p99 <= (uint32_t)(WS_PUBLISH_COALESCE_MS + PUBLISH_SLACK_MS) * 1000);
+        test_log("publish to frame read: p50 %u us, p99 %u us, max %u us (%d ms coalesce window)\n",
+                 (unsigned)p50, (unsigned)p99, (unsigned)us[PUBLISHES - 1], WS_PUBLISH_COALESCE_MS);
+    }
+
+    ws_out_client_remove(fds[0]);
+    vTaskDelay(pdMS_TO_TICKS(WS_PUBLISH_COALESCE_MS));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void body(void)
+{
+    fake_game_state_reset();
+    sim_timer_start();
+    CHECK(ws_publisher_init());
+    ws_out_set_close_fn(on_close);
+    game_snapshot_publish();
+
+    test_drops_counted();
+
+    xTaskCreate(ws_task_loop, "ws", 8192, NULL, 5, NULL);
+    xTaskCreate(reader_task, "reader", 4096, NULL, 4, NULL);
+    test_stalled_client();
+    test_publish_latency();
+}
+
+int main(void)
+{
+    test_run_scheduled("test_ws_publisher", body);
+}